@@ -308,7 +308,11 @@ namespace detail {
 
     template <typename T>
     FutureBaseTyped<T>::FutureBaseTyped()
-      : _value()
+      : _callbacks(nullptr)
+      , _inlineCallbackUsed(false)
+      , _resultClaimed(false)
+      , _hasOnCancel(false)
+      , _value()
       , _async(FutureCallbackType_Auto)
     {
     }
@@ -316,9 +320,41 @@ namespace detail {
     template <typename T>
     FutureBaseTyped<T>::~FutureBaseTyped()
     {
-      boost::recursive_mutex::scoped_lock lock(mutex());
-      if (_onDestroyed && hasValue(0))
-        _onDestroyed(_value);
+      {
+        boost::recursive_mutex::scoped_lock lock(mutex());
+        if (_onDestroyed && hasValue(0))
+          _onDestroyed(_value);
+      }
+      // the continuations of a future that never finished
+      CallbackNode* node = _callbacks.load();
+      while (node && node != finishedMarker())
+      {
+        CallbackNode* const next = node->next;
+        releaseCallbackNode(node);
+        node = next;
+      }
+    }
+
+    template <typename T>
+    auto FutureBaseTyped<T>::makeCallbackNode() -> CallbackNode*
+    {
+      // Most futures have a single continuation: keep it with the state.
+      if (!_inlineCallbackUsed.exchange(true, std::memory_order_acquire))
+        return &_inlineCallback;
+      return new CallbackNode;
+    }
+
+    template <typename T>
+    void FutureBaseTyped<T>::releaseCallbackNode(CallbackNode* node)
+    {
+      if (node == &_inlineCallback)
+      {
+        node->callback.clear();
+        node->next = nullptr;
+        _inlineCallbackUsed.store(false, std::memory_order_release);
+      }
+      else
+        delete node;
     }
 
     template <typename T>
@@ -345,6 +381,11 @@ namespace detail {
       bool doCancel = false;
       {
         boost::recursive_mutex::scoped_lock lock(mutex());
+        _hasOnCancel = true;
+        // finish() may not have seen _hasOnCancel, do not keep the callback
+        // alive past the result.
+        if (isFinished())
+          return;
         _onCancel = onCancel;
         doCancel = isCancelRequested();
       }
@@ -354,23 +395,35 @@ namespace detail {
     }
 
     template <typename T>
-    void FutureBaseTyped<T>::executeCallbacks(bool defaultAsync, const Callbacks& callbacks, qi::Future<T>& future)
+    void FutureBaseTyped<T>::executeCallbacks(bool defaultAsync, CallbackNode* callbacks, qi::Future<T>& future)
     {
-      for (const auto& callback : callbacks)
+      // The stack holds the last connected callback first.
+      CallbackNode* ordered = nullptr;
+      while (callbacks)
+      {
+        CallbackNode* const next = callbacks->next;
+        callbacks->next = ordered;
+        ordered = callbacks;
+        callbacks = next;
+      }
+
+      while (ordered)
       {
+        CallbackNode* const node = ordered;
+        ordered = node->next;
         const bool async = [&]{
-          if (callback.callType != FutureCallbackType_Auto)
-            return callback.callType != FutureCallbackType_Sync;
+          if (node->callType != FutureCallbackType_Auto)
+            return node->callType != FutureCallbackType_Sync;
           else
             return defaultAsync != FutureCallbackType_Sync;
         }();
 
         if (async)
-          getEventLoop()->post(boost::bind(callback.callback, future));
+          getEventLoop()->post(boost::bind(node->callback, future));
         else
           try
           {
-            callback.callback(future);
+            node->callback(future);
           }
           catch (const qi::PointerLockException&)
           { // do nothing
@@ -383,6 +436,7 @@ namespace detail {
           {
             qiLogError("qi.future") << "Unknown exception caught in future callback";
           }
+        releaseCallbackNode(node);
       }
     }
 
@@ -390,25 +444,33 @@ namespace detail {
     template <typename F> // FunctionObject<R()> F (R unconstrained)
     void FutureBaseTyped<T>::finish(qi::Future<T>& future, F&& finishTask)
     {
-      bool async;
-      Callbacks onResult;
+      // Only the first caller gets to set the result, the others throw without
+      // having touched it.
+      if (!isRunning() || _resultClaimed.exchange(true))
+        throw FutureException(FutureException::ExceptionState_PromiseAlreadySet);
+      try
       {
-        // report-ready + onResult() must be Atomic to avoid
-        // missing callbacks/double calls in case connect() is invoked at
-        // the same time
-        boost::recursive_mutex::scoped_lock lock(mutex());
-        if (!isRunning())
-          throw FutureException(FutureException::ExceptionState_PromiseAlreadySet);
         finishTask();
+      }
+      catch (...)
+      {
+        _resultClaimed = false;
+        throw;
+      }
 
-        async = (_async != FutureCallbackType_Sync ? true : false);
-        onResult = takeOutResultCallbacks();
+      const bool async = (_async != FutureCallbackType_Sync ? true : false);
+      if (_hasOnCancel.load())
+      {
+        boost::recursive_mutex::scoped_lock lock(mutex());
         clearCancelCallback();
-
-        // wake the waiting threads up
-        notifyFinish();
       }
-      // call the callbacks without the mutex
+
+      // From now on, connect() calls the callbacks by itself.
+      CallbackNode* const onResult = _callbacks.exchange(finishedMarker());
+
+      // wake the waiting threads up
+      notifyFinish();
+
       executeCallbacks(async, onResult, future);
     }
 
@@ -468,12 +530,25 @@ namespace detail {
       if (state() == FutureState_None)
         throw FutureException(FutureException::ExceptionState_FutureInvalid);
 
-      bool ready;
+      bool ready = isFinished();
+      if (!ready)
       {
-        boost::recursive_mutex::scoped_lock lock(mutex());
-        ready = isFinished();
-        if (!ready)
-          _onResult.push_back(Callback(callback, type));
+        CallbackNode* const node = makeCallbackNode();
+        node->callback = callback;
+        node->callType = type;
+        CallbackNode* head = _callbacks.load();
+        while (true)
+        {
+          if (head == finishedMarker())
+          { // finish() took the stack before we could push on it
+            releaseCallbackNode(node);
+            ready = true;
+            break;
+          }
+          node->next = head;
+          if (_callbacks.compare_exchange_weak(head, node))
+            break;
+        }
       }
 
       // result already ready, notify the callback
@@ -519,15 +594,6 @@ namespace detail {
       return _value;
     }
 
-    template <typename T>
-    auto FutureBaseTyped<T>::takeOutResultCallbacks() -> Callbacks
-    {
-      Callbacks onResult;
-      using std::swap;
-      swap(onResult, _onResult);
-      return onResult;
-    }
-
     template <typename T>
     void FutureBaseTyped<T>::clearCancelCallback()
     {
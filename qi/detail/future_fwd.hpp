@@ -10,6 +10,8 @@
 # include <type_traits>
 # include <qi/api.hpp>
 # include <qi/assert.hpp>
+# include <atomic>
+# include <cstdint>
 # include <vector>
 # include <qi/atomic.hpp>
 # include <qi/config.hpp>
@@ -946,18 +948,22 @@ namespace qi {
     private:
       friend class Promise<T>;
       using CallbackType = boost::function<void(qi::Future<T>)>;
-      struct Callback
+      /// A continuation, in the stack of the ones waiting for the result.
+      struct CallbackNode
       {
         CallbackType callback;
-        FutureCallbackType callType;
-
-        Callback(CallbackType callback, FutureCallbackType callType)
-          : callback(callback)
-          , callType(callType)
-        {}
+        FutureCallbackType callType = FutureCallbackType_Auto;
+        CallbackNode* next = nullptr;
       };
-      using Callbacks = std::vector<Callback>;
-      Callbacks                _onResult;
+
+      // The continuations are pushed without locking until the result is set,
+      // which swaps in finishedMarker(). The first one is stored inline.
+      std::atomic<CallbackNode*> _callbacks;
+      CallbackNode             _inlineCallback;
+      std::atomic<bool>        _inlineCallbackUsed;
+      // Set by the first call to finish(), to refuse the next ones.
+      std::atomic<bool>        _resultClaimed;
+      std::atomic<bool>        _hasOnCancel;
       ValueType                _value;
       CancelCallback           _onCancel;
       boost::function<void (ValueType)> _onDestroyed;
@@ -967,13 +973,19 @@ namespace qi {
       template <typename F> // FunctionObject<R()> F (R unconstrained)
       void finish(qi::Future<T>& future, F&& finishTask);
 
-      /// Take the callbacks set for handling the result and leave the member empty. Not thread-safe.
-      Callbacks takeOutResultCallbacks();
+      static CallbackNode* finishedMarker()
+      {
+        return reinterpret_cast<CallbackNode*>(static_cast<std::uintptr_t>(1));
+      }
+
+      CallbackNode* makeCallbackNode();
+      void releaseCallbackNode(CallbackNode* node);
 
       /// Clear the callback set for handling cancellation. Not thread-safe.
       void clearCancelCallback();
 
-      static void executeCallbacks(bool defaultAsync, const Callbacks& callbacks, qi::Future<T>& future);
+      /// Executes the callbacks of a stack, in the order of their connection, and releases them.
+      void executeCallbacks(bool defaultAsync, CallbackNode* callbacks, qi::Future<T>& future);
     };
   }
 
@@ -42,6 +42,20 @@ namespace qi
   class QI_API EventLoop : public ExecutionContext
   {
   public:
+    /// Implementation of the event loop.
+    enum class Backend
+    {
+      /// Set by the QI_EVENTLOOP_BACKEND environment variable, to "asio" or
+      /// "workstealing". Asio if it is not set.
+      Default,
+      /// The tasks, timers and sockets share a single queue.
+      Asio,
+      /// The tasks are queued in one queue per thread, and the idle threads
+      /// take the tasks of the others. Timers and sockets are handled as with
+      /// the Asio backend.
+      WorkStealing,
+    };
+
     /**
      * \brief Create a new eventLoop.
      * \param name Name of the event loop created.
@@ -50,6 +64,13 @@ namespace qi
      */
     EventLoop(const std::string& name = "eventloop");
 
+    /**
+     * \brief Create a new eventLoop with the given implementation.
+     * \param name Name of the event loop created.
+     * \param backend Implementation of the event loop.
+     */
+    EventLoop(const std::string& name, Backend backend);
+
     /// \brief Default destructor.
     ~EventLoop();
     /**
@@ -148,6 +169,7 @@ namespace qi
   private:
     EventLoopPrivate *_p;
     std::string       _name;
+    Backend           _backend;
 
     void postImpl(boost::function<void()> callback) override
     {
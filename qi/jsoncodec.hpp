@@ -42,6 +42,16 @@ namespace qi {
                                          const std::string::const_iterator &end,
                                          AnyValue &target);
 
+  /**
+    * set a value of a known type to the JSON string or throw on parse error.
+    * The value is set as the string is decoded, without an intermediate
+    * generic value. Lists and maps are appended to, and members of structures
+    * missing from a JSON object keep their value.
+    * @param in JSON string to decode.
+    * @param target reference to the value to set. May be partially modified if an error occured.
+    */
+  QI_API void decodeJSON(const std::string &in, AnyReference target);
+
 
 
 }
@@ -463,6 +463,12 @@ namespace qi {
      *
      * When setting to async, this function must be called after main has
      * started.
+     *
+     * Asynchronous logs are stored in a preallocated buffer until the log
+     * thread dispatches them. Its size in bytes can be set with env var
+     * QI_LOG_BUFFER_SIZE (512KiB by default). When it is full, logs are
+     * dropped and counted ("count", the default), silently dropped ("drop")
+     * or the caller waits ("block"), as set by env var QI_LOG_OVERFLOW.
      */
     QI_API void setSynchronousLog(bool sync);
 
@@ -0,0 +1,80 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_BUFFERSTREAM_HPP_
+#define _QIMESSAGING_BUFFERSTREAM_HPP_
+
+#include <cstddef>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <qi/api.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+
+/// @file
+/// Transfers payloads too big to fit in a single message, fragment by
+/// fragment.
+///
+/// The sender passes a stream object instead of the whole buffer, as an
+/// argument or a return value of any call. The receiver pulls fragments of a
+/// bounded size from it with a BufferStreamReader, and can start processing
+/// the first one before the rest has been produced. As a fragment is only
+/// requested when the receiver is ready to take it, the memory used on both
+/// sides stays bounded by the size of the fragments in flight.
+///
+/// Streams are ordinary objects and fragments ordinary calls on them, not a
+/// message type of the protocol: they need no capability and go through any
+/// transport or gateway. Only buffers are streamed, the elements of a list
+/// must be encoded into fragments by the caller.
+
+namespace qi
+{
+  /// Produces the next fragment of a stream, of at most `maxSize` bytes. An
+  /// empty buffer ends the stream.
+  using BufferProducer = boost::function<Buffer (std::size_t maxSize)>;
+
+  /// Returns a stream serving the content of `buffer`. Sub-buffers are not
+  /// transferred.
+  QI_API AnyObject makeBufferStream(const Buffer& buffer);
+
+  /// Returns a stream serving the fragments returned by `producer`, which is
+  /// called as they are requested, one call at a time.
+  QI_API AnyObject makeBufferStream(BufferProducer producer);
+
+  struct BufferStreamReaderPrivate;
+
+  /// Reads the fragments of a stream made by makeBufferStream, possibly in
+  /// another process.
+  ///
+  /// `prefetch` fragment requests are kept in flight to hide the latency of
+  /// the calls. Fragments are returned in order, whatever the order in which
+  /// the requests complete.
+  class QI_API BufferStreamReader : private boost::noncopyable
+  {
+  public:
+    /// Fragments are requested with a size of `fragmentSize` bytes, which must
+    /// stay below the maximum payload of the messages.
+    explicit BufferStreamReader(AnyObject stream,
+                                std::size_t fragmentSize = 1024 * 1024,
+                                unsigned int prefetch = 4);
+    ~BufferStreamReader();
+
+    /// Waits for the next fragment. Returns an empty buffer at the end of the
+    /// stream, and throws if a request failed.
+    /// @warning Blocks the calling thread, do not call it from the event loop
+    /// the answers are processed on.
+    Buffer next();
+
+    /// Returns true once next() has returned the end of the stream.
+    bool atEnd() const;
+
+  private:
+    boost::shared_ptr<BufferStreamReaderPrivate> _p;
+  };
+}
+
+#endif // _QIMESSAGING_BUFFERSTREAM_HPP_
@@ -0,0 +1,37 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_CONNECTIONMETRICS_HPP_
+#define _QIMESSAGING_CONNECTIONMETRICS_HPP_
+
+#include <cstdint>
+#include <iosfwd>
+#include <qi/api.hpp>
+#include <qi/url.hpp>
+
+namespace qi
+{
+  /// Snapshot of the traffic counters of a connection, since it was created.
+  struct QI_API ConnectionMetrics
+  {
+    /// Endpoint of the peer, if the connection is established.
+    Url remoteEndpoint;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t bytesReceived = 0;
+    std::uint64_t messagesSent = 0;
+    std::uint64_t messagesReceived = 0;
+    /// Messages discarded or rejected because the send queue was full.
+    std::uint64_t messagesDiscarded = 0;
+    /// Number of messages waiting to be written to the connection.
+    std::uint64_t sendQueueDepth = 0;
+    /// Highest number of messages that have waited at the same time.
+    std::uint64_t sendQueueHighWatermark = 0;
+  };
+
+  QI_API std::ostream& operator<<(std::ostream& o, const ConnectionMetrics& metrics);
+}
+
+#endif // _QIMESSAGING_CONNECTIONMETRICS_HPP_
@@ -299,6 +299,8 @@ namespace qi { namespace sock {
 ///         (ConstBufferSequence only constrained by the following)
 ///     && N::async_read(sslSocketLValue, mutable_bufs, transferHandler)
 ///     && N::async_read(sslSocketLValue.next_layer(), mutable_bufs, transferHandler)
+///     && N::async_read_some(sslSocketLValue, mutable_bufs, transferHandler)
+///     && N::async_read_some(sslSocketLValue.next_layer(), mutable_bufs, transferHandler)
 ///     && N::async_write(sslSocketLValue, const_bufs, transferHandler)
 ///     && N::async_write(sslSocketLValue.next_layer(), const_bufs, transferHandler)
 /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -131,17 +131,18 @@ namespace qi
         ConnectedResult<N> _result;
         std::atomic<bool> _stopRequested;
         ReceiveMessageContinuous<N> _receiveMsg;
+        ReceiveMessageChunked<N> _receiveMsgChunked;
         SendMessageEnqueue<N, SocketPtr<N>> _sendMsg;
         boost::mutex _disconnectedPromiseMutex;
 
-        Impl(const SocketPtr<N>& socket);
+        Impl(const SocketPtr<N>& socket, size_t receiveChunkSize);
         ~Impl();
 
         template<typename Proc>
         void start(SslEnabled, size_t maxPayload, Proc onReceive, qi::int64_t messageHandlingTimeoutInMus);
 
         template<typename Msg, typename Proc>
-        void send(Msg&& msg, SslEnabled, Proc onSent);
+        EnqueueResult send(Msg&& msg, SslEnabled, Proc onSent);
 
         void stop(Promise<void> disconnectedPromise)
         {
@@ -173,19 +174,33 @@ namespace qi
     public:
       /// If `onReceive` returns `false`, this stops the message receiving.
       ///
+      /// If `receiveChunkSize` is not null, the socket is read by chunks of
+      /// this size (see `ReceiveMessageChunked`). Otherwise, messages are read
+      /// one at a time (see `ReceiveMessageContinuous`).
+      ///
       /// Procedure<bool (ErrorCode<N>, const Message*)> Proc
       template<typename Proc>
       Connected(const SocketPtr<N>&, SslEnabled ssl, size_t maxPayload, const Proc& onReceive,
-        qi::int64_t messageHandlingTimeoutInMus = getSocketTimeWarnThresholdFromEnv().value_or(0));
+        qi::int64_t messageHandlingTimeoutInMus = getSocketTimeWarnThresholdFromEnv().value_or(0),
+        size_t receiveChunkSize = getReceiveChunkSizeFromEnv());
 
       /// If `onSent` returns false, the processing of enqueued messages stops.
       ///
+      /// The message may be discarded if the send queue is full (see
+      /// `SendQueueLimits`).
+      ///
       /// Procedure<bool (ErrorCode<N>, std::list<Message>::const_iterator)>
       template<typename Msg, typename Proc = NoOpProcedure<bool (ErrorCode<N>, std::list<Message>::const_iterator)>>
-      void send(Msg&& msg, SslEnabled ssl, const Proc& onSent = {true})
+      EnqueueResult send(Msg&& msg, SslEnabled ssl, const Proc& onSent = {true})
       {
         return _impl->send(std::forward<Msg>(msg), ssl, onSent);
       }
+      /// By default, the limits are taken from the environment (see
+      /// `getSendQueueLimitsFromEnv`).
+      void setSendQueueLimits(const SendQueueLimits& limits)
+      {
+        _impl->_sendMsg.setQueueLimits(limits);
+      }
       Future<ConnectedResult<N>> complete() const
       {
         return _impl->_completePromise->future();
@@ -198,6 +213,11 @@ namespace qi
       {
         _impl->stop(disconnectedPromise);
       }
+      /// Histogram of the number of messages sent per network write.
+      const SendBatchHistogram& sendBatchSizeHistogram() const
+      {
+        return _impl->_sendMsg.batchSizeHistogram();
+      }
       template<typename Proc>
       auto ioServiceStranded(Proc&& p)
         -> decltype(StrandTransfo<N>{&_impl->socket()->get_io_service()}(std::forward<Proc>(p)))
@@ -209,17 +229,18 @@ namespace qi
     template<typename N>
     template<typename Proc>
     Connected<N>::Connected(const SocketPtr<N>& socket, SslEnabled ssl, size_t maxPayload,
-        const Proc& onReceive, qi::int64_t messageHandlingTimeoutInMus)
-      : _impl(std::make_shared<Impl>(socket))
+        const Proc& onReceive, qi::int64_t messageHandlingTimeoutInMus, size_t receiveChunkSize)
+      : _impl(std::make_shared<Impl>(socket, receiveChunkSize))
     {
       _impl->start(ssl, maxPayload, onReceive, messageHandlingTimeoutInMus);
     }
 
     template<typename N>
-    Connected<N>::Impl::Impl(const SocketPtr<N>& s)
+    Connected<N>::Impl::Impl(const SocketPtr<N>& s, size_t receiveChunkSize)
       : _result{s}
       , _stopRequested(false)
-      , _sendMsg{s}
+      , _receiveMsgChunked{receiveChunkSize}
+      , _sendMsg{s, getSendBatchLimitsFromEnv(), getSendQueueLimitsFromEnv()}
     {
     }
 
@@ -255,34 +276,45 @@ namespace qi
         qi::int64_t messageHandlingTimeoutInMus)
     {
       auto self = shared_from_this();
-      _receiveMsg(socket(), ssl, maxPayload,
-        [=](sock::ErrorCode<N> e, const Message* msg) mutable { // onReceived
-          const bool mustContinue = onReceive(e, msg);
-          if (!mustContinue)
-          {
-            self->setPromise(e, msg);
-            return false; // We must not continue to receive messages.
-          }
-          return true; // Otherwise, we continue to receive messages.
-        },
-        dataBoundTransfo(shared_from_this()), // lifetimeTransfo
-        StrandTransfo<N>{&(*socket()).get_io_service()} // syncTransfo
-      );
+      auto onReceived = [=](sock::ErrorCode<N> e, const Message* msg) mutable {
+        const bool mustContinue = onReceive(e, msg);
+        if (!mustContinue)
+        {
+          self->setPromise(e, msg);
+          return false; // We must not continue to receive messages.
+        }
+        return true; // Otherwise, we continue to receive messages.
+      };
+      auto lifetimeTransfo = dataBoundTransfo(shared_from_this());
+      auto syncTransfo = StrandTransfo<N>{&(*socket()).get_io_service()};
+      if (_receiveMsgChunked.chunkSize() != 0u)
+      {
+        _receiveMsgChunked(socket(), ssl, maxPayload, onReceived, lifetimeTransfo, syncTransfo);
+      }
+      else
+      {
+        _receiveMsg(socket(), ssl, maxPayload, onReceived, lifetimeTransfo, syncTransfo);
+      }
     }
 
     template<typename N>
     Connected<N>::Impl::~Impl()
     {
+      if (_sendMsg.batchLimits().enabled())
+      {
+        qiLogVerbose(logCategory()) << socket().get() << ": messages per write: "
+          << _sendMsg.batchSizeHistogram();
+      }
     }
 
     template<typename N>
     template<typename Msg, typename Proc>
-    void Connected<N>::Impl::send(Msg&& msg, SslEnabled ssl, Proc onSent)
+    EnqueueResult Connected<N>::Impl::send(Msg&& msg, SslEnabled ssl, Proc onSent)
     {
       using SendMessage = decltype(_sendMsg);
       using ReadableMessage = typename SendMessage::ReadableMessage;
       auto self = shared_from_this();
-      _sendMsg(std::forward<Msg>(msg), ssl,
+      return _sendMsg(std::forward<Msg>(msg), ssl,
         [=](const ErrorCode<N>& e, const ReadableMessage& ptrMsg) mutable { // onSent
           const bool mustContinue = onSent(e, ptrMsg);
           if (!mustContinue)
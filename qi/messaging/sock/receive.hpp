@@ -8,8 +8,11 @@
 #include <qi/messaging/sock/common.hpp>
 #include "src/messaging/message.hpp"
 #include <qi/trackable.hpp>
+#include <qi/assert.hpp>
 #include <qi/log.hpp>
 #include <qi/macroregular.hpp>
+#include <cstring>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
 
@@ -254,8 +257,10 @@ namespace qi { namespace sock {
         [=](ErrorCode<N> erc, const Message* m) mutable -> boost::optional<Message*> {
           if (onReceive(erc, m))
           {
-            // Must continue.
-            _msg.buffer().clear();
+            // Must continue. The handlers may have kept copies of the
+            // message, which share its header and buffer: read the next one
+            // in a new message instead of overwriting them.
+            _msg = Message();
             return {&_msg};
           }
           return {};
@@ -304,6 +309,323 @@ namespace qi { namespace sock {
       destroy();
     }
   };
+
+  /// Size in bytes of the per-socket buffer used to receive messages in chunks
+  /// (see `ReceiveMessageChunked`).
+  ///
+  /// Uses the environment variable QI_MESSAGE_RECEIVE_CHUNK_SIZE, if set.
+  /// A value of 0 (the default) means that messages are received one at a time,
+  /// with a read for the header and a read for the payload (see
+  /// `ReceiveMessageContinuous`).
+  size_t getReceiveChunkSizeFromEnv(size_t defaultValue = 0);
+
+  /// Fixed-size storage in which the network writes raw bytes, and from which
+  /// complete messages are extracted.
+  ///
+  /// Bytes are appended at the end of the readable area and consumed from its
+  /// beginning. When there is not enough free space at the end, the readable
+  /// bytes are moved to the front of the storage.
+  ///
+  /// The storage is allocated once, at construction.
+  class ReceiveChunkBuffer
+  {
+    std::vector<unsigned char> _storage;
+    std::size_t _begin;
+    std::size_t _end;
+  public:
+  // Regular:
+    explicit ReceiveChunkBuffer(std::size_t capacity = 0)
+      : _storage(capacity)
+      , _begin(0)
+      , _end(0)
+    {
+    }
+    QI_GENERATE_FRIEND_REGULAR_OPS_3(ReceiveChunkBuffer, _storage, _begin, _end)
+  // Custom:
+    std::size_t capacity() const
+    {
+      return _storage.size();
+    }
+
+    /// Readable bytes.
+    const unsigned char* data() const
+    {
+      return _storage.data() + _begin;
+    }
+    std::size_t size() const
+    {
+      return _end - _begin;
+    }
+
+    /// Precondition: n <= size()
+    void consume(std::size_t n)
+    {
+      _begin += n;
+      if (_begin == _end)
+      {
+        reset();
+      }
+    }
+
+    /// Free space, in which the network can write.
+    /// Readable bytes are first moved to the front of the storage, if needed.
+    unsigned char* prepare()
+    {
+      if (_begin != 0)
+      {
+        std::memmove(_storage.data(), _storage.data() + _begin, size());
+        _end -= _begin;
+        _begin = 0;
+      }
+      return _storage.data() + _end;
+    }
+    std::size_t freeSize() const
+    {
+      return _storage.size() - _end;
+    }
+
+    /// Makes readable `n` bytes written by the network in the free space.
+    /// Precondition: n <= freeSize()
+    void commit(std::size_t n)
+    {
+      _end += n;
+    }
+
+    void reset()
+    {
+      _begin = _end = 0;
+    }
+  };
+
+  namespace detail
+  {
+    /// Holds the state shared by all the steps of the chunked receive loop.
+    ///
+    /// The message is reused for all received messages: once a message has
+    /// been handled, its buffer is cleared but keeps its memory.
+    struct ReceiveChunkState
+    {
+      ReceiveChunkBuffer buffer;
+      Message msg;
+    };
+
+    /// Receive loop reading the socket by large chunks.
+    ///
+    /// Each read gets as many bytes as available in the free space of the
+    /// chunk buffer, then all complete messages it contains are extracted and
+    /// handled, without any additional read.
+    /// Only the bytes of a message that is too big to fit in the chunk buffer
+    /// are read directly into the message.
+    ///
+    /// Network N,
+    /// Mutable<SslSocket<N>> S,
+    /// Procedure<bool (ErrorCode<N>, const Message*)> Proc,
+    /// Transformation<Procedure> F0,
+    /// Transformation<Procedure<void (Args...)>> F1
+    template<typename N, typename S, typename Proc, typename F0, typename F1>
+    struct ReceiveChunkLoop
+    {
+      S socket;
+      ReceiveChunkState* state;
+      SslEnabled ssl;
+      size_t maxPayload;
+      Proc onReceive;
+      F0 lifetimeTransfo;
+      F1 syncTransfo;
+
+      template<typename B, typename H>
+      void asyncRead(const B& buffer, H handler)
+      {
+        if (*ssl)
+        {
+          N::async_read(*socket, buffer, syncTransfo(handler));
+        }
+        else
+        {
+          N::async_read((*socket).next_layer(), buffer, syncTransfo(handler));
+        }
+      }
+
+      void readSome()
+      {
+        auto& buf = state->buffer;
+        auto chunk = N::buffer(buf.prepare(), buf.freeSize());
+        auto self = *this;
+        auto onRead = lifetimeTransfo([=](ErrorCode<N> erc, std::size_t len) mutable {
+          if (erc)
+          {
+            self.fail(erc);
+            return;
+          }
+          self.state->buffer.commit(len);
+          self.extractMessages();
+        });
+        if (*ssl)
+        {
+          N::async_read_some(*socket, chunk, syncTransfo(onRead));
+        }
+        else
+        {
+          N::async_read_some((*socket).next_layer(), chunk, syncTransfo(onRead));
+        }
+      }
+
+      /// Returns true if the message receiving must continue.
+      bool handleMessage()
+      {
+        auto& msg = state->msg;
+        if (!onReceive(success<ErrorCode<N>>(), &msg))
+        {
+          return false;
+        }
+        // The handlers may have kept copies sharing the message.
+        msg = Message();
+        return true;
+      }
+
+      void fail(const ErrorCode<N>& erc)
+      {
+        if (onReceive(erc, nullptr))
+        {
+          state->buffer.reset();
+          state->msg = Message();
+          readSome();
+        }
+      }
+
+      void extractMessages()
+      {
+        static const auto headerSize = sizeof(MessagePrivate::MessageHeader);
+        auto& buf = state->buffer;
+        auto& msg = state->msg;
+        while (buf.size() >= headerSize)
+        {
+          MessagePrivate::MessageHeader header;
+          std::memcpy(&header, buf.data(), headerSize);
+          if (header.magic != MessagePrivate::magic)
+          {
+            qiLogWarning(logCategory()) << &(*socket) << ": Incorrect magic from "
+              << (*socket).lowest_layer().remote_endpoint().address().to_string()
+              << " (expected " << MessagePrivate::magic
+              << ", got " << header.magic << ").";
+            fail(fault<ErrorCode<N>>());
+            return;
+          }
+          const size_t payload = header.size;
+          if (payload > maxPayload)
+          {
+            qiLogWarning(logCategory()) << "Receiving message of size " << payload
+              << " above maximum configured payload size " << maxPayload <<
+                 " (configure with environment variable QI_MAX_MESSAGE_PAYLOAD).";
+            fail(messageSize<ErrorCode<N>>());
+            return;
+          }
+          const size_t available = buf.size() - headerSize;
+          if (available < payload)
+          {
+            if (headerSize + payload <= buf.capacity())
+            {
+              // The message will fit once we have read more bytes.
+              break;
+            }
+            // The message is bigger than the chunk buffer: we move what we
+            // already have into the message and read the rest directly into it.
+            msg._p->header = header;
+            auto p = static_cast<unsigned char*>(msg._p->buffer.reserve(payload));
+            std::memcpy(p, buf.data() + headerSize, available);
+            buf.reset();
+            auto self = *this;
+            asyncRead(N::buffer(p + available, payload - available),
+              lifetimeTransfo([=](ErrorCode<N> erc, std::size_t /*len*/) mutable {
+                if (erc)
+                {
+                  self.fail(erc);
+                  return;
+                }
+                if (self.handleMessage())
+                {
+                  self.readSome();
+                }
+              }));
+            return;
+          }
+          msg._p->header = header;
+          if (payload != 0u)
+          {
+            std::memcpy(msg._p->buffer.reserve(payload), buf.data() + headerSize, payload);
+          }
+          buf.consume(headerSize + payload);
+          if (!handleMessage())
+          {
+            return;
+          }
+        }
+        readSome();
+      }
+    };
+  } // namespace detail
+
+  /// Receive continuously messages until told to stop, by reading the socket
+  /// by large chunks.
+  ///
+  /// The semantics is the same as `ReceiveMessageContinuous`, but instead of
+  /// performing a read for the header and another one for the payload of
+  /// each message, the socket is read by chunks of up to `chunkSize` bytes
+  /// into a buffer allocated once. All the complete messages contained in a
+  /// chunk are then handled in sequence, so that a burst of small messages
+  /// only costs one read.
+  ///
+  /// Message payloads are copied from the chunk buffer into a reused message,
+  /// whose buffer keeps its memory between messages. Therefore, once the
+  /// largest payload has been received, handling a message does not allocate.
+  /// Messages bigger than the chunk buffer are read directly into the message.
+  ///
+  /// The same lifetime considerations as for `ReceiveMessageContinuous` apply.
+  ///
+  /// Example: receiving messages by chunks of 64 KiB until an error occurs
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// ReceiveMessageChunked<N> c{65536};
+  /// c(socket, SslEnabled{false}, maxPayload,
+  ///   [=](Error e, const Message* msgPtr) mutable {
+  ///     if (e) {
+  ///       // treat error
+  ///       return false; // Stop receiving messages.
+  ///     }
+  ///     // use msgPtr
+  ///     return true; // Continue receiving messages.
+  ///   });
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// Network N
+  template<typename N>
+  class ReceiveMessageChunked
+  {
+    detail::ReceiveChunkState _state;
+  public:
+  // Custom:
+    /// Precondition: chunkSize >= sizeof(MessagePrivate::MessageHeader)
+    explicit ReceiveMessageChunked(std::size_t chunkSize = 0)
+      : _state{ReceiveChunkBuffer{chunkSize}, Message{}}
+    {
+    }
+    std::size_t chunkSize() const
+    {
+      return _state.buffer.capacity();
+    }
+  // Procedure:
+    /// Mutable<SslSocket<N>> S,
+    /// Procedure<bool (ErrorCode<N>, const Message*)> Proc,
+    /// Transformation<Procedure> F0,
+    /// Transformation<Procedure<void (Args...)>> F1
+    template<typename S, typename Proc, typename F0 = IdTransfo, typename F1 = IdTransfo>
+    void operator()(const S& socket, SslEnabled ssl, size_t maxPayload,
+        Proc onReceive, const F0& lifetimeTransfo = {}, const F1& syncTransfo = {})
+    {
+      QI_ASSERT(_state.buffer.capacity() >= sizeof(MessagePrivate::MessageHeader));
+      detail::ReceiveChunkLoop<N, S, Proc, F0, F1>{socket, &_state, ssl, maxPayload,
+        onReceive, lifetimeTransfo, syncTransfo}.readSome();
+    }
+  };
 }} // namespace qi::sock
 
 #endif // _QI_SOCK_RECEIVE_HPP
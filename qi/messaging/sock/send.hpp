@@ -2,18 +2,24 @@
 #ifndef _QI_SOCK_SEND_HPP
 #define _QI_SOCK_SEND_HPP
 #include <atomic>
+#include <chrono>
+#include <mutex>
 #include <vector>
 #include <list>
+#include <array>
+#include <ostream>
 #include <stdexcept>
 #include <sstream>
 #include <boost/thread/synchronized_value.hpp>
 #include <boost/core/ignore_unused.hpp>
+#include <boost/optional.hpp>
 #include <qi/messaging/sock/concept.hpp>
 #include <qi/messaging/sock/traits.hpp>
 #include <qi/messaging/sock/option.hpp>
 #include <qi/messaging/sock/error.hpp>
 #include <qi/messaging/sock/common.hpp>
 #include <qi/trackable.hpp>
+#include <qi/async.hpp>
 #include <qi/future.hpp>
 #include <qi/scoped.hpp>
 #include <qi/atomic.hpp>
@@ -24,18 +30,32 @@
 
 namespace qi { namespace sock {
 
-  /// Make network buffers for the given message.
+  /// Number of network buffers needed to send the given message.
   ///
-  /// One buffer is for the header and the other one is for data.
+  /// One buffer is for the header, and for data, one buffer per subbuffer and
+  /// one buffer per chunk of data around a subbuffer.
+  inline std::size_t bufferCount(const Message& msg)
+  {
+    return 1 + 2 * msg.buffer().subBuffers().size() + 1;
+  }
+
+  /// Number of bytes sent on the network for the given message.
+  inline std::size_t wireSize(const Message& msg)
+  {
+    return sizeof(MessagePrivate::MessageHeader) + msg.buffer().totalSize();
+  }
+
+  /// Append to `buffers` the network buffers for the given message.
+  ///
+  /// The network buffers refer to the message memory: no data is copied.
   ///
   /// Network N
   template<typename N>
-  std::vector<ConstBuffer<N>> makeBuffers(const Message& msg)
+  void appendBuffers(std::vector<ConstBuffer<N>>& buffers, const Message& msg)
   {
     // header buffer
     ConstBuffer<N> headerBuffer = N::buffer(static_cast<const void*>(msg._p->getHeader()),
       sizeof(MessagePrivate::MessageHeader));
-    std::vector<ConstBuffer<N>> buffers;
     msg._p->complete();
     const auto& msgBuffer = msg.buffer();
 
@@ -52,7 +72,6 @@ namespace qi { namespace sock {
     // Memory layout for a buffer with 2 subbuffers:
     // (low address)                                                         (high address)
     // |header|buffer_part_0|size_subbuffer_0|buffer_part_1|size_subbuffer_1|buffer_part_2|
-    buffers.reserve(1 + 2 * msgBuffer.subBuffers().size() + 1);
     buffers.push_back(headerBuffer);
 
     decltype(msgBuffer.size()) beginOffset = 0;
@@ -73,6 +92,19 @@ namespace qi { namespace sock {
     // end of main buffer
     buffers.push_back(N::buffer(
       static_cast<const char*>(msgBuffer.data()) + beginOffset, msgBuffer.size() - beginOffset));
+  }
+
+  /// Make network buffers for the given message.
+  ///
+  /// One buffer is for the header and the others are for data.
+  ///
+  /// Network N
+  template<typename N>
+  std::vector<ConstBuffer<N>> makeBuffers(const Message& msg)
+  {
+    std::vector<ConstBuffer<N>> buffers;
+    buffers.reserve(bufferCount(msg));
+    appendBuffers<N>(buffers, msg);
     return buffers;
   }
 
@@ -130,6 +162,246 @@ namespace qi { namespace sock {
     }
   }
 
+  /// Send a batch of consecutive messages through the socket with a single
+  /// write, and call the handler when the operation is complete, successfully
+  /// or not.
+  ///
+  /// The network buffers of all messages are gathered in a single
+  /// scatter-gather write. No message data is copied.
+  ///
+  /// If the handler returns a new batch, it is immediately sent.
+  ///
+  /// Precondition: The `count` messages starting at `cptrMsg` must be valid
+  ///   until the handler has been called.
+  ///
+  /// Precondition: This function must not be called while messages are already
+  ///   being sent. It is possible to call it again only once the handler has
+  ///   been called.
+  ///
+  /// Network N,
+  /// Mutable<SslSocket<N>> S,
+  /// ForwardIterator<Readable<Message>> I,
+  /// Procedure<Optional<std::pair<I, std::size_t>> (ErrorCode<N>, I, std::size_t)> Proc,
+  /// Transformation<Procedure> F0,
+  /// Transformation<Procedure<void (Args...)>> F1
+  template<typename N, typename S, typename I, typename Proc, typename F0 = IdTransfo, typename F1 = IdTransfo>
+  void sendMessageBatch(const S& socket, I cptrMsg, std::size_t count, Proc onSent, SslEnabled ssl,
+      F0 lifetimeTransfo = {}, F1 syncTransfo = {})
+  {
+    std::vector<ConstBuffer<N>> buffers;
+    {
+      std::size_t n = 0;
+      auto it = cptrMsg;
+      for (std::size_t i = 0; i != count; ++i, ++it) n += bufferCount(*it);
+      buffers.reserve(n);
+      it = cptrMsg;
+      for (std::size_t i = 0; i != count; ++i, ++it) appendBuffers<N>(buffers, *it);
+    }
+    auto writeCont = lifetimeTransfo([=](ErrorCode<N> erc, size_t /*len*/) mutable {
+      if (auto optionalNextBatch = onSent(erc, cptrMsg, count))
+      {
+        sendMessageBatch<N>(socket, optionalNextBatch->first, optionalNextBatch->second,
+          onSent, ssl, lifetimeTransfo, syncTransfo);
+      }
+    });
+    if (*ssl)
+    {
+      N::async_write(*socket, std::move(buffers), syncTransfo(writeCont));
+    }
+    else
+    {
+      N::async_write((*socket).next_layer(), std::move(buffers), syncTransfo(writeCont));
+    }
+  }
+
+  /// Limits of the batches of messages sent with a single write by
+  /// `SendMessageEnqueue`.
+  ///
+  /// A batch always contains at least one message, even if this message alone
+  /// exceeds the limits.
+  /// A null `maxBytes` disables batching: each message is sent with its own
+  /// write.
+  struct SendBatchLimits
+  {
+    /// Conservative value for the maximum number of buffers of a
+    /// scatter-gather write (IOV_MAX is 1024 on Linux, 16 on some systems).
+    static const std::size_t defaultMaxBuffers = 64;
+
+    std::size_t maxBytes;
+    std::size_t maxBuffers;
+  // Regular:
+    SendBatchLimits(std::size_t maxBytes = 0, std::size_t maxBuffers = defaultMaxBuffers)
+      : maxBytes(maxBytes)
+      , maxBuffers(maxBuffers)
+    {
+    }
+    QI_GENERATE_FRIEND_REGULAR_OPS_2(SendBatchLimits, maxBytes, maxBuffers)
+  // Custom:
+    bool enabled() const
+    {
+      return maxBytes != 0u;
+    }
+  };
+
+  /// Uses the environment variables QI_MESSAGE_SEND_BATCH_MAX_BYTES and
+  /// QI_MESSAGE_SEND_BATCH_MAX_BUFFERS, if set.
+  /// By default, batching is disabled.
+  SendBatchLimits getSendBatchLimitsFromEnv();
+
+  /// Histogram of the number of messages sent per write.
+  ///
+  /// Bucket `i` counts the writes of [2^i, 2^(i+1)) messages. The last bucket
+  /// also counts all the bigger writes.
+  ///
+  /// Recording and reading are thread-safe.
+  class SendBatchHistogram
+  {
+  public:
+    static const std::size_t bucketCount = 8;
+
+    SendBatchHistogram()
+    {
+      for (auto& c: _counts) c.store(0u);
+    }
+
+    void record(std::size_t batchSize)
+    {
+      std::size_t bucket = 0;
+      while (batchSize > 1u && bucket + 1 < bucketCount)
+      {
+        batchSize >>= 1;
+        ++bucket;
+      }
+      _counts[bucket].fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    std::array<qi::uint64_t, bucketCount> counts() const
+    {
+      std::array<qi::uint64_t, bucketCount> res;
+      for (std::size_t i = 0; i != bucketCount; ++i)
+        res[i] = _counts[i].load(std::memory_order_relaxed);
+      return res;
+    }
+
+    /// Total number of writes recorded.
+    qi::uint64_t writeCount() const
+    {
+      qi::uint64_t n = 0;
+      for (const auto& c: _counts) n += c.load(std::memory_order_relaxed);
+      return n;
+    }
+  private:
+    std::array<std::atomic<qi::uint64_t>, bucketCount> _counts;
+  };
+
+  /// Outputs the histogram, for example: "1: 12, 2-3: 4, 4-7: 0, ..., 128+: 0".
+  inline std::ostream& operator<<(std::ostream& o, const SendBatchHistogram& h)
+  {
+    const auto counts = h.counts();
+    for (std::size_t i = 0; i != counts.size(); ++i)
+    {
+      const std::size_t low = std::size_t(1) << i;
+      if (i != 0) o << ", ";
+      if (i + 1 == counts.size()) o << low << "+";
+      else if (low == 1u) o << low;
+      else o << low << "-" << (2 * low - 1);
+      o << ": " << counts[i];
+    }
+    return o;
+  }
+
+  /// What `SendMessageEnqueue` does with a one-way message (an event or a post)
+  /// that would exceed the limits of its send queue.
+  ///
+  /// The other messages (calls, replies, errors, cancelations, capabilities)
+  /// always are queued: someone waits for them or for their answer.
+  enum class SendQueuePolicy
+  {
+    /// The message is deferred until the queue has room, for at most the
+    /// block timeout of the limits, then it is rejected. The sender is not
+    /// blocked: it is given a future of the enqueuing (see `EnqueueResult`).
+    Block,
+    /// The message is rejected.
+    Fail,
+    /// The oldest queued one-way messages are dropped to make room, the new
+    /// one being dropped last.
+    DropOldestEvents,
+    /// The queued events of the same service, object and signal as a new
+    /// event, if any, are dropped and the new one is queued at the end, so that
+    /// only the latest value is sent. Posts are queued anyway.
+    ConflateEvents,
+  };
+
+  /// Limits of the messages queued by `SendMessageEnqueue`, not counting the
+  /// ones being written.
+  ///
+  /// An empty queue always accepts a message, even if this message alone
+  /// exceeds the limits. A null limit is no limit, so that by default the
+  /// queue is unbounded.
+  ///
+  /// Only one-way messages are subject to the limits, but all the queued
+  /// messages count.
+  struct SendQueueLimits
+  {
+    std::size_t maxBytes;
+    std::size_t maxMessages;
+    SendQueuePolicy policy;
+    std::chrono::milliseconds blockTimeout;
+  // Regular:
+    SendQueueLimits(std::size_t maxBytes = 0, std::size_t maxMessages = 0,
+                    SendQueuePolicy policy = SendQueuePolicy::Fail,
+                    std::chrono::milliseconds blockTimeout = std::chrono::seconds{5})
+      : maxBytes(maxBytes)
+      , maxMessages(maxMessages)
+      , policy(policy)
+      , blockTimeout(blockTimeout)
+    {
+    }
+    QI_GENERATE_FRIEND_REGULAR_OPS_4(SendQueueLimits, maxBytes, maxMessages, policy, blockTimeout)
+  // Custom:
+    bool enabled() const
+    {
+      return maxBytes != 0u || maxMessages != 0u;
+    }
+  };
+
+  /// Uses the environment variables QI_MESSAGE_SEND_QUEUE_MAX_BYTES,
+  /// QI_MESSAGE_SEND_QUEUE_MAX_MESSAGES, QI_MESSAGE_SEND_QUEUE_BLOCK_TIMEOUT
+  /// (in milliseconds) and QI_MESSAGE_SEND_QUEUE_POLICY (one of `block`,
+  /// `fail`, `drop-oldest-events` and `conflate-events`), if set.
+  /// By default, send queues are unbounded.
+  SendQueueLimits getSendQueueLimitsFromEnv();
+
+  /// Outcome of the enqueuing of a message by `SendMessageEnqueue`.
+  struct EnqueueResult
+  {
+    enum class Status
+    {
+      /// The message will be sent.
+      Queued,
+      /// The message waits for room in the send queue (see `deferred`).
+      Deferred,
+      /// The message has been discarded by the policy.
+      Dropped,
+      /// The message has been refused: the sender must be told.
+      Rejected,
+    };
+    Status status;
+    /// Number of messages that were already queued and have been removed from
+    /// the queue by the policy, including the conflated ones.
+    std::size_t droppedCount;
+    /// If the message is deferred, set when it is put in the send queue, or
+    /// in error if it is rejected. Not part of the value of the result.
+    boost::optional<Future<void>> deferred;
+  // Regular:
+    EnqueueResult(Status status = Status::Queued, std::size_t droppedCount = 0)
+      : status(status)
+      , droppedCount(droppedCount)
+    {
+    }
+    QI_GENERATE_FRIEND_REGULAR_OPS_2(EnqueueResult, status, droppedCount)
+  };
+
   /// Functor that sends messages through a socket.
   ///
   /// The role of this type is to provide a queue for messages.
@@ -155,6 +427,20 @@ namespace qi { namespace sock {
   /// A sync procedure transformation can also be provided to wrap any
   /// callback passed to the network. A typical use is to strand the callback.
   ///
+  /// If batching is enabled (see `SendBatchLimits`), all the messages enqueued
+  /// when a write completes are sent with a single scatter-gather write, within
+  /// the given limits (see `sendMessageBatch`). The callback is still called
+  /// once per message. The number of messages per write is recorded in a
+  /// histogram.
+  ///
+  /// If the send queue is bounded (see `SendQueueLimits`), a one-way message
+  /// that would exceed the limits is handled according to the policy of the
+  /// limits. The messages being written are never discarded. The sender is
+  /// never blocked: it may be the thread that drains the queue.
+  /// The messages deferred by the Block policy are rejected by a timer at
+  /// their deadline if the queue has had no room, and all of them are rejected
+  /// if a write fails or the instance is destroyed.
+  ///
   /// Network N, Mutable<SslSocket<N>> S
   template<typename N, typename S = boost::shared_ptr<SslSocket<N>>>
   struct SendMessageEnqueue
@@ -162,13 +448,32 @@ namespace qi { namespace sock {
     using ReadableMessage = std::list<Message>::const_iterator;
     SendMessageEnqueue()
       : _sending{false}
+      , _timerGeneration(0)
+      , _inFlightCount(0)
+      , _waitingBytes(0)
     {
     }
-    explicit SendMessageEnqueue(const S& socket)
+    explicit SendMessageEnqueue(const S& socket, SendBatchLimits batchLimits = {},
+                                SendQueueLimits queueLimits = {})
       : _socket(socket)
       , _sending{false}
+      , _timerGeneration(0)
+      , _batchLimits(batchLimits)
+      , _queueLimits(queueLimits)
+      , _inFlightCount(0)
+      , _waitingBytes(0)
     {
     }
+    /// Rejects the deferred messages. The timer callback is canceled, but the
+    /// instance must still outlive it if it has already started (see
+    /// `lifetimeTransfo`).
+    ~SendMessageEnqueue()
+    {
+      DeferredOutcomes outcomes;
+      auto reportOutcomes = scoped([&] { outcomes.report(); });
+      std::lock_guard<std::mutex> lock{_sendMutex};
+      abortDeferred(outcomes);
+    }
   // Procedure:
     /// Message Msg,
     /// Procedure<bool (ErrorCode<N>, Readable<Message>)> Proc,
@@ -177,9 +482,285 @@ namespace qi { namespace sock {
     template<typename Msg,
              typename Proc = NoOpProcedure<bool (ErrorCode<N>, ReadableMessage)>,
              typename F0 = IdTransfo, typename F1 = IdTransfo>
-    void operator()(Msg&&, SslEnabled, Proc onSent = Proc{true},
+    EnqueueResult operator()(Msg&&, SslEnabled, Proc onSent = Proc{true},
       const F0& lifetimeTransfo = F0{}, const F1& syncTransfo = F1{});
+
+    const SendBatchLimits& batchLimits() const
+    {
+      return _batchLimits;
+    }
+    SendQueueLimits queueLimits()
+    {
+      std::lock_guard<std::mutex> lock{_sendMutex};
+      return _queueLimits;
+    }
+    /// Applies to the messages enqueued from now on.
+    void setQueueLimits(const SendQueueLimits& limits)
+    {
+      std::lock_guard<std::mutex> lock{_sendMutex};
+      _queueLimits = limits;
+    }
+    const SendBatchHistogram& batchSizeHistogram() const
+    {
+      return _batchSizeHistogram;
+    }
   private:
+    /// A one-way message waiting for room in the send queue.
+    struct DeferredMessage
+    {
+      Message message;
+      std::chrono::steady_clock::time_point deadline;
+      Promise<void> promise;
+    };
+
+    /// Outcomes of deferred messages, reported once the send mutex is released
+    /// because the continuations of the futures may send messages.
+    struct DeferredOutcomes
+    {
+      std::vector<Promise<void>> queued;
+      std::vector<Promise<void>> rejected;
+      std::vector<Promise<void>> aborted;
+
+      void report()
+      {
+        for (auto& promise : queued)
+          promise.setValue(nullptr);
+        for (auto& promise : rejected)
+          promise.setError("The send queue has had no room before the block timeout.");
+        for (auto& promise : aborted)
+          promise.setError("The messages of the send queue can no longer be sent.");
+      }
+    };
+
+    /// Number of messages, from the beginning of the send queue, that fit in
+    /// the batch limits. At least one message is returned.
+    ///
+    /// Precondition: The send mutex is locked and the send queue is not empty.
+    std::size_t nextBatchSize() const
+    {
+      std::size_t count = 0, bytes = 0, buffers = 0;
+      for (const auto& m: _sendQueue)
+      {
+        const auto msgBytes = wireSize(m);
+        const auto msgBuffers = bufferCount(m);
+        if (count != 0 && (bytes + msgBytes > _batchLimits.maxBytes
+                           || buffers + msgBuffers > _batchLimits.maxBuffers))
+          break;
+        ++count;
+        bytes += msgBytes;
+        buffers += msgBuffers;
+      }
+      return count;
+    }
+
+    /// Whether the message is subject to the limits of the queue: only one-way
+    /// messages are, nobody waits for them.
+    static bool isOneWay(const Message& msg)
+    {
+      return msg.type() == Message::Type_Event || msg.type() == Message::Type_Post;
+    }
+
+    /// Whether the message is an event of the same signal as `event`.
+    static bool isSameSignalEvent(const Message& msg, const Message& event)
+    {
+      return msg.type() == Message::Type_Event && msg.service() == event.service()
+          && msg.object() == event.object() && msg.function() == event.function();
+    }
+
+    /// Precondition: The send mutex is locked.
+    bool fitsInQueue(const Message& msg) const
+    {
+      // The messages being written do not count.
+      const std::size_t queued = _sendQueue.size() - _inFlightCount;
+      if (queued == 0u)
+        return true;
+      return (_queueLimits.maxMessages == 0u || queued + 1 <= _queueLimits.maxMessages)
+          && (_queueLimits.maxBytes == 0u
+              || _waitingBytes + wireSize(msg) <= _queueLimits.maxBytes);
+    }
+
+    /// Marks the first `count` messages of the send queue as being written.
+    ///
+    /// Precondition: The send mutex is locked and no message is being written.
+    void startWriting(std::size_t count)
+    {
+      auto it = _sendQueue.begin();
+      for (std::size_t i = 0; i != count; ++i, ++it)
+        _waitingBytes -= wireSize(*it);
+      _inFlightCount = count;
+    }
+
+    /// Precondition: The send mutex is locked.
+    std::list<Message>::iterator firstWaiting()
+    {
+      return std::next(_sendQueue.begin(), _inFlightCount);
+    }
+
+    /// Precondition: The send mutex is locked.
+    std::list<Message>::iterator eraseWaiting(std::list<Message>::iterator it)
+    {
+      _waitingBytes -= wireSize(*it);
+      return _sendQueue.erase(it);
+    }
+
+    /// Moves the deferred messages to the end of the send queue, in order, as
+    /// long as they fit, or all of them if `all` is true. The ones whose block
+    /// timeout has passed are rejected instead.
+    ///
+    /// Precondition: The send mutex is locked.
+    void admitDeferred(DeferredOutcomes& outcomes, bool all)
+    {
+      const auto now = std::chrono::steady_clock::now();
+      while (!_deferred.empty())
+      {
+        auto& deferred = _deferred.front();
+        if (deferred.deadline <= now)
+          outcomes.rejected.push_back(deferred.promise);
+        else if (all || fitsInQueue(deferred.message))
+        {
+          _waitingBytes += wireSize(deferred.message);
+          _sendQueue.push_back(std::move(deferred.message));
+          outcomes.queued.push_back(deferred.promise);
+        }
+        else
+          break;
+        _deferred.pop_front();
+      }
+      if (_deferred.empty())
+        cancelDeferredTimer();
+    }
+
+    /// Rejects the deferred messages whose block timeout has passed, wherever
+    /// they are in the list.
+    ///
+    /// Precondition: The send mutex is locked.
+    void rejectExpiredDeferred(DeferredOutcomes& outcomes)
+    {
+      const auto now = std::chrono::steady_clock::now();
+      for (auto it = _deferred.begin(); it != _deferred.end();)
+      {
+        if (it->deadline <= now)
+        {
+          outcomes.rejected.push_back(it->promise);
+          it = _deferred.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+
+    /// Rejects all the deferred messages and cancels the timer: they cannot be
+    /// sent anymore.
+    ///
+    /// Precondition: The send mutex is locked.
+    void abortDeferred(DeferredOutcomes& outcomes)
+    {
+      for (auto& deferred : _deferred)
+        outcomes.aborted.push_back(deferred.promise);
+      _deferred.clear();
+      cancelDeferredTimer();
+    }
+
+    /// Precondition: The send mutex is locked.
+    void cancelDeferredTimer()
+    {
+      if (!_timerDeadline)
+        return;
+      // A callback that could not be canceled does nothing.
+      ++_timerGeneration;
+      _timerDeadline = boost::none;
+      _deferredTimer.cancel();
+    }
+
+    /// Arms the timer at the earliest deadline of the deferred messages, unless
+    /// it is already armed at this deadline or before. The callback is wrapped
+    /// with the transformations given to the call operator.
+    ///
+    /// Precondition: The send mutex is locked.
+    template<typename F0, typename F1>
+    void armDeferredTimer(const F0& lifetimeTransfo, const F1& syncTransfo)
+    {
+      if (_deferred.empty())
+        return;
+      auto deadline = _deferred.front().deadline;
+      for (const auto& deferred : _deferred)
+        deadline = std::min(deadline, deferred.deadline);
+      if (_timerDeadline && *_timerDeadline <= deadline)
+        return;
+      cancelDeferredTimer();
+      const auto generation = _timerGeneration;
+      _timerDeadline = deadline;
+      auto syncTransfoCopy = syncTransfo;
+      auto onTimeout = syncTransfoCopy(lifetimeTransfo([=]() mutable {
+        DeferredOutcomes outcomes;
+        auto reportOutcomes = scoped([&] { outcomes.report(); });
+        std::lock_guard<std::mutex> lock{_sendMutex};
+        if (generation != _timerGeneration)
+          return;
+        _timerDeadline = boost::none;
+        rejectExpiredDeferred(outcomes);
+        armDeferredTimer(lifetimeTransfo, syncTransfo);
+      }));
+      const auto delay = std::max(deadline - std::chrono::steady_clock::now(),
+                                  std::chrono::steady_clock::duration::zero());
+      _deferredTimer = qi::asyncDelay(std::move(onTimeout),
+        qi::Duration(std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count()));
+    }
+
+    /// Applies the policy of the queue limits to a one-way message that does
+    /// not fit, or that must wait for the deferred ones. Returns the result to
+    /// report if the message must not be queued now. `droppedCount` is
+    /// increased by the number of queued messages that are removed.
+    ///
+    /// Precondition: The send mutex is locked and a message is being sent.
+    boost::optional<EnqueueResult> makeRoom(const Message& msg, std::size_t& droppedCount)
+    {
+      using Status = EnqueueResult::Status;
+      switch (_queueLimits.policy)
+      {
+      case SendQueuePolicy::Block:
+      {
+        Promise<void> promise;
+        _deferred.push_back(DeferredMessage{msg,
+          std::chrono::steady_clock::now() + _queueLimits.blockTimeout, promise});
+        EnqueueResult result{Status::Deferred, droppedCount};
+        result.deferred = promise.future();
+        return result;
+      }
+      case SendQueuePolicy::Fail:
+        return EnqueueResult{Status::Rejected};
+      case SendQueuePolicy::DropOldestEvents:
+        for (auto it = firstWaiting(); it != _sendQueue.end() && !fitsInQueue(msg);)
+        {
+          if (isOneWay(*it))
+          {
+            it = eraseWaiting(it);
+            ++droppedCount;
+          }
+          else
+            ++it;
+        }
+        if (!fitsInQueue(msg))
+          return EnqueueResult{Status::Dropped, droppedCount};
+        return {};
+      case SendQueuePolicy::ConflateEvents:
+        if (msg.type() != Message::Type_Event)
+          return {};
+        for (auto it = firstWaiting(); it != _sendQueue.end();)
+        {
+          if (isSameSignalEvent(*it, msg))
+          {
+            it = eraseWaiting(it);
+            ++droppedCount;
+          }
+          else
+            ++it;
+        }
+        return {};
+      }
+      return {};
+    }
+
     S _socket;
     /// A list is used because we need the iterators not to be invalidated by
     /// insertions at begin or end, which is not the case with deque.
@@ -187,6 +768,22 @@ namespace qi { namespace sock {
     std::list<Message> _sendQueue;
     bool _sending;
     std::mutex _sendMutex;
+    /// Messages deferred by the Block policy, in order.
+    std::list<DeferredMessage> _deferred;
+    /// Rejects the deferred messages at their deadline.
+    Future<void> _deferredTimer;
+    boost::optional<std::chrono::steady_clock::time_point> _timerDeadline;
+    /// Incremented each time the timer is replaced or canceled.
+    std::size_t _timerGeneration;
+    SendBatchLimits _batchLimits;
+    SendBatchHistogram _batchSizeHistogram;
+    SendQueueLimits _queueLimits;
+    /// Number of messages, from the beginning of the send queue, that are
+    /// being written.
+    std::size_t _inFlightCount;
+    /// Total wire size of the messages of the send queue that are not being
+    /// written.
+    std::size_t _waitingBytes;
   };
 
   // Lemma SendMessageEnqueue.0:
@@ -197,15 +794,39 @@ namespace qi { namespace sock {
   //  The send queue is a list so adding an element doesn't invalidate the other ones.
   template<typename N, typename S>
   template<typename Msg, typename Proc, typename F0, typename F1>
-  void SendMessageEnqueue<N, S>::operator()(Msg&& msg, SslEnabled ssl, Proc onSent,
+  EnqueueResult SendMessageEnqueue<N, S>::operator()(Msg&& msg, SslEnabled ssl, Proc onSent,
       const F0& lifetimeTransfo, const F1& syncTransfo)
   {
     qiLogDebug(logCategory()) << _socket.get() << " SendMessageEnqueue()(" << msg.type() << ": " << msg.address() << ", ssl=" << *ssl << ")";
     using I = decltype(_sendQueue.begin());
     I itMsg;
+    std::size_t batchSize = 1;
+    std::size_t droppedCount = 0;
     bool mustStartSendLoop = false;
+    DeferredOutcomes outcomes;
+    auto reportOutcomes = scoped([&] { outcomes.report(); });
     {
-      std::lock_guard<std::mutex> lock{_sendMutex};
+      std::unique_lock<std::mutex> lock{_sendMutex};
+      // If nothing is being sent, the queue will not drain: the deferred
+      // messages are queued.
+      admitDeferred(outcomes, !_sending);
+      // Nothing is discarded if the queue will not drain, and a one-way message
+      // is not sent before the deferred ones.
+      if (_queueLimits.enabled() && _sending && isOneWay(msg)
+          && (!fitsInQueue(msg) || !_deferred.empty()))
+      {
+        if (auto result = makeRoom(msg, droppedCount))
+        {
+          if (result->status == EnqueueResult::Status::Deferred)
+            armDeferredTimer(lifetimeTransfo, syncTransfo);
+          qiLogDebug(logCategory()) << _socket.get() << " Send queue full, message "
+            << msg.address() << (result->status == EnqueueResult::Status::Rejected ? " rejected"
+                                 : result->status == EnqueueResult::Status::Dropped ? " dropped"
+                                 : " deferred");
+          return *result;
+        }
+      }
+      _waitingBytes += wireSize(msg);
       _sendQueue.emplace_back(std::forward<Msg>(msg));
       itMsg = _sendQueue.begin();
       // We've just added a message to the queue, so if we are not currently sending,
@@ -214,9 +835,76 @@ namespace qi { namespace sock {
       {
         _sending = true;
         mustStartSendLoop = true;
+        if (_batchLimits.enabled())
+        {
+          batchSize = nextBatchSize();
+        }
+        startWriting(batchSize);
       }
     }
-    if (mustStartSendLoop)
+    if (mustStartSendLoop && _batchLimits.enabled())
+    {
+      // Same reasoning as for the unbatched case below (see lemmas
+      // SendMessageEnqueue.1 and SendMessageEnqueue.2), applied to all the
+      // messages of the batch.
+      auto eraseAndReturnNextBatch =
+        [&, onSent](ErrorCode<N> erc, I itSent, std::size_t count) mutable
+          -> boost::optional<std::pair<I, std::size_t>> {
+          // As for a single message, the loop stops if onSent throws.
+          bool mustContinue = false;
+          boost::optional<std::pair<I, std::size_t>> next;
+          DeferredOutcomes outcomes;
+          try
+          {
+            auto reportOutcomes = scoped([&] { outcomes.report(); });
+            // A scoped is used to cope with potential exception thrown by onSent.
+            auto scopedErase = scoped([&, itSent]() mutable {
+              std::lock_guard<std::mutex> lock{_sendMutex};
+              for (std::size_t i = 0; i != count; ++i)
+                itSent = _sendQueue.erase(itSent);
+              _inFlightCount = 0;
+              if (erc)
+                abortDeferred(outcomes);
+              admitDeferred(outcomes, false);
+              if (!mustContinue || _sendQueue.empty())
+              {
+                QI_ASSERT(_sending);
+                if (!_sending)
+                  qiLogWarning(logCategory()) << "SendMessageEnqueue: sending flag should be raised.";
+                _sending = false;
+                return;
+              }
+              const auto n = nextBatchSize();
+              _batchSizeHistogram.record(n);
+              startWriting(n);
+              // The messages being written do not count anymore.
+              admitDeferred(outcomes, false);
+              next = std::make_pair(_sendQueue.begin(), n);
+            });
+            // All the messages of the batch have been written, so the handler
+            // is called for each of them, even if one asks to stop. The loop
+            // continues only if all of them returned true.
+            auto it = itSent;
+            bool allContinue = true;
+            for (std::size_t i = 0; i != count; ++i, ++it)
+            {
+              const bool c = onSent(erc, it);
+              allContinue = allContinue && c;
+            }
+            mustContinue = allContinue;
+          }
+          catch (const std::exception& e)
+          {
+            qiLogError(logCategory()) << "Error in post-send phase: " << e.what();
+            throw;
+          }
+          return next;
+        };
+      _batchSizeHistogram.record(batchSize);
+      sendMessageBatch<N>(_socket, itMsg, batchSize, std::move(eraseAndReturnNextBatch), ssl,
+        lifetimeTransfo, syncTransfo);
+    }
+    else if (mustStartSendLoop)
     {
       // Lemma SendMessageEnqueue.1:
       //  When calling sendMessage, itMsg is still valid.
@@ -242,12 +930,19 @@ namespace qi { namespace sock {
           // It's ok to allow new sendings once the current one is complete.
           bool mustContinue = false;
           boost::optional<I> itNext;
+          DeferredOutcomes outcomes;
           try
           {
+            auto reportOutcomes = scoped([&] { outcomes.report(); });
             // A scoped is used to cope with potential exception thrown by onSent.
             auto scopedErase = scoped([&] {
               std::lock_guard<std::mutex> lock{_sendMutex};
               _sendQueue.erase(itSent);
+              _inFlightCount = 0;
+              // The socket is failing: the deferred messages would never fit.
+              if (erc)
+                abortDeferred(outcomes);
+              admitDeferred(outcomes, false);
               if (!mustContinue || _sendQueue.empty())
               {
                 QI_ASSERT(_sending);
@@ -256,7 +951,11 @@ namespace qi { namespace sock {
                 _sending = false;
                 return;
               }
+              startWriting(1u);
+              // The message being written does not count anymore.
+              admitDeferred(outcomes, false);
               itNext = _sendQueue.begin();
+              _batchSizeHistogram.record(1u);
             });
             mustContinue = onSent(erc, itSent);
           }
@@ -267,9 +966,11 @@ namespace qi { namespace sock {
           }
           return itNext;
         };
+      _batchSizeHistogram.record(1u);
       sendMessage<N>(_socket, itMsg, std::move(eraseAndReturnNextMessage), ssl,
         lifetimeTransfo, syncTransfo);
     }
+    return EnqueueResult{EnqueueResult::Status::Queued, droppedCount};
   }
 
   /// Functor that sends messages and tracks the object's lifetime.
@@ -297,14 +998,14 @@ namespace qi { namespace sock {
   // Procedure:
     /// Message Msg, Procedure<void (ErrorCode<N>, Readable<Message>)> Proc, Transformation<Procedure<void (Args...)>> F
     template<typename Msg, typename Proc = NoOpProcedure<void (ErrorCode<N>, ReadableMessage)>, typename F = IdTransfo>
-    void operator()(Msg&& m, SslEnabled ssl, Proc onSent = Proc{}, F syncTransfo = F{})
+    EnqueueResult operator()(Msg&& m, SslEnabled ssl, Proc onSent = Proc{}, F syncTransfo = F{})
     {
       auto lifetimeTransfo = trackWithFallbackTransfo([=]() mutable {
           onSent(operationAborted<ErrorCode<N>>(), {});
         },
         this
       );
-      _sendMsg(std::forward<Msg>(m), ssl, onSent, lifetimeTransfo, syncTransfo);
+      return _sendMsg(std::forward<Msg>(m), ssl, onSent, lifetimeTransfo, syncTransfo);
     }
   private:
     SendMessageEnqueue<N, S> _sendMsg;
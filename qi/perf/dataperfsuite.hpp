@@ -40,6 +40,15 @@ namespace qi
       /// Overloading used to print data out.
       DataPerfSuite& operator<<(const DataPerf& data);
 
+      /// Compares the next results to the ones of a file written by a
+      /// previous run. A result worse than its baseline by more than the
+      /// tolerance, relative to the baseline, is reported as a regression.
+      /// Returns false if the file cannot be read.
+      bool setBaseline(const std::string& filename, double tolerance = 0.1);
+
+      /// Number of results reported as regressions.
+      unsigned int regressionCount() const;
+
       /// Print end of file and close it.
       void close();
 
@@ -11,6 +11,7 @@
 #include <qi/messaging/serviceinfo.hpp>
 #include <qi/messaging/authproviderfactory.hpp>
 #include <qi/messaging/clientauthenticatorfactory.hpp>
+#include <qi/messaging/connectionmetrics.hpp>
 #include <qi/future.hpp>
 #include <qi/anyobject.hpp>
 #include <boost/shared_ptr.hpp>
@@ -65,6 +66,13 @@ namespace qi {
     //Server
     qi::FutureSync<void> listen(const qi::Url &address);
     std::vector<qi::Url> endpoints() const;
+
+    /// Returns a snapshot of the traffic counters of every established
+    /// connection of the session, incoming and outgoing.
+    ///
+    /// If QI_CONNECTION_METRICS_PERIOD is set to a number of seconds, the
+    /// snapshot is also logged with this period.
+    std::vector<ConnectionMetrics> connectionMetrics() const;
     bool    setIdentity(const std::string& key, const std::string& crt);
 
     //close both client and server side
@@ -276,6 +276,14 @@ namespace qi {
 
     SignalSubscriber setCallType(MetaCallType ct);
 
+    /** Declares whether the handler may modify its arguments, which is the
+     * case if it takes them by non-const reference. The asynchronous calls
+     * of the handlers which do not modify them share a single copy of the
+     * arguments of an emission, the other handlers get their own copy. False
+     * by default, set by the typed connect() overloads.
+     */
+    SignalSubscriber setReadOnlyArguments(bool readOnly);
+
     /// @return the identifier of the subscription (aka link)
     SignalLink link() const;
     operator SignalLink() const;
@@ -288,7 +296,11 @@ namespace qi {
   private:
     std::shared_ptr<SignalSubscriberPrivate> _p;
 
-    void callImpl(const GenericFunctionParameters& args);
+    /// Same as call(), asynchronous calls of handlers with read-only arguments
+    /// share `asyncArgs`, which is set to a copy of `args` by the first one.
+    void call(const GenericFunctionParameters& args, MetaCallType callType,
+              std::shared_ptr<GenericFunctionParameters>& asyncArgs) const;
+    void callImpl(const GenericFunctionParameters& args) const;
 
   public:
     QI_API_DEPRECATED_MSG("please use link() instead or cast to qi::SignalLink")
@@ -315,6 +327,8 @@ namespace qi {
     //   Mode 1: Direct functor call
     AnyFunction handler;
     MetaCallType threadingModel = MetaCallType_Direct;
+    // Set if the handler does not modify its arguments.
+    bool readOnlyArguments = false;
 
     //   Mode 2: metaCall
     boost::scoped_ptr<AnyWeakObject> target;
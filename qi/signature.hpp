@@ -143,6 +143,8 @@ namespace qi {
     float isConvertibleTo(const Signature& b) const;
 
     static Signature fromType(Type t);
+  private:
+    float computeConvertibility(const Signature& b) const;
   protected:
     // C4251
     boost::shared_ptr<SignaturePrivate> _p;
@@ -10,6 +10,8 @@
 
 # include <sstream>
 # include <algorithm>
+# include <array>
+# include <atomic>
 
 namespace qi
 {
@@ -51,6 +53,17 @@ namespace qi
         _maxValue = (std::max)(_maxValue, val);
       }
     }
+    /**
+     * \brief Add the values pushed to another instance, as if they had been
+     *        pushed to this one. Both instances must have been pushed to.
+     * \param other Instance to merge.
+     */
+    void merge(const MinMaxSum& other)
+    {
+      _cumulatedValue += other._cumulatedValue;
+      _minValue = (std::min)(_minValue, other._minValue);
+      _maxValue = (std::max)(_maxValue, other._maxValue);
+    }
     /// Reset all three values to 0
     void reset()
     {
@@ -74,6 +87,165 @@ namespace qi
     float _cumulatedValue;
   };
 
+  /// Stores percentiles of durations, in seconds
+  class LatencyPercentiles
+  {
+  public:
+    /// Default constructor
+    LatencyPercentiles() : _p50(0), _p90(0), _p99(0), _p999(0) {}
+    /**
+     * \brief Constructor
+     * \param p50 Median.
+     * \param p90 90th percentile.
+     * \param p99 99th percentile.
+     * \param p999 99.9th percentile.
+     */
+    LatencyPercentiles(float p50, float p90, float p99, float p999)
+      : _p50(p50), _p90(p90), _p99(p99), _p999(p999)
+    {}
+
+    /// Get median
+    const float& p50()  const { return _p50;}
+    /// Get 90th percentile
+    const float& p90()  const { return _p90;}
+    /// Get 99th percentile
+    const float& p99()  const { return _p99;}
+    /// Get 99.9th percentile
+    const float& p999() const { return _p999;}
+  private:
+    float _p50;
+    float _p90;
+    float _p99;
+    float _p999;
+  };
+
+  /**
+   * \brief Log-bucketed histogram of durations.
+   *
+   * Durations are counted in microseconds, in buckets whose width is a
+   * sixteenth of the power of two they belong to. Percentiles are thus known
+   * with a relative error below 6.25%, from 1us to 19 hours, in a fixed amount
+   * of memory.
+   *
+   * Durations may be pushed concurrently, and while the histogram is read.
+   */
+  class LatencyHistogram
+  {
+  public:
+    /// Constructor
+    LatencyHistogram()
+    {
+      reset();
+    }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * \brief Count a new duration.
+     * \param seconds Duration in seconds. Longer durations than the range of
+     *        the histogram are counted in its last bucket.
+     */
+    void push(float seconds)
+    {
+      _buckets[bucketIndex(seconds)].fetch_add(1u, std::memory_order_relaxed);
+    }
+    /// Get number of durations counted
+    unsigned int count() const
+    {
+      unsigned int n = 0;
+      for (const auto& bucket : _buckets)
+        n += bucket.load(std::memory_order_relaxed);
+      return n;
+    }
+    /**
+     * \brief Get the duration below which a fraction of the durations fall.
+     * \param fraction Fraction of the durations, 0.99 for the 99th percentile.
+     * \return The upper bound in seconds of the bucket of the percentile,
+     *         or 0 if no duration was counted.
+     */
+    float percentile(float fraction) const
+    {
+      return percentile(counts(), fraction);
+    }
+    /// Get p50, p90, p99 and p999 in seconds
+    LatencyPercentiles percentiles() const
+    {
+      const Counts c = counts();
+      return LatencyPercentiles(percentile(c, 0.5f), percentile(c, 0.9f),
+                                percentile(c, 0.99f), percentile(c, 0.999f));
+    }
+    /// Forget all durations counted
+    void reset()
+    {
+      for (auto& bucket : _buckets)
+        bucket.store(0u, std::memory_order_relaxed);
+    }
+  private:
+    enum
+    {
+      SubBucketBits = 4,
+      SubBucketCount = 1 << SubBucketBits,
+      // 2^36us is about 19 hours
+      MaxExponent = 35,
+      BucketCount = (MaxExponent - SubBucketBits + 2) * SubBucketCount
+    };
+    using Counts = std::array<unsigned int, BucketCount>;
+
+    Counts counts() const
+    {
+      Counts c;
+      for (unsigned int i = 0; i < BucketCount; ++i)
+        c[i] = _buckets[i].load(std::memory_order_relaxed);
+      return c;
+    }
+
+    static float percentile(const Counts& counts, float fraction)
+    {
+      double total = 0;
+      for (unsigned int n : counts)
+        total += n;
+      if (total == 0)
+        return 0;
+      const double rank = (std::max)(1.0, (double)fraction * total);
+      double seen = 0;
+      for (unsigned int i = 0; i < BucketCount; ++i)
+      {
+        seen += counts[i];
+        if (seen >= rank)
+          return (float)bucketUpperBound(i) / 1e6f;
+      }
+      return (float)bucketUpperBound(BucketCount - 1) / 1e6f;
+    }
+
+    static unsigned int bucketIndex(float seconds)
+    {
+      const double us = (double)seconds * 1e6;
+      if (!(us > 0))
+        return 0;
+      const unsigned long long maxUs = (2ULL << MaxExponent) - 1;
+      const unsigned long long value =
+          us >= (double)maxUs ? maxUs : (unsigned long long)us;
+      if (value < SubBucketCount)
+        return (unsigned int)value;
+      unsigned int exponent = SubBucketBits;
+      while (value >> (exponent + 1))
+        ++exponent;
+      const unsigned int sub = (unsigned int)(value >> (exponent - SubBucketBits)) & (SubBucketCount - 1);
+      return (exponent - SubBucketBits + 1) * SubBucketCount + sub;
+    }
+
+    static unsigned long long bucketUpperBound(unsigned int index)
+    {
+      if (index < SubBucketCount)
+        return index;
+      const unsigned int shift = index / SubBucketCount - 1;
+      const unsigned long long low = (unsigned long long)(SubBucketCount + index % SubBucketCount) << shift;
+      return low + (1ULL << shift) - 1;
+    }
+
+    std::array<std::atomic<unsigned int>, BucketCount> _buckets;
+  };
+
   /// Store statistics about method calls.
   class MethodStatistics
   {
@@ -109,6 +281,25 @@ namespace qi
       _system.push(system, _count==0);
       ++_count;
     }
+    /**
+     * \brief Add the values pushed to another instance, as if they had been
+     *        pushed to this one.
+     * \param other Instance to merge.
+     */
+    void merge(const MethodStatistics& other)
+    {
+      if (other._count == 0)
+        return;
+      if (_count == 0)
+      {
+        *this = other;
+        return;
+      }
+      _wall.merge(other._wall);
+      _user.merge(other._user);
+      _system.merge(other._system);
+      _count += other._count;
+    }
     /**
      * \brief Get wall MinMaxSum value.
      * \return Return MinMaxSum value.
@@ -7,7 +7,6 @@
 #ifndef _QI_STRAND_HPP_
 #define _QI_STRAND_HPP_
 
-#include <deque>
 #include <atomic>
 #include <qi/assert.hpp>
 #include <qi/detail/executioncontext.hpp>
@@ -42,26 +41,39 @@ public:
   enum class State;
 
   struct Callback;
-
-  using Queue = std::deque<boost::shared_ptr<Callback>>;
+  struct Job;
 
   qi::ExecutionContext& _eventLoop;
   std::atomic<unsigned int> _curId;
   std::atomic<unsigned int> _aliveCount;
-  bool _processing; // protected by mutex, no need for atomic
   std::atomic<int> _processingThread;
   boost::recursive_mutex _mutex;
   boost::condition_variable_any _processFinished;
-  bool _dying;
-  Queue _queue;
+  std::atomic<bool> _dying;
+
+  // Multiple producers single consumer queue of jobs: producers push after
+  // _queueHead, process() pops after _queueTail, which is an empty node.
+  std::atomic<Job*> _queueHead;
+  Job* _queueTail;
+  // Number of jobs pushed or being pushed and not processed yet. The producer
+  // that increments it from 0 schedules process(), which runs until it goes
+  // back to 0.
+  std::atomic<unsigned int> _queuedCount;
+  // Nodes released by process(), producers take them all at once.
+  std::atomic<Job*> _freeJobs;
+  // Number of nodes of _freeJobs, which process() keeps below a bound.
+  std::atomic<int> _freeJobCount;
 
   StrandPrivate(qi::ExecutionContext& eventLoop);
+  ~StrandPrivate();
 
   Future<void> asyncAtImpl(boost::function<void()> cb, qi::SteadyClockTimePoint tp) override;
   Future<void> asyncDelayImpl(boost::function<void()> cb, qi::Duration delay) override;
 
   boost::shared_ptr<Callback> createCallback(boost::function<void()> cb);
   void enqueue(boost::shared_ptr<Callback> cbStruct);
+  // Enqueues a job which has no promise and cannot be canceled.
+  void enqueue(boost::function<void()> cb);
 
   void process();
   void cancel(boost::shared_ptr<Callback> cbStruct);
@@ -75,20 +87,14 @@ public:
   { QI_ASSERT(false); throw 0; }
   using ExecutionContext::async;
 private:
-  void stopProcess(boost::recursive_mutex::scoped_lock& lock,
-                   bool finished);
+  Job* allocateJob();
+  void releaseJob(Job* job);
+  void push(Job* job);
+  Job* pop();
+  void drainQueue();
+  void stopProcess();
 };
 
-inline StrandPrivate::StrandPrivate(qi::ExecutionContext& eventLoop)
-  : _eventLoop(eventLoop)
-  , _curId(0)
-  , _aliveCount(0)
-  , _processing(false)
-  , _processingThread(0)
-  , _dying(false)
-{
-}
-
 /** Class that schedules tasks sequentially
  *
  * A strand allows one to schedule work on an eventloop with the guaranty
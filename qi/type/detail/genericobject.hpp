@@ -10,9 +10,11 @@
 #include <map>
 #include <string>
 
+#include <boost/optional.hpp>
 #include <boost/smart_ptr/enable_shared_from_this.hpp>
 
 #include <qi/api.hpp>
+#include <qi/clock.hpp>
 #include <qi/type/detail/futureadapter.hpp>
 #include <qi/type/detail/manageable.hpp>
 #include <qi/future.hpp>
@@ -77,6 +79,21 @@ public:
    * @param returnSignature forces the return type if set.
    */
   qi::Future<AnyReference> metaCall(unsigned int method, const GenericFunctionParameters& params, MetaCallType callType = MetaCallType_Auto, Signature returnSignature = Signature());
+
+  /**
+   * Call a method dynamically, by method ID, giving up on it at a deadline.
+   *
+   * If the call is not finished at the deadline, its future is canceled: a
+   * queued call that has not started yet is dropped. Remote objects also
+   * send the deadline along with the call, so that the service stops
+   * working on it by itself.
+   * @param method method ID.
+   * @param params arguments to pass to the call.
+   * @param deadline time after which the result is not needed anymore.
+   * @param callType type of the call.
+   * @param returnSignature forces the return type if set.
+   */
+  qi::Future<AnyReference> metaCall(unsigned int method, const GenericFunctionParameters& params, SteadyClockTimePoint deadline, MetaCallType callType = MetaCallType_Auto, Signature returnSignature = Signature());
   //@}
 
   /// Find method named name callable with arguments parameters
@@ -158,6 +175,11 @@ namespace detail
 // Storage type used by Object<T>, and Proxy.
 using ManagedObjectPtr = boost::shared_ptr<class GenericObject>;
 
+/// Deadline of the metaCall of `target` being made by the calling thread, if
+/// any, for the object types that forward it. The calls made by the method of
+/// `target` while it runs have no deadline unless they are given one.
+QI_API boost::optional<SteadyClockTimePoint> currentCallDeadline(const GenericObject& target);
+
 }
 
 // C4251
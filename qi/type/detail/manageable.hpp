@@ -96,6 +96,12 @@ QI_TYPE_STRUCT_AGREGATE_CONSTRUCTOR(qi::MinMaxSum,
   ("maxValue",       maxValue),
   ("cumulatedValue", cumulatedValue));
 
+QI_TYPE_STRUCT_AGREGATE_CONSTRUCTOR(qi::LatencyPercentiles,
+  ("p50",  p50),
+  ("p90",  p90),
+  ("p99",  p99),
+  ("p999", p999));
+
 QI_TYPE_STRUCT_AGREGATE_CONSTRUCTOR(qi::MethodStatistics,
   ("count",  count),
   ("wall",   wall),
@@ -118,6 +124,8 @@ QI_TYPE_STRUCT(qi::os::timeval, tv_sec, tv_usec);
 namespace qi {
 
   using ObjectStatistics = std::map<unsigned int, MethodStatistics>;
+  /// Percentiles of the wall times of the methods of an object.
+  using ObjectLatencyStatistics = std::map<unsigned int, LatencyPercentiles>;
 /** Per-instance context.
   */
   class QI_API Manageable
@@ -145,11 +153,22 @@ namespace qi {
     bool isStatsEnabled() const;
     /// Set statistics gathering status
     void enableStats(bool enable);
-    /// Push statistics information about \p slotId.
+    /** Push statistics information about \p slotId.
+     *
+     * Statistics are accumulated per thread, and gathered when read.
+     */
     void pushStats(int slotId, float wallTime, float userTime, float systemTime);
     ObjectStatistics stats() const;
     /// Reset all statistical data
     void clearStats();
+    /// Return statistics gathered since the last reset, and reset them
+    ObjectStatistics snapshotStats();
+    /** Return percentiles of the wall times gathered since the last reset.
+     *
+     * Wall times are counted in one histogram per method, of about 2 KB,
+     * reset by clearStats() and snapshotStats().
+     */
+    ObjectLatencyStatistics latencyStats() const;
 
     /// Emitted each time a call starts and finishes, and for each signal trigger.
     Signal<EventTrace> traceObject;
@@ -61,6 +61,10 @@ namespace detail {
     {
       return go()->metaCall(method, params, callType, returnSignature);
     }
+    inline qi::Future<AnyReference> metaCall(unsigned int method, const GenericFunctionParameters& params, SteadyClockTimePoint deadline, MetaCallType callType = MetaCallType_Auto, Signature returnSignature=Signature()) const
+    {
+      return go()->metaCall(method, params, deadline, callType, returnSignature);
+    }
     inline int findMethod(const std::string& name, const GenericFunctionParameters& parameters) const
     {
       return go()->findMethod(name, parameters);
@@ -140,6 +144,14 @@ namespace detail {
     {
       return go()->clearStats();
     }
+    inline ObjectStatistics snapshotStats() const
+    {
+      return go()->snapshotStats();
+    }
+    inline ObjectLatencyStatistics latencyStats() const
+    {
+      return go()->latencyStats();
+    }
     inline bool isTraceEnabled() const
     {
       return go()->isTraceEnabled();
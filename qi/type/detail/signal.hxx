@@ -9,11 +9,36 @@
 
 #include <qi/trackable.hpp>
 #include <qi/type/detail/manageable.hpp>
+#include <type_traits>
 #include <boost/bind.hpp>
 #include <qi/type/detail/functionsignature.hxx>
 
 namespace qi
 {
+  namespace detail
+  {
+    /// True if one of the types is a reference or a pointer to non-const,
+    /// through which a function could modify its arguments.
+    template <typename... P>
+    struct HasMutableReference : std::false_type {};
+
+    template <typename H, typename... P>
+    struct HasMutableReference<H, P...>
+      : std::integral_constant<bool,
+          ((std::is_lvalue_reference<H>::value
+            && !std::is_const<typename std::remove_reference<H>::type>::value)
+           || (std::is_pointer<H>::value
+            && !std::is_const<typename std::remove_pointer<H>::type>::value))
+          || HasMutableReference<P...>::value>
+    {};
+
+    template <typename F>
+    struct HasMutableReferenceArgument : std::true_type {};
+
+    template <typename R, typename... P>
+    struct HasMutableReferenceArgument<R(P...)> : HasMutableReference<P...> {};
+  }
+
   template <typename T>
   template <typename F, typename Arg0, typename... Args>
   SignalSubscriber SignalF<T>::connect(F&& func, Arg0&& arg0, Args&&... args)
@@ -84,7 +109,9 @@ namespace qi
   template<typename F>
   SignalSubscriber SignalBase::connect(boost::function<F> fun)
   {
-    return connect(AnyFunction::from(std::move(fun)));
+    SignalSubscriber sub(AnyFunction::from(std::move(fun)));
+    sub.setReadOnlyArguments(!detail::HasMutableReferenceArgument<F>::value);
+    return connect(sub);
   }
   // TODO: taking by forward ref is too greedy and connect(SignalSubscriber) takes this overload
   // find a way to fix this
@@ -92,7 +119,9 @@ namespace qi
   template<typename F>
   SignalSubscriber SignalF<T>::connect(F c)
   {
-    SignalSubscriber sub = connect(qi::AnyFunction::from(boost::function<T>(std::move(c))));
+    SignalSubscriber sub(qi::AnyFunction::from(boost::function<T>(std::move(c))));
+    sub.setReadOnlyArguments(!detail::HasMutableReferenceArgument<T>::value);
+    sub = connect(sub);
     if (detail::IsAsyncBind<F>::value)
       sub.setCallType(MetaCallType_Direct);
     return sub;
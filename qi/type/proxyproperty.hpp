@@ -7,13 +7,66 @@
 #ifndef _QI_TYPE_PROXYPROPERTY_HPP_
 #define _QI_TYPE_PROXYPROPERTY_HPP_
 
+#include <cstdint>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <qi/log.hpp>
 #include <qi/property.hpp>
 #include <qi/anyfunction.hpp>
+#include <qi/anyvalue.hpp>
+#include <qi/clock.hpp>
 
 
 namespace qi
 {
+  namespace detail
+  {
+    /** Local copy of the value of a property of an object, kept up to date by
+     * a subscription to the property.
+     *
+     * There is at most one mirror per property of an object, shared by all
+     * the proxies mirroring it: a single subscription serves them all.
+     *
+     * If the subscription fails, the mirror is cleared and stores nothing
+     * anymore.
+     */
+    class QI_API PropertyMirror
+    {
+    public:
+      /// Returns the mirror of the property, creating it if needed.
+      static boost::shared_ptr<PropertyMirror> get(AnyObject object, const std::string& propertyName);
+      ~PropertyMirror();
+
+      /// Returns the value if it was stored less than `maxAge` ago.
+      boost::optional<AnyValue> value(Duration maxAge) const;
+      /// Number of values stored or cleared so far.
+      std::uint64_t version() const;
+      /// Stores a value set through a proxy.
+      void store(const AnyValue& value);
+      /// Stores a value read from the object, unless another one was stored
+      /// or the value was cleared since `version`.
+      void refresh(const AnyValue& value, std::uint64_t version);
+      /// Forgets the value, for example because the object cannot be reached.
+      void clear();
+
+    private:
+      PropertyMirror(AnyObject object, const std::string& propertyName);
+      void subscribe(const boost::shared_ptr<PropertyMirror>& self);
+      void storeLocked(const AnyValue& value);
+      void fail();
+
+      AnyWeakObject _object;
+      const std::string _propertyName;
+      mutable boost::mutex _mutex;
+      boost::optional<AnyValue> _value;
+      SteadyClock::time_point _stored;
+      std::uint64_t _version;
+      bool _failed;
+      Future<SignalLink> _link;
+    };
+  }
+
   /** Property proxy using AnyObject as backend
   * @warning reading and writing the property are synchronous operations
   * and might take time if backend object is a remote proxy.
@@ -24,13 +77,16 @@ namespace qi
   public:
     using SignalType = SignalF<void (const T&)>;
     using ThisProxyType = ProxyProperty;
-    ProxyProperty() {}
+    ProxyProperty()
+      : _mirrorMaxAge(Seconds(1))
+    {}
     /* The signal bounce code is completely duplicated from SignalProxy.
      * Unfortunately factoring this is not trivial:
      * onSubscribe needs to be passed to Signal constructor, and we want to keep
      * it that way.
     */
     ProxyProperty(AnyObject object, const std::string& propertyName)
+      : _mirrorMaxAge(Seconds(1))
     {
       setup(object, propertyName);
     }
@@ -39,9 +95,32 @@ namespace qi
     Future<void> onSubscribe(bool enable, GenericObject* object, const std::string& propertyName, SignalLink link);
     AnyReference bounceEvent(const AnyReferenceVector args);
     void triggerOverride(const GenericFunctionParameters& params, MetaCallType, GenericObject* object, const std::string& propertyName);
+
+    /** Answers get() from a local copy of the value, kept up to date by a
+     * subscription to the property, instead of reading it from the backend
+     * each time. The subscription is shared by all the mirrored proxies of the
+     * same property of the same backend object.
+     *
+     * The value is read from the backend again if it was last received more
+     * than `maxAge` ago, which bounds its staleness if notifications are lost
+     * or if the backend is disconnected. The mirror is cleared when reading
+     * from the backend fails.
+     *
+     * Must be called after setup(), before the proxy is used concurrently.
+     */
+    void enableMirror(Duration maxAge = Seconds(1));
+    void disableMirror();
+    /// Number of values received by the mirror, which changes when the
+    /// mirrored value does. 0 if the proxy is not mirrored.
+    std::uint64_t mirrorVersion() const;
   private:
     T getter(GenericObject* object, const std::string& propertyName);
     bool setter(T&, const T&, GenericObject* object, const std::string& propertyName);
+
+    AnyWeakObject _object;
+    std::string _propertyName;
+    boost::shared_ptr<detail::PropertyMirror> _mirror;
+    Duration _mirrorMaxAge;
   };
 
   template<typename T, template< class...> class PropertyType>
@@ -71,6 +150,10 @@ namespace qi
     SignalBase::setTriggerOverride(boost::bind(&ThisProxyType::triggerOverride, this, _1, _2,
       object.asGenericObject(), propertyName));
 
+    _object = object;
+    _propertyName = propertyName;
+    _mirror.reset();
+
     // property part
     this->_getter = boost::bind(&ThisProxyType::getter, this, object.asGenericObject(), propertyName);
     this->_setter = boost::bind(&ThisProxyType::setter, this, _1, _2, object.asGenericObject(), propertyName);
@@ -116,15 +199,53 @@ namespace qi
     object->metaPost(propertyName, params);
   }
   template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::enableMirror(Duration maxAge)
+  {
+    AnyObject object = _object.lock();
+    if (!object)
+      throw std::runtime_error("ProxyProperty::enableMirror: the proxy is not set up");
+    _mirror = detail::PropertyMirror::get(object, _propertyName);
+    _mirrorMaxAge = maxAge;
+  }
+  template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::disableMirror()
+  {
+    _mirror.reset();
+  }
+  template<typename T, template< class...> class PropertyType>
+  std::uint64_t ProxyProperty<T, PropertyType>::mirrorVersion() const
+  {
+    return _mirror ? _mirror->version() : 0u;
+  }
+  template<typename T, template< class...> class PropertyType>
   T ProxyProperty<T, PropertyType>::getter(GenericObject* object, const std::string& propertyName)
   {
-    return object->property<T>(propertyName);
+    if (!_mirror)
+      return object->property<T>(propertyName);
+    if (boost::optional<AnyValue> value = _mirror->value(_mirrorMaxAge))
+      return value->to<T>();
+    // Nothing received yet, or too long ago.
+    const std::uint64_t version = _mirror->version();
+    try
+    {
+      T value = object->property<T>(propertyName);
+      _mirror->refresh(AnyValue::from(value), version);
+      return value;
+    }
+    catch (...)
+    {
+      _mirror->clear();
+      throw;
+    }
   }
   template<typename T, template< class...> class PropertyType>
   bool ProxyProperty<T, PropertyType>::setter(T& target, const T& v, GenericObject* object, const std::string& propertyName)
   {
     // no need to fill target it's never used since we have a getter
     object->setProperty(propertyName, v).value(); // throw on remote error
+    // Read the value just set, without waiting for its notification.
+    if (_mirror)
+      _mirror->store(AnyValue::from(v));
     // Prevent local subscribers from being called
     return false;
   }
@@ -263,36 +263,6 @@ namespace qi {
     }
   }
 
-  class ScopedIncDec {
-  public:
-    ScopedIncDec(qi::Atomic<qi::uint64_t>& atom)
-      : _atom(atom)
-    {
-      ++_atom;
-    }
-
-    ~ScopedIncDec() {
-      --_atom;
-    }
-
-    qi::Atomic<qi::uint64_t>& _atom;
-  };
-
-  class ScopedExitDec {
-  public:
-    ScopedExitDec(qi::Atomic<qi::uint64_t>& atom)
-      : _atom(atom)
-    {
-    }
-
-    ~ScopedExitDec() {
-      --_atom;
-    }
-
-    qi::Atomic<qi::uint64_t>& _atom;
-  };
-
-
   void EventLoopAsio::invoke_maybe(boost::function<void()> f, qi::uint64_t id, qi::Promise<void> p, const boost::system::error_code& erc)
   {
     ScopedExitDec _(_totalTask);
@@ -408,8 +378,14 @@ namespace qi {
   }
 
   EventLoop::EventLoop(const std::string& name)
+  : EventLoop(name, Backend::Default)
+  {
+  }
+
+  EventLoop::EventLoop(const std::string& name, Backend backend)
   : _p(0)
   , _name(name)
+  , _backend(backend)
   {
   }
 
@@ -446,7 +422,19 @@ namespace qi {
     qiLogDebug() << this << " EventLoop start";
     if (_p)
       return;
-    _p = new EventLoopAsio();
+    Backend backend = _backend;
+    if (backend == Backend::Default)
+    {
+      const std::string envBackend = qi::os::getenv("QI_EVENTLOOP_BACKEND");
+      if (envBackend == "workstealing")
+        backend = Backend::WorkStealing;
+      else if (!envBackend.empty() && envBackend != "asio")
+        qiLogWarning() << "Unknown event loop backend " << envBackend << ", using asio";
+    }
+    if (backend == Backend::WorkStealing)
+      _p = new EventLoopWorkStealing();
+    else
+      _p = new EventLoopAsio();
     _p->_name = _name;
     _p->start(nthreads);
     qiLogDebug() << this << " EventLoop start done";
@@ -8,6 +8,9 @@
 #define _SRC_EVENTLOOP_P_HPP_
 
 #include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <boost/thread.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
@@ -36,6 +39,35 @@ namespace qi {
     Stream* sd;
   };
 
+  class ScopedIncDec {
+  public:
+    ScopedIncDec(qi::Atomic<qi::uint64_t>& atom)
+      : _atom(atom)
+    {
+      ++_atom;
+    }
+
+    ~ScopedIncDec() {
+      --_atom;
+    }
+
+    qi::Atomic<qi::uint64_t>& _atom;
+  };
+
+  class ScopedExitDec {
+  public:
+    ScopedExitDec(qi::Atomic<qi::uint64_t>& atom)
+      : _atom(atom)
+    {
+    }
+
+    ~ScopedExitDec() {
+      --_atom;
+    }
+
+    qi::Atomic<qi::uint64_t>& _atom;
+  };
+
   class EventLoopPrivate
   {
   public:
@@ -104,6 +136,73 @@ namespace qi {
     qi::Atomic<uint64_t> _totalTask;
     qi::Atomic<uint64_t> _activeTask;
   };
+
+  /// Thread pool with one task queue per worker thread.
+  ///
+  /// A task posted from a worker is queued in the queue of this worker, other
+  /// tasks are spread among the queues. A worker without tasks takes the tasks
+  /// of the others before going to sleep, so that the workers rarely contend
+  /// on the same queue.
+  ///
+  /// Timers and sockets use an EventLoopAsio. When a timer expires, its task
+  /// is queued in the workers.
+  class EventLoopWorkStealing final: public EventLoopPrivate
+  {
+  public:
+    EventLoopWorkStealing();
+    bool isInThisContext() override;
+    void start(int nthreads) override;
+    void join() override;
+    void stop() override;
+    qi::Future<void> asyncCall(qi::Duration delay,
+      boost::function<void ()> callback) override;
+    void post(qi::Duration delay,
+      const boost::function<void ()>& callback) override;
+    qi::Future<void> asyncCall(qi::SteadyClockTimePoint timepoint,
+        boost::function<void ()> callback) override;
+    void post(qi::SteadyClockTimePoint timepoint,
+        const boost::function<void ()>& callback) override;
+    void destroy() override;
+    void* nativeHandle() override;
+    void setMaxThreads(unsigned int max) override;
+  private:
+    struct Task;
+    struct Worker;
+
+    ~EventLoopWorkStealing() override;
+    void schedule(Task task);
+    bool popTask(Worker& worker, Task& task);
+    void waitForTask();
+    void invoke(Task& task);
+    qi::Future<void> asyncAt(qi::SteadyClockTimePoint timepoint,
+        boost::function<void ()> callback, qi::uint64_t id);
+    bool launchWorker();
+    void _runWorker(Worker* worker);
+    void _pingThread();
+
+    /// Runs the timers and the sockets.
+    EventLoopAsio* _io;
+    /// Created at start, for the maximal number of workers. Only the first
+    /// `_workerCount` ones have a thread.
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<unsigned int> _workerCount;
+    /// Queue of the next task posted from outside of the workers.
+    std::atomic<unsigned int> _nextWorker;
+    /// Number of tasks in the queues.
+    std::atomic<std::size_t> _queuedTasks;
+    std::atomic<unsigned int> _sleepingWorkers;
+    std::atomic<bool> _stopping;
+    boost::mutex _sleepMutex;
+    boost::condition_variable _taskQueued;
+    boost::condition_variable _stopped;
+    boost::mutex _threadsMutex;
+    std::vector<std::thread> _threads;
+    unsigned int _maxThreads;
+    boost::thread_specific_ptr<Worker> _currentWorker;
+
+    qi::Atomic<uint64_t> _totalTask;
+    qi::Atomic<uint64_t> _activeTask;
+  };
 }
 
 #endif  // _SRC_EVENTLOOP_P_HPP_
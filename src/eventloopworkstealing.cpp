@@ -0,0 +1,443 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+#include <deque>
+
+#include <boost/make_shared.hpp>
+#include <boost/optional.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+#include <qi/eventloop.hpp>
+#include <qi/future.hpp>
+#include <qi/getenv.hpp>
+
+#include "eventloop_p.hpp"
+#ifdef WITH_PROBES
+# include "tp_qi.h"
+#else
+# define tracepoint(...)
+#endif
+
+qiLogCategory("qi.eventloop");
+
+namespace qi {
+  struct EventLoopWorkStealing::Task
+  {
+    boost::function<void()> callback;
+    qi::uint64_t id;
+    /// Not set for the tasks that are posted.
+    boost::optional<qi::Promise<void>> promise;
+  };
+
+  struct EventLoopWorkStealing::Worker
+  {
+    explicit Worker(unsigned int index)
+      : index(index)
+      , size(0u)
+    {
+    }
+
+    const unsigned int index;
+    boost::mutex mutex;
+    std::deque<Task> tasks;
+    /// Size of `tasks`, readable without locking the mutex.
+    std::atomic<std::size_t> size;
+  };
+
+  using SteadyTimer = boost::asio::basic_waitable_timer<SteadyClock>;
+
+  static qi::Atomic<uint64_t> gTaskId{0};
+
+  // Number of times an idle worker looks for tasks before going to sleep.
+  static const int idleSpinCount = 64;
+
+  EventLoopWorkStealing::EventLoopWorkStealing()
+    : _io(new EventLoopAsio())
+    , _workerCount(0u)
+    , _nextWorker(0u)
+    , _queuedTasks(0u)
+    , _sleepingWorkers(0u)
+    , _stopping(false)
+    , _maxThreads(0)
+    , _currentWorker([](Worker*) {}) // workers are owned by _workers
+  {
+    _name = "workstealingeventloop";
+  }
+
+  EventLoopWorkStealing::~EventLoopWorkStealing()
+  {
+    stop();
+    join();
+    _io->destroy();
+  }
+
+  void EventLoopWorkStealing::start(int nthread)
+  {
+    if (!_workers.empty())
+      return;
+    if (nthread == 0)
+    {
+      nthread = boost::thread::hardware_concurrency();
+      if (nthread < 3)
+        nthread = 3;
+      const char* envNthread = getenv("QI_EVENTLOOP_THREAD_COUNT");
+      if (envNthread)
+        nthread = strtol(envNthread, 0, 0);
+    }
+    _maxThreads = qi::os::getEnvDefault("QI_EVENTLOOP_MAX_THREADS", 150);
+
+    // The workers cannot be reallocated once started, so create as many as
+    // the pool can grow to.
+    const unsigned int capacity = std::max(static_cast<unsigned int>(nthread),
+                                           _maxThreads ? _maxThreads : 150u);
+    _workers.resize(capacity);
+
+    _io->_name = _name + ".io";
+    _io->start(qi::os::getEnvDefault("QI_EVENTLOOP_IO_THREAD_COUNT", 2));
+    for (int i = 0; i < nthread; ++i)
+      launchWorker();
+    boost::mutex::scoped_lock lock(_threadsMutex);
+    _threads.emplace_back(&EventLoopWorkStealing::_pingThread, this);
+  }
+
+  bool EventLoopWorkStealing::launchWorker()
+  {
+    boost::mutex::scoped_lock lock(_threadsMutex);
+    const unsigned int index = _workerCount.load();
+    if (_stopping.load() || index == _workers.size())
+      return false;
+    _workers[index].reset(new Worker(index));
+    _threads.emplace_back(&EventLoopWorkStealing::_runWorker, this, _workers[index].get());
+    // Publishes the worker to the producers and the other workers.
+    _workerCount.store(index + 1);
+    return true;
+  }
+
+  void EventLoopWorkStealing::_runWorker(Worker* worker)
+  {
+    qiLogDebug() << this << " worker " << worker->index << " starting";
+    qi::os::setCurrentThreadName(_name);
+    _currentWorker.reset(worker);
+    Task task;
+    while (!_stopping.load())
+    {
+      if (!popTask(*worker, task))
+      {
+        waitForTask();
+        continue;
+      }
+      try
+      {
+        invoke(task);
+      }
+      catch (const detail::TerminateThread& /* e */)
+      {
+        break;
+      }
+      task = Task();
+    }
+    _currentWorker.reset();
+  }
+
+  bool EventLoopWorkStealing::popTask(Worker& worker, Task& task)
+  {
+    if (worker.size.load(std::memory_order_relaxed))
+    {
+      boost::mutex::scoped_lock lock(worker.mutex);
+      if (!worker.tasks.empty())
+      {
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+        --_queuedTasks;
+        return true;
+      }
+    }
+
+    // Steal from the back of the queues of the other workers, the owners take
+    // from the front.
+    const unsigned int count = _workerCount.load();
+    for (unsigned int i = 1; i < count; ++i)
+    {
+      Worker& victim = *_workers[(worker.index + i) % count];
+      if (!victim.size.load(std::memory_order_relaxed))
+        continue;
+      boost::mutex::scoped_lock lock(victim.mutex);
+      if (!victim.tasks.empty())
+      {
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        victim.size.store(victim.tasks.size(), std::memory_order_relaxed);
+        --_queuedTasks;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void EventLoopWorkStealing::waitForTask()
+  {
+    // Tasks often come in bursts: look again a few times before sleeping.
+    for (int i = 0; i < idleSpinCount; ++i)
+    {
+      if (_queuedTasks.load() || _stopping.load())
+        return;
+      std::this_thread::yield();
+    }
+
+    boost::mutex::scoped_lock lock(_sleepMutex);
+    // Producers increment the number of queued tasks before reading the
+    // number of sleeping workers: either they see this worker sleeping and
+    // wake it up, or this worker sees their task.
+    ++_sleepingWorkers;
+    while (!_queuedTasks.load() && !_stopping.load())
+      _taskQueued.wait(lock);
+    --_sleepingWorkers;
+  }
+
+  void EventLoopWorkStealing::schedule(Task task)
+  {
+    Worker* worker = _currentWorker.get();
+    if (!worker)
+    {
+      const unsigned int count = _workerCount.load();
+      worker = _workers[count ? _nextWorker.fetch_add(1u, std::memory_order_relaxed) % count : 0].get();
+    }
+    {
+      boost::mutex::scoped_lock lock(worker->mutex);
+      worker->tasks.push_back(std::move(task));
+      worker->size.store(worker->tasks.size(), std::memory_order_relaxed);
+    }
+    ++_queuedTasks;
+    if (_sleepingWorkers.load())
+    {
+      boost::mutex::scoped_lock lock(_sleepMutex);
+      _taskQueued.notify_one();
+    }
+  }
+
+  void EventLoopWorkStealing::invoke(Task& task)
+  {
+    ScopedExitDec _(_totalTask);
+    ScopedIncDec active(_activeTask);
+    tracepoint(qi_qi, eventloop_task_start, task.id);
+
+    try
+    {
+      task.callback();
+      tracepoint(qi_qi, eventloop_task_stop, task.id);
+      if (task.promise)
+        task.promise->setValue(0);
+    }
+    catch (const detail::TerminateThread& /* e */)
+    {
+      throw;
+    }
+    catch (const std::exception& ex)
+    {
+      tracepoint(qi_qi, eventloop_task_error, task.id);
+      if (task.promise)
+        task.promise->setError(ex.what());
+    }
+    catch (...)
+    {
+      tracepoint(qi_qi, eventloop_task_error, task.id);
+      if (task.promise)
+        task.promise->setError("unknown error");
+    }
+  }
+
+  void EventLoopWorkStealing::_pingThread()
+  {
+    qi::os::setCurrentThreadName("EvLoop.mon");
+    static unsigned int msTimeout = qi::os::getEnvDefault("QI_EVENTLOOP_PING_TIMEOUT", 500u);
+    static unsigned int msGrace = qi::os::getEnvDefault("QI_EVENTLOOP_GRACE_PERIOD", 0u);
+    static unsigned int maxTimeouts = qi::os::getEnvDefault("QI_EVENTLOOP_MAX_TIMEOUTS", 20u);
+    unsigned int nbTimeout = 0;
+    boost::mutex::scoped_lock lock(_sleepMutex);
+    while (!_stopping.load())
+    {
+      lock.unlock();
+      qiLogDebug() << "Ping";
+      auto calling = asyncCall(Seconds{0}, []{});
+      auto callState = calling.waitFor(MilliSeconds{msTimeout});
+      unsigned int sleepMs = msTimeout;
+      if (callState == FutureState_Running && !_stopping.load())
+      {
+        const bool limitReached = (_maxThreads && _workerCount.load() >= _maxThreads)
+            || !launchWorker();
+        if (limitReached)
+        {
+          ++nbTimeout;
+          qiLogInfo() << "Threadpool " << _name << " limit reached (" << nbTimeout
+                      << " timeouts, number of tasks: " << _totalTask.load()
+                      << ", number of active tasks: " << _activeTask.load()
+                      <<  ", number of threads: " << _workerCount.load() << ")";
+
+          if (nbTimeout >= maxTimeouts)
+          {
+            qiLogError() << "Threadpool " << _name <<
+              ": System seems to be deadlocked, sending emergency signal";
+            if (_emergencyCallback)
+            {
+              try {
+                _emergencyCallback();
+              } catch (...) {
+              }
+            }
+          }
+        }
+        else
+        {
+          qiLogInfo() << _name << ": Spawned more threads (" << _workerCount.load() << ')';
+        }
+        sleepMs = msGrace;
+      }
+      else
+      {
+        nbTimeout = 0;
+        qiLogDebug() << "Ping ok";
+      }
+      lock.lock();
+      if (!_stopping.load())
+        _stopped.timed_wait(lock, boost::posix_time::milliseconds(sleepMs));
+    }
+  }
+
+  bool EventLoopWorkStealing::isInThisContext()
+  {
+    // As with EventLoopAsio in pool mode, tasks are not considered to run in
+    // the context of the loop, so that the calls they make are still queued.
+    return false;
+  }
+
+  void EventLoopWorkStealing::stop()
+  {
+    qiLogDebug() << "stopping workstealingeventloop: " << this;
+    {
+      boost::mutex::scoped_lock lock(_sleepMutex);
+      _stopping = true;
+      _taskQueued.notify_all();
+      _stopped.notify_all();
+    }
+    _io->stop();
+  }
+
+  void EventLoopWorkStealing::join()
+  {
+    if (_currentWorker.get())
+    {
+      qiLogError() << "Cannot join from within event loop thread";
+      return;
+    }
+    qiLogVerbose()
+        << "Waiting threads from the pool \"" << _name << "\", remaining tasks: "
+        << _totalTask.load() << " (" << _activeTask.load() <<  " active)...";
+    while (true)
+    {
+      std::thread thread;
+      {
+        boost::mutex::scoped_lock lock(_threadsMutex);
+        if (_threads.empty())
+          break;
+        thread = std::move(_threads.back());
+        _threads.pop_back();
+      }
+      if (thread.joinable())
+        thread.join();
+    }
+    _io->join();
+    qiLogDebug()  << "Waiting done";
+  }
+
+  void EventLoopWorkStealing::destroy()
+  {
+    // A worker cannot join itself.
+    if (_currentWorker.get())
+      std::thread([this]{ delete this; }).detach();
+    else
+      delete this;
+  }
+
+  void EventLoopWorkStealing::post(qi::Duration delay,
+      const boost::function<void ()>& cb)
+  {
+    if (delay == qi::Duration(0))
+    {
+      const auto id = ++gTaskId;
+      tracepoint(qi_qi, eventloop_post, id, cb.target_type().name());
+      ++_totalTask;
+      schedule(Task{cb, id, boost::none});
+    }
+    else
+      asyncCall(delay, cb);
+  }
+
+  qi::Future<void> EventLoopWorkStealing::asyncCall(qi::Duration delay,
+      boost::function<void ()> cb)
+  {
+    if (_stopping.load())
+      return qi::makeFutureError<void>("Schedule attempt on destroyed thread pool");
+
+    const auto id = ++gTaskId;
+
+    ++_totalTask;
+    tracepoint(qi_qi, eventloop_delay, id, cb.target_type().name(), boost::chrono::duration_cast<qi::MicroSeconds>(delay).count());
+    if (delay > Duration::zero())
+      return asyncAt(SteadyClock::now() + delay, std::move(cb), id);
+    Promise<void> prom;
+    schedule(Task{std::move(cb), id, prom});
+    return prom.future();
+  }
+
+  void EventLoopWorkStealing::post(qi::SteadyClockTimePoint timepoint,
+      const boost::function<void ()>& cb)
+  {
+    asyncCall(timepoint, cb);
+  }
+
+  qi::Future<void> EventLoopWorkStealing::asyncCall(qi::SteadyClockTimePoint timepoint,
+      boost::function<void ()> cb)
+  {
+    if (_stopping.load())
+      return qi::makeFutureError<void>("Schedule attempt on destroyed thread pool");
+
+    const auto id = ++gTaskId;
+    ++_totalTask;
+    return asyncAt(timepoint, std::move(cb), id);
+  }
+
+  qi::Future<void> EventLoopWorkStealing::asyncAt(qi::SteadyClockTimePoint timepoint,
+      boost::function<void ()> cb, qi::uint64_t id)
+  {
+    auto& io = *static_cast<boost::asio::io_service*>(_io->nativeHandle());
+    boost::shared_ptr<SteadyTimer> timer = boost::make_shared<SteadyTimer>(boost::ref(io));
+    timer->expires_at(timepoint);
+    qi::Promise<void> prom(boost::bind(&SteadyTimer::cancel, timer));
+    timer->async_wait([=](const boost::system::error_code& erc) mutable {
+      if (erc)
+      {
+        tracepoint(qi_qi, eventloop_task_cancel, id);
+        --_totalTask;
+        prom.setCanceled();
+        return;
+      }
+      // The timer only queues the task, which is run by the workers.
+      schedule(Task{cb, id, prom});
+    });
+    return prom.future();
+  }
+
+  void EventLoopWorkStealing::setMaxThreads(unsigned int max)
+  {
+    _maxThreads = max;
+  }
+
+  void* EventLoopWorkStealing::nativeHandle()
+  {
+    return _io->nativeHandle();
+  }
+}
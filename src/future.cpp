@@ -2,12 +2,14 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <vector>
+#include <qi/atomic.hpp>
 #include <qi/future.hpp>
 #include <qi/log.hpp>
 #include <qi/os.hpp>
 
 #include <boost/thread.hpp>
-#include <boost/pool/singleton_pool.hpp>
+#include <boost/thread/tss.hpp>
 
 qiLogCategory("qi.future");
 
@@ -29,19 +31,75 @@ namespace qi {
       std::string  _error;
       std::atomic<FutureState> _state;
       std::atomic<bool> _cancelRequested;
+      // Number of threads blocked in wait(), notifyFinish() only takes the
+      // mutex if there are some.
+      std::atomic<unsigned int> _waiters;
     };
 
-    struct FutureBasePrivatePoolTag { };
-    using futurebase_pool = boost::singleton_pool<FutureBasePrivatePoolTag, sizeof(FutureBasePrivate)>;
+    namespace
+    {
+      /// Blocks of released FutureBasePrivate, kept by each thread to be
+      /// reused without locking.
+      class FutureBasePrivateCache
+      {
+      public:
+        FutureBasePrivateCache()
+        {
+          _blocks.reserve(maxBlocks);
+        }
+
+        ~FutureBasePrivateCache()
+        {
+          for (void* block : _blocks)
+            ::operator delete(block);
+        }
+
+        void* take()
+        {
+          if (_blocks.empty())
+            return ::operator new(sizeof(FutureBasePrivate));
+          void* const block = _blocks.back();
+          _blocks.pop_back();
+          return block;
+        }
+
+        void give(void* block)
+        {
+          if (_blocks.size() < maxBlocks)
+            _blocks.push_back(block);
+          else
+            ::operator delete(block);
+        }
+
+      private:
+        static const std::size_t maxBlocks = 256;
+        std::vector<void*> _blocks;
+      };
+
+      boost::thread_specific_ptr<FutureBasePrivateCache>& futureBasePrivateCache()
+      {
+        static boost::thread_specific_ptr<FutureBasePrivateCache>* cache = nullptr;
+        QI_THREADSAFE_NEW(cache);
+        return *cache;
+      }
+    }
 
     void* FutureBasePrivate::operator new(size_t sz)
     {
-      return futurebase_pool::malloc();
+      auto& cache = futureBasePrivateCache();
+      if (!cache.get())
+        cache.reset(new FutureBasePrivateCache);
+      return cache->take();
     }
 
     void FutureBasePrivate::operator delete(void* ptr)
     {
-      futurebase_pool::free(ptr);
+      auto& cache = futureBasePrivateCache();
+      // the cache of an exiting thread may already be gone
+      if (cache.get())
+        cache->give(ptr);
+      else
+        ::operator delete(ptr);
     }
 
     FutureBasePrivate::FutureBasePrivate()
@@ -49,9 +107,8 @@ namespace qi {
         _mutex(),
         _error(),
         _state(FutureState_None),
-        _cancelRequested(false)
-
-
+        _cancelRequested(false),
+        _waiters(0)
     {
     }
 
@@ -75,31 +132,56 @@ namespace qi {
       return p->_state.load() != FutureState_Running;
     }
 
+    namespace
+    {
+      /// Registers the calling thread as waiting for the future while alive.
+      class ScopedWaiter
+      {
+      public:
+        explicit ScopedWaiter(FutureBasePrivate* p)
+          : _p(p)
+        {
+          ++_p->_waiters;
+        }
+
+        ~ScopedWaiter()
+        {
+          --_p->_waiters;
+        }
+
+      private:
+        FutureBasePrivate* _p;
+      };
+    }
+
     FutureState FutureBase::wait(int msecs) const {
-      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
-      if (_p->_state.load() != FutureState_Running)
+      // msecs <= 0 : do nothing just return the state
+      if (_p->_state.load() != FutureState_Running || msecs <= 0)
         return FutureState(_p->_state.load());
+      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
+      ScopedWaiter waiter(_p);
       if (msecs == FutureTimeout_Infinite)
         _p->_cond.wait(lock, boost::bind(&waitFinished, _p));
-      else if (msecs > 0)
+      else
         _p->_cond.wait_for(lock, qi::MilliSeconds(msecs),
             boost::bind(&waitFinished, _p));
-      // msecs <= 0 : do nothing just return the state
       return FutureState(_p->_state.load());
     }
 
     FutureState FutureBase::wait(qi::Duration duration) const {
-      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       if (_p->_state.load() != FutureState_Running)
         return FutureState(_p->_state.load());
+      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
+      ScopedWaiter waiter(_p);
       _p->_cond.wait_for(lock, duration, boost::bind(&waitFinished, _p));
       return FutureState(_p->_state.load());
     }
 
     FutureState FutureBase::wait(qi::SteadyClock::time_point timepoint) const {
-      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       if (_p->_state.load() != FutureState_Running)
         return FutureState(_p->_state.load());
+      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
+      ScopedWaiter waiter(_p);
       _p->_cond.wait_until(lock, timepoint, boost::bind(&waitFinished, _p));
       return FutureState(_p->_state.load());
     }
@@ -123,8 +205,9 @@ namespace qi {
     void FutureBase::reportError(const std::string &message) {
       //always set by setError
       //boost::recursive_mutex::scoped_lock lock(_p->_mutex);
-      _p->_state = FutureState_FinishedWithError;
+      // the error must be visible to whoever sees the state
       _p->_error = message;
+      _p->_state = FutureState_FinishedWithError;
     }
 
     void FutureBase::reportStart() {
@@ -133,6 +216,10 @@ namespace qi {
     }
 
     void FutureBase::notifyFinish() {
+      // The state was set before: a waiter either sees it before blocking, or
+      // was registered before we look at _waiters.
+      if (_p->_waiters.load() == 0)
+        return;
       boost::unique_lock<boost::recursive_mutex> l{_p->_mutex};
       _p->_cond.notify_all();
     }
@@ -171,7 +258,6 @@ namespace qi {
         throw FutureException(FutureException::ExceptionState_FutureTimeout);
       if (_p->_state.load() != FutureState_FinishedWithError)
         throw FutureException(FutureException::ExceptionState_FutureHasNoError);
-      boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       return _p->_error;
     }
 
@@ -15,7 +15,9 @@
 #include <qi/assert.hpp>
 #include <qi/log.hpp>
 #include "log_p.hpp"
+#include "logring_p.hpp"
 #include <qi/os.hpp>
+#include <atomic>
 #include <list>
 #include <map>
 #include <cstring>
@@ -32,7 +34,6 @@
 #include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
 
-#include <boost/lockfree/queue.hpp>
 #include <boost/function.hpp>
 
 #ifdef WITH_SYSTEMD
@@ -51,13 +52,6 @@
 #endif
 
 
-#define RTLOG_BUFFERS (128)
-
-#define CAT_SIZE 64
-#define FILE_SIZE 128
-#define FUNC_SIZE 64
-#define LOG_SIZE 2048
-
 qiLogCategory("qi.log");
 
 namespace qi {
@@ -218,18 +212,6 @@ namespace qi {
 
   namespace log {
 
-    using privateLog = struct sPrivateLog
-    {
-      qi::LogLevel               _logLevel;
-      char                       _category[CAT_SIZE];
-      char                       _file[FILE_SIZE];
-      char                       _function[FUNC_SIZE];
-      int                        _line;
-      char                       _log[LOG_SIZE];
-      qi::Clock::time_point       _date;
-      qi::SystemClock::time_point _systemDate;
-    };
-
     class Log
     {
     public:
@@ -244,6 +226,8 @@ namespace qi {
 
       void run();
       void printLog();
+      // Wake up the log thread if it is waiting for records.
+      void notifyLogThread();
       // Invoke handlers who enabled given level/category
       void dispatch(const qi::LogLevel,
                     const qi::Clock::time_point date,
@@ -273,7 +257,12 @@ namespace qi {
       bool                       SyncLog;
       bool                       AsyncLogInit;
 
-      boost::lockfree::queue<privateLog*>     logs;
+      // Records waiting to be dispatched by the log thread.
+      detail::LogRing            logs;
+      // Raised by the log thread before waiting, so that only the first
+      // record pushed afterwards wakes it up.
+      std::atomic<bool>          LogThreadWaiting;
+      std::uint64_t              reportedDropCount;
 
       using LogHandlerMap = std::map<std::string, Handler>;
       LogHandlerMap logHandlers;
@@ -327,8 +316,6 @@ namespace qi {
     static LogColor               _glColorWhen = LogColor_Auto;
 
     static Log                   *LogInstance = nullptr;
-    static privateLog             LogBuffer[RTLOG_BUFFERS];
-    static volatile unsigned long LogPush = 0;
 
 #ifdef ANDROID
     static AndroidLogHandler *_glAndroidLogHandler = nullptr;
@@ -529,18 +516,32 @@ namespace qi {
 
     void Log::printLog()
     {
-      privateLog* pl = nullptr;
       boost::mutex::scoped_lock lock(LogHandlerLock);
-      while (logs.pop(pl))
+      logs.consume([this](const detail::LogRecord& r) {
+        dispatch(r.level, r.date, r.systemDate, r.category, r.message, r.file, r.function, r.line);
+      });
+      const std::uint64_t dropCount = logs.dropCount();
+      if (dropCount != reportedDropCount)
+      {
+        std::ostringstream ss;
+        ss << (dropCount - reportedDropCount) << " log messages dropped: "
+              "the asynchronous log buffer of " << logs.capacity() << " bytes is full "
+              "(see QI_LOG_BUFFER_SIZE and QI_LOG_OVERFLOW).";
+        reportedDropCount = dropCount;
+        dispatch(qi::LogLevel_Warning, qi::Clock::now(), qi::SystemClock::now(),
+                 "qi.log", ss.str().c_str(), __FILE__, __FUNCTION__, __LINE__);
+      }
+    }
+
+    void Log::notifyLogThread()
+    {
+      // Only the first record pushed after the log thread started waiting
+      // wakes it up: the log thread then dispatches all the pending records.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (LogThreadWaiting.exchange(false))
       {
-        dispatch(pl->_logLevel,
-                 pl->_date,
-                 pl->_systemDate,
-                 pl->_category,
-                 pl->_log,
-                 pl->_file,
-                 pl->_function,
-                 pl->_line);
+        boost::mutex::scoped_lock lock(LogWriteLock);
+        LogReadyCond.notify_one();
       }
     }
 
@@ -585,7 +586,10 @@ namespace qi {
       {
         {
           boost::mutex::scoped_lock lock(LogWriteLock);
-          LogReadyCond.wait(lock);
+          LogThreadWaiting = true;
+          if (logs.empty())
+            LogReadyCond.wait(lock);
+          LogThreadWaiting = false;
         }
 
         printLog();
@@ -605,7 +609,11 @@ namespace qi {
     inline Log::Log() :
       SyncLog(true),
       AsyncLogInit(false)
-      , logs(50)
+      , logs(qi::os::getEnvParam<std::size_t>("QI_LOG_BUFFER_SIZE", 512 * 1024),
+             detail::overflowPolicyFromString(qi::os::getEnvParam<std::string>("QI_LOG_OVERFLOW", "count"),
+                                              detail::OverflowPolicy::CountDrops))
+      , LogThreadWaiting(false)
+      , reportedDropCount(0u)
     {
       LogInit = true;
     };
@@ -625,17 +633,6 @@ namespace qi {
       }
     }
 
-    static void my_strcpy(char *dst, const char *src, int len) {
-      if (!src)
-        src = "(null)";
-#ifdef _MSV_VER
-      strncpy_s(dst, len, src, _TRUNCATE);
-#else
-      strncpy(dst, src, len);
-      dst[len - 1] = 0;
-#endif
-    }
-
     static void doInit(qi::LogLevel verb) {
       //if init has already been called, we are set here. (reallocating all globals
       // will lead to racecond)
@@ -726,20 +723,17 @@ namespace qi {
       }
       else
       {
-        int tmpRtLogPush = ++LogPush % RTLOG_BUFFERS;
-        privateLog* pl = &(LogBuffer[tmpRtLogPush]);
-
-        pl->_logLevel = verb;
-        pl->_line = line;
-        pl->_date = date;
-        pl->_systemDate = systemDate;
-
-        my_strcpy(pl->_category, categoryStr, CAT_SIZE);
-        my_strcpy(pl->_file, file, FILE_SIZE);
-        my_strcpy(pl->_function, fct, FUNC_SIZE);
-        my_strcpy(pl->_log, msg, LOG_SIZE);
-        LogInstance->logs.push(pl);
-        LogInstance->LogReadyCond.notify_one();
+        const detail::LogRecord record{verb, date, systemDate, categoryStr, file, fct, msg, line};
+        Log& l = *LogInstance;
+        auto onFull = [&l] {
+          // The log thread must not wait for itself.
+          if (boost::this_thread::get_id() == l.LogThread.get_id())
+            return false;
+          l.notifyLogThread();
+          return true;
+        };
+        if (l.logs.push(record, onFull))
+          l.notifyLogThread();
       }
     }
 
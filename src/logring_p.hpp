@@ -0,0 +1,321 @@
+#pragma once
+/*
+ * Copyright (c) 2012 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+#ifndef _SRC_LOGRING_P_HPP_
+#define _SRC_LOGRING_P_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <qi/clock.hpp>
+#include <qi/log.hpp>
+
+namespace qi
+{
+  namespace log
+  {
+    namespace detail
+    {
+      /// What to do with a log record that does not fit in the ring.
+      enum class OverflowPolicy
+      {
+        Drop,       ///< The record is silently dropped.
+        CountDrops, ///< The record is dropped and the number of drops is counted.
+        Block,      ///< The producer waits until there is room in the ring.
+      };
+
+      /// Accepts "drop", "count" and "block". Returns `defaultPolicy` for any
+      /// other value.
+      inline OverflowPolicy overflowPolicyFromString(const std::string& s, OverflowPolicy defaultPolicy)
+      {
+        if (s == "drop")
+          return OverflowPolicy::Drop;
+        if (s == "count")
+          return OverflowPolicy::CountDrops;
+        if (s == "block")
+          return OverflowPolicy::Block;
+        return defaultPolicy;
+      }
+
+      /// A log record, as given to the ring and as read back from it.
+      /// The strings are not owned.
+      struct LogRecord
+      {
+        qi::LogLevel level;
+        qi::Clock::time_point date;
+        qi::SystemClock::time_point systemDate;
+        const char* category;
+        const char* file;
+        const char* function;
+        const char* message;
+        int line;
+      };
+
+      /// Preallocated multi-producer single-consumer ring of variable-length
+      /// log records.
+      ///
+      /// Pushing a record does not allocate: producers reserve room in the
+      /// ring with an atomic operation, copy the record, then publish it.
+      /// The consumer reads the records in place, in reservation order, and
+      /// stops at the first record that is not published yet.
+      ///
+      /// The ring is divided in units of `unitSize` bytes. A record occupies
+      /// a contiguous sequence of units: a header followed by the strings. A
+      /// record that would cross the end of the ring is preceded by a padding
+      /// record up to the end of the ring.
+      ///
+      /// Strings are truncated to the maximum sizes given below.
+      class LogRing
+      {
+      public:
+        static const std::size_t unitSize = 16;
+        static const std::size_t maxCategorySize = 64;
+        static const std::size_t maxFileSize = 128;
+        static const std::size_t maxFunctionSize = 64;
+        static const std::size_t maxMessageSize = 2048;
+        /// The ring can always contain at least one record of maximal size.
+        static const std::size_t minCapacity = 8 * 1024;
+
+        /// The capacity is rounded up to a multiple of `unitSize`.
+        LogRing(std::size_t capacityInBytes, OverflowPolicy policy)
+          : _unitCount((std::max(capacityInBytes, minCapacity) + unitSize - 1) / unitSize)
+          , _policy(policy)
+          , _data(new Unit[_unitCount])
+          , _published(new std::atomic<std::uint32_t>[_unitCount])
+          , _reserved(0u)
+          , _released(0u)
+          , _dropCount(0u)
+        {
+          for (std::size_t i = 0; i != _unitCount; ++i)
+            _published[i].store(0u, std::memory_order_relaxed);
+        }
+
+        std::size_t capacity() const
+        {
+          return _unitCount * unitSize;
+        }
+
+        OverflowPolicy policy() const
+        {
+          return _policy;
+        }
+
+        /// Number of records dropped because the ring was full, unless the
+        /// policy is `OverflowPolicy::Drop`.
+        std::uint64_t dropCount() const
+        {
+          return _dropCount.load(std::memory_order_relaxed);
+        }
+
+        /// Consumer only.
+        bool empty() const
+        {
+          const std::uint64_t tail = _released.load(std::memory_order_relaxed);
+          return _published[tail % _unitCount].load(std::memory_order_seq_cst) == 0u;
+        }
+
+        /// Copies the record in the ring. Thread-safe.
+        ///
+        /// If the ring is full, applies the overflow policy. With the
+        /// `OverflowPolicy::Block` policy, `onFull` is called each time the
+        /// producer waits for room in the ring. If it returns false, the
+        /// record is dropped and counted instead.
+        ///
+        /// Returns false if the record was dropped.
+        ///
+        /// Procedure<bool ()> F
+        template<typename F>
+        bool push(const LogRecord& record, F onFull);
+
+        bool push(const LogRecord& record)
+        {
+          return push(record, []{ return true; });
+        }
+
+        /// Calls `f` for each published record, in order, and frees its room
+        /// in the ring. The record is only valid during the call.
+        ///
+        /// Must only be called by one thread at a time.
+        ///
+        /// Returns the number of records consumed.
+        ///
+        /// Procedure<void (const LogRecord&)> F
+        template<typename F>
+        std::size_t consume(F f);
+
+      private:
+        struct Unit
+        {
+          unsigned char bytes[unitSize];
+        };
+
+        struct Header
+        {
+          qi::LogLevel level;
+          int line;
+          qi::Clock::time_point date;
+          qi::SystemClock::time_point systemDate;
+          std::uint16_t categorySize;
+          std::uint16_t fileSize;
+          std::uint16_t functionSize;
+          std::uint16_t messageSize;
+        };
+
+        /// Published value of a padding record.
+        static const std::uint32_t paddingFlag = 0x80000000u;
+
+        static std::size_t boundedLength(const char* s, std::size_t maxSize)
+        {
+          if (!s)
+            return std::strlen("(null)");
+          const void* end = std::memchr(s, 0, maxSize - 1);
+          return end ? static_cast<const char*>(end) - s : maxSize - 1;
+        }
+
+        static unsigned char* copyString(unsigned char* dst, const char* src, std::size_t size)
+        {
+          if (!src)
+            src = "(null)";
+          std::memcpy(dst, src, size);
+          dst[size] = 0;
+          return dst + size + 1;
+        }
+
+        unsigned char* unitData(std::size_t index)
+        {
+          return _data[index].bytes;
+        }
+
+        const std::size_t _unitCount;
+        const OverflowPolicy _policy;
+        std::unique_ptr<Unit[]> _data;
+        /// For each unit where a record begins, the number of units of the
+        /// record once it is published, 0 otherwise.
+        std::unique_ptr<std::atomic<std::uint32_t>[]> _published;
+        /// Total number of units reserved by producers.
+        std::atomic<std::uint64_t> _reserved;
+        /// Total number of units freed by the consumer.
+        std::atomic<std::uint64_t> _released;
+        std::atomic<std::uint64_t> _dropCount;
+      };
+
+      template<typename F>
+      bool LogRing::push(const LogRecord& record, F onFull)
+      {
+        Header header;
+        header.level = record.level;
+        header.line = record.line;
+        header.date = record.date;
+        header.systemDate = record.systemDate;
+        header.categorySize = static_cast<std::uint16_t>(boundedLength(record.category, maxCategorySize));
+        header.fileSize = static_cast<std::uint16_t>(boundedLength(record.file, maxFileSize));
+        header.functionSize = static_cast<std::uint16_t>(boundedLength(record.function, maxFunctionSize));
+        header.messageSize = static_cast<std::uint16_t>(boundedLength(record.message, maxMessageSize));
+        const std::size_t bytes = sizeof(Header) + header.categorySize + header.fileSize
+            + header.functionSize + header.messageSize + 4;
+        const std::size_t units = (bytes + unitSize - 1) / unitSize;
+
+        // Reserve the units of the record, and of the padding if needed.
+        std::uint64_t position = _reserved.load(std::memory_order_relaxed);
+        std::size_t index;
+        std::size_t reservedUnits;
+        while (true)
+        {
+          index = position % _unitCount;
+          const std::size_t unitsToEnd = _unitCount - index;
+          reservedUnits = units <= unitsToEnd ? units : unitsToEnd + units;
+          if (position + reservedUnits - _released.load(std::memory_order_acquire) > _unitCount)
+          {
+            switch (_policy)
+            {
+            case OverflowPolicy::Drop:
+              return false;
+            case OverflowPolicy::CountDrops:
+              _dropCount.fetch_add(1u, std::memory_order_relaxed);
+              return false;
+            case OverflowPolicy::Block:
+              if (!onFull())
+              {
+                _dropCount.fetch_add(1u, std::memory_order_relaxed);
+                return false;
+              }
+              std::this_thread::yield();
+              position = _reserved.load(std::memory_order_relaxed);
+              continue;
+            }
+          }
+          if (_reserved.compare_exchange_weak(position, position + reservedUnits,
+                                              std::memory_order_relaxed))
+            break;
+        }
+
+        if (reservedUnits != units)
+        {
+          const std::size_t paddingUnits = reservedUnits - units;
+          _published[index].store(paddingFlag | static_cast<std::uint32_t>(paddingUnits),
+                                  std::memory_order_release);
+          index = 0;
+        }
+
+        unsigned char* p = unitData(index);
+        std::memcpy(p, &header, sizeof(Header));
+        p += sizeof(Header);
+        p = copyString(p, record.category, header.categorySize);
+        p = copyString(p, record.file, header.fileSize);
+        p = copyString(p, record.function, header.functionSize);
+        copyString(p, record.message, header.messageSize);
+        _published[index].store(static_cast<std::uint32_t>(units), std::memory_order_seq_cst);
+        return true;
+      }
+
+      template<typename F>
+      std::size_t LogRing::consume(F f)
+      {
+        std::size_t count = 0;
+        std::uint64_t tail = _released.load(std::memory_order_relaxed);
+        while (true)
+        {
+          const std::size_t index = tail % _unitCount;
+          const std::uint32_t published = _published[index].load(std::memory_order_acquire);
+          if (published == 0u)
+            break;
+          if (!(published & paddingFlag))
+          {
+            const unsigned char* p = unitData(index);
+            Header header;
+            std::memcpy(&header, p, sizeof(Header));
+            p += sizeof(Header);
+            LogRecord record;
+            record.level = header.level;
+            record.line = header.line;
+            record.date = header.date;
+            record.systemDate = header.systemDate;
+            record.category = reinterpret_cast<const char*>(p);
+            p += header.categorySize + 1;
+            record.file = reinterpret_cast<const char*>(p);
+            p += header.fileSize + 1;
+            record.function = reinterpret_cast<const char*>(p);
+            p += header.functionSize + 1;
+            record.message = reinterpret_cast<const char*>(p);
+            f(record);
+            ++count;
+          }
+          _published[index].store(0u, std::memory_order_relaxed);
+          tail += published & ~paddingFlag;
+          _released.store(tail, std::memory_order_release);
+        }
+        return count;
+      }
+    }
+  }
+}
+
+#endif  // _SRC_LOGRING_P_HPP_
@@ -6,6 +6,7 @@
 #include <boost/make_shared.hpp>
 
 #include <qi/anyobject.hpp>
+#include <qi/eventloop.hpp>
 #include <qi/type/objecttypebuilder.hpp>
 #include "boundobject.hpp"
 
@@ -226,7 +227,9 @@ namespace qi {
   }
 
   void ServiceBoundObject::onMessage(const qi::Message &msg, MessageSocketPtr socket) {
-    boost::mutex::scoped_lock lock(_callMutex);
+    // Messages of different sockets are decoded concurrently. The messages of
+    // a socket are delivered one at a time, in order, so a cancel is always
+    // handled after the registration of the call it targets.
     try {
       if (msg.version() > qi::Message::currentVersion())
       {
@@ -247,6 +250,25 @@ namespace qi {
         return;
       }
 
+      // Calls that reached their deadline are dropped before being decoded.
+      boost::optional<SteadyClockTimePoint> deadline;
+      if (msg.type() == Message::Type_Call)
+      {
+        if (const boost::optional<Duration> timeLeft = msg.deadlineTimeLeft())
+        {
+          if (*timeLeft <= Duration::zero())
+          {
+            qiLogDebug() << "Dropping call " << msg.address() << ": deadline exceeded";
+            Promise<AnyReference> expired;
+            expired.setCanceled();
+            serverResultAdapter(expired.future(), Signature(), _gethost(), socket, msg.address(), Signature(),
+                                CancelableKitWeak());
+            return;
+          }
+          deadline = SteadyClock::now() + *timeLeft;
+        }
+      }
+
       qi::AnyObject    obj;
       unsigned int     funcId;
       //choose between special function (on BoundObject) or normal calls
@@ -335,14 +357,16 @@ namespace qi {
       }
       mfp = value.asTupleValuePtr();
       /* Because of 'global' _currentSocket, we cannot support parallel
-      * executions at this point.
+      * executions of the calls that may run synchronously.
       * Both on self, and on obj which can use currentSocket() too.
       *
-      * So put a lock, and rely on metaCall we invoke being asynchronous for// execution
-      * This is decided by _callType, set from BoundObject ctor argument, passed by Server, which
-      * uses its internal _defaultCallType, passed to its constructor, default
-      * to queued. When Server is instanciated by ObjectHost, it uses the default
-      * value.
+      * So those calls are made under _mutex, and queued ones are only posted,
+      * without locking. The call type is decided by _callType, set from
+      * BoundObject ctor argument, passed by Server, which uses its internal
+      * _defaultCallType, passed to its constructor, default to queued. When
+      * Server is instanciated by ObjectHost, it uses the default value.
+      * Calls that must be ordered rely on the threading model of the object
+      * (a single-threaded object runs its calls in its strand).
       *
       * As a consequence, users of currentSocket() must set _callType to Direct.
       * Calling currentSocket multiple times in a row should be avoided.
@@ -350,9 +374,6 @@ namespace qi {
       switch (msg.type())
       {
       case Message::Type_Call: {
-        boost::recursive_mutex::scoped_lock lock(_mutex);
-        _currentSocket = socket;
-
         // Property accessors are insecure to call synchronously
         // because users can customize them.
         const bool isUserDefinedFunction =
@@ -360,18 +381,42 @@ namespace qi {
         qi::MetaCallType callType = isUserDefinedFunction ? _callType : MetaCallType_Direct;
 
         qi::Signature sig = returnSignature.empty() ? Signature() : Signature(returnSignature);
-        qi::Future<AnyReference> fut = obj.metaCall(funcId, mfp, callType, sig);
+        // The deadline lets the object drop the call if it is still queued
+        // when the deadline passes.
+        auto doCall = [&] {
+          return deadline ? obj.metaCall(funcId, mfp, *deadline, callType, sig)
+                          : obj.metaCall(funcId, mfp, callType, sig);
+        };
+        qi::Future<AnyReference> fut;
+        if (callType == MetaCallType_Queued)
+          fut = doCall();
+        else
+        {
+          boost::recursive_mutex::scoped_lock lock(_mutex);
+          _currentSocket = socket;
+          fut = doCall();
+          _currentSocket.reset();
+        }
         AtomicIntPtr cancelRequested = boost::make_shared<Atomic<int> >(0);
         {
           qiLogDebug() << this << " Registering future for " << socket.get() << ", message:" << msg.id();
           boost::mutex::scoped_lock futlock(_cancelables->guard);
           _cancelables->map[socket][msg.id()] = std::make_pair(fut, cancelRequested);
         }
+        if (deadline && !fut.isFinished())
+        {
+          // Stop working on the call when its caller gives up on it, including
+          // on the future it may have returned.
+          Future<void> timer = getEventLoop()->asyncAt(
+              qi::bind(&ServiceBoundObject::cancelExpiredCall, this,
+                       boost::weak_ptr<MessageSocket>(socket), msg.id()),
+              *deadline);
+          fut.connect([timer](const Future<AnyReference>&) mutable { timer.cancel(); });
+        }
         Signature retSig;
         const MetaMethod* mm = obj.metaObject().method(funcId);
         if (mm)
           retSig = mm->returnSignature();
-        _currentSocket.reset();
 
         fut.connect(boost::bind<void>
                     (&ServiceBoundObject::serverResultAdapter, _1, retSig, _gethost(), socket, msg.address(), sig,
@@ -380,7 +425,10 @@ namespace qi {
         break;
       case Message::Type_Post: {
         if (obj == _self) // we need a sync call (see comment above), post does not provide it
+        {
+          boost::recursive_mutex::scoped_lock lock(_mutex);
           obj.metaCall(funcId, mfp, MetaCallType_Direct);
+        }
         else
           obj.metaPost(funcId, mfp);
       }
@@ -478,6 +526,15 @@ namespace qi {
     }
   }
 
+  void ServiceBoundObject::cancelExpiredCall(boost::weak_ptr<MessageSocket> socket, MessageId id)
+  {
+    if (MessageSocketPtr s = socket.lock())
+    {
+      qiLogDebug() << "Call " << id << " reached its deadline";
+      cancelCall(s, Message(), id);
+    }
+  }
+
   void ServiceBoundObject::onSocketDisconnected(MessageSocketPtr client, std::string error)
   {
     // Disconnect event links set for this client.
@@ -487,6 +544,7 @@ namespace qi {
       boost::mutex::scoped_lock lock(_cancelables->guard);
       _cancelables->map.erase(client);
     }
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     BySocketServiceSignalLinks::iterator it = _links.find(client);
     if (it != _links.end())
     {
@@ -122,6 +122,8 @@ namespace qi {
 
     using MessageId = unsigned int;
     void cancelCall(MessageSocketPtr origSocket, const Message& cancelMessage, MessageId origMsgId);
+    /// Cancels a call that reached its deadline, if it is still running.
+    void cancelExpiredCall(boost::weak_ptr<MessageSocket> socket, MessageId id);
 
   private:
     using FutureMap = std::map<MessageId, std::pair<Future<AnyReference>, AtomicIntPtr>>;
@@ -150,10 +152,9 @@ namespace qi {
     using ServiceSignalLinks = std::map<SignalLink, RemoteSignalLink>;
     using BySocketServiceSignalLinks = std::map<qi::MessageSocketPtr, ServiceSignalLinks>;
 
-    //Event handling (no lock needed)
+    //Event handling (protected by _mutex)
     BySocketServiceSignalLinks  _links;
 
-    boost::mutex _callMutex;
   private:
     qi::MessageSocketPtr _currentSocket;
     unsigned int           _serviceId;
@@ -0,0 +1,203 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <boost/make_shared.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <qi/log.hpp>
+#include <qi/messaging/bufferstream.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+qiLogCategory("qimessaging.bufferstream");
+
+namespace qi
+{
+  namespace
+  {
+    /// A fragment and its position in the stream.
+    using Fragment = std::pair<std::uint64_t, Buffer>;
+
+    /// The sending side of a stream.
+    ///
+    /// Fragments are numbered when they are produced, so that the reader can
+    /// put them back in order if the requests are handled concurrently.
+    class BufferStreamSource
+    {
+    public:
+      explicit BufferStreamSource(BufferProducer producer)
+        : _producer(std::move(producer))
+        , _next(0)
+        , _ended(false)
+      {
+      }
+
+      Fragment read(unsigned int maxSize)
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        Fragment fragment(_next++, Buffer());
+        if (_ended || maxSize == 0)
+          return fragment;
+        fragment.second = _producer(maxSize);
+        if (fragment.second.size() == 0)
+        {
+          // Release whatever the producer holds as soon as possible.
+          _ended = true;
+          _producer.clear();
+        }
+        return fragment;
+      }
+
+    private:
+      boost::mutex _mutex;
+      BufferProducer _producer;
+      std::uint64_t _next;
+      bool _ended;
+    };
+  }
+
+  AnyObject makeBufferStream(const Buffer& buffer)
+  {
+    std::size_t offset = 0;
+    return makeBufferStream([buffer, offset](std::size_t maxSize) mutable {
+      Buffer fragment;
+      const auto size = std::min(maxSize, buffer.size() - offset);
+      if (size)
+      {
+        buffer.read(fragment.reserve(size), offset, size);
+        offset += size;
+      }
+      return fragment;
+    });
+  }
+
+  AnyObject makeBufferStream(BufferProducer producer)
+  {
+    if (!producer)
+      throw std::invalid_argument("makeBufferStream: empty producer");
+    auto source = boost::make_shared<BufferStreamSource>(std::move(producer));
+    DynamicObjectBuilder ob;
+    ob.advertiseMethod("read", boost::function<Fragment (unsigned int)>(
+                         [source](unsigned int maxSize) { return source->read(maxSize); }));
+    return ob.object();
+  }
+
+  struct BufferStreamReaderPrivate
+  {
+    BufferStreamReaderPrivate(AnyObject stream, std::size_t fragmentSize, unsigned int prefetch)
+      : stream(std::move(stream))
+      , fragmentSize(static_cast<unsigned int>(fragmentSize))
+      , prefetch(std::max(1u, prefetch))
+      , inFlight(0)
+      , next(0)
+      , endRequested(false)
+      , atEnd(false)
+    {
+    }
+
+    /// mutex must be locked.
+    void request(const boost::shared_ptr<BufferStreamReaderPrivate>& self)
+    {
+      while (inFlight < prefetch && !endRequested && error.empty())
+      {
+        ++inFlight;
+        boost::weak_ptr<BufferStreamReaderPrivate> weak = self;
+        // Asynchronous, as the callback locks the mutex and the call may
+        // already be finished.
+        stream.async<Fragment>("read", fragmentSize).connect([weak](const Future<Fragment>& f) {
+          if (auto self = weak.lock())
+            self->onFragment(f);
+        }, FutureCallbackType_Async);
+      }
+    }
+
+    void onFragment(const Future<Fragment>& f)
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      --inFlight;
+      if (f.hasError())
+        error = f.error();
+      else if (f.isCanceled())
+        error = "fragment request canceled";
+      else
+      {
+        const Fragment& fragment = f.value();
+        // Every request issued after the end is also answered with an empty
+        // fragment: stop requesting as soon as one comes back.
+        if (fragment.second.size() == 0)
+          endRequested = true;
+        fragments.insert(fragment);
+      }
+      received.notify_all();
+    }
+
+    AnyObject stream;
+    const unsigned int fragmentSize;
+    const unsigned int prefetch;
+
+    boost::mutex mutex;
+    boost::condition_variable received;
+    unsigned int inFlight;
+    // Fragments received ahead of the one expected next.
+    std::map<std::uint64_t, Buffer> fragments;
+    std::uint64_t next;
+    bool endRequested;
+    bool atEnd;
+    std::string error;
+  };
+
+  BufferStreamReader::BufferStreamReader(AnyObject stream, std::size_t fragmentSize, unsigned int prefetch)
+  {
+    if (!stream)
+      throw std::invalid_argument("BufferStreamReader: invalid stream");
+    if (fragmentSize == 0 || fragmentSize > std::numeric_limits<unsigned int>::max())
+      throw std::invalid_argument("BufferStreamReader: invalid fragment size");
+    _p = boost::make_shared<BufferStreamReaderPrivate>(std::move(stream), fragmentSize, prefetch);
+  }
+
+  BufferStreamReader::~BufferStreamReader()
+  {
+  }
+
+  Buffer BufferStreamReader::next()
+  {
+    boost::mutex::scoped_lock lock(_p->mutex);
+    if (_p->atEnd)
+      return Buffer();
+    _p->request(_p);
+    auto it = _p->fragments.find(_p->next);
+    while (it == _p->fragments.end())
+    {
+      if (!_p->error.empty())
+        throw std::runtime_error("BufferStreamReader: " + _p->error);
+      _p->received.wait(lock);
+      it = _p->fragments.find(_p->next);
+    }
+    Buffer fragment = std::move(it->second);
+    _p->fragments.erase(it);
+    ++_p->next;
+    if (fragment.size() == 0)
+    {
+      _p->atEnd = true;
+      _p->fragments.clear();
+      qiLogDebug() << "end of stream after " << (_p->next - 1) << " fragments";
+      return fragment;
+    }
+    _p->request(_p);
+    return fragment;
+  }
+
+  bool BufferStreamReader::atEnd() const
+  {
+    boost::mutex::scoped_lock lock(_p->mutex);
+    return _p->atEnd;
+  }
+}
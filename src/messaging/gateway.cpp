@@ -98,6 +98,79 @@ void GwTransaction::setDestinationIfNull(MessageSocketPtr dest)
     _destination = dest;
 }
 
+void OngoingMessageTable::insert(ServiceId service, GWMessageId id, ClientInfo client)
+{
+  Shard& s = shard(id);
+  boost::mutex::scoped_lock lock(s.mutex);
+  s.entries[id] = Entry{ service, std::move(client) };
+}
+
+boost::optional<ClientInfo> OngoingMessageTable::find(ServiceId service, GWMessageId id)
+{
+  Shard& s = shard(id);
+  boost::mutex::scoped_lock lock(s.mutex);
+  auto it = s.entries.find(id);
+  if (it == s.entries.end() || it->second.service != service)
+    return {};
+  return it->second.client;
+}
+
+boost::optional<ClientInfo> OngoingMessageTable::take(ServiceId service, GWMessageId id)
+{
+  Shard& s = shard(id);
+  boost::mutex::scoped_lock lock(s.mutex);
+  auto it = s.entries.find(id);
+  if (it == s.entries.end() || it->second.service != service)
+    return {};
+  ClientInfo client = std::move(it->second.client);
+  s.entries.erase(it);
+  return client;
+}
+
+std::vector<ClientInfo> OngoingMessageTable::takeService(ServiceId service)
+{
+  std::vector<ClientInfo> clients;
+  for (auto& s : _shards)
+  {
+    boost::mutex::scoped_lock lock(s.mutex);
+    for (auto it = s.entries.begin(); it != s.entries.end();)
+    {
+      if (it->second.service == service)
+      {
+        clients.push_back(std::move(it->second.client));
+        it = s.entries.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+  return clients;
+}
+
+void OngoingMessageTable::eraseClient(const MessageSocketPtr& socket)
+{
+  for (auto& s : _shards)
+  {
+    boost::mutex::scoped_lock lock(s.mutex);
+    for (auto it = s.entries.begin(); it != s.entries.end();)
+    {
+      if (it->second.client.socket == socket)
+        it = s.entries.erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
+void OngoingMessageTable::clear()
+{
+  for (auto& s : _shards)
+  {
+    boost::mutex::scoped_lock lock(s.mutex);
+    s.entries.clear();
+  }
+}
+
 Gateway::Gateway(bool enforceAuth)
   : _p(boost::make_shared<GatewayPrivate>(enforceAuth))
   , connected(_p->connected)
@@ -224,10 +297,7 @@ void GatewayPrivate::close(bool clearEndpoints)
     }
     qi::waitForAll(disconnections);
   }
-  {
-    boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-    _ongoingMessages.clear();
-  }
+  _ongoingMessages.clear();
   {
     boost::mutex::scoped_lock lock(_pendingMsgMutex);
     _pendingMessages.clear();
@@ -428,23 +498,7 @@ void GatewayPrivate::onClientDisconnected(MessageSocketPtr socket, std::string u
         ++it;
     }
   }
-  {
-    boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-    OngoingMessagesMap::iterator it = _ongoingMessages.begin();
-    OngoingMessagesMap::iterator end = _ongoingMessages.end();
-    for (; it != end; ++it)
-    {
-      IdLookupMap::iterator msgIt = it->second.begin();
-      IdLookupMap::iterator msgEnd = it->second.end();
-      while (msgIt != msgEnd)
-      {
-        if (msgIt->second.socket == socket)
-          it->second.erase(msgIt++);
-        else
-          msgIt++;
-      }
-    }
-  }
+  _ongoingMessages.eraseClient(socket);
   {
     boost::mutex::scoped_lock lock(_pendingMsgMutex);
     PendingMessagesMap::iterator it = _pendingMessages.begin();
@@ -675,10 +729,7 @@ void GatewayPrivate::forwardMessage(ClientMessageId origId,
     // it as our key in our map message.
     qiLogDebug() << "Forward message: " << forward.address() << " Original id:" << origId
                  << " Origin: " << origin.get() << " Destination: " << destination.get();
-    {
-      boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-      _ongoingMessages[service][gwId] = { origId, origin };
-    }
+    _ongoingMessages.insert(service, gwId, { origId, origin });
     destination->send(forward);
   }
   else
@@ -1051,19 +1102,11 @@ GWMessageId GatewayPrivate::handleCallMessage(GwTransaction& t, MessageSocketPtr
   qiLogDebug() << "Handle call " << t.content.address();
   Message& msg = t.content;
   ServiceId targetService = msg.service();
-  Message forward;
+  // The forwarded message has a gateway-generated id, unique on our side.
+  Message forward = t.relay();
   MessageSocketPtr serviceSocket = destination ? destination : safeGetService(targetService);
 
   t.setDestinationIfNull(serviceSocket);
-  forward.setType(msg.type());
-  forward.setService(msg.service());
-  forward.setObject(msg.object());
-  forward.setFunction(msg.function());
-  // The message buffer is moved because:
-  //  1) Buffer has an entity semantics
-  //  2) the message ends up being reused by the socket and the buffer is cleared
-  forward.setBuffer(Buffer{std::move(msg.buffer())});
-  forward.setFlags(msg.flags());
   // Check if we already have a connection to this service
   if (!serviceSocket || !serviceSocket->isConnected())
   {
@@ -1111,7 +1154,6 @@ void GatewayPrivate::handleReplyMessage(GwTransaction& t)
   Message& msg = t.content;
   ServiceId service = msg.service();
   GWMessageId gwId = msg.id();
-  ClientInfo client;
 
   if (service == 0 && msg.object() > 1)
   {
@@ -1119,22 +1161,18 @@ void GatewayPrivate::handleReplyMessage(GwTransaction& t)
     service = _objectHost.getOriginalObjectAddress(ObjectAddress(service, msg.object())).service;
   }
 
+  const auto client = _ongoingMessages.take(service, gwId);
+  // This is likely an internal message and so can be ignored here
+  if (!client)
   {
-    boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-    // This is likely an internal message and so can be ignored here
-    if (_ongoingMessages[service].find(gwId) == _ongoingMessages[service].end())
-    {
-      qiLogDebug() << "Reply with no original message [" << gwId << "]: " << t.content.address();
-      return;
-    }
-    client = _ongoingMessages[service][gwId];
-    _ongoingMessages[service].erase(gwId);
+    qiLogDebug() << "Reply with no original message [" << gwId << "]: " << t.content.address();
+    return;
   }
 
-  qiLogDebug() << "Reply to socket " << client.socket << " with original ID " << client.id;
-  Message answer(msg);
-  answer.setId(client.id);
-  t.setDestinationIfNull(client.socket);
+  qiLogDebug() << "Reply to socket " << client->socket << " with original ID " << client->id;
+  Message answer = t.relay();
+  answer.setId(client->id);
+  t.setDestinationIfNull(client->socket);
   if (t.destination()->isConnected())
   {
     qiLogVerbose() << "Reply: " << msg.address();
@@ -1184,11 +1222,9 @@ void GatewayPrivate::onAnyMessageReady(const Message& msg, MessageSocketPtr sock
 
       // This is likely an internal message and so can be ignored here
       {
-        boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-        auto& messageMap = _ongoingMessages[serviceId];
-        auto foundIt = messageMap.find(gwId);
-        if (foundIt != _ongoingMessages[serviceId].end() && foundIt->second.socket)
-          return foundIt->second.socket;
+        const auto client = _ongoingMessages.find(serviceId, gwId);
+        if (client && client->socket)
+          return client->socket;
       }
 
       {
@@ -1327,10 +1363,8 @@ void GatewayPrivate::onServiceDirectoryMessageReady(const Message& msg, MessageS
     if (msg.type() != Message::Type_Error)
     {
       MessageSocketPtr origin;
-      {
-        boost::mutex::scoped_lock lock(_ongoingMsgMutex);
-        origin = _ongoingMessages[ServiceSD][msg.id()].socket;
-      }
+      if (const auto client = _ongoingMessages.find(ServiceSD, msg.id()))
+        origin = client->socket;
       int serviceId = msg.value("I", socket).to<unsigned int>();
       {
         boost::recursive_mutex::scoped_lock lock(_serviceMutex);
@@ -1514,18 +1548,12 @@ void GatewayPrivate::invalidateClientsMessages(ServiceId sid)
     _pendingMessages.erase(sid);
   }
   {
-    boost::mutex::scoped_lock lock(_ongoingMsgMutex);
     Message forged;
-    IdLookupMap::iterator it = _ongoingMessages[sid].begin();
-    IdLookupMap::iterator end = _ongoingMessages[sid].end();
-
-    for (; it != end; ++it)
+    for (const auto& client : _ongoingMessages.takeService(sid))
     {
-      forged.setId(it->second.id);
-      serviceUnavailable(sid, forged, it->second.socket);
+      forged.setId(client.id);
+      serviceUnavailable(sid, forged, client.socket);
     }
-    _ongoingMessages[sid].clear();
-    _ongoingMessages.erase(sid);
   }
 }
 
@@ -7,12 +7,15 @@
 #ifndef _SRC_MESSAGING_GATEWAY_P_HPP_
 #define _SRC_MESSAGING_GATEWAY_P_HPP_
 
+#include <boost/optional.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <qi/messaging/gateway.hpp>
 #include <qi/property.hpp>
 #include <qi/periodictask.hpp>
 
+#include <array>
 #include <mutex>
 
 #include "message.hpp"
@@ -50,12 +53,14 @@ class GwTransaction
 public:
   GwTransaction(const Message& msg)
     : content(msg)
+    , _received(msg)
     , _originalObjectId(msg.object())
     , _originalServiceId(msg.service())
   {
   }
   GwTransaction(const GwTransaction& t)
     : content(t.content)
+    , _received(t._received)
     , _destination(t._destination)
     , _originalObjectId(t._originalObjectId)
     , _originalServiceId(t._originalServiceId)
@@ -63,6 +68,25 @@ public:
   }
   Message content;
 
+  /// Returns a new message, with a new id, the header of `content` and the
+  /// payload of the received message.
+  ///
+  /// The payload is shared, not copied: the socket reads the next message in
+  /// a new one and nothing modifies the buffer of a received message.
+  Message relay() const
+  {
+    Message relayed;
+    MessagePrivate::MessageHeader& header = relayed._p->header;
+    const MessagePrivate::MessageHeader& contentHeader = content._p->header;
+    header.type = contentHeader.type;
+    header.flags = contentHeader.flags;
+    header.service = contentHeader.service;
+    header.object = contentHeader.object;
+    header.action = contentHeader.action;
+    relayed._p->buffer = _received.buffer();
+    return relayed;
+  }
+
   void forceDestination(MessageSocketPtr dest);
   void setDestinationIfNull(MessageSocketPtr dest);
   MessageSocketPtr destination()
@@ -79,11 +103,55 @@ public:
   }
 
 private:
+  Message _received;
   MessageSocketPtr _destination;
   ObjectId _originalObjectId;
   ServiceId _originalServiceId;
 };
 
+/// Clients of the messages relayed to services, by id of the relayed
+/// message.
+///
+/// The ids of relayed messages are generated by the gateway and are unique,
+/// so they are the only key. The table is split in shards, each with its own
+/// mutex, so that sockets relaying messages do not contend on a single lock.
+class OngoingMessageTable
+{
+public:
+  void insert(ServiceId service, GWMessageId id, ClientInfo client);
+  /// Returns the client of the message if it was relayed to this service.
+  boost::optional<ClientInfo> find(ServiceId service, GWMessageId id);
+  /// Same as `find` but also removes the message from the table.
+  boost::optional<ClientInfo> take(ServiceId service, GWMessageId id);
+  /// Removes and returns the clients of all messages relayed to this service.
+  std::vector<ClientInfo> takeService(ServiceId service);
+  /// Forgets the messages sent by this client.
+  void eraseClient(const MessageSocketPtr& socket);
+  void clear();
+
+private:
+  struct Entry
+  {
+    ServiceId service;
+    ClientInfo client;
+  };
+
+  struct Shard
+  {
+    boost::mutex mutex;
+    boost::unordered_map<GWMessageId, Entry> entries;
+  };
+
+  static const std::size_t shardCount = 16;
+
+  Shard& shard(GWMessageId id)
+  {
+    return _shards[id % shardCount];
+  }
+
+  std::array<Shard, shardCount> _shards;
+};
+
 class GatewayPrivate : public qi::Trackable<GatewayPrivate>
 {
 public:
@@ -187,12 +255,9 @@ private:
   GwObjectHost _objectHost;
 
 
-  using IdLookupMap = std::map<GWMessageId, ClientInfo >;
-  using OngoingMessagesMap = std::map<ServiceId, IdLookupMap>;
   // This represents the messages that are currently awaiting a response, with both endpoints being known
   // and connected to the gateway.
-  OngoingMessagesMap _ongoingMessages;
-  boost::mutex _ongoingMsgMutex;
+  OngoingMessageTable _ongoingMessages;
 
   // Messages for services that are not registered to the GW yet.
   // Once they are, we'll forward them.
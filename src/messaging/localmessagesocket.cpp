@@ -0,0 +1,621 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+#include <atomic>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <qi/getenv.hpp>
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+#include <qi/scoped.hpp>
+#include <qi/messaging/sock/networkasio.hpp>
+#include <qi/messaging/sock/send.hpp>
+#include "localmessagesocket.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+qiLogCategory("qimessaging.localmessagesocket");
+
+namespace qi
+{
+  namespace
+  {
+    struct LocalSocketDir
+    {
+      std::string path;
+      // False if the directory was configured by the user, who is then
+      // responsible for its permissions.
+      bool isPrivate;
+    };
+
+    const LocalSocketDir& localSocketDir()
+    {
+      static const LocalSocketDir dir = [] {
+        const std::string configured = qi::os::getenv("QI_LOCAL_SOCKET_DIR");
+        if (!configured.empty())
+          return LocalSocketDir{configured, false};
+        const std::string runtime = qi::os::getenv("XDG_RUNTIME_DIR");
+        if (!runtime.empty())
+          return LocalSocketDir{(boost::filesystem::path(runtime) / "qi").string(), true};
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        return LocalSocketDir{"/tmp/qi-" + boost::lexical_cast<std::string>(::geteuid()), true};
+#else
+        return LocalSocketDir{"/tmp/qi", true};
+#endif
+      }();
+      return dir;
+    }
+  }
+
+  std::string localSocketPath(const Url& url)
+  {
+    const auto name = "qi-" + boost::lexical_cast<std::string>(url.port()) + ".sock";
+    return (boost::filesystem::path(localSocketDir().path) / name).string();
+  }
+
+  boost::system::error_code checkLocalSocketDir(bool create)
+  {
+    boost::system::error_code erc;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    const auto& dir = localSocketDir();
+    if (create && ::mkdir(dir.path.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+      erc.assign(errno, boost::system::system_category());
+      qiLogWarning() << "Cannot create local socket directory " << dir.path << ": " << erc.message();
+      return erc;
+    }
+    if (!dir.isPrivate)
+      return erc;
+    // Anybody able to write in the directory could replace our sockets or
+    // have us connect to theirs.
+    struct stat st;
+    if (::lstat(dir.path.c_str(), &st) != 0)
+    {
+      erc.assign(errno, boost::system::system_category());
+      return erc;
+    }
+    if (!S_ISDIR(st.st_mode) || st.st_uid != ::geteuid() || (st.st_mode & 077) != 0)
+    {
+      qiLogWarning() << "Local socket directory " << dir.path
+                     << " must be a directory private to the current user.";
+      erc = boost::asio::error::access_denied;
+    }
+#else
+    (void)create;
+    erc = boost::asio::error::operation_not_supported;
+#endif
+    return erc;
+  }
+
+  bool isLocalTransportAdvertised()
+  {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    static const bool advertised = qi::os::getEnvDefault("QI_LOCAL_TRANSPORT", false);
+    return advertised;
+#else
+    return false;
+#endif
+  }
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  namespace
+  {
+    /// Replaces the magic of messages whose payload is in a shared memory
+    /// segment. Their payload is the name of the segment.
+    const qi::uint32_t segmentMagic = 0x42adde43;
+    const std::string segmentPrefix = "/qi-";
+    const std::size_t maxSegmentNameSize = 255;
+
+    std::size_t segmentThreshold()
+    {
+      static const std::size_t threshold =
+          qi::os::getEnvDefault<std::size_t>("QI_LOCAL_SHM_THRESHOLD", 64 * 1024);
+      return threshold;
+    }
+
+    /// Writes the payload of the message to a new shared memory segment, as it
+    /// would be sent through a socket, and returns the name of the segment, or
+    /// an empty string on failure.
+    std::string writeSegment(const Message& msg)
+    {
+      static std::atomic<unsigned int> segmentCount{0};
+      const std::string name = segmentPrefix + boost::lexical_cast<std::string>(os::getpid())
+          + "-" + boost::lexical_cast<std::string>(segmentCount++);
+      const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd < 0)
+      {
+        qiLogVerbose() << "Cannot create shared memory segment " << name << ": " << strerror(errno);
+        return {};
+      }
+      // The first buffer is the header, which goes through the socket.
+      const auto buffers = sock::makeBuffers<sock::NetworkAsio>(msg);
+      const std::size_t size = msg.buffer().totalSize();
+      void* data = MAP_FAILED;
+      if (::ftruncate(fd, size) == 0)
+        data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (data == MAP_FAILED)
+      {
+        qiLogVerbose() << "Cannot map shared memory segment " << name << ": " << strerror(errno);
+        ::shm_unlink(name.c_str());
+        return {};
+      }
+      auto out = static_cast<unsigned char*>(data);
+      for (std::size_t i = 1; i < buffers.size(); ++i)
+      {
+        const auto chunkSize = boost::asio::buffer_size(buffers[i]);
+        std::memcpy(out, boost::asio::buffer_cast<const void*>(buffers[i]), chunkSize);
+        out += chunkSize;
+      }
+      ::munmap(data, size);
+      return name;
+    }
+
+    /// Returns true if the segment was not unlinked yet.
+    bool segmentExists(const std::string& name)
+    {
+      const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+      if (fd < 0)
+        return errno != ENOENT;
+      ::close(fd);
+      return true;
+    }
+
+    /// Returns true if the peer runs as the same user as this process, and can
+    /// therefore open the segments we create.
+    bool isSameUserPeer(LocalMessageSocket::Socket& socket)
+    {
+#if defined(SO_PEERCRED)
+      struct ucred cred;
+      socklen_t size = sizeof(cred);
+      if (::getsockopt(socket.native_handle(), SOL_SOCKET, SO_PEERCRED, &cred, &size) != 0)
+        return false;
+      return cred.uid == ::geteuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+      uid_t uid;
+      gid_t gid;
+      if (::getpeereid(socket.native_handle(), &uid, &gid) != 0)
+        return false;
+      return uid == ::geteuid();
+#else
+      (void)socket;
+      return false;
+#endif
+    }
+
+    /// Reads the payload of a message from a shared memory segment, and
+    /// unlinks it.
+    bool readSegment(const std::string& name, Buffer& buffer, std::size_t maxPayload)
+    {
+      if (name.compare(0, segmentPrefix.size(), segmentPrefix) != 0
+          || name.find('/', 1) != std::string::npos)
+      {
+        qiLogWarning() << "Invalid shared memory segment name: " << name;
+        return false;
+      }
+      const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+      if (fd < 0)
+      {
+        qiLogWarning() << "Cannot open shared memory segment " << name << ": " << strerror(errno);
+        return false;
+      }
+      ::shm_unlink(name.c_str());
+      auto closeFd = scoped([=] { ::close(fd); });
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+        return false;
+      const std::size_t size = static_cast<std::size_t>(st.st_size);
+      if (size > maxPayload)
+      {
+        qiLogWarning() << "Receiving message of size " << size
+                       << " above maximum configured payload size " << maxPayload
+                       << " (configure with environment variable QI_MAX_MESSAGE_PAYLOAD).";
+        return false;
+      }
+      if (size == 0)
+        return true;
+      void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED)
+      {
+        qiLogWarning() << "Cannot map shared memory segment " << name << ": " << strerror(errno);
+        return false;
+      }
+      // Buffer cannot refer to foreign memory, the payload is copied once.
+      std::memcpy(buffer.reserve(size), data, size);
+      ::munmap(data, size);
+      return true;
+    }
+  }
+
+  LocalMessageSocket::LocalMessageSocket(boost::asio::io_service& io, SocketPtr socket)
+    : _ioService(io)
+    , _socket(socket)
+    , _peerOpensSegments(false)
+  {
+    if (socket)
+      _status = Status::Connecting;
+  }
+
+  LocalMessageSocket::~LocalMessageSocket()
+  {
+    // We are in the destructor, so no concurrency problem.
+    if (_socket)
+    {
+      boost::system::error_code erc;
+      _socket->close(erc);
+    }
+    unlinkSentSegments();
+  }
+
+  FutureSync<void> LocalMessageSocket::connect(const Url& url)
+  {
+    Promise<void> connectedPromise;
+    boost::mutex::scoped_lock lock(_stateMutex);
+    if (_status != Status::Disconnected)
+    {
+      qiLogWarning() << this << " connect() but status is " << static_cast<int>(_status.load());
+      return makeFutureError<void>("Must be disconnected to connect().");
+    }
+    const auto dirErc = checkLocalSocketDir(false);
+    if (dirErc)
+      return makeFutureError<void>("Connect error: " + dirErc.message());
+    auto socket = boost::make_shared<Socket>(_ioService);
+    _socket = socket;
+    _url = url;
+    _status = Status::Connecting;
+    auto self = shared_from_this();
+    const boost::asio::local::stream_protocol::endpoint endpoint(localSocketPath(url));
+    socket->async_connect(endpoint, [=](const boost::system::error_code& erc) mutable {
+      {
+        boost::mutex::scoped_lock lock(self->_stateMutex);
+        if (self->_socket != socket)
+        {
+          connectedPromise.setError("Connect abort: disconnection requested while connecting");
+          return;
+        }
+        if (erc)
+        {
+          self->_socket.reset();
+          self->_status = Status::Disconnected;
+          connectedPromise.setError("Connect error: " + erc.message());
+          return;
+        }
+        self->_status = Status::Connected;
+        self->startReading(socket);
+      }
+      self->connected();
+      connectedPromise.setValue(nullptr);
+      qiLogDebug() << self.get() << " connected to " << url.str();
+    });
+    return connectedPromise.future();
+  }
+
+  bool LocalMessageSocket::ensureReading()
+  {
+    {
+      boost::mutex::scoped_lock lock(_stateMutex);
+      if (_status != Status::Connecting || !_socket)
+      {
+        qiLogInfo() << this << " ensureReading: socket must be in connecting state.";
+        return false;
+      }
+      _status = Status::Connected;
+      startReading(_socket);
+    }
+    connected();
+    return true;
+  }
+
+  FutureSync<void> LocalMessageSocket::disconnect()
+  {
+    SocketPtr socket;
+    {
+      boost::mutex::scoped_lock lock(_stateMutex);
+      socket = _socket;
+    }
+    return doDisconnect(socket);
+  }
+
+  FutureSync<void> LocalMessageSocket::doDisconnect(const SocketPtr& socket)
+  {
+    bool wasConnected = false;
+    {
+      boost::mutex::scoped_lock lock(_stateMutex);
+      // libqi's code heavily relies on socket disconnection being reentrant...
+      if (!socket || _socket != socket)
+        return Future<void>(nullptr);
+      wasConnected = _status == Status::Connected;
+      _status = Status::Disconnecting;
+      // Pending operations keep the socket alive and complete with an error.
+      boost::system::error_code erc;
+      socket->close(erc);
+      _socket.reset();
+      _sendQueue.clear();
+      _counters.sendQueueCleared();
+      // The peer will not read the segments not read yet.
+      unlinkSentSegments();
+      _status = Status::Disconnected;
+    }
+    static const std::string data{"disconnected"};
+    if (wasConnected)
+      disconnected(data);
+    socketEvent(SocketEventData(data));
+    return Future<void>(nullptr);
+  }
+
+  void LocalMessageSocket::onError(const SocketPtr& socket, const std::string& error)
+  {
+    qiLogDebug() << this << " socket exited connected state: " << error;
+    doDisconnect(socket);
+  }
+
+  MessageSocket::Status LocalMessageSocket::status() const
+  {
+    return _status;
+  }
+
+  boost::optional<Url> LocalMessageSocket::remoteEndpoint() const
+  {
+    boost::mutex::scoped_lock lock(_stateMutex);
+    if (_status == Status::Connected)
+      return _url;
+    return {};
+  }
+
+  Url LocalMessageSocket::url() const
+  {
+    boost::mutex::scoped_lock lock(_stateMutex);
+    return _url;
+  }
+
+  void LocalMessageSocket::setUrl(const Url& url)
+  {
+    boost::mutex::scoped_lock lock(_stateMutex);
+    _url = url;
+  }
+
+  void LocalMessageSocket::startReading(const SocketPtr& socket)
+  {
+    _peerOpensSegments = isSameUserPeer(*socket);
+    if (!_peerOpensSegments)
+      qiLogVerbose() << this << " peer runs as another user, not using shared memory";
+    readHeader(socket);
+  }
+
+  void LocalMessageSocket::pruneSentSegments()
+  {
+    // The peer reads the segments in order, so the first one still existing
+    // is the next one it will read.
+    while (!_sentSegments.empty() && !segmentExists(_sentSegments.front()))
+      _sentSegments.pop_front();
+  }
+
+  void LocalMessageSocket::unlinkSentSegments()
+  {
+    for (const auto& name : _sentSegments)
+      ::shm_unlink(name.c_str());
+    _sentSegments.clear();
+  }
+
+  void LocalMessageSocket::readHeader(const SocketPtr& socket)
+  {
+    auto self = shared_from_this();
+    boost::asio::async_read(*socket,
+        boost::asio::buffer(_inMessage._p->getHeader(), sizeof(MessagePrivate::MessageHeader)),
+        [=](const boost::system::error_code& erc, std::size_t) {
+          self->onReadHeader(socket, erc);
+        });
+  }
+
+  void LocalMessageSocket::onReadHeader(const SocketPtr& socket, const boost::system::error_code& erc)
+  {
+    static const auto maxPayload = getMaxPayloadFromEnv();
+    if (erc)
+    {
+      onError(socket, erc.message());
+      return;
+    }
+    auto self = shared_from_this();
+    const auto& header = _inMessage._p->header;
+    if (header.magic == segmentMagic)
+    {
+      if (header.size == 0 || header.size > maxSegmentNameSize)
+      {
+        onError(socket, "invalid shared memory segment name size");
+        return;
+      }
+      _inSegmentName.resize(header.size);
+      boost::asio::async_read(*socket, boost::asio::buffer(&_inSegmentName[0], header.size),
+          [=](const boost::system::error_code& erc, std::size_t) {
+            self->onReadSegmentName(socket, erc);
+          });
+      return;
+    }
+    if (header.magic != MessagePrivate::magic)
+    {
+      qiLogWarning() << this << ": Incorrect magic (expected " << MessagePrivate::magic
+                     << ", got " << header.magic << ").";
+      onError(socket, "incorrect magic");
+      return;
+    }
+    const std::size_t payload = header.size;
+    if (payload == 0u)
+    {
+      onMessage(socket);
+      return;
+    }
+    if (payload > maxPayload)
+    {
+      qiLogWarning() << "Receiving message of size " << payload
+                     << " above maximum configured payload size " << maxPayload
+                     << " (configure with environment variable QI_MAX_MESSAGE_PAYLOAD).";
+      onError(socket, "message too big");
+      return;
+    }
+    void* data = _inMessage._p->buffer.reserve(payload);
+    boost::asio::async_read(*socket, boost::asio::buffer(data, payload),
+        [=](const boost::system::error_code& erc, std::size_t) {
+          self->onReadPayload(socket, erc);
+        });
+  }
+
+  void LocalMessageSocket::onReadPayload(const SocketPtr& socket, const boost::system::error_code& erc)
+  {
+    if (erc)
+    {
+      onError(socket, erc.message());
+      return;
+    }
+    onMessage(socket);
+  }
+
+  void LocalMessageSocket::onReadSegmentName(const SocketPtr& socket, const boost::system::error_code& erc)
+  {
+    static const auto maxPayload = getMaxPayloadFromEnv();
+    if (erc)
+    {
+      onError(socket, erc.message());
+      return;
+    }
+    auto& header = _inMessage._p->header;
+    if (!readSegment(_inSegmentName, _inMessage._p->buffer, maxPayload))
+    {
+      onError(socket, "cannot read shared memory segment");
+      return;
+    }
+    header.magic = MessagePrivate::magic;
+    header.size = static_cast<qi::uint32_t>(_inMessage._p->buffer.size());
+    onMessage(socket);
+  }
+
+  void LocalMessageSocket::onMessage(const SocketPtr& socket)
+  {
+    qiLogDebug() << this << " Message received " << _inMessage.id();
+    if (!handleMessage(_inMessage))
+    {
+      onError(socket, "message handling failed");
+      return;
+    }
+    // The handlers may have kept copies sharing the message.
+    _inMessage = Message();
+    {
+      boost::mutex::scoped_lock lock(_stateMutex);
+      if (_socket != socket)
+        return;
+    }
+    readHeader(socket);
+  }
+
+  bool LocalMessageSocket::handleCapabilityMessage(const Message& msg)
+  {
+    AnyReference cmRef;
+    try
+    {
+      cmRef = msg.value(typeOf<CapabilityMap>()->signature(), shared_from_this());
+      CapabilityMap cm = cmRef.to<CapabilityMap>();
+      cmRef.destroy();
+      boost::mutex::scoped_lock lock(_contextMutex);
+      _remoteCapabilityMap.insert(cm.begin(), cm.end());
+    }
+    catch (const std::runtime_error& e)
+    {
+      cmRef.destroy();
+      qiLogError() << this << " Ill-formed capabilities message: " << e.what();
+      return false;
+    }
+    return true;
+  }
+
+  bool LocalMessageSocket::handleMessage(const Message& msg)
+  {
+    _counters.messageReceived(msg);
+    const bool authentication = !hasReceivedRemoteCapabilities()
+        && msg.service() == Message::Service_Server
+        && msg.function() == Message::ServerFunction_Authenticate;
+    if (authentication || msg.type() == Message::Type_Capability)
+    {
+      bool success = false;
+      if (msg.type() != Message::Type_Error)
+        success = handleCapabilityMessage(msg);
+      if (!success || msg.type() == Message::Type_Capability)
+        return success;
+    }
+    messageReady(msg);
+    socketEvent(SocketEventData(msg));
+    _dispatcher.dispatch(msg);
+    return true;
+  }
+
+  bool LocalMessageSocket::send(const Message& msg)
+  {
+    boost::mutex::scoped_lock lock(_stateMutex);
+    if (_status != Status::Connected)
+    {
+      qiLogWarning() << this << " Socket must be connected to send().";
+      return false;
+    }
+    _sendQueue.push_back(msg);
+    _counters.messageEnqueued();
+    if (_writing.empty())
+      startWrite();
+    return true;
+  }
+
+  void LocalMessageSocket::startWrite()
+  {
+    const auto threshold = segmentThreshold();
+    std::vector<boost::asio::const_buffer> buffers;
+    _writing.reserve(_sendQueue.size());
+    pruneSentSegments();
+    for (auto& msg : _sendQueue)
+    {
+      _writing.push_back(PendingWrite{std::move(msg), {}, {}});
+      auto& write = _writing.back();
+      if (_peerOpensSegments && write.message.buffer().totalSize() >= threshold)
+        write.segmentName = writeSegment(write.message);
+      if (write.segmentName.empty())
+      {
+        sock::appendBuffers<sock::NetworkAsio>(buffers, write.message);
+        continue;
+      }
+      _sentSegments.push_back(write.segmentName);
+      write.segmentHeader = write.message._p->header;
+      write.segmentHeader.magic = segmentMagic;
+      write.segmentHeader.size = static_cast<qi::uint32_t>(write.segmentName.size());
+      buffers.push_back(boost::asio::buffer(&write.segmentHeader, sizeof(write.segmentHeader)));
+      buffers.push_back(boost::asio::buffer(write.segmentName));
+    }
+    _sendQueue.clear();
+    auto self = shared_from_this();
+    auto socket = _socket;
+    boost::asio::async_write(*socket, std::move(buffers),
+        [=](const boost::system::error_code& erc, std::size_t) {
+          self->onWrite(socket, erc);
+        });
+  }
+
+  void LocalMessageSocket::onWrite(const SocketPtr& socket, const boost::system::error_code& erc)
+  {
+    {
+      boost::mutex::scoped_lock lock(_stateMutex);
+      // On error, the segments not read are unlinked by the disconnection.
+      for (const auto& write : _writing)
+        _counters.messageWritten(write.message, !erc);
+      _writing.clear();
+      // Messages may have been queued for a new connection in the meantime.
+      if (_socket && _status == Status::Connected && !_sendQueue.empty())
+        startWrite();
+    }
+    if (erc)
+      onError(socket, erc.message());
+  }
+#endif
+}
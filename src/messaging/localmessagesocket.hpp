@@ -0,0 +1,129 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_LOCALMESSAGESOCKET_HPP_
+#define _SRC_LOCALMESSAGESOCKET_HPP_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <qi/url.hpp>
+#include "message.hpp"
+#include "messagesocket.hpp"
+
+/// @file
+/// Contains a socket to send and receive qi::Messages between processes of the
+/// same machine, through a Unix-domain socket.
+
+namespace qi
+{
+  /// Url scheme of the local transport.
+  const char* const localProtocol = "unix";
+
+  /// Returns the path of the Unix-domain socket of an url like
+  /// `unix://localhost:<port>`. The port only identifies the socket, which is
+  /// created in the directory given by QI_LOCAL_SOCKET_DIR, or by default in
+  /// `$XDG_RUNTIME_DIR/qi`, or `/tmp/qi-<uid>` if XDG_RUNTIME_DIR is not set.
+  std::string localSocketPath(const Url& url);
+
+  /// Checks that the directory of the local sockets is private to the current
+  /// user, creating it with mode 0700 if `create` is true. No check is done on
+  /// a directory given by QI_LOCAL_SOCKET_DIR, except for its existence.
+  boost::system::error_code checkLocalSocketDir(bool create);
+
+  /// Returns true if sessions listening automatically also listen to a local
+  /// endpoint, which is the case if QI_LOCAL_TRANSPORT is set to 1.
+  bool isLocalTransportAdvertised();
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  /// A message socket over a Unix-domain socket.
+  ///
+  /// Messages are framed as over tcp, except for the ones bigger than
+  /// QI_LOCAL_SHM_THRESHOLD bytes (64KiB by default): their payload is written
+  /// to a shared memory segment, and only the header and the name of the
+  /// segment go through the socket. The receiver unlinks the segment as soon as
+  /// it has opened it, the sender unlinks the segments the receiver did not
+  /// open when disconnecting. Segments are only used if the peer runs as the
+  /// same user, the only one able to open them.
+  ///
+  /// The socket kinematics are the same as the ones of TcpMessageSocket:
+  /// client-side sockets are constructed disconnected and connect(), server-side
+  /// ones are constructed connecting and ensureReading().
+  class LocalMessageSocket
+    : public MessageSocket
+    , public boost::enable_shared_from_this<LocalMessageSocket>
+  {
+  public:
+    using Socket = boost::asio::local::stream_protocol::socket;
+    using SocketPtr = boost::shared_ptr<Socket>;
+
+    /// If the socket is not null, we consider we are on server side.
+    explicit LocalMessageSocket(boost::asio::io_service& io, SocketPtr socket = {});
+    ~LocalMessageSocket();
+
+    FutureSync<void> connect(const Url& url) override;
+    FutureSync<void> disconnect() override;
+    bool send(const Message& msg) override;
+    bool ensureReading() override;
+    Status status() const override;
+    boost::optional<Url> remoteEndpoint() const override;
+    Url url() const override;
+
+    /// Sets the url reported by server-side sockets.
+    void setUrl(const Url& url);
+
+  private:
+    struct PendingWrite
+    {
+      Message message;
+      // Set if the payload of the message went to a shared memory segment.
+      MessagePrivate::MessageHeader segmentHeader;
+      std::string segmentName;
+    };
+
+    void startReading(const SocketPtr& socket);
+    void readHeader(const SocketPtr& socket);
+    void onReadHeader(const SocketPtr& socket, const boost::system::error_code& erc);
+    void onReadPayload(const SocketPtr& socket, const boost::system::error_code& erc);
+    void onReadSegmentName(const SocketPtr& socket, const boost::system::error_code& erc);
+    void onMessage(const SocketPtr& socket);
+    /// _stateMutex must be locked.
+    void startWrite();
+    /// _stateMutex must be locked.
+    void pruneSentSegments();
+    /// _stateMutex must be locked.
+    void unlinkSentSegments();
+    void onWrite(const SocketPtr& socket, const boost::system::error_code& erc);
+    /// Disconnects if `socket` is still the current one.
+    void onError(const SocketPtr& socket, const std::string& error);
+    FutureSync<void> doDisconnect(const SocketPtr& socket);
+
+    bool handleCapabilityMessage(const Message& msg);
+    bool handleMessage(const Message& msg);
+
+    boost::asio::io_service& _ioService;
+    mutable boost::mutex _stateMutex;
+    SocketPtr _socket;
+    Url _url;
+    std::vector<Message> _sendQueue;
+    std::vector<PendingWrite> _writing;
+    // Segments sent and maybe not opened by the peer yet, in sending order.
+    std::deque<std::string> _sentSegments;
+    // Set when the connection starts, before any write.
+    bool _peerOpensSegments;
+    // Only used by the reading operation in progress.
+    Message _inMessage;
+    std::string _inSegmentName;
+  };
+
+  using LocalMessageSocketPtr = boost::shared_ptr<LocalMessageSocket>;
+#endif
+}
+
+#endif  // _SRC_LOCALMESSAGESOCKET_HPP_
@@ -2,6 +2,7 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <algorithm>
 #include <cstring>
 
 #include <boost/make_shared.hpp>
@@ -265,6 +266,25 @@ namespace qi {
     return _p->header.flags;
   }
 
+  void Message::appendDeadline(SteadyClockTimePoint deadline)
+  {
+    cow();
+    const qi::int64_t timeLeft = std::max<qi::int64_t>(0,
+        boost::chrono::duration_cast<qi::MicroSeconds>(deadline - SteadyClock::now()).count());
+    _p->buffer.write(&timeLeft, sizeof(timeLeft));
+    _p->header.flags |= TypeFlag_Deadline;
+  }
+
+  boost::optional<Duration> Message::deadlineTimeLeft() const
+  {
+    const Buffer& buffer = _p->buffer;
+    if (!(flags() & TypeFlag_Deadline) || buffer.size() < sizeof(qi::int64_t))
+      return {};
+    qi::int64_t timeLeft = 0;
+    buffer.read(&timeLeft, buffer.size() - sizeof(timeLeft), sizeof(timeLeft));
+    return Duration(qi::MicroSeconds(timeLeft));
+  }
+
   void Message::setService(qi::uint32_t service)
   {
     cow();
@@ -14,6 +14,8 @@
 #include <qi/anyfunction.hpp>
 #include <qi/types.hpp>
 #include <qi/macroregular.hpp>
+#include <qi/clock.hpp>
+#include <boost/optional.hpp>
 #include <boost/weak_ptr.hpp>
 
 namespace qi {
@@ -161,6 +163,11 @@ namespace qi {
      * NOT IMPLEMENTED
      */
     static const unsigned int TypeFlag_ReturnType = 2;
+    /* If flag is set, the last 8 bytes of a call payload are the time that
+     * was left before the deadline of the call when it was sent, in
+     * microseconds. Only sent to ends with the CallDeadlines capability.
+     */
+    static const unsigned int TypeFlag_Deadline = 4;
 
     static const char* typeToString(Type t);
     static const char* actionToString(unsigned int action, unsigned int service);
@@ -217,6 +224,12 @@ namespace qi {
     void setValues(const std::vector<qi::AnyReference>& values, const qi::Signature& targetSignature, boost::weak_ptr<ObjectHost> context = {}, StreamContext* streamContext = 0);
     /// Append additional data to payload
     void appendValue(const AutoAnyReference& value, boost::weak_ptr<ObjectHost> context = {}, StreamContext* streamContext = 0);
+    /// Append the time left before `deadline` to payload, after any other
+    /// value, and set TypeFlag_Deadline.
+    void appendDeadline(SteadyClockTimePoint deadline);
+    /// Time that was left before the deadline of the call when it was sent,
+    /// if it has one.
+    boost::optional<Duration> deadlineTimeLeft() const;
     MessageAddress address() const;
 
     bool         isValid() const;
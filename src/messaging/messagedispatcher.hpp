@@ -7,6 +7,8 @@
 #ifndef _SRC_MESSAGEDISPATCHER_HPP_
 #define _SRC_MESSAGEDISPATCHER_HPP_
 
+#include <map>
+#include <memory>
 #include <qi/anyobject.hpp>
 #include <qi/signal.hpp>
 #include <boost/thread/mutex.hpp>
@@ -21,20 +23,19 @@ namespace qi {
    * Receive message from a TransportSocket and send them on the appropriate
    * signal, based on the serviceId of the message.
    *
-   * This class generate an error message for all pending message that have timed out.
-   * at the moment it only generate message if the socket have been disconnected.
+   * Messages are dispatched from an immutable snapshot of the signal map,
+   * without locking. Connecting and disconnecting signals publish a new
+   * snapshot.
    *
-   * TODO: handle timeout on request taking too long to complete
+   * Pending calls are not tracked here: each RemoteObject matches the replies
+   * to its calls, and fails them when the socket is disconnected.
    */
   class MessageDispatcher {
   public:
     MessageDispatcher();
 
-    //internal: called by Socket to tell the class that we sent a message
-    void sent(const qi::Message& msg);
     //internal: called by Socket to tell the class a message have been receive
     void dispatch(const qi::Message& msg);
-    void cleanPendingMessages();
 
     static const unsigned int ALL_OBJECTS;
     qi::SignalLink messagePendingConnect(unsigned int serviceId, unsigned int objectId, boost::function<void (const qi::Message&)> fun);
@@ -45,13 +46,11 @@ namespace qi {
     using OnMessageSignal = Signal<const qi::Message&>;
     // use shared-ptr on signal so that we may hold it without holding the map lock
     using SignalMap = std::map<Target, boost::shared_ptr<OnMessageSignal> >;
-    using MessageSentMap = std::map<unsigned int, MessageAddress>;
 
-    SignalMap              _signalMap;
+    // Copy of the map read by dispatch() without locking the mutex, replaced
+    // as a whole on each change.
+    std::shared_ptr<const SignalMap> _signalMap;
     boost::recursive_mutex _signalMapMutex;
-
-    MessageSentMap         _messageSent;
-    boost::mutex           _messageSentMutex;
   };
 
 }
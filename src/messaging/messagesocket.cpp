@@ -1,7 +1,9 @@
+#include <ostream>
 #include <qi/log.hpp>
 #include <qi/messaging/sock/option.hpp>
 #include "messagesocket.hpp"
 #include "tcpmessagesocket.hpp"
+#include "localmessagesocket.hpp"
 
 // Disable "'this': used in base member initializer list"
 #if BOOST_COMP_MSVC
@@ -14,6 +16,104 @@ qiLogCategory(qi::sock::logCategory());
 
 namespace qi
 {
+  namespace
+  {
+    std::size_t wireSize(const Message& msg)
+    {
+      return sizeof(MessagePrivate::MessageHeader) + msg.buffer().totalSize();
+    }
+
+    template<typename T>
+    void storeMax(std::atomic<T>& max, T value)
+    {
+      T current = max.load(std::memory_order_relaxed);
+      while (current < value
+             && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    /// Subtracts `count` from `value`, without going below zero: the queue may
+    /// have been cleared before its messages are reported.
+    template<typename T>
+    void subtractSaturated(std::atomic<T>& value, T count)
+    {
+      T current = value.load(std::memory_order_relaxed);
+      while (!value.compare_exchange_weak(current, current > count ? current - count : T(0),
+                                          std::memory_order_relaxed))
+      {
+      }
+    }
+  }
+
+  MessageSocketCounters::MessageSocketCounters()
+    : _bytesSent(0)
+    , _bytesReceived(0)
+    , _messagesSent(0)
+    , _messagesReceived(0)
+    , _messagesDiscarded(0)
+    , _sendQueueDepth(0)
+    , _sendQueueHighWatermark(0)
+  {
+  }
+
+  void MessageSocketCounters::messageEnqueued()
+  {
+    const auto depth = _sendQueueDepth.fetch_add(1u, std::memory_order_relaxed) + 1u;
+    storeMax(_sendQueueHighWatermark, depth);
+  }
+
+  void MessageSocketCounters::messageWritten(const Message& msg, bool success)
+  {
+    subtractSaturated(_sendQueueDepth, std::uint64_t(1u));
+    if (!success)
+      return;
+    _bytesSent.fetch_add(wireSize(msg), std::memory_order_relaxed);
+    _messagesSent.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  void MessageSocketCounters::messagesDiscarded(std::size_t count)
+  {
+    if (count == 0)
+      return;
+    subtractSaturated(_sendQueueDepth, std::uint64_t(count));
+    _messagesDiscarded.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void MessageSocketCounters::sendQueueCleared()
+  {
+    _sendQueueDepth.store(0u, std::memory_order_relaxed);
+  }
+
+  void MessageSocketCounters::messageReceived(const Message& msg)
+  {
+    _bytesReceived.fetch_add(wireSize(msg), std::memory_order_relaxed);
+    _messagesReceived.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  ConnectionMetrics MessageSocketCounters::snapshot() const
+  {
+    ConnectionMetrics metrics;
+    const auto relaxed = std::memory_order_relaxed;
+    metrics.bytesSent = _bytesSent.load(relaxed);
+    metrics.bytesReceived = _bytesReceived.load(relaxed);
+    metrics.messagesSent = _messagesSent.load(relaxed);
+    metrics.messagesReceived = _messagesReceived.load(relaxed);
+    metrics.messagesDiscarded = _messagesDiscarded.load(relaxed);
+    metrics.sendQueueDepth = _sendQueueDepth.load(relaxed);
+    metrics.sendQueueHighWatermark = _sendQueueHighWatermark.load(relaxed);
+    return metrics;
+  }
+
+  std::ostream& operator<<(std::ostream& o, const ConnectionMetrics& m)
+  {
+    return o << m.remoteEndpoint.str() << ": sent " << m.messagesSent << " messages ("
+             << m.bytesSent << " bytes), received " << m.messagesReceived << " messages ("
+             << m.bytesReceived << " bytes), discarded " << m.messagesDiscarded
+             << " messages, send queue " << m.sendQueueDepth << " (max "
+             << m.sendQueueHighWatermark << ")";
+  }
+
   MessageSocket::~MessageSocket()
   {
     qiLogDebug() << "Destroying transport socket";
@@ -24,6 +124,14 @@ namespace qi
     return _status == qi::MessageSocket::Status::Connected;
   }
 
+  ConnectionMetrics MessageSocket::metrics() const
+  {
+    ConnectionMetrics metrics = _counters.snapshot();
+    if (auto endpoint = remoteEndpoint())
+      metrics.remoteEndpoint = *endpoint;
+    return metrics;
+  }
+
   MessageSocketPtr makeMessageSocket(const std::string &protocol, qi::EventLoop *eventLoop)
   {
     MessageSocketPtr ret;
@@ -36,6 +144,12 @@ namespace qi
     {
       return TcpMessageSocketPtr(new TcpMessageSocket<>(*asIoServicePtr(eventLoop), true));
     }
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    if (protocol == localProtocol)
+    {
+      return boost::make_shared<LocalMessageSocket>(*asIoServicePtr(eventLoop));
+    }
+#endif
     qiLogError() << "Unrecognized protocol to create the TransportSocket: " << protocol;
     return ret;
   }
@@ -2,6 +2,8 @@
 #ifndef _SRC_MESSAGESOCKET_HPP_
 #define _SRC_MESSAGESOCKET_HPP_
 
+# include <atomic>
+# include <cstdint>
 # include <boost/noncopyable.hpp>
 # include <boost/variant.hpp>
 # include <boost/optional.hpp>
@@ -11,6 +13,7 @@
 # include <qi/eventloop.hpp>
 # include <qi/signal.hpp>
 # include <qi/binarycodec.hpp>
+# include <qi/messaging/connectionmetrics.hpp>
 # include <string>
 # include "messagedispatcher.hpp"
 # include "streamcontext.hpp"
@@ -35,6 +38,39 @@ namespace qi
 
   class Session;
 
+  /// Traffic counters of a message socket.
+  ///
+  /// The counters are relaxed atomics that can be read at any time. They are
+  /// not updated together, so a snapshot may be slightly inconsistent.
+  class MessageSocketCounters
+  {
+  public:
+    MessageSocketCounters();
+
+    /// A message has been put in the send queue.
+    void messageEnqueued();
+    /// A message of the send queue has been written, or has failed to be if
+    /// `success` is false.
+    void messageWritten(const Message& msg, bool success);
+    /// Messages of the send queue, including one that has just been enqueued,
+    /// have been discarded by the policy of the send queue.
+    void messagesDiscarded(std::size_t count);
+    /// The messages waiting to be sent have been dropped.
+    void sendQueueCleared();
+    void messageReceived(const Message& msg);
+
+    ConnectionMetrics snapshot() const;
+
+  private:
+    std::atomic<std::uint64_t> _bytesSent;
+    std::atomic<std::uint64_t> _bytesReceived;
+    std::atomic<std::uint64_t> _messagesSent;
+    std::atomic<std::uint64_t> _messagesReceived;
+    std::atomic<std::uint64_t> _messagesDiscarded;
+    std::atomic<std::uint64_t> _sendQueueDepth;
+    std::atomic<std::uint64_t> _sendQueueHighWatermark;
+  };
+
   class MessageSocket : private boost::noncopyable, public StreamContext
   {
   public:
@@ -88,9 +124,13 @@ namespace qi
       _dispatcher.messagePendingDisconnect(serviceId, objectId, linkId);
     }
 
+    /// Returns a snapshot of the traffic counters of the socket.
+    ConnectionMetrics metrics() const;
+
   protected:
     qi::EventLoop* _eventLoop;
     qi::MessageDispatcher _dispatcher;
+    MessageSocketCounters _counters;
 
     std::atomic<MessageSocket::Status> _status;
   public:
@@ -107,6 +147,9 @@ namespace qi
 
   using MessageSocketPtr = boost::shared_ptr<MessageSocket>;
   MessageSocketPtr makeMessageSocket(const std::string &protocol, qi::EventLoop *eventLoop = getEventLoop());
+
+  /// Maximum size of received payloads, set with QI_MAX_MESSAGE_PAYLOAD.
+  size_t getMaxPayloadFromEnv(size_t defaultValue = 50000000);
 }
 
 #endif  // _SRC_MESSAGESOCKET_HPP_
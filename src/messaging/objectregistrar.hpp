@@ -61,6 +61,7 @@ namespace qi {
     using Server::listen;
     using Server::setIdentity;
     using Server::endpoints;
+    using Server::sockets;
 
   private:
     //0 on error
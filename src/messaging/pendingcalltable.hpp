@@ -0,0 +1,210 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_PENDINGCALLTABLE_HPP_
+#define _SRC_PENDINGCALLTABLE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+namespace qi {
+
+  /**
+   * @brief Table of the calls waiting for their reply, keyed by message id.
+   * \internal
+   *
+   * The table is open-addressed: a call is stored in one of the `probeCount`
+   * slots following the one its id maps to. Message ids being mostly
+   * consecutive, the calls in flight rarely collide.
+   *
+   * Inserting and taking a call only use atomic operations on its slots.
+   * When all the slots of an id are used, a table twice as big is added under
+   * a mutex; the previous tables are still looked up, until the destruction
+   * of the whole table.
+   *
+   * Ids must be unique among the calls in the table.
+   *
+   * Thread-safe.
+   */
+  template<typename T>
+  class PendingCallTable : private boost::noncopyable
+  {
+  public:
+    static const std::size_t probeCount = 8;
+
+    /// `initialCapacity` must be a power of two.
+    explicit PendingCallTable(std::size_t initialCapacity = 64)
+      : _newest(new Table(initialCapacity, nullptr))
+    {
+    }
+
+    ~PendingCallTable()
+    {
+      Table* table = _newest.load();
+      while (table)
+      {
+        Table* previous = table->previous;
+        delete table;
+        table = previous;
+      }
+    }
+
+    void insert(unsigned int id, T value)
+    {
+      Table* table = _newest.load(std::memory_order_acquire);
+      while (!table->insert(id, value))
+        table = grow(table);
+    }
+
+    /// Removes the call and returns it, or none if there is no such call.
+    boost::optional<T> take(unsigned int id)
+    {
+      for (Table* table = _newest.load(std::memory_order_acquire); table; table = table->previous)
+        if (auto value = table->take(id))
+          return value;
+      return {};
+    }
+
+    /// Removes all the calls and returns them with their ids.
+    std::vector<std::pair<unsigned int, T>> takeAll()
+    {
+      std::vector<std::pair<unsigned int, T>> values;
+      for (Table* table = _newest.load(std::memory_order_acquire); table; table = table->previous)
+        table->takeAll(values);
+      return values;
+    }
+
+    /// Total number of slots, for the tests.
+    std::size_t capacity() const
+    {
+      std::size_t capacity = 0;
+      for (Table* table = _newest.load(std::memory_order_acquire); table; table = table->previous)
+        capacity += table->mask + 1;
+      return capacity;
+    }
+
+  private:
+    enum State : std::uint64_t
+    {
+      State_Free = 0,
+      // Being written or read by a single thread.
+      State_Busy = 1,
+      State_Ready = 2,
+    };
+
+    static std::uint64_t key(unsigned int id, State state)
+    {
+      return (static_cast<std::uint64_t>(id) << 32) | state;
+    }
+
+    struct Slot
+    {
+      /// Id of the call in the upper 32 bits, state in the lower ones. Free
+      /// slots are 0.
+      std::atomic<std::uint64_t> word{0};
+      /// Optional, so that free slots do not construct values.
+      boost::optional<T> value;
+    };
+
+    struct Table
+    {
+      Table(std::size_t capacity, Table* previous)
+        : mask(capacity - 1)
+        , slots(new Slot[capacity])
+        , previous(previous)
+      {
+      }
+
+      Slot& slot(unsigned int id, std::size_t probe)
+      {
+        return slots[(id + probe) & mask];
+      }
+
+      bool insert(unsigned int id, T& value)
+      {
+        for (std::size_t probe = 0; probe < probeCount; ++probe)
+        {
+          Slot& s = slot(id, probe);
+          std::uint64_t expected = State_Free;
+          if (s.word.load(std::memory_order_relaxed) != expected
+              || !s.word.compare_exchange_strong(expected, key(id, State_Busy), std::memory_order_acquire))
+            continue;
+          s.value = std::move(value);
+          s.word.store(key(id, State_Ready), std::memory_order_release);
+          return true;
+        }
+        return false;
+      }
+
+      boost::optional<T> take(unsigned int id)
+      {
+        for (std::size_t probe = 0; probe < probeCount; ++probe)
+        {
+          Slot& s = slot(id, probe);
+          std::uint64_t expected = key(id, State_Ready);
+          if (s.word.load(std::memory_order_relaxed) != expected
+              || !s.word.compare_exchange_strong(expected, key(id, State_Busy), std::memory_order_acquire))
+            continue;
+          return release(s);
+        }
+        return {};
+      }
+
+      void takeAll(std::vector<std::pair<unsigned int, T>>& values)
+      {
+        for (std::size_t i = 0; i <= mask; ++i)
+        {
+          Slot& s = slots[i];
+          std::uint64_t word = s.word.load(std::memory_order_relaxed);
+          if ((word & 0xFFFFFFFFu) != State_Ready
+              || !s.word.compare_exchange_strong(word, (word & ~std::uint64_t(0xFFFFFFFFu)) | State_Busy,
+                                                 std::memory_order_acquire))
+            continue;
+          values.emplace_back(static_cast<unsigned int>(word >> 32), release(s));
+        }
+      }
+
+      /// Precondition: The slot is busy.
+      static T release(Slot& s)
+      {
+        T value = std::move(*s.value);
+        // Do not keep what the value holds alive.
+        s.value = boost::none;
+        s.word.store(State_Free, std::memory_order_release);
+        return value;
+      }
+
+      const std::size_t mask;
+      std::unique_ptr<Slot[]> slots;
+      Table* const previous;
+    };
+
+    /// Returns the newest table, adding one if it is still `full`.
+    Table* grow(Table* full)
+    {
+      std::lock_guard<std::mutex> lock(_growMutex);
+      Table* newest = _newest.load(std::memory_order_acquire);
+      if (newest != full)
+        return newest;
+      newest = new Table(2 * (full->mask + 1), full);
+      _newest.store(newest, std::memory_order_release);
+      return newest;
+    }
+
+    std::atomic<Table*> _newest;
+    std::mutex _growMutex;
+  };
+
+}
+
+#endif  // _SRC_PENDINGCALLTABLE_HPP_
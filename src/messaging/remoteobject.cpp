@@ -205,20 +205,19 @@ namespace qi {
       return;
     }
 
-    qi::Promise<AnyReference> promise;
+    boost::optional<PendingCall> pending = _promises.take(msg.id());
+    if (!pending)
     {
-      auto syncPromises = _promises.synchronize();
-      auto it = syncPromises->find(msg.id());
-      if (it != syncPromises->end()) {
-        promise = (*syncPromises)[msg.id()];
-        syncPromises->erase(it);
-        qiLogDebug() << "Handling promise id:" << msg.id();
-      } else  {
-        qiLogError() << "no promise found for req id:" << msg.id()
-                     << "  obj: " << msg.service() << "  func: " << msg.function() << " type: " << Message::typeToString(msg.type());
-        return;
-      }
+      // The call may have been given up at its deadline.
+      qiLogVerbose() << "no promise found for req id:" << msg.id()
+                   << "  obj: " << msg.service() << "  func: " << msg.function() << " type: " << Message::typeToString(msg.type());
+      return;
     }
+    qiLogDebug() << "Handling promise id:" << msg.id();
+    PendingCall& call = *pending;
+    // Count the call before its caller can see its result.
+    pushCallStats(call, msg.function());
+    qi::Promise<AnyReference>& promise = call.promise;
 
     switch (msg.type()) {
       case qi::Message::Type_Canceled: {
@@ -270,7 +269,17 @@ namespace qi {
   }
 
 
-  qi::Future<AnyReference> RemoteObject::metaCall(AnyObject, unsigned int method, const qi::GenericFunctionParameters &in, MetaCallType callType, Signature returnSignature)
+  void RemoteObject::pushCallStats(const PendingCall& call, unsigned int method)
+  {
+    if (!call.start)
+      return;
+    // Only the round trip is known from here, user and system times are
+    // counted by the remote object.
+    if (AnyObject context = AnyWeakObject(call.statsContext).lock())
+      context.asGenericObject()->pushStats(method, (float)(qi::os::ustime() - call.start) / 1e6f, 0.f, 0.f);
+  }
+
+  qi::Future<AnyReference> RemoteObject::metaCall(AnyObject context, unsigned int method, const qi::GenericFunctionParameters &in, MetaCallType callType, Signature returnSignature)
   {
     MetaMethod *mm = metaObject().method(method);
     if (!mm) {
@@ -316,14 +325,16 @@ namespace qi {
       {
         return makeFutureError<AnyReference>("Socket is not connected");
       }
-      auto syncPromises = _promises.synchronize();
-      if (syncPromises->find(msg.id()) != syncPromises->end())
+      // Message ids are unique, there cannot be another call with this one.
+      qiLogDebug() << "Adding promise id:" << msg.id();
+      PendingCall call;
+      call.promise = out;
+      if (context && context.isStatsEnabled())
       {
-        qiLogError() << "There is already a pending promise with id "
-                                   << msg.id();
+        call.statsContext = context;
+        call.start = qi::os::ustime();
       }
-      qiLogDebug() << "Adding promise id:" << msg.id();
-      (*syncPromises)[msg.id()] = out;
+      _promises.insert(msg.id(), std::move(call));
     }
     qi::Signature funcSig = mm->parametersSignature();
     try {
@@ -343,6 +354,12 @@ namespace qi {
       msg.addFlags(Message::TypeFlag_ReturnType);
       msg.setValue(returnSignature.toString(), Signature("s"));
     }
+    // The deadline goes last, as the service reads it before the rest.
+    const boost::optional<SteadyClockTimePoint> deadline =
+        context ? detail::currentCallDeadline(*context.asGenericObject()) : boost::none;
+    const bool deadlineSent = deadline && sock->sharedCapability<bool>("CallDeadlines", false);
+    if (deadlineSent)
+      msg.appendDeadline(*deadline);
     msg.setType(qi::Message::Type_Call);
     msg.setService(_service);
     msg.setObject(_object);
@@ -367,16 +384,28 @@ namespace qi {
       }
       out.setError(ss.str());
       qiLogDebug() << "Removing promise id:" << msg.id();
-      _promises->erase(msg.id());
+      _promises.take(msg.id());
     }
     else
-      out.setOnCancel(qi::bind(&RemoteObject::onFutureCancelled, this, msg.id()));
+      out.setOnCancel(qi::bind(&RemoteObject::onFutureCancelled, this, msg.id(), deadline, deadlineSent));
     return out.future();
   }
 
-  void RemoteObject::onFutureCancelled(unsigned int originalMessageId)
+  void RemoteObject::onFutureCancelled(unsigned int originalMessageId,
+                                       boost::optional<SteadyClockTimePoint> deadline,
+                                       bool deadlineSent)
   {
     qiLogDebug() << "Cancel request for message " << originalMessageId;
+    if (deadline && SteadyClock::now() >= *deadline)
+    {
+      // The caller gave up on the call: do not wait for the service to
+      // acknowledge the cancel, it may be too busy to do it in time.
+      if (boost::optional<PendingCall> pending = _promises.take(originalMessageId))
+        pending->promise.setCanceled();
+      // The service knows the deadline and drops the call by itself.
+      if (deadlineSent)
+        return;
+    }
     MessageSocketPtr sock = *_socket;
     Message cancelMessage;
 
@@ -577,17 +606,12 @@ namespace qi {
         if (!fromSignal)
           socket->disconnected.disconnectAsync(_linkDisconnected);
     }
-    std::map<int, qi::Promise<AnyReference> > promises;
-    {
-      auto syncPromises = _promises.synchronize();
-      promises = *syncPromises;
-      syncPromises->clear();
-    }
     // Nobody should be able to add anything to promises at this point.
+    auto promises = _promises.takeAll();
     for (auto& pair: promises)
     {
       qiLogVerbose() << "Reporting error for request " << pair.first << "(" << reason << ")";
-      pair.second.setError(reason);
+      pair.second.promise.setError(reason);
     }
 
     //@warning: remove connection are not removed
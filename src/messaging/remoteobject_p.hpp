@@ -14,6 +14,7 @@
 
 #include "messagedispatcher.hpp"
 #include "objecthost.hpp"
+#include "pendingcalltable.hpp"
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/synchronized_value.hpp>
@@ -61,7 +62,9 @@ namespace qi {
 
     virtual void metaPost(AnyObject context, unsigned int event, const GenericFunctionParameters& args);
     virtual qi::Future<AnyReference> metaCall(AnyObject context, unsigned int method, const GenericFunctionParameters& args, qi::MetaCallType callType, Signature returnSignature);
-    void onFutureCancelled(unsigned int originalMessageId);
+    void onFutureCancelled(unsigned int originalMessageId,
+                           boost::optional<SteadyClockTimePoint> deadline,
+                           bool deadlineSent);
 
     //metaObject received
     void onMetaObject(qi::Future<qi::MetaObject> fut, qi::Promise<void> prom);
@@ -75,10 +78,22 @@ namespace qi {
   protected:
     using LocalToRemoteSignalLinkMap = std::map<qi::uint64_t, RemoteSignalLinks>;
 
+    struct PendingCall
+    {
+      qi::Promise<AnyReference> promise;
+      // Proxy to which the duration of the call is reported, if it gathers
+      // statistics.
+      AnyWeakObject statsContext;
+      qi::int64_t start = 0;
+    };
+    // Report the duration of a call to the proxy it was made from.
+    static void pushCallStats(const PendingCall& call, unsigned int method);
+
     boost::synchronized_value<MessageSocketPtr>   _socket;
     unsigned int                                    _service;
     unsigned int                                    _object;
-    boost::synchronized_value<std::map<int, qi::Promise<AnyReference>>> _promises;
+    // Replies are matched to their call without locking.
+    PendingCallTable<PendingCall>                   _promises;
     qi::SignalLink                                  _linkMessageDispatcher;
     qi::SignalLink                                  _linkDisconnected;
     qi::AnyObject                                   _self;
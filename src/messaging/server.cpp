@@ -368,6 +368,16 @@ namespace qi {
     return _server.endpoints();
   }
 
+  std::vector<MessageSocketPtr> Server::sockets()
+  {
+    std::vector<MessageSocketPtr> result;
+    boost::recursive_mutex::scoped_lock sl(_socketsMutex);
+    result.reserve(_subscribers.size());
+    for (const auto& subscriber : _subscribers)
+      result.push_back(subscriber.first);
+    return result;
+  }
+
   void Server::open()
   {
     _dying = false;
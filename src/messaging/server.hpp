@@ -40,6 +40,8 @@ namespace qi {
     bool removeObject(unsigned int idx);
 
     std::vector<qi::Url> endpoints() const;
+    /// Returns the sockets of the connected clients.
+    std::vector<MessageSocketPtr> sockets();
 
     void onTransportServerNewConnection(MessageSocketPtr socket, bool startReading);
     void setAuthProviderFactory(AuthProviderFactoryPtr factory);
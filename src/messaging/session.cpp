@@ -9,9 +9,12 @@
 # pragma warning(disable: 4355)
 #endif
 
+#include <set>
 #include <qi/session.hpp>
+#include <qi/getenv.hpp>
 #include "message.hpp"
 #include "messagesocket.hpp"
+#include "localmessagesocket.hpp"
 #include <qi/anyobject.hpp>
 #include <qi/messaging/serviceinfo.hpp>
 #include "remoteobject_p.hpp"
@@ -44,9 +47,19 @@ namespace qi {
     _sdClient.serviceRemoved.connect(session->serviceUnregistered);
     setAuthProviderFactory(AuthProviderFactoryPtr(new NullAuthProviderFactory));
     setClientAuthenticatorFactory(ClientAuthenticatorFactoryPtr(new NullClientAuthenticatorFactory));
+
+    static const auto metricsPeriod = qi::os::getEnvDefault<unsigned int>("QI_CONNECTION_METRICS_PERIOD", 0u);
+    if (metricsPeriod)
+    {
+      _metricsTask.setName("ConnectionMetrics");
+      _metricsTask.setPeriod(qi::Seconds(metricsPeriod));
+      _metricsTask.setCallback(qi::bind(&SessionPrivate::logConnectionMetrics, this));
+      _metricsTask.start();
+    }
   }
 
   SessionPrivate::~SessionPrivate() {
+    _metricsTask.stop();
     destroy();
     close();
   }
@@ -145,6 +158,33 @@ namespace qi {
     return _sdClient.isConnected();
   }
 
+  std::vector<ConnectionMetrics> SessionPrivate::connectionMetrics()
+  {
+    // The socket of the service directory is also used by the server and
+    // the cache.
+    std::set<MessageSocketPtr> sockets;
+    if (!_sdClient.isLocal())
+      if (auto sdSocket = _sdClient.socket())
+        sockets.insert(sdSocket);
+    for (const auto& socket : _serverObject.sockets())
+      sockets.insert(socket);
+    for (const auto& socket : _socketsCache.sockets())
+      sockets.insert(socket);
+
+    std::vector<ConnectionMetrics> metrics;
+    metrics.reserve(sockets.size());
+    for (const auto& socket : sockets)
+      if (socket->isConnected())
+        metrics.push_back(socket->metrics());
+    return metrics;
+  }
+
+  void SessionPrivate::logConnectionMetrics()
+  {
+    for (const auto& metrics : connectionMetrics())
+      qiLogInfo() << metrics;
+  }
+
 
   // ###### Session
   Session::Session(bool enforceAuthentication)
@@ -183,6 +223,11 @@ namespace qi {
     return _p->isConnected();
   }
 
+  std::vector<ConnectionMetrics> Session::connectionMetrics() const
+  {
+    return _p->connectionMetrics();
+  }
+
   qi::Url Session::url() const {
     if (_p->_sdClient.isLocal())
       return endpoints()[0];
@@ -274,6 +319,8 @@ namespace qi {
       qi::Url listeningAddress("tcp://0.0.0.0:0");
       qiLogVerbose() << listeningAddress.str() << "." << std::endl;
       listen(listeningAddress);
+      if (isLocalTransportAdvertised())
+        listen(qi::Url(std::string(localProtocol) + "://localhost:0"));
     }
 
     if (!isConnected()) {
@@ -8,6 +8,7 @@
 #define _SRC_SESSION_P_HPP_
 
 #include <qi/session.hpp>
+#include <qi/periodictask.hpp>
 #include "servicedirectoryclient.hpp"
 #include "objectregistrar.hpp"
 #include "sessionservice.hpp"
@@ -37,6 +38,9 @@ namespace qi {
     void setAuthProviderFactory(AuthProviderFactoryPtr factory);
     void setClientAuthenticatorFactory(ClientAuthenticatorFactoryPtr factory);
 
+    std::vector<ConnectionMetrics> connectionMetrics();
+    void logConnectionMetrics();
+
   public:
     void listenStandaloneCont(qi::Promise<void> p, qi::Future<void> f);
     // internal, add sd socket to socket cache
@@ -57,6 +61,8 @@ namespace qi {
     Session_Services       _servicesHandler;
     Session_SD             _sd;
     TransportSocketCache   _socketsCache;
+    // Logs the metrics of the connections, if enabled.
+    PeriodicTask           _metricsTask;
   };
 }
 
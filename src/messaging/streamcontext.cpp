@@ -116,6 +116,10 @@ static void initCapabilities()
   /* RemoteCancelableCalls: remote end supports call cancelations.
    */
   (*_defaultCapabilities)["RemoteCancelableCalls"] = AnyValue::from(true);
+  /* CallDeadlines: remote end understands call deadlines
+   * (Message::TypeFlag_Deadline).
+   */
+  (*_defaultCapabilities)["CallDeadlines"] = AnyValue::from(true);
   // Process override from environment
   std::string capstring = qi::os::getenv("QI_TRANSPORT_CAPABILITIES");
   std::vector<std::string> caps;
@@ -6,6 +6,8 @@
 #include <qi/log.hpp>
 #include <qi/messaging/sock/networkasio.hpp>
 #include <qi/messaging/sock/option.hpp>
+#include <qi/messaging/sock/send.hpp>
+#include "message.hpp"
 
 #if BOOST_OS_WINDOWS
 # include <Winsock2.h> // needed by mstcpip.h
@@ -133,6 +135,62 @@ namespace qi {
 
 namespace qi { namespace sock {
 
+  size_t getReceiveChunkSizeFromEnv(size_t defaultValue)
+  {
+    static const auto chunkSizeEnvVariable = os::getenv("QI_MESSAGE_RECEIVE_CHUNK_SIZE");
+    if (chunkSizeEnvVariable.empty())
+      return defaultValue;
+    const auto chunkSize = boost::lexical_cast<size_t>(chunkSizeEnvVariable);
+    if (chunkSize != 0u && chunkSize < sizeof(MessagePrivate::MessageHeader))
+    {
+      qiLogWarning() << "QI_MESSAGE_RECEIVE_CHUNK_SIZE must be at least the size of a "
+        "message header (" << sizeof(MessagePrivate::MessageHeader) << " bytes). "
+        "Using " << sizeof(MessagePrivate::MessageHeader) << " bytes.";
+      return sizeof(MessagePrivate::MessageHeader);
+    }
+    return chunkSize;
+  }
+
+  SendBatchLimits getSendBatchLimitsFromEnv()
+  {
+    static const auto maxBytesEnvVariable = os::getenv("QI_MESSAGE_SEND_BATCH_MAX_BYTES");
+    static const auto maxBuffersEnvVariable = os::getenv("QI_MESSAGE_SEND_BATCH_MAX_BUFFERS");
+    SendBatchLimits limits;
+    if (!maxBytesEnvVariable.empty())
+      limits.maxBytes = boost::lexical_cast<size_t>(maxBytesEnvVariable);
+    if (!maxBuffersEnvVariable.empty())
+      limits.maxBuffers = boost::lexical_cast<size_t>(maxBuffersEnvVariable);
+    return limits;
+  }
+
+  SendQueueLimits getSendQueueLimitsFromEnv()
+  {
+    static const auto maxBytesEnvVariable = os::getenv("QI_MESSAGE_SEND_QUEUE_MAX_BYTES");
+    static const auto maxMessagesEnvVariable = os::getenv("QI_MESSAGE_SEND_QUEUE_MAX_MESSAGES");
+    static const auto blockTimeoutEnvVariable = os::getenv("QI_MESSAGE_SEND_QUEUE_BLOCK_TIMEOUT");
+    static const auto policy = [] {
+      const auto name = os::getenv("QI_MESSAGE_SEND_QUEUE_POLICY");
+      if (name == "block")
+        return SendQueuePolicy::Block;
+      if (name == "drop-oldest-events")
+        return SendQueuePolicy::DropOldestEvents;
+      if (name == "conflate-events")
+        return SendQueuePolicy::ConflateEvents;
+      if (!name.empty() && name != "fail")
+        qiLogWarning() << "Unknown QI_MESSAGE_SEND_QUEUE_POLICY '" << name << "', using 'fail'.";
+      return SendQueuePolicy::Fail;
+    }();
+    SendQueueLimits limits;
+    limits.policy = policy;
+    if (!maxBytesEnvVariable.empty())
+      limits.maxBytes = boost::lexical_cast<size_t>(maxBytesEnvVariable);
+    if (!maxMessagesEnvVariable.empty())
+      limits.maxMessages = boost::lexical_cast<size_t>(maxMessagesEnvVariable);
+    if (!blockTimeoutEnvVariable.empty())
+      limits.blockTimeout = std::chrono::milliseconds{boost::lexical_cast<qi::int64_t>(blockTimeoutEnvVariable)};
+    return limits;
+  }
+
   boost::optional<qi::int64_t> getSocketTimeWarnThresholdFromEnv()
   {
     static const auto thresholdEnvVariable = os::getenv("QIMESSAGING_SOCKET_DISPATCH_TIME_WARN_THRESHOLD");
@@ -239,6 +239,17 @@ namespace qi {
       return getStatus() == Status::Connected;
     }
     bool ensureReading() override;
+
+    /// Sets the limits of the send queue of the current connection and of the
+    /// next ones. By default, they are taken from the environment (see
+    /// `sock::getSendQueueLimitsFromEnv`).
+    void setSendQueueLimits(const sock::SendQueueLimits& limits)
+    {
+      boost::recursive_mutex::scoped_lock lock(_stateMutex);
+      _sendQueueLimits = limits;
+      if (getStatus() == Status::Connected)
+        asConnected(_state).setSendQueueLimits(limits);
+    }
   private:
     /// Handler called when we transition outside the connected state.
     /// It is the responsibility of the caller to ensure the socket pointer is
@@ -281,6 +292,8 @@ namespace qi {
     using State = boost::variant<DisconnectedState, ConnectingState, ConnectedState, DisconnectingState>;
     State _state;
     boost::synchronized_value<Url> _url;
+    // Protected by _stateMutex.
+    sock::SendQueueLimits _sendQueueLimits;
 
     bool mustTreatAsServerAuthentication(const Message& msg) const;
     bool handleCapabilityMessage(const Message& msg);
@@ -325,6 +338,7 @@ namespace qi {
     , _sslContext{Method::sslv23}
     , _ioService(io)
     , _state{DisconnectedState{}}
+    , _sendQueueLimits(sock::getSendQueueLimitsFromEnv())
   {
     if (socket)
     {
@@ -344,8 +358,6 @@ namespace qi {
     }
   }
 
-  size_t getMaxPayloadFromEnv(size_t defaultValue = 50000000);
-
   /// Start receiving messages. Also allows to send messages.
   ///
   /// The returned value indicates if the operation succeeded.
@@ -374,6 +386,7 @@ namespace qi {
       auto self = shared_from_this();
       _state = ConnectedState(res.socket, _ssl, maxPayload, sock::HandleMessage<N>{self});
       auto& connected = asConnected(_state);
+      connected.setSendQueueLimits(_sendQueueLimits);
       connected.complete().then(connected.ioServiceStranded(
         OnConnectedComplete{self, Future<void>{nullptr}}
       ));
@@ -426,6 +439,7 @@ namespace qi {
         static const auto maxPayload = getMaxPayloadFromEnv();
         _state = ConnectedState(res.socket, _ssl, maxPayload, sock::HandleMessage<N>{self});
         auto& connected = asConnected(_state);
+        connected.setSendQueueLimits(_sendQueueLimits);
         connected.complete().then(connected.ioServiceStranded(
           OnConnectedComplete{self, connectedPromise.future()}
         ));
@@ -489,6 +503,8 @@ namespace qi {
         {
           boost::recursive_mutex::scoped_lock lock(self->_stateMutex);
           self->_state = DisconnectedState{};
+          // The messages that were not sent are dropped with the connected state.
+          self->_counters.sendQueueCleared();
           QI_LOG_DEBUG_SOCKET(socket.get()) << "Socket disconnected.";
         }
         static const std::string data{"disconnected"};
@@ -546,6 +562,7 @@ namespace qi {
   template<typename N>
   bool TcpMessageSocket<N>::handleMessage(const Message& msg)
   {
+    _counters.messageReceived(msg);
     bool success = false;
     if (mustTreatAsServerAuthentication(msg) || msg.type() == Message::Type_Capability)
     {
@@ -574,8 +591,26 @@ namespace qi {
       QI_LOG_WARNING_SOCKET(this) << "Socket must be connected to send().";
       return false;
     }
-    asConnected(_state).send(msg, _ssl);
-    return true;
+    _counters.messageEnqueued();
+    boost::weak_ptr<TcpMessageSocket> weakSelf = shared_from_this();
+    const auto result = asConnected(_state).send(msg, _ssl,
+      [weakSelf](const sock::ErrorCode<N>& erc, std::list<Message>::const_iterator itMsg) {
+        if (auto self = weakSelf.lock())
+          self->_counters.messageWritten(*itMsg, !erc);
+        return true;
+      });
+    using Status = sock::EnqueueResult::Status;
+    const bool discarded = result.status == Status::Dropped || result.status == Status::Rejected;
+    _counters.messagesDiscarded(result.droppedCount + (discarded ? 1u : 0u));
+    if (result.deferred)
+    {
+      result.deferred->then([weakSelf](Future<void> queued) {
+        if (queued.hasError())
+          if (auto self = weakSelf.lock())
+            self->_counters.messagesDiscarded(1u);
+      });
+    }
+    return result.status != Status::Rejected;
   }
 } // namespace qi
 
@@ -27,6 +27,8 @@
 #include "transportserver.hpp"
 #include "messagesocket.hpp"
 #include "transportserverasio_p.hpp"
+#include "transportserverlocal_p.hpp"
+#include "localmessagesocket.hpp"
 
 qiLogCategory("qimessaging.transportserver");
 
@@ -48,6 +50,12 @@ namespace qi
     {
       impl = TransportServerAsioPrivate::make(this, ctx);
     }
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    else if (url.protocol() == localProtocol)
+    {
+      impl = TransportServerLocalPrivate::make(this, ctx);
+    }
+#endif
     else
     {
       const char* s = "Unrecognized protocol to create the TransportServer.";
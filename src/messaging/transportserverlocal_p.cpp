@@ -0,0 +1,180 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+
+#include "messagesocket.hpp"
+#include "localmessagesocket.hpp"
+#include "transportserverlocal_p.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+
+#include <unistd.h>
+
+qiLogCategory("qimessaging.transportserver");
+
+namespace qi
+{
+  namespace
+  {
+    // Ports tried when listening on port 0, from a start depending on the
+    // process to avoid always colliding with the same ones.
+    const unsigned int firstAutoPort = 10000;
+    const unsigned int autoPortCount = 50000;
+    const unsigned int autoPortAttempts = 128;
+
+    const int64_t acceptRetryDelayMs = 100;
+
+    Url localUrl(unsigned short port)
+    {
+      return Url(std::string(localProtocol) + "://localhost:" + boost::lexical_cast<std::string>(port));
+    }
+  }
+
+  TransportServerLocalPrivate::TransportServerLocalPrivate(TransportServer* self, EventLoop* ctx)
+    : TransportServerImpl(self, ctx)
+    , _acceptor(*asIoServicePtr(ctx))
+    , _live(true)
+  {
+  }
+
+  boost::shared_ptr<TransportServerLocalPrivate> TransportServerLocalPrivate::make(
+      TransportServer* self,
+      EventLoop* ctx)
+  {
+    return boost::shared_ptr<TransportServerLocalPrivate>{new TransportServerLocalPrivate(self, ctx)};
+  }
+
+  TransportServerLocalPrivate::~TransportServerLocalPrivate()
+  {
+  }
+
+  boost::system::error_code TransportServerLocalPrivate::bind(const qi::Url& url)
+  {
+    using Endpoint = boost::asio::local::stream_protocol::endpoint;
+    const auto path = localSocketPath(url);
+    boost::system::error_code erc = checkLocalSocketDir(true);
+    if (erc)
+      return erc;
+    _acceptor.bind(Endpoint(path), erc);
+    if (erc == boost::asio::error::address_in_use)
+    {
+      // The socket file of a dead process is refused connections. The
+      // directory being private, it can only be one of our own.
+      Socket probe(*asIoServicePtr(context));
+      boost::system::error_code probeErc;
+      probe.connect(Endpoint(path), probeErc);
+      if (probeErc == boost::asio::error::connection_refused)
+      {
+        qiLogVerbose() << "Removing stale socket " << path;
+        ::unlink(path.c_str());
+        erc.clear();
+        _acceptor.bind(Endpoint(path), erc);
+      }
+    }
+    if (!erc)
+      _path = path;
+    return erc;
+  }
+
+  qi::Future<void> TransportServerLocalPrivate::listen(const qi::Url& url)
+  {
+    boost::system::error_code erc;
+    _acceptor.open(boost::asio::local::stream_protocol(), erc);
+    if (!erc)
+    {
+      if (url.port() != 0)
+      {
+        _listenUrl = localUrl(url.port());
+        erc = bind(_listenUrl);
+      }
+      else
+      {
+        const unsigned int start = static_cast<unsigned int>(os::getpid()) * 7919u;
+        for (unsigned int i = 0; i < autoPortAttempts; ++i)
+        {
+          _listenUrl = localUrl(static_cast<unsigned short>(firstAutoPort + (start + i) % autoPortCount));
+          erc = bind(_listenUrl);
+          if (erc != boost::asio::error::address_in_use)
+            break;
+        }
+      }
+    }
+    if (!erc)
+      _acceptor.listen(boost::asio::socket_base::max_connections, erc);
+    if (erc)
+    {
+      std::stringstream ss;
+      ss << "failed to listen on " << url.str() << ": " << erc.message();
+      qiLogError() << ss.str();
+      return qi::makeFutureError<void>(ss.str());
+    }
+
+    {
+      boost::mutex::scoped_lock l(_endpointsMutex);
+      _endpoints.push_back(_listenUrl);
+    }
+    qiLogInfo() << "TransportServer will listen on: " << _listenUrl.str();
+
+    {
+      boost::mutex::scoped_lock lock(_acceptCloseMutex);
+      accept();
+    }
+    _connectionPromise.setValue(0);
+    return _connectionPromise.future();
+  }
+
+  void TransportServerLocalPrivate::accept()
+  {
+    auto socket = boost::make_shared<Socket>(*asIoServicePtr(context));
+    auto self = shared_from_this();
+    _acceptor.async_accept(*socket, [=](const boost::system::error_code& erc) {
+      self->onAccept(erc, socket);
+    });
+  }
+
+  void TransportServerLocalPrivate::onAccept(const boost::system::error_code& erc,
+                                             boost::shared_ptr<Socket> socket)
+  {
+    boost::mutex::scoped_lock lock(_acceptCloseMutex);
+    if (!_live)
+      return;
+    if (erc)
+    {
+      qiLogDebug() << "accept error " << erc.message();
+      self->acceptError(erc.value());
+      // Errors such as running out of file descriptors may last: retry later.
+      auto server = shared_from_this();
+      context->asyncDelay([server] {
+          boost::mutex::scoped_lock lock(server->_acceptCloseMutex);
+          if (server->_live)
+            server->accept();
+        },
+        qi::MilliSeconds(acceptRetryDelayMs));
+      return;
+    }
+    auto messageSocket = boost::make_shared<LocalMessageSocket>(*asIoServicePtr(context), socket);
+    messageSocket->setUrl(_listenUrl);
+    qiLogDebug() << "New socket accepted: " << messageSocket.get();
+    self->newConnection(std::pair<MessageSocketPtr, Url>{messageSocket, _listenUrl});
+    accept();
+  }
+
+  void TransportServerLocalPrivate::close()
+  {
+    boost::mutex::scoped_lock lock(_acceptCloseMutex);
+    if (!_live)
+      return;
+    _live = false;
+    boost::system::error_code erc;
+    _acceptor.close(erc);
+    if (!_path.empty())
+      ::unlink(_path.c_str());
+  }
+}
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_TRANSPORTSERVERLOCAL_P_HPP_
+#define _SRC_TRANSPORTSERVERLOCAL_P_HPP_
+
+#include <atomic>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <qi/url.hpp>
+#include "transportserver.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+
+namespace qi
+{
+  /// Accepts connections on the Unix-domain socket of a `unix://localhost:<port>`
+  /// url. If the port is 0, a free one is picked.
+  class TransportServerLocalPrivate
+    : public TransportServerImpl
+    , public boost::enable_shared_from_this<TransportServerLocalPrivate>
+  {
+    TransportServerLocalPrivate(TransportServer* self, EventLoop* ctx);
+
+  public:
+    using Acceptor = boost::asio::local::stream_protocol::acceptor;
+    using Socket = boost::asio::local::stream_protocol::socket;
+
+    static boost::shared_ptr<TransportServerLocalPrivate> make(TransportServer* self, EventLoop* ctx);
+
+    ~TransportServerLocalPrivate() override;
+
+    qi::Future<void> listen(const qi::Url& listenUrl) override;
+    void close() override;
+
+  private:
+    /// Binds the acceptor to the socket of the url, removing the socket file
+    /// if it was left by a dead process.
+    boost::system::error_code bind(const qi::Url& url);
+    void accept();
+    void onAccept(const boost::system::error_code& erc, boost::shared_ptr<Socket> socket);
+
+    Acceptor _acceptor;
+    std::atomic<bool> _live;
+    Url _listenUrl;
+    std::string _path;
+
+    // The server must avoid being closed while accepting a connection.
+    boost::mutex _acceptCloseMutex;
+  };
+}
+
+#endif
+
+#endif  // _SRC_TRANSPORTSERVERLOCAL_P_HPP_
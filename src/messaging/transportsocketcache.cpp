@@ -11,6 +11,7 @@
 #include <qi/log.hpp>
 
 #include "messagesocket.hpp"
+#include "localmessagesocket.hpp"
 #include "transportsocketcache.hpp"
 
 qiLogCategory("qimessaging.transportsocketcache");
@@ -107,22 +108,44 @@ static UrlVector localhost_only(const UrlVector& input)
   return result;
 }
 
-Future<MessageSocketPtr> TransportSocketCache::socket(const ServiceInfo& servInfo, const std::string& url)
+static UrlVector protocol_only(const UrlVector& input, const std::string& protocol)
+{
+  UrlVector result;
+  for (const auto& url: input)
+  {
+    if (url.protocol() == protocol)
+      result.push_back(url);
+  }
+  return result;
+}
+
+Future<MessageSocketPtr> TransportSocketCache::socket(const ServiceInfo& servInfo, const std::string& protocol)
 {
   const std::string& machineId = servInfo.machineId();
   ConnectionAttemptPtr couple = boost::make_shared<ConnectionAttempt>();
   couple->relatedUrls = servInfo.endpoints();
+  if (!protocol.empty())
+  {
+    UrlVector matching = protocol_only(couple->relatedUrls, protocol);
+    if (!matching.empty())
+      couple->relatedUrls = std::move(matching);
+  }
   bool local = machineId == os::getMachineId();
   UrlVector connectionCandidates;
 
-  // If the connection is local, we're mainly interested in localhost endpoint
+  // If the connection is local, we're mainly interested in the Unix-domain
+  // socket endpoints, then in the localhost ones.
   if (local)
-    connectionCandidates = localhost_only(servInfo.endpoints());
+  {
+    connectionCandidates = protocol_only(couple->relatedUrls, localProtocol);
+    if (connectionCandidates.empty())
+      connectionCandidates = localhost_only(couple->relatedUrls);
+  }
 
   // If the connection isn't local or if the service doesn't expose local endpoints,
   // try and connect to whatever is available.
   if (connectionCandidates.size() == 0)
-    connectionCandidates = servInfo.endpoints();
+    connectionCandidates = couple->relatedUrls;
 
   couple->endpoint = MessageSocketPtr();
   couple->state = State_Pending;
@@ -160,7 +183,7 @@ Future<MessageSocketPtr> TransportSocketCache::socket(const ServiceInfo& servInf
       if (!url.isValid())
         continue; // Do not try to connect to an invalid url!
 
-      if (!local && isLocalHost(url.host()))
+      if (!local && (isLocalHost(url.host()) || url.protocol() == localProtocol))
         continue; // Do not try to connect on localhost when it is a remote!
 
       urlMap[url] = couple;
@@ -202,6 +225,17 @@ FutureSync<void> TransportSocketCache::disconnect(MessageSocketPtr socket)
   });
 }
 
+std::vector<MessageSocketPtr> TransportSocketCache::sockets()
+{
+  std::vector<MessageSocketPtr> result;
+  boost::mutex::scoped_lock lock(_socketMutex);
+  for (const auto& machine : _connections)
+    for (const auto& attempt : machine.second)
+      if (attempt.second->state == State_Connected && attempt.second->endpoint)
+        result.push_back(attempt.second->endpoint);
+  return result;
+}
+
 void TransportSocketCache::insert(const std::string& machineId, const Url& url, MessageSocketPtr socket)
 {
   // If a connection is pending for this machine / url, terminate the pendage and set the
@@ -48,11 +48,17 @@ namespace qi
     /// The original url of the service directory is always preferred to the
     /// other endpoints, and other endpoints will not be tried if the services
     /// are running on another machine.
+    /// When the service runs on this machine, its Unix-domain socket endpoints
+    /// are preferred to its localhost ones.
     /// @param servInfo A service info retrieved from a service directory.
-    /// @param sdUrl The endpoint of the service directory on which the service info came from.
-    Future<MessageSocketPtr> socket(const ServiceInfo& servInfo, const std::string& sdUrl);
+    /// @param protocol If not empty, only the endpoints of this protocol are
+    /// tried, if the service has any.
+    Future<MessageSocketPtr> socket(const ServiceInfo& servInfo, const std::string& protocol);
     void insert(const std::string& machineId, const Url& url, MessageSocketPtr socket);
 
+    /// Returns the sockets of the established connections.
+    std::vector<MessageSocketPtr> sockets();
+
     /// The returned future is set when the socket has been disconnected and
     /// effectively removed from the cache.
     FutureSync<void> disconnect(MessageSocketPtr socket);
@@ -9,6 +9,9 @@
 
 #include <iostream>
 #include <iomanip>
+#include <locale>
+#include <sstream>
+#include <string>
 
 namespace qi
 {
@@ -18,6 +21,8 @@ namespace qi
     _p->projectName = projectName;
     _p->executableName = executableName;
     _p->outputData = outputData;
+    _p->tolerance = 0.;
+    _p->regressionCount = 0;
 
     if (!filename.empty() && outputData != OutputData_None) {
       _p->out.open(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
@@ -28,6 +33,8 @@ namespace qi
     }
 
     if (_p->out.is_open()) {
+      // The results are read back by setBaseline() whatever the locale.
+      _p->out.imbue(std::locale::classic());
       _p->out  << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>" << std::endl
                << "<perf_results project=\"" << projectName << "\" executable=\""
                << executableName << "\">" << std::endl;
@@ -45,31 +52,37 @@ namespace qi
   }
 
   DataPerfSuite& DataPerfSuite::operator<<(const DataPerf& data) {
+    std::string resultType;
+    float resultValue;
+    // Whether a higher value is a better result.
+    bool higherIsBetter = true;
+    switch (_p->outputData)
+    {
+    case OutputData_Cpu:
+      resultType = "Cpu";
+      resultValue = static_cast<float>(data.getCpu());
+      higherIsBetter = false;
+      break;
+    case OutputData_Period:
+      resultType = "Period";
+      resultValue = static_cast<float>(data.getPeriod());
+      higherIsBetter = false;
+      break;
+    case OutputData_MsgPerSecond:
+      resultType = "MsgPerSecond";
+      resultValue = static_cast<float>(data.getMsgPerSecond());
+      break;
+    case OutputData_MsgMBPerSecond:
+    default:
+      resultType = "MsgMBPerSecond";
+      resultValue = static_cast<float>(data.getMegaBytePerSecond());
+      break;
+    }
+    const std::string benchmark = data.getBenchmarkName() + "_" + resultType;
+
     if (_p->out.is_open()) {
-      std::string resultType;
-      float resultValue;
-      switch (_p->outputData)
-      {
-      case OutputData_Cpu:
-        resultType = "Cpu";
-        resultValue = static_cast<float>(data.getCpu());
-        break;
-      case OutputData_Period:
-        resultType = "Period";
-        resultValue = static_cast<float>(data.getPeriod());
-        break;
-      case OutputData_MsgPerSecond:
-        resultType = "MsgPerSecond";
-        resultValue = static_cast<float>(data.getMsgPerSecond());
-        break;
-      case OutputData_MsgMBPerSecond:
-      default:
-        resultType = "MsgMBPerSecond";
-        resultValue = static_cast<float>(data.getMegaBytePerSecond());
-        break;
-      }
       _p->out << "\t<perf_result "
-              << "benchmark=\"" << data.getBenchmarkName() << "_" << resultType << "\" "
+              << "benchmark=\"" << benchmark << "\" "
               << "result_value=\"" << std::fixed << std::setprecision(6) << resultValue << "\" "
               << "result_type=\"" << resultType << "\" "
               << "test_name=\"" << data.getBenchmarkName() << "\" ";
@@ -88,19 +101,74 @@ namespace qi
           << data.getMsgPerSecond() << " msg/s, "
           << std::setprecision(12) << data.getMegaBytePerSecond() << " MB/s, "
           << std::setprecision(0) << data.getPeriod() << " us, "
-          << std::setprecision(1) << data.getCpu() << " %"
-          << std::endl;
+          << std::setprecision(1) << data.getCpu() << " %";
     } else {
       std::cout
           << std::setprecision(12) << data.getMsgPerSecond() << " msg/s, "
           << data.getPeriod() << " us, "
-          << data.getCpu() << " %"
-          << std::endl;
+          << data.getCpu() << " %";
     }
 
+    const auto it = _p->baseline.find(benchmark);
+    if (it != _p->baseline.end() && it->second > 0.f) {
+      // Relative change, positive when the result is better.
+      const double change = (higherIsBetter ? resultValue - it->second : it->second - resultValue)
+          / it->second;
+      std::cout << " (baseline " << std::setprecision(2) << it->second << ", "
+                << std::showpos << std::setprecision(1) << change * 100. << std::noshowpos << " %)";
+      if (change < -_p->tolerance) {
+        ++_p->regressionCount;
+        std::cout << " REGRESSION";
+      }
+    }
+    std::cout << std::endl;
+
     return *this;
   }
 
+  bool DataPerfSuite::setBaseline(const std::string& filename, double tolerance)
+  {
+    boost::filesystem::ifstream in(filename);
+    if (!in.is_open()) {
+      std::cerr << "Can't open baseline file " << filename << "." << std::endl;
+      return false;
+    }
+    const auto attribute = [](const std::string& line, const std::string& name) -> std::string {
+      const std::string key = name + "=\"";
+      const auto begin = line.find(key);
+      if (begin == std::string::npos)
+        return {};
+      const auto end = line.find('"', begin + key.size());
+      if (end == std::string::npos)
+        return {};
+      return line.substr(begin + key.size(), end - begin - key.size());
+    };
+    _p->baseline.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+      const std::string benchmark = attribute(line, "benchmark");
+      const std::string value = attribute(line, "result_value");
+      if (benchmark.empty() || value.empty())
+        continue;
+      // Independent from the global locale, which may use a decimal comma.
+      std::istringstream parser(value);
+      parser.imbue(std::locale::classic());
+      float parsed;
+      if (parser >> parsed && (parser >> std::ws).eof())
+        _p->baseline[benchmark] = parsed;
+      else
+        std::cerr << "Invalid baseline value for " << benchmark << ": " << value << std::endl;
+    }
+    _p->tolerance = tolerance;
+    _p->regressionCount = 0;
+    return true;
+  }
+
+  unsigned int DataPerfSuite::regressionCount() const
+  {
+    return _p->regressionCount;
+  }
+
   void DataPerfSuite::flush()
   {
     if (_p->out.is_open())
@@ -11,6 +11,8 @@
 
 #include <qi/perf/dataperfsuite.hpp>
 
+#include <map>
+#include <string>
 #include <boost/filesystem/fstream.hpp>
 
 namespace qi
@@ -31,6 +33,15 @@ namespace qi
 
     //! Name of the executable.
     std::string executableName;
+
+    //! Results to compare to, by benchmark.
+    std::map<std::string, float> baseline;
+
+    //! Relative loss above which a result is a regression.
+    double tolerance;
+
+    //! Number of results that are regressions.
+    unsigned int regressionCount;
   };
 }
 
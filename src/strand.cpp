@@ -4,8 +4,11 @@
 */
 #include <atomic>
 #include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <qi/strand.hpp>
+#include <qi/atomic.hpp>
 #include <qi/log.hpp>
 #include <qi/future.hpp>
 #include <qi/getenv.hpp>
@@ -26,12 +29,164 @@ enum class StrandPrivate::State
 struct StrandPrivate::Callback
 {
   uint32_t id;
-  State state;
+  std::atomic<State> state;
   boost::function<void()> callback;
   qi::Promise<void> promise;
   qi::Future<void> asyncFuture;
 };
 
+// A job is either a posted callback, or a callback with a promise which can
+// be canceled.
+struct StrandPrivate::Job
+{
+  std::atomic<Job*> next;
+  boost::function<void()> callback;
+  boost::shared_ptr<Callback> cbStruct;
+};
+
+namespace
+{
+  // Bounds of the jobs kept for reuse by a strand and by a thread, beyond
+  // which released jobs are freed.
+  const int maxFreeJobs = 256;
+  const int maxCachedJobs = 256;
+
+  /// Frees the jobs of the list and returns their number.
+  int deleteJobs(StrandPrivate::Job* job)
+  {
+    int count = 0;
+    while (job)
+    {
+      StrandPrivate::Job* next = job->next.load(std::memory_order_relaxed);
+      delete job;
+      job = next;
+      ++count;
+    }
+    return count;
+  }
+
+  // Jobs are recycled by process() into the free list of their strand, and
+  // producers take the whole free list into the cache of their thread, so that
+  // posting to a strand does not allocate once the strand is warm.
+  struct JobCache
+  {
+    StrandPrivate::Job* first = nullptr;
+
+    ~JobCache()
+    {
+      deleteJobs(first);
+    }
+
+    /// Keeps at most maxCachedJobs jobs of the list, which replaces the empty
+    /// cache, and frees the others. Returns the number of jobs of the list.
+    int take(StrandPrivate::Job* list)
+    {
+      first = list;
+      int count = 0;
+      StrandPrivate::Job* last = nullptr;
+      for (StrandPrivate::Job* job = list; job && count < maxCachedJobs;
+           job = job->next.load(std::memory_order_relaxed))
+      {
+        last = job;
+        ++count;
+      }
+      if (last)
+      {
+        StrandPrivate::Job* rest = last->next.load(std::memory_order_relaxed);
+        last->next.store(nullptr, std::memory_order_relaxed);
+        count += deleteJobs(rest);
+      }
+      return count;
+    }
+  };
+
+  JobCache& jobCache()
+  {
+    static boost::thread_specific_ptr<JobCache>* cache = nullptr;
+    QI_THREADSAFE_NEW(cache);
+    JobCache* res = cache->get();
+    if (!res)
+    {
+      res = new JobCache;
+      cache->reset(res);
+    }
+    return *res;
+  }
+}
+
+StrandPrivate::StrandPrivate(qi::ExecutionContext& eventLoop)
+  : _eventLoop(eventLoop)
+  , _curId(0)
+  , _aliveCount(0)
+  , _processingThread(0)
+  , _dying(false)
+  , _queueHead(new Job{{nullptr}, {}, {}})
+  , _queueTail(_queueHead.load())
+  , _queuedCount(0)
+  , _freeJobs(nullptr)
+  , _freeJobCount(0)
+{
+}
+
+StrandPrivate::~StrandPrivate()
+{
+  // process() holds a shared pointer on us, so the queue is empty
+  QI_ASSERT(_queuedCount == 0);
+  deleteJobs(_queueTail);
+  deleteJobs(_freeJobs.load());
+}
+
+StrandPrivate::Job* StrandPrivate::allocateJob()
+{
+  JobCache& cache = jobCache();
+  if (!cache.first)
+  {
+    const int taken = cache.take(_freeJobs.exchange(nullptr, std::memory_order_acquire));
+    if (taken)
+      _freeJobCount.fetch_sub(taken, std::memory_order_relaxed);
+  }
+  Job* job = cache.first;
+  if (!job)
+    return new Job{{nullptr}, {}, {}};
+  cache.first = job->next.load(std::memory_order_relaxed);
+  return job;
+}
+
+void StrandPrivate::releaseJob(Job* job)
+{
+  // The count may be transiently off while producers take the list, which
+  // only makes the bound approximate.
+  if (_freeJobCount.load(std::memory_order_relaxed) >= maxFreeJobs)
+  {
+    delete job;
+    return;
+  }
+  // Only process() releases jobs, and producers only take the whole list, so
+  // there is no ABA problem here.
+  Job* first = _freeJobs.load(std::memory_order_relaxed);
+  do
+    job->next.store(first, std::memory_order_relaxed);
+  while (!_freeJobs.compare_exchange_weak(first, job, std::memory_order_release,
+                                          std::memory_order_relaxed));
+  _freeJobCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+StrandPrivate::Job* StrandPrivate::pop()
+{
+  // _queuedCount is not 0, so a job is pushed or being pushed
+  Job* tail = _queueTail;
+  Job* next = tail->next.load(std::memory_order_acquire);
+  while (!next)
+  {
+    boost::this_thread::yield();
+    next = tail->next.load(std::memory_order_acquire);
+  }
+  // next becomes the empty node once the caller has taken its job
+  _queueTail = next;
+  releaseJob(tail);
+  return next;
+}
+
 boost::shared_ptr<StrandPrivate::Callback> StrandPrivate::createCallback(boost::function<void()> cb)
 {
   ++_aliveCount;
@@ -50,7 +205,8 @@ Future<void> StrandPrivate::asyncAtImpl(boost::function<void()> cb, qi::SteadyCl
   qiLogDebug() << "Scheduling job id " << cbStruct->id
     << " at " << qi::to_string(tp);
   cbStruct->asyncFuture = _eventLoop.asyncAt(boost::bind(
-        &StrandPrivate::enqueue, this, cbStruct),
+        static_cast<void (StrandPrivate::*)(boost::shared_ptr<Callback>)>(&StrandPrivate::enqueue),
+        this, cbStruct),
       tp);
   return cbStruct->promise.future();
 }
@@ -64,7 +220,8 @@ Future<void> StrandPrivate::asyncDelayImpl(boost::function<void()> cb, qi::Durat
     << " in " << qi::to_string(delay);
   if (delay.count())
     cbStruct->asyncFuture = _eventLoop.asyncDelay(boost::bind(
-          &StrandPrivate::enqueue, this, cbStruct),
+          static_cast<void (StrandPrivate::*)(boost::shared_ptr<Callback>)>(&StrandPrivate::enqueue),
+          this, cbStruct),
         delay);
   else
     enqueue(cbStruct);
@@ -73,65 +230,87 @@ Future<void> StrandPrivate::asyncDelayImpl(boost::function<void()> cb, qi::Durat
 
 void StrandPrivate::enqueue(boost::shared_ptr<Callback> cbStruct)
 {
-  const bool shouldschedule = [&]()
+  qiLogDebug() << "Enqueueing job id " << cbStruct->id;
+  if (_dying)
   {
-    boost::recursive_mutex::scoped_lock lock(_mutex);
-    qiLogDebug() << "Enqueueing job id " << cbStruct->id;
     // the callback may have been canceled
     if (cbStruct->state == State::None)
     {
-      if (_dying)
-      {
-        cbStruct->promise.setError("the strand is dying");
-        qiLogDebug() << "Strand is dying on job id " << cbStruct->id;
-        return false;
-      }
-
-      qiLogDebug() << "Strand callback state is None on job id " << cbStruct->id;
-      _queue.push_back(cbStruct);
-      cbStruct->state = State::Scheduled;
-    }
-    else
-    {
-      QI_ASSERT(cbStruct->state == State::Canceled);
-      qiLogDebug() << "Job was canceled, dropping";
-      return false;
-    }
-    // if process was not scheduled yet, do it, there is work to do
-    if (!_processing)
-    {
-      qiLogDebug() << "Schedule process on job id " << cbStruct->id;
-      _processing = true;
-      return true;
+      cbStruct->promise.setError("the strand is dying");
+      qiLogDebug() << "Strand is dying on job id " << cbStruct->id;
     }
+    return;
+  }
 
-    return false;
-  }();
+  State expected = State::None;
+  if (!cbStruct->state.compare_exchange_strong(expected, State::Scheduled))
+  {
+    QI_ASSERT(expected == State::Canceled);
+    qiLogDebug() << "Job was canceled, dropping";
+    return;
+  }
+
+  Job* job = allocateJob();
+  job->cbStruct = std::move(cbStruct);
+  push(job);
+}
+
+void StrandPrivate::enqueue(boost::function<void()> cb)
+{
+  if (_dying)
+    return;
+  ++_aliveCount;
+  Job* job = allocateJob();
+  job->callback = std::move(cb);
+  push(job);
+}
+
+void StrandPrivate::push(Job* job)
+{
+  const bool shouldschedule = _queuedCount.fetch_add(1) == 0;
+  job->next.store(nullptr, std::memory_order_relaxed);
+  Job* prev = _queueHead.exchange(job, std::memory_order_acq_rel);
+  prev->next.store(job, std::memory_order_release);
 
+  // if process was not scheduled yet, do it, there is work to do
   if (shouldschedule)
   {
     qiLogDebug() << "StrandPrivate::process was not scheduled, doing it";
-    _eventLoop.async(boost::bind(&StrandPrivate::process, shared_from_this()));
+    _eventLoop.post(boost::bind(&StrandPrivate::process, shared_from_this()));
   }
 }
 
-void StrandPrivate::stopProcess(boost::recursive_mutex::scoped_lock& lock,
-                                bool finished)
+void StrandPrivate::stopProcess()
 {
-  // if we still have work
-  if (!finished && !_dying)
-  {
-    qiLogDebug() << "Strand quantum expired, rescheduling";
-    lock.unlock();
-    _eventLoop.async(boost::bind(&StrandPrivate::process, shared_from_this()));
-  }
-  else
+  // join() may be waiting for the queue to be empty
+  if (_dying)
   {
-    _processing = false;
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     _processFinished.notify_all();
   }
 }
 
+void StrandPrivate::drainQueue()
+{
+  do
+  {
+    Job* job = pop();
+    boost::shared_ptr<Callback> cbStruct = std::move(job->cbStruct);
+    boost::function<void()>().swap(job->callback);
+    if (!cbStruct)
+    {
+      --_aliveCount;
+      continue;
+    }
+    State expected = State::Scheduled;
+    if (cbStruct->state.compare_exchange_strong(expected, State::Running))
+    {
+      --_aliveCount;
+      cbStruct->promise.setError("the strand is dying");
+    }
+  } while (_queuedCount.fetch_sub(1) != 1);
+}
+
 void StrandPrivate::process()
 {
   static const unsigned int QI_STRAND_QUANTUM_US =
@@ -139,103 +318,96 @@ void StrandPrivate::process()
 
   qiLogDebug() << "StrandPrivate::process started";
 
-  _processingThread = qi::os::gettid();
-
+  const int tid = qi::os::gettid();
   qi::SteadyClockTimePoint start = qi::SteadyClock::now();
 
   do
   {
-    boost::shared_ptr<Callback> cbStruct;
+    if (_dying)
     {
-      boost::recursive_mutex::scoped_lock lock(_mutex);
-      if (_dying)
-      {
-        qiLogDebug() << this << " strand is dying, stopping process";
-        break;
-      }
+      qiLogDebug() << this << " strand is dying, stopping process";
+      drainQueue();
+      stopProcess();
+      return;
+    }
 
-      QI_ASSERT(_processing);
-      if (_queue.empty())
-      {
-        qiLogDebug() << "Queue empty, stopping";
-        stopProcess(lock, true);
-        _processingThread = 0;
-        return;
+    _processingThread.store(tid, std::memory_order_relaxed);
+    Job* job = pop();
+    boost::shared_ptr<Callback> cbStruct = std::move(job->cbStruct);
+    boost::function<void()> callback;
+    callback.swap(job->callback);
+    if (!cbStruct)
+    {
+      --_aliveCount;
+      try {
+        callback();
+      }
+      catch (...) {
+        // nobody is waiting for the result of a posted job
       }
-      cbStruct = _queue.front();
-      _queue.pop_front();
-      if (cbStruct->state == State::Scheduled)
+    }
+    else
+    {
+      State expected = State::Scheduled;
+      if (cbStruct->state.compare_exchange_strong(expected, State::Running))
       {
         --_aliveCount;
-        cbStruct->state = State::Running;
+        qiLogDebug() << "Executing job id " << cbStruct->id;
+        try {
+          cbStruct->callback();
+          cbStruct->promise.setValue(0);
+        }
+        catch (std::exception& e) {
+          cbStruct->promise.setError(e.what());
+        }
+        catch (...) {
+          cbStruct->promise.setError("callback has thrown in strand");
+        }
+        qiLogDebug() << "Finished job id " << cbStruct->id;
       }
       else
       {
         // Job was canceled, cancel() already has done --_aliveCount
         qiLogDebug() << "Abandoning job id " << cbStruct->id
-          << ", state: " << static_cast<int>(cbStruct->state);
-        continue;
+          << ", state: " << static_cast<int>(expected);
       }
     }
-    qiLogDebug() << "Executing job id " << cbStruct->id;
-    try {
-      cbStruct->callback();
-      cbStruct->promise.setValue(0);
-    }
-    catch (std::exception& e) {
-      cbStruct->promise.setError(e.what());
-    }
-    catch (...) {
-      cbStruct->promise.setError("callback has thrown in strand");
+    _processingThread.store(0, std::memory_order_relaxed);
+
+    if (_queuedCount.fetch_sub(1) == 1)
+    {
+      qiLogDebug() << "Queue empty, stopping";
+      stopProcess();
+      return;
     }
-    qiLogDebug() << "Finished job id " << cbStruct->id;
   } while (qi::SteadyClock::now() - start < qi::MicroSeconds(QI_STRAND_QUANTUM_US));
 
-  _processingThread = 0;
-
-  {
-    boost::recursive_mutex::scoped_lock lock(_mutex);
-    stopProcess(lock, false);
-  }
+  qiLogDebug() << "Strand quantum expired, rescheduling";
+  _eventLoop.post(boost::bind(&StrandPrivate::process, shared_from_this()));
 }
 
 void StrandPrivate::cancel(boost::shared_ptr<Callback> cbStruct)
 {
-  boost::recursive_mutex::scoped_lock lock(_mutex);
-
-  switch (cbStruct->state)
+  State expected = State::None;
+  if (cbStruct->state.compare_exchange_strong(expected, State::Canceled))
   {
-    case State::None:
-      qiLogDebug() << "Not scheduled yet, canceling future";
-      cbStruct->asyncFuture.cancel();
-      cbStruct->state = State::Canceled;
-      --_aliveCount;
-      cbStruct->promise.setCanceled();
-      break;
-    case State::Scheduled:
-      qiLogDebug() << "Was scheduled, removing it from queue";
-      {
-        bool erased = false;
-        for (Queue::iterator iter = _queue.begin(); iter != _queue.end(); ++iter)
-          if ((*iter)->id == cbStruct->id)
-          {
-            _queue.erase(iter);
-            erased = true;
-            break;
-          }
-        // state was scheduled, so the callback must be there
-        QI_ASSERT(erased);
-        // Silence compile warning unused erased
-        (void)erased;
-
-      }
-      --_aliveCount;
-      cbStruct->promise.setCanceled();
-      break;
-    default:
-      qiLogDebug() << "State is " << static_cast<int>(cbStruct->state)
-        << ", too late for canceling";
-      break;
+    qiLogDebug() << "Not scheduled yet, canceling future";
+    cbStruct->asyncFuture.cancel();
+    --_aliveCount;
+    cbStruct->promise.setCanceled();
+  }
+  else if (expected == State::Scheduled &&
+           cbStruct->state.compare_exchange_strong(expected, State::Canceled))
+  {
+    // process() drops the job when it pops it
+    qiLogDebug() << "Was scheduled, canceling it";
+    --_aliveCount;
+    cbStruct->promise.setCanceled();
+  }
+  else
+  {
+    qiLogDebug() << "State is " << static_cast<int>(expected)
+      << ", too late for canceling";
   }
 }
 
@@ -268,7 +440,7 @@ void Strand::join()
 
   {
     boost::unique_lock<boost::recursive_mutex> lock(_p->_mutex);
-    qiLogVerbose() << this << " joining (processing: " << _p->_processing
+    qiLogVerbose() << this << " joining (queued: " << _p->_queuedCount
       << ", size: " << _p->_aliveCount << ")";
 
     _p->_dying = true;
@@ -282,17 +454,8 @@ void Strand::join()
 
     boost::atomic_exchange(&prv, _p);
 
-    prv->_processFinished.wait(lock, [&]{ return !prv->_processing; });
-    while (!prv->_queue.empty())
-    {
-      auto task = std::move(prv->_queue.front());
-      prv->_queue.pop_front();
-      if (task->state == StrandPrivate::State::Canceled)
-        continue;
-      QI_ASSERT(task->state == StrandPrivate::State::Scheduled);
-      task->promise.setError("the strand is dying");
-      --prv->_aliveCount;
-    }
+    // process() fails the remaining jobs once it sees that we are dying
+    prv->_processFinished.wait(lock, [&]{ return prv->_queuedCount == 0; });
 
     qiLogVerbose() << this << " joined, remaining tasks: " << prv->_aliveCount;
   }
@@ -340,7 +503,7 @@ void Strand::postImpl(boost::function<void()> callback)
 {
   auto prv = boost::atomic_load(&_p);
   if (prv)
-    prv->enqueue(prv->createCallback(std::move(callback)));
+    prv->enqueue(std::move(callback));
 }
 
 bool Strand::isInThisContext()
@@ -2,7 +2,14 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
 #include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+#include <qi/atomic.hpp>
 #include <qi/future.hpp>
 #include <qi/signature.hpp>
 #include <qi/anyfunction.hpp>
@@ -13,44 +20,135 @@ qiLogCategory("qitype.functiontype");
 namespace qi
 {
 
-  //make destroy exception-safe for AnyFunction::call
-  class AnyReferenceArrayDestroyer : private boost::noncopyable {
-  public:
-    AnyReferenceArrayDestroyer(AnyReference *toDestroy, void **convertedArgs, bool shouldDelete)
-      : toDestroy(toDestroy)
-      , convertedArgs(convertedArgs)
-      , toDestroyPos(0)
-      , shouldDelete(shouldDelete)
+  namespace
+  {
+    // Number of arguments converted without allocating.
+    const unsigned int inlineArgumentCount = 8;
+
+    enum ArgumentConversion
     {
-    }
+      ArgumentConversion_PassThrough, // same type, the argument is passed as is
+      ArgumentConversion_String,      // to std::string, built in the call arena
+      ArgumentConversion_Generic,     // AnyReference::convert
+    };
+
+    /// Remembers, per thread, how the arguments of a type are passed to
+    /// parameters of another type, to skip the type comparisons of the next
+    /// calls. Types are never destroyed, so their addresses are stable keys.
+    class ConversionPlanCache
+    {
+    public:
+      ArgumentConversion conversion(TypeInterface* from, TypeInterface* to)
+      {
+        const std::size_t h = (reinterpret_cast<std::uintptr_t>(from) >> 4)
+                            ^ (reinterpret_cast<std::uintptr_t>(to) >> 2);
+        Entry& entry = _entries[h & (entryCount - 1)];
+        if (entry.from != from || entry.to != to)
+        {
+          entry.from = from;
+          entry.to = to;
+          entry.conversion = plan(from, to);
+        }
+        return entry.conversion;
+      }
 
-    ~AnyReferenceArrayDestroyer() {
-      destroy();
+    private:
+      static ArgumentConversion plan(TypeInterface* from, TypeInterface* to)
+      {
+        if (from == to || from->info() == to->info())
+          return ArgumentConversion_PassThrough;
+        if (from->kind() == TypeKind_String && to->info() == typeOf<std::string>()->info())
+          return ArgumentConversion_String;
+        return ArgumentConversion_Generic;
+      }
+
+      struct Entry
+      {
+        TypeInterface* from = nullptr;
+        TypeInterface* to = nullptr;
+        ArgumentConversion conversion = ArgumentConversion_Generic;
+      };
+      static const std::size_t entryCount = 64;
+      Entry _entries[entryCount];
+    };
+
+    ConversionPlanCache& conversionPlanCache()
+    {
+      static boost::thread_specific_ptr<ConversionPlanCache>* cache = nullptr;
+      QI_THREADSAFE_NEW(cache);
+      if (!cache->get())
+        cache->reset(new ConversionPlanCache);
+      return *cache->get();
     }
 
-    void destroy() {
-      if (toDestroy) {
-        for (unsigned i = 0; i < toDestroyPos; ++i)
-          toDestroy[i].destroy();
-        if (shouldDelete)
-          delete[] toDestroy;
-        toDestroy = 0;
+    /// The converted arguments of a call and the temporaries they need, on
+    /// the stack up to inlineArgumentCount arguments. The temporaries are
+    /// destroyed even if the call throws.
+    class CallArena : private boost::noncopyable
+    {
+    public:
+      explicit CallArena(unsigned int argc)
+        : convertedArgs(_inlineArgs)
+        , _temporaries(_inlineTemporaries)
+        , _temporaryCount(0)
+        , _stringCount(0)
+      {
+        if (argc > inlineArgumentCount)
+        {
+          _heapArgs.reset(new void*[argc]);
+          _heapTemporaries.reset(new AnyReference[argc]);
+          convertedArgs = _heapArgs.get();
+          _temporaries = _heapTemporaries.get();
+        }
+      }
+
+      ~CallArena()
+      {
+        destroy();
       }
-      if (shouldDelete && convertedArgs) {
-        delete[] convertedArgs;
-        convertedArgs = 0;
+
+      /// Returns false if the strings would have to be allocated.
+      bool canHoldString() const
+      {
+        return _stringCount < inlineArgumentCount;
       }
-    }
 
+      std::string* makeString(const char* data, std::size_t size)
+      {
+        QI_ASSERT(canHoldString());
+        return new (&_strings[_stringCount++]) std::string(data, size);
+      }
 
-  public:
-    AnyReference* toDestroy;
-    void**        convertedArgs;
-    unsigned int  toDestroyPos;
-    bool          shouldDelete;
-  };
+      void addTemporary(const AnyReference& temporary)
+      {
+        _temporaries[_temporaryCount++] = temporary;
+      }
 
+      void destroy()
+      {
+        for (unsigned int i = 0; i < _temporaryCount; ++i)
+          _temporaries[i].destroy();
+        _temporaryCount = 0;
+        for (unsigned int i = 0; i < _stringCount; ++i)
+          reinterpret_cast<std::string*>(&_strings[i])->~basic_string();
+        _stringCount = 0;
+      }
 
+      void** convertedArgs;
+
+    private:
+      using StringStorage = std::aligned_storage<sizeof(std::string), alignof(std::string)>::type;
+
+      void* _inlineArgs[inlineArgumentCount];
+      AnyReference _inlineTemporaries[inlineArgumentCount];
+      StringStorage _strings[inlineArgumentCount];
+      std::unique_ptr<void*[]> _heapArgs;
+      std::unique_ptr<AnyReference[]> _heapTemporaries;
+      AnyReference* _temporaries;
+      unsigned int _temporaryCount;
+      unsigned int _stringCount;
+    };
+  }
 
   AnyReference AnyFunction::call(AnyReference arg1, const AnyReferenceVector& remaining)
   {
@@ -122,17 +220,10 @@ namespace qi
       --sz;
     }
     unsigned offset = transform.prependValue? 1:0;
-#if QI_HAS_VARIABLE_LENGTH_ARRAY
-    AnyReference sstoDestroy[sz+offset];
-    void* ssconvertedArgs[sz+offset];
-    AnyReferenceArrayDestroyer arad(sstoDestroy, ssconvertedArgs, false);
-#else
-    AnyReference* sstoDestroy = new AnyReference[sz+offset];
-    void** ssconvertedArgs = new void*[sz+offset];
-    AnyReferenceArrayDestroyer arad(sstoDestroy, ssconvertedArgs, true);
-#endif
+    CallArena arena(sz+offset);
     if (transform.prependValue)
-      arad.convertedArgs[0] = transform.boundValue;
+      arena.convertedArgs[0] = transform.boundValue;
+    ConversionPlanCache& plans = conversionPlanCache();
     for (unsigned i=0; i<sz; ++i)
     {
       const unsigned ti = i + offset;
@@ -142,8 +233,17 @@ namespace qi
       if (!argType) // invalid argument not wrapped into a dynamic AnyReference!
         throwForInvalidConversion(i, arg.signature(), target[ti]->signature(), this->parametersSignature(this->transform.dropFirst));
 
-      if (argType == target[ti] || argType->info() == target[ti]->info())
-        arad.convertedArgs[ti] = arg.rawValue();
+      const ArgumentConversion conversion = plans.conversion(argType, target[ti]);
+      if (conversion == ArgumentConversion_PassThrough)
+        arena.convertedArgs[ti] = arg.rawValue();
+      else if (conversion == ArgumentConversion_String && arena.canHoldString())
+      {
+        StringTypeInterface::ManagedRawString raw =
+            static_cast<StringTypeInterface*>(argType)->get(arg.rawValue());
+        arena.convertedArgs[ti] = arena.makeString(raw.first.first, raw.first.second);
+        if (raw.second)
+          raw.second(raw.first);
+      }
       else
       {
         std::pair<AnyReference,bool> v = arg.convert(target[ti]);
@@ -167,13 +267,13 @@ namespace qi
         }
 
         if (v.second)
-          arad.toDestroy[arad.toDestroyPos++] = v.first;
-        arad.convertedArgs[ti] = v.first.rawValue();
+          arena.addTemporary(v.first);
+        arena.convertedArgs[ti] = v.first.rawValue();
       }
     }
     void* res;
-    res = type->call(value, arad.convertedArgs, sz+offset);
-    arad.destroy();
+    res = type->call(value, arena.convertedArgs, sz+offset);
+    arena.destroy();
     return AnyReference(resultType(), res);
   }
 
@@ -193,13 +193,15 @@ class MFunctorCall
 public:
   MFunctorCall(AnyFunction& func_, GenericFunctionParameters& params_,
      qi::Promise<AnyReference>* out_, bool noCloneFirst_,
-     AnyObject context_, unsigned int methodId_, unsigned int callerId_, qi::os::timeval postTimestamp_)
+     AnyObject context_, unsigned int methodId_, unsigned int callerId_, qi::os::timeval postTimestamp_,
+     boost::optional<SteadyClockTimePoint> deadline_)
     : out(out_)
     , noCloneFirst(noCloneFirst_)
     , context(context_)
     , methodId(methodId_)
     , callerId(callerId_)
     , postTimestamp(postTimestamp_)
+    , deadline(deadline_)
   {
     std::swap(this->func, func_);
     std::swap((AnyReferenceVector&) params_,
@@ -221,10 +223,15 @@ public:
     noCloneFirst = b.noCloneFirst;
     callerId = b.callerId;
     this->postTimestamp = b.postTimestamp;
+    deadline = b.deadline;
   }
   void operator()()
   {
-    call(*out, context, params, methodId, func, callerId, postTimestamp);
+    // Its caller gave up on it before it could start.
+    if (deadline && SteadyClock::now() >= *deadline)
+      out->setCanceled();
+    else
+      call(*out, context, params, methodId, func, callerId, postTimestamp);
     params.destroy(noCloneFirst);
     delete out;
   }
@@ -236,6 +243,7 @@ public:
   unsigned int methodId;
   unsigned int callerId;
   qi::os::timeval postTimestamp;
+  boost::optional<SteadyClockTimePoint> deadline;
 };
 
 }
@@ -281,8 +289,11 @@ qi::Future<AnyReference> metaCall(ExecutionContext* el,
     GenericFunctionParameters pCopy = params.copy(noCloneFirst);
     qi::Future<AnyReference> result = out->future();
     qi::os::timeval t(qi::SystemClock::now().time_since_epoch());
+    boost::optional<SteadyClockTimePoint> deadline;
+    if (context)
+      deadline = detail::currentCallDeadline(*context.asGenericObject());
     el->post(MFunctorCall(func, pCopy, out.release(), noCloneFirst, context,
-                           methodId, callerId ? callerId : qi::os::gettid(), t));
+                           methodId, callerId ? callerId : qi::os::gettid(), t, deadline));
     return result;
   }
 }
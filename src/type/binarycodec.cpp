@@ -15,8 +15,16 @@
 #include <qi/anyobject.hpp>
 #include <qi/type/typedispatcher.hpp>
 #include <qi/types.hpp>
+#include <qi/scoped.hpp>
+#include <algorithm>
 #include <vector>
 #include <cstring>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/unordered_map.hpp>
 
 qiLogCategory("qitype.binarycoder");
 
@@ -28,6 +36,8 @@ namespace qi {
     void serialize(AnyReference val, BinaryEncoder& out, SerializeObjectCallback context, StreamContext* ctx);
     AnyReference deserialize(AnyReference what, BinaryDecoder& in, DeserializeObjectCallback context, StreamContext* ctx);
     AnyReference deserialize(qi::TypeInterface *type, BinaryDecoder& in, DeserializeObjectCallback context, StreamContext* ctx);
+    // Whether the type is a tuple made at runtime, see makeTupleType.
+    bool isDynamicTupleType(TypeInterface* type);
   }
   class BinaryDecoder;
   class BinaryEncoder;
@@ -379,6 +389,100 @@ namespace qi {
 
   namespace detail {
 
+    /// Can be disabled to compare with the element by element codec.
+    static std::atomic<bool> contiguousListCodecEnabled{true};
+
+    /// Returns the vector referenced by `list` if it is a std::vector<T>.
+    template<typename T>
+    static std::vector<T>* contiguousList(const AnyReference& list)
+    {
+      static TypeInterface* const type = typeOf<std::vector<T>>();
+      if (list.type() != type && list.type()->info() != type->info())
+        return nullptr;
+      void* storage = list.rawValue();
+      return static_cast<std::vector<T>*>(list.type()->ptrFromStorage(&storage));
+    }
+
+    template<typename T, typename F>
+    static bool applyIfVectorOf(const AnyReference& list, F& f)
+    {
+      std::vector<T>* v = contiguousList<T>(list);
+      if (!v)
+        return false;
+      f(*v);
+      return true;
+    }
+
+    /// Calls `f` on the vector referenced by `list` if it is a std::vector of
+    /// integers or floating point numbers, which are serialized as their bytes
+    /// in memory, and returns true. Otherwise returns false.
+    ///
+    /// As the binary format is in the byte order of the host, these lists can
+    /// be copied from or to the buffer at once.
+    template<typename F>
+    static bool applyToContiguousList(const AnyReference& list, F& f)
+    {
+      if (!contiguousListCodecEnabled.load(std::memory_order_relaxed))
+        return false;
+      switch (static_cast<ListTypeInterface*>(list.type())->elementType()->kind())
+      {
+      case TypeKind_Float:
+        return applyIfVectorOf<float>(list, f) || applyIfVectorOf<double>(list, f);
+      case TypeKind_Int:
+        // std::vector<bool> is not supported.
+        return applyIfVectorOf<int>(list, f) || applyIfVectorOf<unsigned int>(list, f)
+            || applyIfVectorOf<char>(list, f) || applyIfVectorOf<signed char>(list, f)
+            || applyIfVectorOf<unsigned char>(list, f) || applyIfVectorOf<short>(list, f)
+            || applyIfVectorOf<unsigned short>(list, f) || applyIfVectorOf<long>(list, f)
+            || applyIfVectorOf<unsigned long>(list, f) || applyIfVectorOf<long long>(list, f)
+            || applyIfVectorOf<unsigned long long>(list, f);
+      default:
+        return false;
+      }
+    }
+
+    struct ContiguousListWriter
+    {
+      template<typename T>
+      void operator()(const std::vector<T>& v)
+      {
+        out.beginList(static_cast<qi::uint32_t>(v.size()), signature);
+        if (!v.empty())
+          out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+        out.endList();
+      }
+
+      BinaryEncoder& out;
+      const Signature& signature;
+    };
+
+    /// Appends the decoded elements, like the element by element decoding.
+    struct ContiguousListReader
+    {
+      template<typename T>
+      void operator()(std::vector<T>& v)
+      {
+        qi::uint32_t sz = 0;
+        in.read(sz);
+        if (in.status() != BinaryDecoder::Status::Ok || sz == 0)
+          return;
+        // The size is checked against the data before any allocation.
+        const void* data = sz <= std::numeric_limits<std::size_t>::max() / sizeof(T)
+            ? in.readRaw(sz * sizeof(T)) : nullptr;
+        if (!data)
+        {
+          in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+          return;
+        }
+        const std::size_t offset = v.size();
+        v.resize(offset + sz);
+        // The data may not be aligned for T.
+        std::memcpy(v.data() + offset, data, sz * sizeof(T));
+      }
+
+      BinaryDecoder& in;
+    };
+
     class SerializeTypeVisitor
     {
     public:
@@ -442,7 +546,11 @@ namespace qi {
 
       void visitList(AnyIterator it, AnyIterator end)
       {
-        out.beginList(value.size(), static_cast<ListTypeInterface*>(value.type())->elementType()->signature());
+        const Signature elementSignature = static_cast<ListTypeInterface*>(value.type())->elementType()->signature();
+        ContiguousListWriter writer{out, elementSignature};
+        if (applyToContiguousList(value, writer))
+          return;
+        out.beginList(value.size(), elementSignature);
         for (; it != end; ++it)
           serialize(*it, out, serializeObjectCb, streamContext);
         out.endList();
@@ -634,6 +742,9 @@ namespace qi {
 
       void visitList(AnyIterator, AnyIterator)
       {
+        ContiguousListReader reader{in};
+        if (applyToContiguousList(result, reader))
+          return;
         TypeInterface* elementType = static_cast<ListTypeInterface*>(result.type())->elementType();
         qi::uint32_t sz = 0;
         in.read(sz);
@@ -771,10 +882,312 @@ namespace qi {
       StreamContext* streamContext;
     }; //class
 
+
+    /// Serialization plan of a struct whose fields are all integers, floating
+    /// point numbers or strings, compiled once per type.
+    ///
+    /// Encoding writes each run of numeric fields that are contiguous in the
+    /// instance memory with a single copy. Decoding reads each run with a
+    /// single read, then sets the fields one by one through the struct
+    /// interface, so that custom setters (see QI_TYPE_STRUCT_EX) still apply.
+    ///
+    /// The produced data is the same as with the type visitors.
+    class StructCodecPlan
+    {
+    public:
+      /// Returns the plan of the type, or null if the type is not eligible.
+      /// Plans are compiled on first use and never freed.
+      static const StructCodecPlan* get(TypeInterface* type);
+
+      /// Whether each field of the struct can be set individually, which is
+      /// needed by `decode`.
+      bool canDecode() const
+      {
+        return _canDecode;
+      }
+
+      void encode(void* storage, BinaryEncoder& out) const;
+      void decode(void* storage, BinaryDecoder& in) const;
+
+    private:
+      /// Size of the local buffer used to read runs of fields. Runs are split
+      /// to fit in it.
+      static const std::size_t maxRunSize = 256;
+
+      struct Field
+      {
+        unsigned int index;
+        std::size_t offset; // in the instance memory
+        std::size_t size;   // 0 for a std::string
+        // Any byte is accepted on the wire, but a bool must hold 0 or 1.
+        bool isBool;
+      };
+
+      /// A string, or numeric fields contiguous in memory and in the data.
+      struct Run
+      {
+        std::size_t firstField;
+        std::size_t fieldCount;
+        std::size_t offset;
+        std::size_t size; // 0 for a std::string
+      };
+
+      static StructCodecPlan* compile(TypeInterface* type);
+
+      StructTypeInterface* _type;
+      Signature _signature;
+      std::vector<Field> _fields;
+      std::vector<Run> _runs;
+      bool _canDecode;
+    };
+
+    static const std::size_t notPlain = static_cast<std::size_t>(-1);
+
+    /// Returns the size of the values of the type if they are serialized as
+    /// their bytes in memory, 0 for a std::string, or `notPlain`.
+    static std::size_t plainFieldSize(TypeInterface* type)
+    {
+      static std::vector<TypeInterface*>* plainTypes = nullptr;
+      QI_ONCE((plainTypes = new std::vector<TypeInterface*>{
+        qi::typeOf<bool>(), qi::typeOf<char>(), qi::typeOf<signed char>(),
+        qi::typeOf<unsigned char>(), qi::typeOf<short>(), qi::typeOf<unsigned short>(),
+        qi::typeOf<int>(), qi::typeOf<unsigned int>(), qi::typeOf<long>(),
+        qi::typeOf<unsigned long>(), qi::typeOf<long long>(), qi::typeOf<unsigned long long>(),
+        qi::typeOf<float>(), qi::typeOf<double>(), qi::typeOf<std::string>()}));
+
+      const TypeKind kind = type->kind();
+      if (kind == TypeKind_Int || kind == TypeKind_Float || kind == TypeKind_String)
+      {
+        // Other types of these kinds, like durations, convert their values.
+        const bool plain = std::any_of(plainTypes->begin(), plainTypes->end(),
+                                       [&](TypeInterface* t) { return t->info() == type->info(); })
+            || (kind == TypeKind_Int && dynamic_cast<IntTypeInterfaceImpl<int>*>(type)); // enums
+        if (!plain)
+          return notPlain;
+      }
+      switch (kind)
+      {
+      case TypeKind_Int:
+      {
+        const unsigned int size = static_cast<IntTypeInterface*>(type)->size();
+        return size == 0 ? sizeof(bool) : size;
+      }
+      case TypeKind_Float:
+        return static_cast<FloatTypeInterface*>(type)->size();
+      case TypeKind_String:
+        return 0;
+      default:
+        return notPlain;
+      }
+    }
+
+    /// Can be disabled to compare with the type visitors.
+    static std::atomic<bool> structCodecPlansEnabled{true};
+
+    StructCodecPlan* StructCodecPlan::compile(TypeInterface* type)
+    {
+      static_assert(sizeof(bool) == 1, "bool is serialized with one byte");
+      // The fields of dynamic tuples are not stored in the instance.
+      if (isDynamicTupleType(type))
+        return nullptr;
+      StructTypeInterface* structType = static_cast<StructTypeInterface*>(type);
+      const std::vector<TypeInterface*> memberTypes = structType->memberTypes();
+      if (memberTypes.empty())
+        return nullptr;
+
+      std::vector<std::size_t> sizes;
+      for (TypeInterface* member: memberTypes)
+      {
+        const std::size_t size = plainFieldSize(member);
+        if (size == notPlain)
+          return nullptr;
+        sizes.push_back(size);
+      }
+
+      // The offsets of the fields are found on two instances: they must be
+      // the same for both, or the fields are not stored in the instance.
+      void* storages[2] = { type->initializeStorage(), type->initializeStorage() };
+      auto destroyStorages = scoped([&] {
+        for (void* storage: storages)
+          if (storage)
+            type->destroy(storage);
+      });
+      if (!storages[0] || !storages[1])
+        return nullptr;
+      std::unique_ptr<StructCodecPlan> plan(new StructCodecPlan);
+      for (unsigned int i = 0; i < memberTypes.size(); ++i)
+      {
+        std::ptrdiff_t offsets[2];
+        for (int s = 0; s < 2; ++s)
+        {
+          void* fieldStorage = structType->get(storages[s], i);
+          if (!fieldStorage || memberTypes[i]->ptrFromStorage(&fieldStorage) != fieldStorage)
+            return nullptr;
+          offsets[s] = static_cast<char*>(fieldStorage)
+              - static_cast<char*>(type->ptrFromStorage(&storages[s]));
+        }
+        if (offsets[0] != offsets[1] || offsets[0] < 0)
+          return nullptr;
+        const bool isBool = memberTypes[i]->info() == qi::typeOf<bool>()->info();
+        plan->_fields.push_back(Field{i, static_cast<std::size_t>(offsets[0]), sizes[i], isBool});
+      }
+
+      for (std::size_t i = 0; i < plan->_fields.size(); ++i)
+      {
+        const Field& field = plan->_fields[i];
+        if (!plan->_runs.empty())
+        {
+          Run& last = plan->_runs.back();
+          if (field.size && last.size && last.offset + last.size == field.offset
+              && last.size + field.size <= maxRunSize)
+          {
+            ++last.fieldCount;
+            last.size += field.size;
+            continue;
+          }
+        }
+        plan->_runs.push_back(Run{i, 1, field.offset, field.size});
+      }
+
+      plan->_type = structType;
+      plan->_signature = makeTupleSignature(memberTypes);
+      try
+      {
+        // Structs built from a constructor cannot set a single field.
+        for (unsigned int i = 0; i < memberTypes.size(); ++i)
+          structType->set(&storages[0], i, structType->get(storages[1], i));
+        plan->_canDecode = true;
+      }
+      catch (const std::exception&)
+      {
+        plan->_canDecode = false;
+      }
+      return plan.release();
+    }
+
+    const StructCodecPlan* StructCodecPlan::get(TypeInterface* type)
+    {
+      using PlanMap = boost::unordered_map<TypeInterface*, const StructCodecPlan*>;
+      // Plans are looked up in a per-thread map first, to avoid locking.
+      static boost::thread_specific_ptr<PlanMap>* threadPlans = nullptr;
+      static PlanMap* plans = nullptr;
+      static boost::mutex* mutex = nullptr;
+      QI_THREADSAFE_NEW(threadPlans, plans, mutex);
+
+      PlanMap* localPlans = threadPlans->get();
+      if (!localPlans)
+      {
+        localPlans = new PlanMap;
+        threadPlans->reset(localPlans);
+      }
+      PlanMap::const_iterator it = localPlans->find(type);
+      if (it != localPlans->end())
+        return it->second;
+
+      const StructCodecPlan* plan;
+      {
+        boost::mutex::scoped_lock lock(*mutex);
+        it = plans->find(type);
+        if (it != plans->end())
+          plan = it->second;
+        else
+        {
+          try
+          {
+            plan = compile(type);
+          }
+          catch (const std::exception& e)
+          {
+            qiLogDebug() << "Cannot compile a serialization plan for " << type->infoString() << ": " << e.what();
+            plan = nullptr;
+          }
+          qiLogDebug() << "Serialization plan for " << type->infoString() << ": "
+                       << (plan ? "compiled" : "not eligible");
+          plans->emplace(type, plan);
+        }
+      }
+      localPlans->emplace(type, plan);
+      return plan;
+    }
+
+    void StructCodecPlan::encode(void* storage, BinaryEncoder& out) const
+    {
+      const char* instance = static_cast<const char*>(_type->ptrFromStorage(&storage));
+      out.beginTuple(_signature);
+      for (const Run& run: _runs)
+      {
+        if (run.size)
+          out.write(instance + run.offset, run.size);
+        else
+        {
+          const std::string& s = *reinterpret_cast<const std::string*>(instance + run.offset);
+          out.writeString(s.data(), s.size());
+        }
+      }
+      out.endTuple();
+    }
+
+    void StructCodecPlan::decode(void* storage, BinaryDecoder& in) const
+    {
+      for (const Run& run: _runs)
+      {
+        if (run.size)
+        {
+          unsigned char data[maxRunSize];
+          if (in.readRaw(data, run.size) != run.size)
+          {
+            in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+            return;
+          }
+          for (std::size_t i = run.firstField; i < run.firstField + run.fieldCount; ++i)
+          {
+            const Field& field = _fields[i];
+            // Copy to an aligned storage of the field type.
+            union { std::uint64_t u64; double d; unsigned char bytes[8]; } value;
+            std::memcpy(value.bytes, data + (field.offset - run.offset), field.size);
+            if (field.isBool)
+              value.bytes[0] = value.bytes[0] != 0;
+            _type->set(&storage, field.index, value.bytes);
+          }
+        }
+        else
+        {
+          std::string s;
+          in.read(s);
+          if (in.status() != BinaryDecoder::Status::Ok)
+            return;
+          _type->set(&storage, _fields[run.firstField].index, &s);
+        }
+      }
+    }
+
+    static const StructCodecPlan* structCodecPlan(const AnyReference& value)
+    {
+      if (!value.type() || value.type()->kind() != TypeKind_Tuple
+          || !structCodecPlansEnabled.load(std::memory_order_relaxed))
+        return nullptr;
+      return StructCodecPlan::get(value.type());
+    }
+
+    void setStructCodecPlansEnabled(bool enabled)
+    {
+      structCodecPlansEnabled = enabled;
+    }
+
+    void setContiguousListCodecEnabled(bool enabled)
+    {
+      contiguousListCodecEnabled = enabled;
+    }
+
     void serialize(AnyReference val, BinaryEncoder& out, SerializeObjectCallback context, StreamContext* sctx)
     {
-      detail::SerializeTypeVisitor stv(out, context, val, sctx);
-      qi::typeDispatch(stv, val);
+      if (const StructCodecPlan* plan = structCodecPlan(val))
+        plan->encode(val.rawValue(), out);
+      else
+      {
+        detail::SerializeTypeVisitor stv(out, context, val, sctx);
+        qi::typeDispatch(stv, val);
+      }
       if (out.status() != BinaryEncoder::Status::Ok) {
         std::stringstream ss;
         ss << "OSerialization error " << BinaryEncoder::statusToStr(out.status());
@@ -784,15 +1197,24 @@ namespace qi {
 
     AnyReference deserialize(AnyReference what, BinaryDecoder& in, DeserializeObjectCallback context, StreamContext* sctx)
     {
-      detail::DeserializeTypeVisitor dtv(in, context, sctx);
-      dtv.result = what;
-      qi::typeDispatch(dtv, dtv.result);
+      const StructCodecPlan* plan = structCodecPlan(what);
+      if (plan && plan->canDecode())
+      {
+        plan->decode(what.rawValue(), in);
+      }
+      else
+      {
+        detail::DeserializeTypeVisitor dtv(in, context, sctx);
+        dtv.result = what;
+        qi::typeDispatch(dtv, dtv.result);
+        what = dtv.result;
+      }
       if (in.status() != BinaryDecoder::Status::Ok) {
         std::stringstream ss;
         ss << "ISerialization error " << BinaryDecoder::statusToStr(in.status());
         throw std::runtime_error(ss.str());
       }
-      return dtv.result;
+      return what;
     }
 
     AnyReference deserialize(qi::TypeInterface *type, BinaryDecoder& in, DeserializeObjectCallback context, StreamContext* sctx)
@@ -810,8 +1232,13 @@ namespace qi {
 
   void encodeBinary(qi::Buffer *buf, const qi::AutoAnyReference &gvp, SerializeObjectCallback onObject, StreamContext* sctx) {
     BinaryEncoder be(*buf);
-    detail::SerializeTypeVisitor stv(be, onObject, gvp, sctx);
-    qi::typeDispatch(stv, gvp);
+    if (const detail::StructCodecPlan* plan = detail::structCodecPlan(gvp))
+      plan->encode(gvp.rawValue(), be);
+    else
+    {
+      detail::SerializeTypeVisitor stv(be, onObject, gvp, sctx);
+      qi::typeDispatch(stv, gvp);
+    }
     if (be.status() != BinaryEncoder::Status::Ok) {
       std::stringstream ss;
       ss << "OSerialization error " << BinaryEncoder::statusToStr(be.status());
@@ -823,16 +1250,25 @@ namespace qi {
   AnyReference decodeBinary(qi::BufferReader *buf, qi::AnyReference gvp,
     DeserializeObjectCallback onObject, StreamContext* sctx) {
     BinaryDecoder in(buf);
-    detail::DeserializeTypeVisitor dtv(in, onObject, sctx);
-    dtv.result = gvp;
-    qi::typeDispatch(dtv, dtv.result);
+    const detail::StructCodecPlan* plan = detail::structCodecPlan(gvp);
+    if (plan && plan->canDecode())
+    {
+      plan->decode(gvp.rawValue(), in);
+    }
+    else
+    {
+      detail::DeserializeTypeVisitor dtv(in, onObject, sctx);
+      dtv.result = gvp;
+      qi::typeDispatch(dtv, dtv.result);
+      gvp = dtv.result;
+    }
     if (in.status() != BinaryDecoder::Status::Ok) {
       std::stringstream ss;
       ss << "ISerialization error " << BinaryDecoder::statusToStr(in.status());
       qiLogError() << ss.str();
       throw std::runtime_error(ss.str());
     }
-    return dtv.result;
+    return gvp;
   }
 
 }
@@ -154,6 +154,19 @@ namespace qi {
     BinaryEncoderPrivate *_p;
   };
 
+  namespace detail
+  {
+    /// Enables or disables the serialization plans of the structs made of
+    /// numbers and strings (enabled by default). When disabled, these structs
+    /// are serialized by the type visitors, which produce the same data.
+    QI_API void setStructCodecPlansEnabled(bool enabled);
+
+    /// Enables or disables the copy at once of the std::vector of integers or
+    /// floating point numbers (enabled by default). When disabled, their
+    /// elements are serialized one by one, which produces the same data.
+    QI_API void setContiguousListCodecEnabled(bool enabled);
+  }
+
   template<typename T>
   void BinaryEncoder::write(const T &v)
   {
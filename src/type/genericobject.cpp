@@ -1,4 +1,7 @@
+#include <boost/thread/tss.hpp>
 #include <qi/anyobject.hpp>
+#include <qi/atomic.hpp>
+#include <qi/eventloop.hpp>
 #include <qi/log.hpp>
 
 #include "metaobject_p.hpp"
@@ -8,6 +11,55 @@ qiLogCategory("qitype.genericobject");
 namespace qi
 {
 
+namespace
+{
+  struct CallDeadline
+  {
+    SteadyClockTimePoint deadline;
+    // The object called, the only one the deadline applies to: the calls
+    // its methods make while running in the calling thread do not inherit it.
+    const GenericObject* target;
+  };
+
+  boost::thread_specific_ptr<CallDeadline>& callDeadlineSlot()
+  {
+    static boost::thread_specific_ptr<CallDeadline>* slot = nullptr;
+    QI_THREADSAFE_NEW(slot);
+    return *slot;
+  }
+
+  /// Sets the deadline of the call of `target` made by the current thread
+  /// while it lives.
+  class CallDeadlineScope
+  {
+  public:
+    CallDeadlineScope(SteadyClockTimePoint deadline, const GenericObject* target)
+      : _previous(callDeadlineSlot().release())
+    {
+      callDeadlineSlot().reset(new CallDeadline{deadline, target});
+    }
+
+    ~CallDeadlineScope()
+    {
+      callDeadlineSlot().reset(_previous);
+    }
+
+  private:
+    CallDeadline* _previous;
+  };
+}
+
+namespace detail
+{
+  boost::optional<SteadyClockTimePoint> currentCallDeadline(const GenericObject& target)
+  {
+    const CallDeadline* current = callDeadlineSlot().get();
+    if (!current || current->target != &target)
+      return {};
+    return current->deadline;
+  }
+}
+
 GenericObject::GenericObject(ObjectTypeInterface *type, void *value)
 : type(type)
 , value(value)
@@ -61,6 +113,32 @@ qi::Future<AnyReference> GenericObject::metaCall(
   return unwrappedResult.future();
 }
 
+qi::Future<AnyReference> GenericObject::metaCall(
+    unsigned int method,
+    const GenericFunctionParameters& params,
+    SteadyClockTimePoint deadline,
+    MetaCallType callType,
+    Signature returnSignature)
+{
+  if (SteadyClock::now() >= deadline)
+  {
+    Promise<AnyReference> expired;
+    expired.setCanceled();
+    return expired.future();
+  }
+  Future<AnyReference> result;
+  {
+    CallDeadlineScope scope(deadline, this);
+    result = metaCall(method, params, callType, returnSignature);
+  }
+  if (!result.isFinished())
+  {
+    Future<void> timer = getEventLoop()->asyncAt([result]() mutable { result.cancel(); }, deadline);
+    result.connect([timer](const Future<AnyReference>&) mutable { timer.cancel(); });
+  }
+  return result;
+}
+
 qi::Future<AnyReference> GenericObject::metaCall(
     const std::string &nameWithOptionalSignature,
     const GenericFunctionParameters& args,
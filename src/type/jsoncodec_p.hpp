@@ -7,11 +7,125 @@
 #ifndef _JSONPARSER_P_HPP_
 # define _JSONPARSER_P_HPP_
 
+# include <cstring>
 # include <string>
 # include <qi/anyvalue.hpp>
+# include <qi/types.hpp>
+# ifdef __SSE2__
+#  include <emmintrin.h>
+# endif
 
 namespace qi {
 
+  namespace detail
+  {
+    /// Scanners of the characters the JSON codec has to stop at, which look at
+    /// 16 bytes at once with SSE2, or 8 bytes at once otherwise.
+    namespace json
+    {
+      inline bool isStringSpecial(unsigned char c)
+      {
+        return c == '"' || c == '\\';
+      }
+
+      /// Printable ASCII characters are output as they are, except for the
+      /// ones that must be escaped.
+      inline bool isEncodingSpecial(unsigned char c)
+      {
+        return c < 0x20 || c >= 0x7F || c == '"' || c == '\\';
+      }
+
+# ifndef __SSE2__
+      inline qi::uint64_t loadWord(const char* p)
+      {
+        qi::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+      }
+
+      inline qi::uint64_t broadcast(unsigned char c)
+      {
+        return 0x0101010101010101ULL * c;
+      }
+
+      /// Non-zero if a byte of word is zero.
+      inline qi::uint64_t hasZeroByte(qi::uint64_t word)
+      {
+        return (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+      }
+# endif
+
+      /// Returns the first quote or backslash of [it, end), or end.
+      inline const char* findStringSpecial(const char* it, const char* end)
+      {
+# ifdef __SSE2__
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - it >= 16)
+        {
+          const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+          const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                          _mm_cmpeq_epi8(chunk, backslash)));
+          if (mask)
+            return it + __builtin_ctz(mask);
+          it += 16;
+        }
+# else
+        while (end - it >= 8)
+        {
+          const qi::uint64_t word = loadWord(it);
+          if (hasZeroByte(word ^ broadcast('"')) | hasZeroByte(word ^ broadcast('\\')))
+            break;
+          it += 8;
+        }
+# endif
+        while (it != end && !isStringSpecial(*it))
+          ++it;
+        return it;
+      }
+
+      /// Returns the first character of [it, end) that cannot be output as is
+      /// in a JSON string, or end.
+      inline const char* findEncodingSpecial(const char* it, const char* end)
+      {
+# ifdef __SSE2__
+        // As signed bytes, the characters below 0x20 and above 0x7F are all
+        // lower than 0x20.
+        const __m128i space = _mm_set1_epi8(0x20);
+        const __m128i del = _mm_set1_epi8(0x7F);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - it >= 16)
+        {
+          const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+          const __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmplt_epi8(chunk, space), _mm_cmpeq_epi8(chunk, del)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+          const int mask = _mm_movemask_epi8(special);
+          if (mask)
+            return it + __builtin_ctz(mask);
+          it += 16;
+        }
+# else
+        while (end - it >= 8)
+        {
+          const qi::uint64_t word = loadWord(it);
+          const qi::uint64_t belowSpace =
+              (word - broadcast(0x20)) & ~word & 0x8080808080808080ULL;
+          if (belowSpace | (word & 0x8080808080808080ULL)
+              | hasZeroByte(word ^ broadcast(0x7F))
+              | hasZeroByte(word ^ broadcast('"')) | hasZeroByte(word ^ broadcast('\\')))
+            break;
+          it += 8;
+        }
+# endif
+        while (it != end && !isEncodingSpecial(*it))
+          ++it;
+        return it;
+      }
+    }
+  }
+
   class JsonDecoderPrivate
   {
   public:
@@ -19,28 +133,41 @@ namespace qi {
     JsonDecoderPrivate(const std::string::const_iterator &begin,
                       const std::string::const_iterator &end);
     std::string::const_iterator decode(AnyValue &out);
+    /// Decodes directly into a value of a known type.
+    std::string::const_iterator decode(AnyReference out);
 
   private:
+    struct Number
+    {
+      bool isFloat;
+      qi::int64_t integer;
+      double real;
+    };
+
     void skipWhiteSpaces();
-    bool getDigits(std::string &result);
-    bool getInteger(std::string &result);
-    bool getInteger(qi::int64_t &result);
-    bool getExponent(std::string &result);
-    bool getFloat(double &result);
+    bool getDigits(qi::uint64_t &result, int &droppedDigits);
+    bool getNumber(Number &result);
     bool decodeArray(AnyValue &value);
-    bool decodeFloat(AnyValue &value);
-    bool decodeInteger(AnyValue &value);
+    bool decodeNumber(AnyValue &value);
     bool getCleanString(std::string &result);
     bool decodeString(AnyValue &value);
     bool decodeObject(AnyValue &value);
-    bool match(std::string const& expected);
+    bool match(const char* expected);
     bool decodeSpecial(AnyValue &value);
     bool decodeValue(AnyValue &value);
 
+    bool decodeTypedList(AnyReference &target);
+    bool decodeTypedMap(AnyReference &target);
+    bool decodeTypedTuple(AnyReference &target);
+    bool decodeTypedValue(AnyReference &target);
+
+    std::string::const_iterator position() const;
+
   private:
-    std::string::const_iterator const _begin;
-    std::string::const_iterator const _end;
-    std::string::const_iterator       _it;
+    std::string::const_iterator const _iteratorBegin;
+    const char* const _begin;
+    const char* const _end;
+    const char*       _it;
   };
 
 }
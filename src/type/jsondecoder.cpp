@@ -5,7 +5,9 @@
 
 #include <qi/jsoncodec.hpp>
 #include <qi/anyvalue.hpp>
+#include <algorithm>
 #include <iterator>
+#include <limits>
 #include <boost/lexical_cast.hpp>
 #ifdef WITH_BOOST_LOCALE
 #  include <boost/locale.hpp>
@@ -14,144 +16,170 @@
 
 namespace qi {
 
+  namespace
+  {
+    const char* dataBegin(const std::string::const_iterator &begin,
+                          const std::string::const_iterator &end)
+    {
+      return begin == end ? nullptr : &*begin;
+    }
+
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    // The powers of ten that are exactly represented by a double.
+    const double exactPowersOfTen[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const int maxExactPowerOfTen = 22;
+    // Mantissas below 2^53 are exactly represented by a double.
+    const qi::uint64_t maxExactMantissa = 1ULL << 53;
+  }
+
   JsonDecoderPrivate::JsonDecoderPrivate(const std::string &in)
-    :_begin(in.begin()),
-      _end(in.end()),
+    : _iteratorBegin(in.begin()),
+      _begin(in.data()),
+      _end(in.data() + in.size()),
       _it(_begin)
   {}
 
   JsonDecoderPrivate::JsonDecoderPrivate(const std::string::const_iterator &begin,
                     const std::string::const_iterator &end)
-    :_begin(begin),
-      _end(end),
+    : _iteratorBegin(begin),
+      _begin(dataBegin(begin, end)),
+      _end(_begin + (end - begin)),
       _it(_begin)
   {}
 
+  std::string::const_iterator JsonDecoderPrivate::position() const
+  {
+    return _iteratorBegin + (_it - _begin);
+  }
+
   std::string::const_iterator JsonDecoderPrivate::decode(AnyValue &out)
   {
     _it = _begin;
     if (!decodeValue(out))
       throw std::runtime_error("parse error");
-    return _it;
+    return position();
   }
 
-  void JsonDecoderPrivate::skipWhiteSpaces()
+  std::string::const_iterator JsonDecoderPrivate::decode(AnyReference out)
   {
-    while (_it != _end && (*_it == ' ' || *_it == '\n'))
-      ++_it;
+    _it = _begin;
+    if (!decodeTypedValue(out))
+      throw std::runtime_error("parse error");
+    return position();
   }
 
-  bool JsonDecoderPrivate::getDigits(std::string &result)
+  void JsonDecoderPrivate::skipWhiteSpaces()
   {
-    std::string::const_iterator begin = _it;
-
-    while (_it != _end && *_it >= '0' && *_it <= '9')
+    while (_it != _end && (*_it == ' ' || *_it == '\n' || *_it == '\t' || *_it == '\r'))
       ++_it;
-    if (_it == begin)
-        return false;
-    result = std::string(begin, _it);
-    return true;
   }
 
-  bool JsonDecoderPrivate::getInteger(std::string &result)
+  bool JsonDecoderPrivate::getDigits(qi::uint64_t &result, int &droppedDigits)
   {
-    std::string::const_iterator save = _it;
-    std::string integerStr;
+    const char* const begin = _it;
+    for (; _it != _end && isDigit(*_it); ++_it)
+    {
+      const unsigned int digit = *_it - '0';
+      if (droppedDigits == 0 && result <= (std::numeric_limits<qi::uint64_t>::max() - digit) / 10)
+        result = result * 10 + digit;
+      else
+        ++droppedDigits;
+    }
+    return _it != begin;
+  }
 
+  bool JsonDecoderPrivate::getNumber(Number &result)
+  {
+    const char* const save = _it;
     if (_it == _end)
       return false;
-    if (*_it == '-')
-    {
+    const bool negative = *_it == '-';
+    if (negative)
       ++_it;
-      integerStr = "-";
-    }
-    std::string digitsStr;
 
-    if (!getDigits(digitsStr))
+    qi::uint64_t mantissa = 0;
+    int droppedDigits = 0;
+    if (!getDigits(mantissa, droppedDigits))
     {
       _it = save;
       return false;
     }
-    integerStr += digitsStr;
+    // the digits dropped from the integer part multiply the mantissa
+    int exponent = droppedDigits;
+    result.isFloat = false;
 
-    result = integerStr;
-    return true;
-  }
-
-  bool JsonDecoderPrivate::getInteger(qi::int64_t &result)
-  {
-    std::string integerStr;
-
-    if (!getInteger(integerStr))
-      return false;
-    result = ::atol(integerStr.c_str());
-    return true;
-  }
-
-  bool JsonDecoderPrivate::getExponent(std::string &result)
-  {
-    std::string::const_iterator save = _it;
-
-    if (_it == _end || (*_it != 'e' && *_it != 'E'))
-      return false;
-    ++_it;
-    std::string exponentStr;
-
-    exponentStr += 'e';
-    if (*_it == '+' || *_it == '-')
+    if (_it + 1 < _end && *_it == '.' && isDigit(*(_it + 1)))
     {
-      exponentStr += *_it;
       ++_it;
-    }
-    else
-      exponentStr += '+';
-    std::string integerStr;
-    if (!getDigits(integerStr))
-    {
-      _it = save;
-      return false;
+      const char* const fractionBegin = _it;
+      int droppedFractionDigits = droppedDigits;
+      getDigits(mantissa, droppedFractionDigits);
+      exponent -= static_cast<int>(_it - fractionBegin) - (droppedFractionDigits - droppedDigits);
+      droppedDigits = droppedFractionDigits;
+      result.isFloat = true;
     }
 
-    result = exponentStr + integerStr;
-    return true;
-  }
-
-  bool JsonDecoderPrivate::getFloat(double &result)
-  {
-    std::string floatStr;
-    std::string beforePoint;
-    std::string afterPoint;
-    std::string exponent;
-    std::string::const_iterator save = _it;
-
-    if (!getInteger(beforePoint))
-      return false;
-    if (!getExponent(exponent))
+    if (_it != _end && (*_it == 'e' || *_it == 'E'))
     {
-      if (_it == _end || *_it != '.')
+      const char* exponentIt = _it + 1;
+      bool negativeExponent = false;
+      if (exponentIt != _end && (*exponentIt == '+' || *exponentIt == '-'))
       {
-        _it = save;
-        return false;
+        negativeExponent = *exponentIt == '-';
+        ++exponentIt;
       }
-      ++_it;
-      if (!getDigits(afterPoint))
+      if (exponentIt != _end && isDigit(*exponentIt))
       {
-        _it = save;
-        return false;
+        int explicitExponent = 0;
+        for (; exponentIt != _end && isDigit(*exponentIt); ++exponentIt)
+          if (explicitExponent < 100000)
+            explicitExponent = explicitExponent * 10 + (*exponentIt - '0');
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        _it = exponentIt;
+        result.isFloat = true;
       }
-      getExponent(exponent);
-      floatStr = beforePoint + "." + afterPoint + exponent;
     }
-    else
-      floatStr = beforePoint + exponent;
 
-    result = boost::lexical_cast<double>(floatStr.c_str());
+    if (!result.isFloat)
+    {
+      // clamped as strtol does
+      const qi::uint64_t limit = negative
+          ? static_cast<qi::uint64_t>(std::numeric_limits<qi::int64_t>::max()) + 1
+          : static_cast<qi::uint64_t>(std::numeric_limits<qi::int64_t>::max());
+      if (droppedDigits || mantissa > limit)
+        mantissa = limit;
+      result.integer = negative
+          ? static_cast<qi::int64_t>(0 - mantissa)
+          : static_cast<qi::int64_t>(mantissa);
+      return true;
+    }
+
+    if (droppedDigits == 0 && mantissa < maxExactMantissa
+        && exponent >= -maxExactPowerOfTen && exponent <= maxExactPowerOfTen)
+    {
+      // Both operands are exact, so the result is correctly rounded.
+      double real = static_cast<double>(mantissa);
+      if (exponent >= 0)
+        real *= exactPowersOfTen[exponent];
+      else
+        real /= exactPowersOfTen[-exponent];
+      result.real = negative ? -real : real;
+    }
+    else
+      result.real = boost::lexical_cast<double>(std::string(save, _it));
     return true;
   }
 
   bool JsonDecoderPrivate::decodeArray(AnyValue &value)
   {
-    std::string::const_iterator save = _it;
+    const char* const save = _it;
 
     if (_it == _end || *_it != '[')
       return false;
@@ -165,11 +193,11 @@ namespace qi {
       if (!decodeValue(subElement))
         break;
       tmpArray.push_back(subElement);
-      if (*_it != ',')
+      if (_it == _end || *_it != ',')
         break;
       ++_it;
     }
-    if (*_it != ']')
+    if (_it == _end || *_it != ']')
     {
       _it = save;
       return false;
@@ -179,84 +207,76 @@ namespace qi {
     return true;
   }
 
-  bool JsonDecoderPrivate::decodeFloat(AnyValue &value)
-  {
-    double tmpFloat;
-
-    if (!getFloat(tmpFloat))
-      return false;
-    value = AnyValue(tmpFloat);
-    return true;
-  }
-
-  bool JsonDecoderPrivate::decodeInteger(AnyValue &value)
+  bool JsonDecoderPrivate::decodeNumber(AnyValue &value)
   {
-    qi::int64_t tmpInteger;
+    Number number;
 
-    if (!getInteger(tmpInteger))
+    if (!getNumber(number))
       return false;
-    value = AnyValue(tmpInteger);
+    if (number.isFloat)
+      value = AnyValue(number.real);
+    else
+      value = AnyValue(number.integer);
     return true;
   }
 
   bool JsonDecoderPrivate::getCleanString(std::string &result)
   {
-    std::string::const_iterator save = _it;
+    const char* const save = _it;
 
     if (_it == _end || *_it != '"')
       return false;
     std::string tmpString;
 
     ++_it;
-    for (;_it != _end && *_it != '"';)
+    while (true)
     {
-      if (*_it == '\\')
+      // copy the characters up to the next quote or backslash at once
+      const char* const runEnd = detail::json::findStringSpecial(_it, _end);
+      tmpString.append(_it, runEnd);
+      _it = runEnd;
+      if (_it == _end || *_it == '"')
+        break;
+
+      if (_it + 1 == _end)
+      {
+        _it = save;
+        return false;
+      }
+      switch (*(_it + 1))
+      {
+      case '"' : tmpString += '"' ; _it += 2; break;
+      case '\\': tmpString += '\\'; _it += 2; break;
+      case '/' : tmpString += '/' ; _it += 2; break;
+      case 'b' : tmpString += '\b'; _it += 2; break;
+      case 'f' : tmpString += '\f'; _it += 2; break;
+      case 'n' : tmpString += '\n'; _it += 2; break;
+      case 'r' : tmpString += '\r'; _it += 2; break;
+      case 't' : tmpString += '\t'; _it += 2; break;
+#ifdef WITH_BOOST_LOCALE
+      case 'u' :
       {
-        if (_it + 1 == _end)
+        if (std::distance(_it, _end) <= 6)
         {
           _it = save;
           return false;
         }
-        switch (*(_it + 1))
+        std::istringstream ss(std::string(_it+2, _it+6));
+        int val;
+        ss >> std::hex >> val;
+        if (!ss.eof())
         {
-        case '"' : tmpString += '"' ; _it += 2; break;
-        case '\\': tmpString += '\\'; _it += 2; break;
-        case '/' : tmpString += '/' ; _it += 2; break;
-        case 'b' : tmpString += '\b'; _it += 2; break;
-        case 'f' : tmpString += '\f'; _it += 2; break;
-        case 'n' : tmpString += '\n'; _it += 2; break;
-        case 'r' : tmpString += '\r'; _it += 2; break;
-        case 't' : tmpString += '\t'; _it += 2; break;
-#ifdef WITH_BOOST_LOCALE
-        case 'u' :
-        {
-          if (std::distance(_it, _end) <= 6)
-          {
-            _it = save;
-            return false;
-          }
-          std::istringstream ss(std::string(_it+2, _it+6));
-          int val;
-          ss >> std::hex >> val;
-          if (!ss.eof())
-          {
-            _it = save;
-            return false;
-          }
-          tmpString += boost::locale::conv::utf_to_utf<char>(&val, &val + 1);
-          _it += 6;
-          break;
-        }
-#endif
-        default:
           _it = save;
           return false;
         }
+        tmpString += boost::locale::conv::utf_to_utf<char>(&val, &val + 1);
+        _it += 6;
+        break;
       }
-      else
-      {
-        tmpString += *_it;
-        ++_it;
+#endif
+      default:
+        _it = save;
+        return false;
       }
     }
     if (_it == _end)
@@ -265,7 +285,7 @@ namespace qi {
       return false;
     }
     ++_it;
-    result = tmpString;
+    result.swap(tmpString);
     return true;
   }
 
@@ -281,7 +301,7 @@ namespace qi {
 
   bool JsonDecoderPrivate::decodeObject(AnyValue &value)
   {
-    std::string::const_iterator save = _it;
+    const char* const save = _it;
 
     if (_it == _end || *_it != '{')
       return false;
@@ -325,26 +345,14 @@ namespace qi {
     return true;
   }
 
-  bool JsonDecoderPrivate::match(std::string const& expected)
+  bool JsonDecoderPrivate::match(const char* expected)
   {
-    std::string::const_iterator save = _it;
-    std::string::const_iterator begin = expected.begin();
+    const char* it = _it;
 
-    while (_it != _end && begin != expected.end())
-    {
-      if (*_it != *begin)
-      {
-        _it = save;
+    for (; *expected; ++expected, ++it)
+      if (it == _end || *it != *expected)
         return false;
-      }
-      ++_it;
-      ++begin;
-    }
-    if (begin != expected.end())
-    {
-      _it = save;
-      return false;
-    }
+    _it = it;
     return true;
   }
 
@@ -368,8 +376,7 @@ namespace qi {
     skipWhiteSpaces();
     if (decodeSpecial(value)
         || decodeString(value)
-        || decodeFloat(value)
-        || decodeInteger(value)
+        || decodeNumber(value)
         || decodeArray(value)
         || decodeObject(value)
         )
@@ -380,6 +387,208 @@ namespace qi {
     return false;
   }
 
+  bool JsonDecoderPrivate::decodeTypedList(AnyReference &target)
+  {
+    if (_it == _end || *_it != '[')
+      return false;
+    ++_it;
+    TypeInterface* elementType = static_cast<ListTypeInterface*>(target.type())->elementType();
+    skipWhiteSpaces();
+    if (_it != _end && *_it == ']')
+    {
+      ++_it;
+      return true;
+    }
+    while (true)
+    {
+      AnyValue element(elementType);
+      AnyReference elementRef = element.asReference();
+      if (!decodeTypedValue(elementRef))
+        return false;
+      target.append(elementRef);
+      if (_it == _end)
+        return false;
+      if (*_it == ']')
+      {
+        ++_it;
+        return true;
+      }
+      if (*_it != ',')
+        return false;
+      ++_it;
+    }
+  }
+
+  bool JsonDecoderPrivate::decodeTypedMap(AnyReference &target)
+  {
+    if (_it == _end || *_it != '{')
+      return false;
+    ++_it;
+    TypeInterface* elementType = static_cast<MapTypeInterface*>(target.type())->elementType();
+    skipWhiteSpaces();
+    if (_it != _end && *_it == '}')
+    {
+      ++_it;
+      return true;
+    }
+    while (true)
+    {
+      skipWhiteSpaces();
+      std::string key;
+      if (!getCleanString(key))
+        return false;
+      skipWhiteSpaces();
+      if (_it == _end || *_it != ':')
+        return false;
+      ++_it;
+      AnyValue element(elementType);
+      AnyReference elementRef = element.asReference();
+      if (!decodeTypedValue(elementRef))
+        return false;
+      // converted by insert() if the keys are not strings
+      target.insert(AnyReference::from(key), elementRef);
+      if (_it == _end)
+        return false;
+      if (*_it == '}')
+      {
+        ++_it;
+        return true;
+      }
+      if (*_it != ',')
+        return false;
+      ++_it;
+    }
+  }
+
+  bool JsonDecoderPrivate::decodeTypedTuple(AnyReference &target)
+  {
+    if (_it == _end || (*_it != '[' && *_it != '{'))
+      return false;
+    StructTypeInterface* type = static_cast<StructTypeInterface*>(target.type());
+    const std::vector<TypeInterface*> memberTypes = type->memberTypes();
+    std::vector<AnyValue> members;
+    members.reserve(memberTypes.size());
+    for (TypeInterface* memberType : memberTypes)
+      members.emplace_back(memberType);
+
+    if (*_it == '[')
+    { // members in order
+      ++_it;
+      for (std::size_t i = 0; i < members.size(); ++i)
+      {
+        if (i && (_it == _end || *_it++ != ','))
+          return false;
+        AnyReference memberRef = members[i].asReference();
+        if (!decodeTypedValue(memberRef))
+          return false;
+      }
+      skipWhiteSpaces();
+      if (_it == _end || *_it != ']')
+        return false;
+      ++_it;
+    }
+    else
+    { // members by name, the missing ones keep their default value
+      ++_it;
+      const std::vector<std::string> names = type->elementsName();
+      skipWhiteSpaces();
+      bool first = true;
+      while (_it != _end && *_it != '}')
+      {
+        if (!first && *_it++ != ',')
+          return false;
+        first = false;
+        skipWhiteSpaces();
+        std::string key;
+        if (!getCleanString(key))
+          return false;
+        skipWhiteSpaces();
+        if (_it == _end || *_it != ':')
+          return false;
+        ++_it;
+        const auto name = std::find(names.begin(), names.end(), key);
+        if (name == names.end())
+        { // not a member, skipped
+          AnyValue ignored;
+          if (!decodeValue(ignored))
+            return false;
+          continue;
+        }
+        AnyReference memberRef = members[name - names.begin()].asReference();
+        if (!decodeTypedValue(memberRef))
+          return false;
+      }
+      if (_it == _end)
+        return false;
+      ++_it;
+    }
+
+    AnyReferenceVector memberRefs;
+    memberRefs.reserve(members.size());
+    for (const AnyValue& member : members)
+      memberRefs.push_back(member.asReference());
+    target.setTuple(memberRefs);
+    return true;
+  }
+
+  bool JsonDecoderPrivate::decodeTypedValue(AnyReference &target)
+  {
+    skipWhiteSpaces();
+    bool decoded = false;
+    switch (target.kind())
+    {
+    case TypeKind_Int:
+    case TypeKind_Float:
+    {
+      Number number;
+      if ((decoded = match("true")))
+        target.setInt(1);
+      else if ((decoded = match("false")))
+        target.setInt(0);
+      else if ((decoded = getNumber(number)))
+      {
+        if (number.isFloat)
+          target.setDouble(number.real);
+        else
+          target.setInt(number.integer);
+      }
+      break;
+    }
+    case TypeKind_String:
+    {
+      std::string value;
+      if ((decoded = getCleanString(value)))
+        target.setString(value);
+      break;
+    }
+    case TypeKind_List:
+    case TypeKind_VarArgs:
+      decoded = decodeTypedList(target);
+      break;
+    case TypeKind_Map:
+      decoded = decodeTypedMap(target);
+      break;
+    case TypeKind_Tuple:
+      decoded = decodeTypedTuple(target);
+      break;
+    case TypeKind_Dynamic:
+    {
+      AnyValue value;
+      if ((decoded = decodeValue(value)))
+        target.setDynamic(value.asReference());
+      break;
+    }
+    case TypeKind_Void:
+      decoded = match("null");
+      break;
+    default:
+      throw std::runtime_error(std::string("Cannot decode JSON into a value of type ") + target.type()->infoString());
+    }
+    if (decoded)
+      skipWhiteSpaces();
+    return decoded;
+  }
+
   std::string::const_iterator decodeJSON(const std::string::const_iterator &begin,
                                          const std::string::const_iterator &end,
                                          AnyValue &target)
@@ -397,4 +606,10 @@ namespace qi {
     return value;
   }
 
+  void decodeJSON(const std::string &in, AnyReference target)
+  {
+    JsonDecoderPrivate parser(in);
+    parser.decode(target);
+  }
+
 }
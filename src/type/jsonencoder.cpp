@@ -12,6 +12,7 @@
 #include <qi/jsoncodec.hpp>
 #include <qi/anyobject.hpp>
 #include <qi/type/typedispatcher.hpp>
+#include "jsoncodec_p.hpp"
 
 qiLogCategory("qitype.jsonencoder");
 
@@ -95,6 +96,8 @@ namespace qi {
 
   std::string encodeJSON(const qi::AutoAnyReference &value, JsonOption jsonPrintOption) {
     std::stringstream ss;
+    //force C local, for int and float formatting
+    ss.imbue(std::locale::classic());
     serialize(value, ss, jsonPrintOption, 0);
     return ss.str();
   }
@@ -107,8 +110,6 @@ namespace qi {
       , jsonPrintOption(jsonPrintOptiond)
       , indent(indentd)
     {
-      //force C local, for int and float formatting
-      out.imbue(std::locale("C"));
     }
 
     void printIndent()
@@ -188,10 +189,39 @@ namespace qi {
 
     void visitString(const char* data, size_t size)
     {
+      out << "\"";
+      const char* it = data;
+      const char* const end = data + size;
+      while (it != end)
+      {
+        // write the characters that need no escaping at once
+        const char* const runEnd = detail::json::findEncodingSpecial(it, end);
+        out.write(it, runEnd - it);
+        it = runEnd;
+        if (it == end)
+          break;
+        const unsigned char c = *it;
+        // Characters beyond ASCII are decoded along with the rest of the
+        // string by the generic path.
+        if (c >= 0x80)
+          break;
+        std::string escaped;
+        if (!add_esc_char(c, escaped, jsonPrintOption))
+          escaped = non_printable_to_string(c);
+        out << escaped;
+        ++it;
+      }
+      if (it != end)
+        out << escapeString(it, end - it);
+      out << "\"";
+    }
+
+    std::string escapeString(const char* data, size_t size)
+    {
 #ifdef WITH_BOOST_LOCALE
-      out << "\"" << add_esc_chars(boost::locale::conv::to_utf<wchar_t>(std::string(data, size), "UTF-8"), jsonPrintOption) << "\"";
+      return add_esc_chars(boost::locale::conv::to_utf<wchar_t>(std::string(data, size), "UTF-8"), jsonPrintOption);
 #else
-      out << "\"" << add_esc_chars(std::wstring(data, data+size), jsonPrintOption) << "\"";
+      return add_esc_chars(std::wstring(data, data+size), jsonPrintOption);
 #endif
     }
 
@@ -1,9 +1,30 @@
+#include <array>
+#include <atomic>
+#include <memory>
+#include <boost/thread/tss.hpp>
+#include <qi/atomic.hpp>
 #include <qi/type/detail/manageable.hpp>
 #include <qi/type/objecttypebuilder.hpp>
 #include "../type/signal_p.hpp"
 
 namespace qi
 {
+  namespace
+  {
+    /// Index of the statistics shard of the calling thread. Threads are spread
+    /// over the shards in the order in which they first push statistics.
+    unsigned int threadStatsSlot()
+    {
+      static boost::thread_specific_ptr<unsigned int>* slot = nullptr;
+      QI_THREADSAFE_NEW(slot);
+      if (!slot->get())
+      {
+        static std::atomic<unsigned int> nextSlot{0};
+        slot->reset(new unsigned int(nextSlot++));
+      }
+      return *slot->get();
+    }
+  }
 
   class ManageablePrivate
   {
@@ -20,10 +41,74 @@ namespace qi
 
     bool statsEnabled;
     bool traceEnabled;
-    ObjectStatistics stats;
     qi::Atomic<int> traceId;
+
+    /* Statistics are pushed to a shard picked by the calling thread, so that
+     * threads calling the same object do not contend on a lock. Shards are
+     * merged when the statistics are read.
+     */
+    struct StatsShard
+    {
+      boost::mutex mutex;
+      ObjectStatistics stats;
+      // Histograms of `latencies` already used from this shard.
+      std::map<unsigned int, LatencyHistogram*> latencies;
+    };
+    static const unsigned int statsShardCount = 8;
+    std::array<StatsShard, statsShardCount> statsShards;
+
+    /* Wall times are also counted in a histogram per method, shared by all the
+     * shards because it is pushed to without lock.
+     */
+    boost::mutex latenciesMutex;
+    std::map<unsigned int, std::unique_ptr<LatencyHistogram>> latencies;
+
+    ObjectStatistics gatherStats(bool reset);
+    /// Precondition: the mutex of the shard is locked.
+    LatencyHistogram& latencyHistogram(StatsShard& shard, unsigned int slotId);
+    void resetLatencies();
   };
 
+  ObjectStatistics ManageablePrivate::gatherStats(bool reset)
+  {
+    ObjectStatistics result;
+    for (auto& shard : statsShards)
+    {
+      ObjectStatistics stats;
+      {
+        boost::mutex::scoped_lock l(shard.mutex);
+        if (reset)
+          stats.swap(shard.stats);
+        else
+          stats = shard.stats;
+      }
+      for (const auto& method : stats)
+        result[method.first].merge(method.second);
+    }
+    return result;
+  }
+
+  LatencyHistogram& ManageablePrivate::latencyHistogram(StatsShard& shard, unsigned int slotId)
+  {
+    LatencyHistogram*& histogram = shard.latencies[slotId];
+    if (!histogram)
+    {
+      boost::mutex::scoped_lock l(latenciesMutex);
+      std::unique_ptr<LatencyHistogram>& owned = latencies[slotId];
+      if (!owned)
+        owned.reset(new LatencyHistogram);
+      histogram = owned.get();
+    }
+    return *histogram;
+  }
+
+  void ManageablePrivate::resetLatencies()
+  {
+    boost::mutex::scoped_lock l(latenciesMutex);
+    for (auto& method : latencies)
+      method.second->reset();
+  }
+
   ManageablePrivate::ManageablePrivate()
     : dying(false)
     , statsEnabled(false)
@@ -101,21 +186,43 @@ namespace qi
 
   void Manageable::pushStats(int slotId, float wallTime, float userTime, float systemTime)
   {
-    boost::mutex::scoped_lock l(_p->registrationsMutex);
-    MethodStatistics& ms = _p->stats[slotId];
+    auto& shard = _p->statsShards[threadStatsSlot() % ManageablePrivate::statsShardCount];
+    boost::mutex::scoped_lock l(shard.mutex);
+    MethodStatistics& ms = shard.stats[slotId];
     ms.push(wallTime, userTime, systemTime);
+    _p->latencyHistogram(shard, slotId).push(wallTime);
   }
 
   ObjectStatistics Manageable::stats() const
   {
-    boost::mutex::scoped_lock l(_p->registrationsMutex);
-    return _p->stats;
+    return _p->gatherStats(false);
   }
 
   void Manageable::clearStats()
   {
-    boost::mutex::scoped_lock l(_p->registrationsMutex);
-    _p->stats.clear();
+    for (auto& shard : _p->statsShards)
+    {
+      boost::mutex::scoped_lock l(shard.mutex);
+      shard.stats.clear();
+    }
+    _p->resetLatencies();
+  }
+
+  ObjectStatistics Manageable::snapshotStats()
+  {
+    ObjectStatistics stats = _p->gatherStats(true);
+    _p->resetLatencies();
+    return stats;
+  }
+
+  ObjectLatencyStatistics Manageable::latencyStats() const
+  {
+    ObjectLatencyStatistics result;
+    boost::mutex::scoped_lock l(_p->latenciesMutex);
+    for (const auto& method : _p->latencies)
+      if (method.second->count() != 0)
+        result[method.first] = method.second->percentiles();
+    return result;
   }
 
   bool Manageable::isTraceEnabled() const
@@ -155,6 +262,8 @@ namespace qi
     builder.advertiseMethod("isTraceEnabled", &Manageable::isTraceEnabled, MetaCallType_Auto, id++);
     builder.advertiseMethod("enableTrace", &Manageable::enableTrace,       MetaCallType_Auto, id++);
     builder.advertiseSignal("traceObject", &Manageable::traceObject, id++);
+    builder.advertiseMethod("snapshotStats", &Manageable::snapshotStats,   MetaCallType_Auto, id++);
+    builder.advertiseMethod("latencyStats", &Manageable::latencyStats,     MetaCallType_Auto, id++);
     QI_ASSERT(id <= endId);
     const detail::ObjectTypeData& typeData = builder.typeData();
     *manageable::methodMap = typeData.methodMap;
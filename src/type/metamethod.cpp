@@ -63,7 +63,6 @@ namespace qi {
   MetaMethodPrivate::MetaMethodPrivate()
     : uid(0)
     , parameters(0)
-    , next(NULL)
   {}
 
   void MetaMethodPrivate::appendParameter(const MetaMethodParameter& mm) {
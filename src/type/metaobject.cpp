@@ -10,6 +10,7 @@
 #include "metamethod_p.hpp"
 #include <boost/algorithm/string/predicate.hpp>
 #include <qi/iocolor.hpp>
+#include <algorithm>
 #include <qi/detail/print.hpp>
 #include <iomanip>
 
@@ -20,6 +21,7 @@ namespace qi {
 qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaObjectPrivate::MetaObjectPrivate(const MetaObjectPrivate &rhs)
+    : _dispatchTable(nullptr)
   {
     (*this) = rhs;
   }
@@ -44,21 +46,118 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
     }
     _index = rhs._index;
     _description = rhs._description;
-    // cache data uses pointers to map entries and must be refreshed
+    // cache data uses pointers to map entries and must be refreshed. No
+    // lookup can be in flight, as the maps have just been replaced: the
+    // replaced tables can be freed.
+    _dispatchTable = nullptr;
+    _dispatchTables.clear();
     refreshCache();
     return (*this);
   }
 
-  std::vector<qi::MetaMethod> MetaObjectPrivate::findMethod(const std::string &name) const
+  MetaObjectPrivate::DispatchTable::DispatchTable(MetaObject::MethodMap& methods,
+                                                  MetaObject::SignalMap& signals,
+                                                  MetaObject::PropertyMap& properties,
+                                                  const SignatureToIdx& nameToIdx)
   {
-    boost::recursive_mutex::scoped_lock sl(_methodsMutex);
-    std::vector<qi::MetaMethod>         ret;
+    std::vector<unsigned int> uids;
+    uids.reserve(methods.size() + signals.size() + properties.size());
+    for (const auto& method: methods)
+      uids.push_back(method.first);
+    for (const auto& signal: signals)
+      uids.push_back(signal.first);
+    for (const auto& property: properties)
+      uids.push_back(property.first);
+    std::sort(uids.begin(), uids.end());
+    uids.erase(std::unique(uids.begin(), uids.end()), uids.end());
+    if (uids.empty() || uids.back() < maxDenseUid)
+      _members.resize(uids.empty() ? 0 : uids.back() + 1);
+    else
+    {
+      _sparseUids = std::move(uids);
+      _members.resize(_sparseUids.size());
+    }
+    const auto slot = [this](unsigned int uid) -> Members& {
+      return const_cast<Members&>(*members(uid));
+    };
 
-    for (const auto& method: _methods) {
-      const qi::MetaMethod &mm = method.second;
-      if (mm.name() == name)
-        ret.push_back(mm);
+    std::map<std::string, std::vector<MetaMethod*>> overloads;
+    for (auto& method: methods)
+    {
+      slot(method.first).method = &method.second;
+      overloads[method.second.name()].push_back(&method.second);
+    }
+    std::map<std::string, unsigned int> signalNames;
+    for (auto& signal: signals)
+    {
+      slot(signal.first).signal = &signal.second;
+      signalNames.insert(std::make_pair(signal.second.name(), signal.first));
     }
+    for (auto& property: properties)
+      slot(property.first).property = &property.second;
+
+    std::vector<std::pair<std::string, std::vector<MetaMethod*>>> overloadItems;
+    overloadItems.reserve(overloads.size());
+    for (auto& overload: overloads)
+    {
+      // newest overloads first
+      std::reverse(overload.second.begin(), overload.second.end());
+      overloadItems.emplace_back(overload.first, std::move(overload.second));
+    }
+    _overloads = FrozenStringMap<std::vector<MetaMethod*>>(std::move(overloadItems));
+    _signalNameToId = FrozenStringMap<unsigned int>(
+        std::vector<std::pair<std::string, unsigned int>>(signalNames.begin(), signalNames.end()));
+    _nameToIdx = FrozenStringMap<MetaObjectIdType>(
+        std::vector<std::pair<std::string, MetaObjectIdType>>(nameToIdx.begin(), nameToIdx.end()));
+  }
+
+  const MetaObjectPrivate::DispatchTable::Members* MetaObjectPrivate::DispatchTable::members(
+      unsigned int uid) const
+  {
+    if (_sparseUids.empty())
+      return uid < _members.size() ? &_members[uid] : nullptr;
+    const auto it = std::lower_bound(_sparseUids.begin(), _sparseUids.end(), uid);
+    if (it == _sparseUids.end() || *it != uid)
+      return nullptr;
+    return &_members[it - _sparseUids.begin()];
+  }
+
+  int MetaObjectPrivate::DispatchTable::id(const std::string& signature, MetaObjectType type) const
+  {
+    const MetaObjectIdType* found = _nameToIdx.find(signature);
+    if (found && found->type == type)
+      return found->id;
+    return -1;
+  }
+
+  int MetaObjectPrivate::DispatchTable::signalIdFromName(const std::string& name) const
+  {
+    const unsigned int* found = _signalNameToId.find(name);
+    return found ? static_cast<int>(*found) : -1;
+  }
+
+  const std::vector<MetaMethod*>& MetaObjectPrivate::DispatchTable::overloads(const std::string& name) const
+  {
+    static const std::vector<MetaMethod*> none;
+    const std::vector<MetaMethod*>* found = _overloads.find(name);
+    return found ? *found : none;
+  }
+
+  const MetaObjectPrivate::DispatchTable& MetaObjectPrivate::dispatchTable() const
+  {
+    if (const DispatchTable* table = _dispatchTable.load(std::memory_order_acquire))
+      return *table;
+    return const_cast<MetaObjectPrivate*>(this)->refreshCache();
+  }
+
+  std::vector<qi::MetaMethod> MetaObjectPrivate::findMethod(const std::string &name) const
+  {
+    const std::vector<MetaMethod*>& overloads = dispatchTable().overloads(name);
+    std::vector<qi::MetaMethod> ret;
+    ret.reserve(overloads.size());
+    // by increasing uid
+    for (auto it = overloads.rbegin(); it != overloads.rend(); ++it)
+      ret.push_back(**it);
     return ret;
   }
 
@@ -148,119 +247,109 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
    */
   int MetaObjectPrivate::findMethod(const std::string& nameWithOptionalSignature, const GenericFunctionParameters& args, bool* canCache) const
   {
-    // We can keep this outside the lock because we assume MetaMethods can't be
-    // removed
-    MetaMethod* firstOverload = nullptr;
-    {
-      boost::recursive_mutex::scoped_lock sl(_methodsMutex);
-      if (_dirtyCache)
-        const_cast<MetaObjectPrivate*>(this)->refreshCache();
-      if (nameWithOptionalSignature.find(':') != nameWithOptionalSignature.npos)
-      { // full name and signature was given, there can be only one match
-        if (canCache)
-          *canCache = true;
-        int idRev = methodId(nameWithOptionalSignature);
-        if (idRev == -1) {
-          std::string funname = qi::signatureSplit(nameWithOptionalSignature)[1];
-          // check if it's no method found, or if it's arguments mismatch
-          if (methodId(funname) != -1) {
-            return -2;
-          }
-          return -1;
+    // The dispatch table is immutable: no lock is needed to read it.
+    const DispatchTable& table = dispatchTable();
+    if (nameWithOptionalSignature.find(':') != nameWithOptionalSignature.npos)
+    { // full name and signature was given, there can be only one match
+      if (canCache)
+        *canCache = true;
+      int idRev = table.id(nameWithOptionalSignature, MetaObjectType_Method);
+      if (idRev == -1) {
+        std::string funname = qi::signatureSplit(nameWithOptionalSignature)[1];
+        // check if it's no method found, or if it's arguments mismatch
+        if (table.id(funname, MetaObjectType_Method) != -1) {
+          return -2;
         }
-        else
-          return idRev;
-      }
-      // Only name given, try to find an unique match with given argument count
-      OverloadMap::const_iterator overloadIt = _methodNameToOverload.find(nameWithOptionalSignature);
-      if (overloadIt == _methodNameToOverload.end())
-      { // no match for the name, no chance
-        if (canCache)
-          *canCache = true;
         return -1;
       }
-      MetaMethod* firstMatch = nullptr;
-      bool ambiguous = false;
-      size_t nargs = args.size();
-      for (MetaMethod* mm = overloadIt->second; mm; mm=mm->_p->next)
+      else
+        return idRev;
+    }
+    // Only name given, try to find an unique match with given argument count
+    const std::vector<MetaMethod*>& overloads = table.overloads(nameWithOptionalSignature);
+    if (overloads.empty())
+    { // no match for the name, no chance
+      if (canCache)
+        *canCache = true;
+      return -1;
+    }
+    MetaMethod* firstMatch = nullptr;
+    bool ambiguous = false;
+    size_t nargs = args.size();
+    for (MetaMethod* mm: overloads)
+    {
+      QI_ASSERT(mm->name() == nameWithOptionalSignature);
+      const Signature& sig = mm->parametersSignature();
+      if (sig == "m" || sig.children().size() == nargs)
       {
-        QI_ASSERT(mm->name() == nameWithOptionalSignature);
-        const Signature& sig = mm->parametersSignature();
-        if (sig == "m" || sig.children().size() == nargs)
+        if (firstMatch)
+        { // this is the second match, ambiguity that needs args to resolve
+          ambiguous = true;
+          break;
+        }
+        else
         {
-          if (firstMatch)
-          { // this is the second match, ambiguity that needs args to resolve
-            ambiguous = true;
-            break;
-          }
-          else
-          {
-            firstMatch = mm;
-            // go on to check for more matches
-          }
+          firstMatch = mm;
+          // go on to check for more matches
         }
       }
-      if (canCache)
-        *canCache = !ambiguous || !firstMatch;
-      if (!firstMatch) {
-        //TODO....
-        return -2; // no match for a correct overload (bad number of args)
-      }
-      if (!ambiguous) {
+    }
+    if (canCache)
+      *canCache = !ambiguous || !firstMatch;
+    if (!firstMatch) {
+      //TODO....
+      return -2; // no match for a correct overload (bad number of args)
+    }
+    if (!ambiguous) {
 
-        return firstMatch->uid();
-      }
-      firstOverload = overloadIt->second;
+      return firstMatch->uid();
     }
 
     int retval = -2;
     // resolve ambiguity by using arguments
     for (unsigned dyn = 0; dyn < 2; ++dyn)
     {
-      // DO *NOT* hold the lock while resolving signatures dynamically. This
-      // may block (and in case of python need the GIL)
+      // Resolving signatures dynamically may block (and in case of python
+      // need the GIL): no lock must be held here.
       Signature sResolved = args.signature(dyn==1);
-      {
-        boost::recursive_mutex::scoped_lock sl(_methodsMutex);
-        std::string resolvedSig = sResolved.toString();
-        std::string fullSig = nameWithOptionalSignature + "::" + resolvedSig;
-        qiLogDebug() << "Finding method for resolved signature " << fullSig;
-        // First try an exact match, which is much faster if we're lucky.
-        int idRev = methodId(nameWithOptionalSignature);
-        if (idRev != -1)
-          return idRev;
-
-        using MethodsPtr = std::vector<std::pair<const MetaMethod*, float>>;
-        MethodsPtr mml;
-
-        // embed findCompatibleMethod
-        for (MetaMethod* mm = firstOverload; mm; mm=mm->_p->next)
-        { // still suboptimal, we are rescanning all overloads regardless of arg count
-          float score = sResolved.isConvertibleTo(mm->parametersSignature());
-          if (score)
-            mml.push_back(std::make_pair(mm, score));
-        }
+      std::string resolvedSig = sResolved.toString();
+      std::string fullSig = nameWithOptionalSignature + "::" + resolvedSig;
+      qiLogDebug() << "Finding method for resolved signature " << fullSig;
+      // First try an exact match, which is much faster if we're lucky.
+      int idRev = table.id(nameWithOptionalSignature, MetaObjectType_Method);
+      if (idRev != -1)
+        return idRev;
+
+      using MethodsPtr = std::vector<std::pair<const MetaMethod*, float>>;
+      MethodsPtr mml;
+
+      // embed findCompatibleMethod
+      for (MetaMethod* mm: overloads)
+      { // still suboptimal, we are rescanning all overloads regardless of arg count
+        float score = sResolved.isConvertibleTo(mm->parametersSignature());
+        if (score)
+          mml.push_back(std::make_pair(mm, score));
+      }
 
-        if (mml.empty())
-          continue;
-        if (mml.size() == 1)
-          return mml.front().first->uid();
+      if (mml.empty())
+        continue;
+      if (mml.size() == 1)
+        return mml.front().first->uid();
 
-        // get best match
-        MethodsPtr::iterator it = std::max_element(mml.begin(), mml.end(), less_pair_second());
-        int count = 0;
-        for (unsigned i=0; i<mml.size(); ++i)
-        {
-          if (mml[i].second == it->second)
-            ++count;
-        }
-        QI_ASSERT(count);
-        if (count > 1) {
-          qiLogVerbose() << generateErrorString(nameWithOptionalSignature, fullSig, const_cast<MetaObjectPrivate*>(this)->findCompatibleMethod(nameWithOptionalSignature), -3, false);
-          retval = -3;
-        } else
-          return it->first->uid();
+      // get best match
+      MethodsPtr::iterator it = std::max_element(mml.begin(), mml.end(), less_pair_second());
+      int count = 0;
+      for (unsigned i=0; i<mml.size(); ++i)
+      {
+        if (mml[i].second == it->second)
+          ++count;
       }
+      QI_ASSERT(count);
+      if (count > 1) {
+        qiLogVerbose() << generateErrorString(nameWithOptionalSignature, fullSig, const_cast<MetaObjectPrivate*>(this)->findCompatibleMethod(nameWithOptionalSignature), -3, false);
+        retval = -3;
+      } else
+        return it->first->uid();
     }
     return retval;
   }
@@ -301,12 +390,13 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaSignal* MetaObjectPrivate::signal(const std::string &name)
   {
-    boost::recursive_mutex::scoped_lock sl(_eventsMutex);
-    int id = signalId(name);
+    const DispatchTable& table = dispatchTable();
+    int id = table.id(name, MetaObjectType_Signal);
+    if (id == -1)
+      id = table.signalIdFromName(name);
     if (id < 0)
       return  nullptr;
-    else
-      return &_events[id];
+    return table.members(id)->signal;
   }
 
   MemberAddInfo MetaObjectPrivate::addMethod(MetaMethodBuilder& builder, int uid) {
@@ -335,7 +425,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
     builder.setUid(uid);
     _methods[uid] = builder.metaMethod();
     _objectNameToIdx[method.toString()] = MetaObjectIdType(uid, MetaObjectType_Method);
-    _dirtyCache = true;
+    invalidateCache();
     return MemberAddInfo(uid, true);
   }
 
@@ -380,7 +470,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
     {
       _objectNameToIdx[ms.toString()] = MetaObjectIdType(uid, MetaObjectType_Signal);
     }
-    _dirtyCache = true;
+    invalidateCache();
     return MemberAddInfo(uid, true);
   }
 
@@ -418,7 +508,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
     const MetaProperty mp(id, name, signature);
     _properties[id] = mp;
     _objectNameToIdx[mp.toString()] = MetaObjectIdType(id, MetaObjectType_Property);
-    _dirtyCache = true;
+    invalidateCache();
     return MemberAddInfo(id, true);
   }
 
@@ -438,7 +528,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       _methods[newUid] = qi::MetaMethod(newUid, method.second);
       _objectNameToIdx[method.second.toString()] = MetaObjectIdType(newUid, MetaObjectType_Method);
     }
-    _dirtyCache = true;
+    invalidateCache();
     //todo: update uid
     return true;
   }
@@ -458,7 +548,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       _events[newUid] = ms;
       _objectNameToIdx[ms.toString()] = MetaObjectIdType(newUid, MetaObjectType_Signal);
     }
-    _dirtyCache = true;
+    invalidateCache();
     //todo: update uid
     return true;
   }
@@ -478,37 +568,28 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       _properties[newUid] = mp;
       _objectNameToIdx[mp.toString()] = MetaObjectIdType(newUid, MetaObjectType_Property);
     }
-    _dirtyCache = true;
+    invalidateCache();
     //todo: update uid
     return true;
   }
 
 
-  void MetaObjectPrivate::refreshCache()
+  const MetaObjectPrivate::DispatchTable& MetaObjectPrivate::refreshCache()
   {
     // Both change on property(=event) and method will invalidate the cache.
     boost::recursive_mutex::scoped_lock ml(_methodsMutex);
     boost::recursive_mutex::scoped_lock el(_eventsMutex);
+    boost::recursive_mutex::scoped_lock pl(_propertiesMutex);
+    if (const DispatchTable* table = _dispatchTable.load())
+      return *table;
     unsigned int idx = 0;
     {
       _objectNameToIdx.clear();
-      _methodNameToOverload.clear();
       for (MetaObject::MethodMap::iterator i = _methods.begin();
         i != _methods.end(); ++i)
       {
         _objectNameToIdx[i->second.toString()] = MetaObjectIdType(i->second.uid(), MetaObjectType_Method);
         idx = std::max(idx, i->second.uid());
-        OverloadMap::iterator overloadIt = _methodNameToOverload.find(i->second.name());
-        if (overloadIt == _methodNameToOverload.end())
-        {
-          _methodNameToOverload[i->second.name()] = &i->second;
-          i->second._p->next = 0;
-        }
-        else
-        { // push_front
-          i->second._p->next =  overloadIt->second;
-          overloadIt->second = &i->second;
-        }
       }
     }
     {
@@ -521,7 +602,10 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
     }
     // never lower index
     _index = std::max(idx, _index.load());
-    _dirtyCache = false;
+    _dispatchTables.emplace_back(new DispatchTable(_methods, _events, _properties, _objectNameToIdx));
+    const DispatchTable* table = _dispatchTables.back().get();
+    _dispatchTable.store(table, std::memory_order_release);
+    return *table;
   }
 
   void MetaObjectPrivate::setDescription(const std::string &desc) {
@@ -551,61 +635,45 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
   }
 
   MetaMethod *MetaObject::method(unsigned int id) {
-    boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
-    MethodMap::iterator i = _p->_methods.find(id);
-    if (i == _p->_methods.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->method : nullptr;
   }
 
   const MetaMethod *MetaObject::method(unsigned int id) const {
-    boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
-    MethodMap::const_iterator i = _p->_methods.find(id);
-    if (i == _p->_methods.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->method : nullptr;
   }
 
   MetaSignal *MetaObject::signal(unsigned int id) {
-    boost::recursive_mutex::scoped_lock sl(_p->_eventsMutex);
-    SignalMap::iterator i = _p->_events.find(id);
-    if (i == _p->_events.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->signal : nullptr;
   }
 
   const MetaSignal *MetaObject::signal(unsigned int id) const {
-    boost::recursive_mutex::scoped_lock sl(_p->_eventsMutex);
-    SignalMap::const_iterator i = _p->_events.find(id);
-    if (i == _p->_events.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->signal : nullptr;
   }
 
   MetaProperty *MetaObject::property(unsigned int id) {
-    boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    PropertyMap::iterator i = _p->_properties.find(id);
-    if (i == _p->_properties.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->property : nullptr;
   }
 
   const MetaProperty *MetaObject::property(unsigned int id) const {
-    boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    PropertyMap::const_iterator i = _p->_properties.find(id);
-    if (i == _p->_properties.end())
-      return  nullptr;
-    return &i->second;
+    const MetaObjectPrivate::DispatchTable::Members* members = _p->dispatchTable().members(id);
+    return members ? members->property : nullptr;
   }
 
   int MetaObject::methodId(const std::string &nameWithSignature) const
   {
-    return _p->methodId(nameWithSignature);
+    return _p->dispatchTable().id(nameWithSignature, MetaObjectPrivate::MetaObjectType_Method);
   }
 
   int MetaObject::signalId(const std::string &name) const
   {
-    return _p->signalId(name);
+    const MetaObjectPrivate::DispatchTable& table = _p->dispatchTable();
+    const int id = table.id(name, MetaObjectPrivate::MetaObjectType_Signal);
+    return id == -1 ? table.signalIdFromName(name) : id;
   }
 
   MetaObject::MethodMap MetaObject::methodMap() const {
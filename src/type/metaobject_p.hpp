@@ -7,6 +7,12 @@
 #ifndef _SRC_METAOBJECT_P_HPP_
 #define _SRC_METAOBJECT_P_HPP_
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include <qi/atomic.hpp>
 #include <qi/type/metasignal.hpp>
 #include <qi/type/metaobject.hpp>
@@ -16,13 +22,63 @@
 
 namespace qi {
 
+  /// An immutable hash map from strings, with open addressing, that can be
+  /// read concurrently without locking.
+  template <typename V>
+  class FrozenStringMap
+  {
+  public:
+    /// The keys must be unique.
+    explicit FrozenStringMap(std::vector<std::pair<std::string, V>> items = {})
+    {
+      std::size_t capacity = 8;
+      while (capacity < items.size() * 2)
+        capacity *= 2;
+      _slots.resize(capacity);
+      _mask = capacity - 1;
+      for (auto& item : items)
+      {
+        const std::size_t hash = std::hash<std::string>()(item.first);
+        std::size_t i = hash & _mask;
+        while (_slots[i].used)
+          i = (i + 1) & _mask;
+        _slots[i] = Slot{true, hash, std::move(item.first), std::move(item.second)};
+      }
+    }
+
+    /// Returns null if the key is not in the map.
+    const V* find(const std::string& key) const
+    {
+      const std::size_t hash = std::hash<std::string>()(key);
+      for (std::size_t i = hash & _mask; _slots[i].used; i = (i + 1) & _mask)
+      {
+        const Slot& slot = _slots[i];
+        if (slot.hash == hash && slot.key == key)
+          return &slot.value;
+      }
+      return nullptr;
+    }
+
+  private:
+    struct Slot
+    {
+      bool used;
+      std::size_t hash;
+      std::string key;
+      V value;
+    };
+
+    std::vector<Slot> _slots;
+    std::size_t _mask;
+  };
+
   class MetaObjectPrivate {
   public:
     //by default we start at qiObjectSpecialMemberMaxUid,
     //the first qiObjectSpecialMemberMaxUid id are reserved for bound object
     MetaObjectPrivate()
       : _index(qiObjectSpecialMemberMaxUid - 1)
-      , _dirtyCache(false)
+      , _dispatchTable(nullptr)
     {
     }
 
@@ -52,6 +108,53 @@ namespace qi {
       MetaObjectType type{MetaObjectType_None};
     };
 
+    /// A frozen copy of the member indexes, built by refreshCache() and
+    /// dropped by any addition of members. It is read without locking: the
+    /// lookups by uid are array indexes, the ones by name hash lookups.
+    ///
+    /// The members it points to are the ones of the maps, which are never
+    /// erased from except by operator=.
+    class DispatchTable
+    {
+    public:
+      struct Members
+      {
+        MetaMethod* method = nullptr;
+        MetaSignal* signal = nullptr;
+        MetaProperty* property = nullptr;
+      };
+
+      DispatchTable(MetaObject::MethodMap& methods,
+                    MetaObject::SignalMap& signals,
+                    MetaObject::PropertyMap& properties,
+                    const std::map<std::string, MetaObjectIdType>& nameToIdx);
+
+      /// Returns null if no member has this uid.
+      const Members* members(unsigned int uid) const;
+      /// Returns -1 if no member of this type has this full signature.
+      int id(const std::string& signature, MetaObjectType type) const;
+      /// Returns the uid of the first signal with this name, or -1.
+      int signalIdFromName(const std::string& name) const;
+      /// Returns the methods with this name, by decreasing uid.
+      const std::vector<MetaMethod*>& overloads(const std::string& name) const;
+
+    private:
+      // Above this uid, the members are looked up by dichotomy in
+      // _sparseUids instead of being indexed by their uid.
+      static const unsigned int maxDenseUid = 1 << 16;
+
+      // Indexed by uid, or parallel to _sparseUids.
+      std::vector<Members> _members;
+      std::vector<unsigned int> _sparseUids;
+      FrozenStringMap<MetaObjectIdType> _nameToIdx;
+      FrozenStringMap<unsigned int> _signalNameToId;
+      FrozenStringMap<std::vector<MetaMethod*>> _overloads;
+    };
+
+    /// Returns the current dispatch table, refreshing the cache if a member
+    /// was added since the last refresh.
+    const DispatchTable& dispatchTable() const;
+
     using SignatureToIdx = std::map<std::string, MetaObjectIdType>;
     inline int idFromName(const SignatureToIdx& map, const std::string& sig, MetaObjectType type = MetaObjectType_None) const {
       SignatureToIdx::const_iterator it = map.find(sig);
@@ -146,8 +249,9 @@ namespace qi {
     */
     MemberAddInfo addProperty(const std::string& name, const Signature &signature, int id = -1);
 
-    // Recompute data cached in *ToIdx
-    void refreshCache();
+    // Recompute data cached in *ToIdx and the dispatch table, if members were
+    // added since the last refresh
+    const DispatchTable& refreshCache();
 
     void setDescription(const std::string& desc);
 
@@ -167,10 +271,14 @@ namespace qi {
   private:
     mutable boost::recursive_mutex      _methodsMutex;
 
-  public:
-    using OverloadMap = std::map<std::string, MetaMethod*>;
-    OverloadMap                         _methodNameToOverload;
+    // Called when members are added: the cache will be refreshed by the
+    // next lookup.
+    void invalidateCache()
+    {
+      _dispatchTable = nullptr;
+    }
 
+  public:
     //name::sig() -> Index
     SignatureToIdx                      _objectNameToIdx;
     MetaObject::SignalMap               _events;
@@ -183,8 +291,12 @@ namespace qi {
 
     std::string                         _description;
 
-    // true if cache must be refreshed
-    mutable bool                        _dirtyCache;
+    // Null if cache must be refreshed. Lookups only load this pointer: they
+    // take no lock and do not own the table. The current and the replaced
+    // tables are owned by _dispatchTables and freed only by the destructor
+    // and operator=, when no lookup can be in flight.
+    std::atomic<const DispatchTable*>   _dispatchTable;
+    std::vector<std::unique_ptr<DispatchTable>> _dispatchTables;
 
     // Global uid for event subscribers.
     static qi::Atomic<int> uid;
@@ -0,0 +1,184 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <map>
+#include <string>
+#include <utility>
+#include <boost/bind/bind.hpp>
+#include <boost/weak_ptr.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/type/proxyproperty.hpp>
+
+qiLogCategory("qitype.propertymirror");
+
+namespace qi
+{
+  namespace detail
+  {
+    namespace
+    {
+      /// The object is identified by its weak pointer, which, unlike its
+      /// address, is not reused by another object while the key exists.
+      using MirrorKey = std::pair<boost::weak_ptr<GenericObject>, std::string>;
+
+      struct MirrorKeyLess
+      {
+        bool operator()(const MirrorKey& a, const MirrorKey& b) const
+        {
+          if (a.first.owner_before(b.first))
+            return true;
+          if (b.first.owner_before(a.first))
+            return false;
+          return a.second < b.second;
+        }
+      };
+      using Registry = std::map<MirrorKey, boost::weak_ptr<PropertyMirror>, MirrorKeyLess>;
+
+      boost::mutex& registryMutex()
+      {
+        static boost::mutex mutex;
+        return mutex;
+      }
+
+      /// Mirrors alive, so that the proxies of the same property share one.
+      /// Guarded by registryMutex().
+      Registry& registry()
+      {
+        static Registry mirrors;
+        return mirrors;
+      }
+
+      AnyReference onMirroredChange(const boost::weak_ptr<PropertyMirror>& weak,
+                                    const AnyReferenceVector& args)
+      {
+        if (auto mirror = weak.lock())
+          if (!args.empty())
+            mirror->store(AnyValue(args[0], true, true));
+        return AnyReference(typeOf<void>());
+      }
+    }
+
+    boost::shared_ptr<PropertyMirror> PropertyMirror::get(AnyObject object, const std::string& propertyName)
+    {
+      boost::mutex::scoped_lock lock(registryMutex());
+      boost::weak_ptr<PropertyMirror>& entry =
+          registry()[MirrorKey(object.managedObjectPtr(), propertyName)];
+      if (auto mirror = entry.lock())
+        return mirror;
+      boost::shared_ptr<PropertyMirror> mirror(new PropertyMirror(object, propertyName));
+      entry = mirror;
+      mirror->subscribe(mirror);
+      return mirror;
+    }
+
+    PropertyMirror::PropertyMirror(AnyObject object, const std::string& propertyName)
+      : _object(object)
+      , _propertyName(propertyName)
+      , _version(0)
+      , _failed(false)
+    {
+    }
+
+    PropertyMirror::~PropertyMirror()
+    {
+      {
+        boost::mutex::scoped_lock lock(registryMutex());
+        auto it = registry().find(MirrorKey(_object._ptr, _propertyName));
+        // The entry may already be reused by a new mirror.
+        if (it != registry().end() && it->second.expired())
+          registry().erase(it);
+      }
+      AnyWeakObject weakObject = _object;
+      const std::string propertyName = _propertyName;
+      // Do not wait for the subscription, nor for its removal. The object may
+      // be destroyed in the meantime.
+      _link.connect([weakObject, propertyName](const Future<SignalLink>& link) mutable {
+        if (!link.hasValue())
+          return;
+        AnyObject object = weakObject.lock();
+        if (!object)
+          return;
+        Future<void> disconnected = object.disconnect(link.value()).async();
+        disconnected.connect([propertyName](const Future<void>& f) {
+          if (f.hasError())
+            qiLogVerbose() << "failed to unsubscribe from " << propertyName << ": " << f.error();
+        });
+      });
+    }
+
+    void PropertyMirror::subscribe(const boost::shared_ptr<PropertyMirror>& self)
+    {
+      boost::weak_ptr<PropertyMirror> weak = self;
+      AnyObject object = _object.lock();
+      // Not synchronous: a remote subscription is a round trip.
+      _link = object.connect(_propertyName, SignalSubscriber(
+          AnyFunction::fromDynamicFunction(boost::bind(&onMirroredChange, weak, boost::placeholders::_1)),
+          MetaCallType_Direct)).async();
+      const std::string propertyName = _propertyName;
+      _link.connect([weak, propertyName](const Future<SignalLink>& link) {
+        if (!link.hasError())
+          return;
+        qiLogWarning() << "cannot mirror " << propertyName << ": " << link.error();
+        if (auto mirror = weak.lock())
+          mirror->fail();
+      });
+    }
+
+    boost::optional<AnyValue> PropertyMirror::value(Duration maxAge) const
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      if (!_value || SteadyClock::now() - _stored >= maxAge)
+        return {};
+      return _value;
+    }
+
+    std::uint64_t PropertyMirror::version() const
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      return _version;
+    }
+
+    void PropertyMirror::store(const AnyValue& value)
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      storeLocked(value);
+    }
+
+    void PropertyMirror::clear()
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      _value = boost::none;
+      ++_version;
+    }
+
+    void PropertyMirror::fail()
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      _failed = true;
+      _value = boost::none;
+      ++_version;
+    }
+
+    void PropertyMirror::refresh(const AnyValue& value, std::uint64_t version)
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      // A notification came in while the value was read: it is at least as
+      // recent.
+      if (_version != version)
+        return;
+      storeLocked(value);
+    }
+
+    void PropertyMirror::storeLocked(const AnyValue& value)
+    {
+      // Without subscription, a stored value would not be kept up to date.
+      if (_failed)
+        return;
+      _value = value;
+      _stored = SteadyClock::now();
+      ++_version;
+    }
+  }
+}
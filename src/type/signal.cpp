@@ -44,6 +44,7 @@ namespace qi {
       subscriber = it->second;
       // Remove from map (but SignalSubscriber object still good)
       subscriberMap.erase(it);
+      publishSubscribers();
       if (subscriberMap.empty() && onSubscribers)
         onSubscribersToCall = onSubscribers;
       // Ensure no call on subscriber occurs once this function returns
@@ -85,6 +86,25 @@ namespace qi {
     });
   }
 
+  void SignalBasePrivate::publishSubscribers()
+  {
+    std::shared_ptr<const SignalSubscriberList> list;
+    if (!subscriberMap.empty())
+    {
+      auto newList = std::make_shared<SignalSubscriberList>();
+      newList->reserve(subscriberMap.size());
+      for (const auto& i: subscriberMap)
+        newList->push_back(i.second);
+      list = std::move(newList);
+    }
+    std::atomic_store(&subscribers, list);
+  }
+
+  std::shared_ptr<const SignalSubscriberList> SignalBasePrivate::subscriberSnapshot() const
+  {
+    return std::atomic_load(&subscribers);
+  }
+
   SignalSubscriberPrivate::SignalSubscriberPrivate() = default;
   SignalSubscriberPrivate::~SignalSubscriberPrivate() = default;
 
@@ -125,7 +145,6 @@ namespace qi {
   void SignalBase::setCallType(MetaCallType callType)
   {
     QI_ASSERT(_p);
-    boost::recursive_mutex::scoped_lock lock(_p->mutex);
     _p->defaultCallType = callType;
   }
 
@@ -155,7 +174,7 @@ namespace qi {
                      << signature.toString() << " " << _p->signature.toString();
         return MetaCallType_Auto;
       }
-      return _p->defaultCallType;
+      return _p->defaultCallType.load();
     }();
 
     trigger(params, mct);
@@ -165,6 +184,7 @@ namespace qi {
   {
     QI_ASSERT(_p);
     SignalBase::Trigger trigger;
+    if (_p->hasTriggerOverride)
     {
       boost::recursive_mutex::scoped_lock lock(_p->mutex);
       trigger = _p->triggerOverride;
@@ -180,6 +200,7 @@ namespace qi {
     QI_ASSERT(_p);
     boost::recursive_mutex::scoped_lock lock(_p->mutex);
     _p->triggerOverride = t;
+    _p->hasTriggerOverride = !t.empty();
   }
 
   void SignalBase::setOnSubscribers(OnSubscribers onSubscribers)
@@ -193,26 +214,23 @@ namespace qi {
   {
     MetaCallType mct = callType;
     QI_ASSERT(_p);
+    if (mct == qi::MetaCallType_Auto)
+      mct = _p->defaultCallType;
 
-    SignalSubscriberMap copy;
-    {
-      boost::recursive_mutex::scoped_lock lock(_p->mutex);
-      if (mct == qi::MetaCallType_Auto)
-        mct = _p->defaultCallType;
-
-      copy = _p->subscriberMap;
-    }
-    qiLogDebug() << (void*)this << " Invoking signal subscribers: " << copy.size();
-    for (auto& i: copy)
-    {
-      qiLogDebug() << (void*)this << " Invoking signal subscriber";
-      SignalSubscriber s = i.second; // holds the subscription alive
-      s.call(params, mct);
-    }
+    // holds the subscriptions alive
+    const auto snapshot = _p->subscriberSnapshot();
+    if (!snapshot)
+      return;
+    qiLogDebug() << (void*)this << " Invoking signal subscribers: " << snapshot->size();
+    // copied by the first asynchronous subscriber with read-only arguments,
+    // shared with the next ones
+    std::shared_ptr<GenericFunctionParameters> asyncArgs;
+    for (const auto& subscriber: *snapshot)
+      subscriber.call(params, mct, asyncArgs);
     qiLogDebug() << (void*)this << " done invoking signal subscribers";
   }
 
-  void SignalSubscriber::callImpl(const GenericFunctionParameters& args)
+  void SignalSubscriber::callImpl(const GenericFunctionParameters& args) const
   {
     if (!_p->enabled)
       return;
@@ -250,6 +268,13 @@ namespace qi {
   }
 
   void SignalSubscriber::call(const GenericFunctionParameters& args, MetaCallType callType)
+  {
+    std::shared_ptr<GenericFunctionParameters> asyncArgs;
+    call(args, callType, asyncArgs);
+  }
+
+  void SignalSubscriber::call(const GenericFunctionParameters& args, MetaCallType callType,
+                              std::shared_ptr<GenericFunctionParameters>& asyncArgs) const
   {
     // this is held alive by caller
     if (_p->handler)
@@ -277,10 +302,23 @@ namespace qi {
         }
 
         auto subscriberCopy = *this;
-        std::shared_ptr<GenericFunctionParameters> argsCopy{ new auto(args.copy()), [](GenericFunctionParameters* object) {
-          object->destroy(); // see GenericFunctionParameters::copy() for details
-          delete object;
-        } };
+        const auto copyArgs = [&args] {
+          return std::shared_ptr<GenericFunctionParameters>(new auto(args.copy()),
+              [](GenericFunctionParameters* object) {
+                object->destroy(); // see GenericFunctionParameters::copy() for details
+                delete object;
+              });
+        };
+        // A handler which may modify its arguments must not share them.
+        std::shared_ptr<GenericFunctionParameters> argsCopy;
+        if (_p->readOnlyArguments)
+        {
+          if (!asyncArgs)
+            asyncArgs = copyArgs();
+          argsCopy = asyncArgs;
+        }
+        else
+          argsCopy = copyArgs();
 
         executionContext->post([subscriberCopy, argsCopy] () mutable{
           subscriberCopy.callImpl(*argsCopy);
@@ -316,6 +354,12 @@ namespace qi {
     return *this;
   }
 
+  SignalSubscriber SignalSubscriber::setReadOnlyArguments(bool readOnly)
+  {
+    _p->readOnlyArguments = readOnly;
+    return *this;
+  }
+
   SignalLink SignalSubscriber::link() const
   {
     return _p->linkId;
@@ -399,6 +443,7 @@ namespace qi {
     subscriberInMap = src;
     subscriberInMap._p->linkId = res;
     subscriberInMap._p->source = this->_p;
+    _p->publishSubscribers();
     Future<void> callingOnSubscribers{0};
     if (first && _p->onSubscribers)
       callingOnSubscribers = _p->onSubscribers(true);
@@ -426,6 +471,7 @@ namespace qi {
 
     _p->subscriberMap.erase(it->second);
     _p->trackMap.erase(it);
+    _p->publishSubscribers();
   }
 
   bool SignalBase::disconnectAll()
@@ -7,6 +7,9 @@
 #ifndef _SRC_SIGNAL_P_HPP_
 #define _SRC_SIGNAL_P_HPP_
 
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <qi/signal.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/recursive_mutex.hpp>
@@ -15,6 +18,8 @@ namespace qi {
 
   using SignalSubscriberMap = std::map<SignalLink, SignalSubscriber>;
   using TrackMap = std::map<int, SignalLink>;
+  /// Subscribers in the order of their links. Never modified once published.
+  using SignalSubscriberList = std::vector<SignalSubscriber>;
 
   class SignalBasePrivate
   {
@@ -30,15 +35,22 @@ namespace qi {
   private:
     friend class SignalBase;
     Future<bool> disconnectAllStep(bool overallSuccess);
+    /// Publishes the content of subscriberMap to the emitters. mutex must be locked.
+    void publishSubscribers();
+    std::shared_ptr<const SignalSubscriberList> subscriberSnapshot() const;
 
     SignalBase::OnSubscribers      onSubscribers;
     SignalSubscriberMap            subscriberMap;
+    // Copy of subscriberMap read by the emitters without locking mutex,
+    // replaced as a whole on each change. Null if there are no subscribers.
+    std::shared_ptr<const SignalSubscriberList> subscribers;
     TrackMap                       trackMap;
     qi::Atomic<int>                trackId;
     qi::Signature                  signature;
     boost::recursive_mutex         mutex;
-    MetaCallType                   defaultCallType;
+    std::atomic<MetaCallType>      defaultCallType;
     SignalBase::Trigger            triggerOverride;
+    std::atomic<bool>              hasTriggerOverride{false};
   };
 
 }
@@ -2,14 +2,22 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <atomic>
 #include <cstring>
+#include <utility>
 
 #include <qi/assert.hpp>
+#include <qi/atomic.hpp>
 #include <qi/signature.hpp>
 #include <qi/type/typeinterface.hpp>
 #include <qi/jsoncodec.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/unordered_map.hpp>
 #include "signatureconvertor.hpp"
+#include "signature_p.hpp"
 
 qiLogCategory("qitype.signature");
 
@@ -93,7 +101,7 @@ namespace qi {
 
 #define RET_CALC (1.0f * childErr * ((float)(100 - error)) / 100.0f)
 
-  float qi::Signature::isConvertibleTo(const qi::Signature& b) const
+  float qi::Signature::computeConvertibility(const qi::Signature& b) const
   {
     /* The returned float is just a basic heuristic, it does not handle:
      * - comparison between integral types
@@ -254,6 +262,8 @@ namespace qi {
 
     std::string            _signature;
     std::vector<Signature> _children;
+    // Interned signatures are never destroyed: their address identifies them.
+    bool                   _interned = false;
   };
 
   static size_t findNext(const std::string &signature, size_t index) {
@@ -429,29 +439,157 @@ namespace qi {
     _signature.assign(signature, begin, end - begin);
   }
 
+  namespace
+  {
+    using SignaturePrivatePtr = boost::shared_ptr<SignaturePrivate>;
+    using SignatureMap = boost::unordered_map<std::string, SignaturePrivatePtr>;
+
+    // Parsed signatures are interned: building a signature that was already
+    // built returns the same immutable SignaturePrivate without parsing it
+    // again. Lookups go through a cache local to each thread, backed by a
+    // global table.
+    const std::size_t maxInternedSignatures = 8192;
+    // Maximum number of conversion scores memoized by each thread.
+    const std::size_t maxMemoizedScores = 16384;
+
+    std::atomic<bool> signatureCacheEnabled{true};
+
+    struct SignatureTable
+    {
+      boost::mutex mutex;
+      SignatureMap signatures;
+      // Set once the table holds maxInternedSignatures signatures. The table
+      // is never modified afterwards, so it is read without the mutex.
+      std::atomic<bool> full{false};
+    };
+
+    SignatureTable& signatureTable()
+    {
+      static SignatureTable* table = nullptr;
+      QI_THREADSAFE_NEW(table);
+      return *table;
+    }
+
+    SignatureMap& localSignatures()
+    {
+      static boost::thread_specific_ptr<SignatureMap>* signatures = nullptr;
+      QI_THREADSAFE_NEW(signatures);
+      SignatureMap* res = signatures->get();
+      if (!res)
+      {
+        res = new SignatureMap;
+        signatures->reset(res);
+      }
+      return *res;
+    }
+
+    using ScoreKey = std::pair<const SignaturePrivate*, const SignaturePrivate*>;
+    using ScoreMap = boost::unordered_map<ScoreKey, float>;
+
+    ScoreMap& localScores()
+    {
+      static boost::thread_specific_ptr<ScoreMap>* scores = nullptr;
+      QI_THREADSAFE_NEW(scores);
+      ScoreMap* res = scores->get();
+      if (!res)
+      {
+        res = new ScoreMap;
+        scores->reset(res);
+      }
+      return *res;
+    }
+
+    SignaturePrivatePtr parseSignature(const std::string& signature, size_t begin, size_t end)
+    {
+      auto p = boost::make_shared<SignaturePrivate>();
+      p->init(signature, begin, end);
+      return p;
+    }
+
+    SignaturePrivatePtr internSignature(const std::string& signature)
+    {
+      if (!signatureCacheEnabled.load(std::memory_order_relaxed))
+        return parseSignature(signature, 0, signature.size());
+
+      SignatureMap& local = localSignatures();
+      auto it = local.find(signature);
+      if (it != local.end())
+        return it->second;
+
+      SignatureTable& table = signatureTable();
+      if (table.full.load(std::memory_order_acquire))
+      {
+        // Signatures that are not interned are parsed each time, without
+        // taking the mutex.
+        auto git = table.signatures.find(signature);
+        if (git != table.signatures.end())
+          return local[signature] = git->second;
+        return parseSignature(signature, 0, signature.size());
+      }
+      {
+        boost::mutex::scoped_lock lock(table.mutex);
+        auto git = table.signatures.find(signature);
+        if (git != table.signatures.end())
+          return local[signature] = git->second;
+      }
+
+      // Parse without the lock: children are interned too.
+      auto p = parseSignature(signature, 0, signature.size());
+      boost::mutex::scoped_lock lock(table.mutex);
+      if (table.signatures.size() >= maxInternedSignatures)
+        return p;
+      auto inserted = table.signatures.emplace(signature, p);
+      inserted.first->second->_interned = true;
+      if (table.signatures.size() >= maxInternedSignatures)
+        table.full.store(true, std::memory_order_release);
+      return local[signature] = inserted.first->second;
+    }
+  }
+
+  namespace detail
+  {
+    void setSignatureCacheEnabled(bool enabled)
+    {
+      signatureCacheEnabled.store(enabled);
+    }
+  }
+
   Signature::Signature()
     : _p(boost::make_shared<SignaturePrivate>())
   {
   }
 
   Signature::Signature(const char *signature)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature))
   {
-    _p->_signature.assign(signature);
-    _p->init(_p->_signature, 0, _p->_signature.size());
   }
 
 
   Signature::Signature(const std::string &signature)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature))
   {
-    _p->init(signature, 0, signature.size());
   }
 
   Signature::Signature(const std::string &signature, size_t begin, size_t end)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature.substr(begin, end - begin)))
+  {
+  }
+
+  float Signature::isConvertibleTo(const Signature& b) const
   {
-    _p->init(signature, begin, end);
+    // Interned signatures never change, nor does their score.
+    if (!_p->_interned || !b._p->_interned)
+      return computeConvertibility(b);
+
+    ScoreMap& scores = localScores();
+    const ScoreKey key(_p.get(), b._p.get());
+    auto it = scores.find(key);
+    if (it != scores.end())
+      return it->second;
+    const float score = computeConvertibility(b);
+    if (scores.size() < maxMemoizedScores)
+      scores.emplace(key, score);
+    return score;
   }
 
   bool Signature::isValid() const {
@@ -556,6 +694,8 @@ namespace qi {
   //compare signature without taking annotation into account
   bool operator==(const Signature& lhs, const Signature& rhs)
   {
+    if (lhs._p == rhs._p)
+      return true;
     if (lhs.type() != rhs.type())
       return false;
     if (lhs.children().size() != rhs.children().size())
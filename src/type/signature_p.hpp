@@ -0,0 +1,23 @@
+#pragma once
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_TYPE_SIGNATURE_P_HPP_
+#define _SRC_TYPE_SIGNATURE_P_HPP_
+
+#include <qi/api.hpp>
+
+namespace qi
+{
+  namespace detail
+  {
+    /// Signatures built from a string are interned and their conversion
+    /// scores memoized, unless this is disabled. Signatures interned before
+    /// remain so. Used to compare both modes.
+    QI_API void setSignatureCacheEnabled(bool enabled);
+  }
+}
+
+#endif  // _SRC_TYPE_SIGNATURE_P_HPP_
@@ -4,7 +4,10 @@
 */
 
 #include <boost/lexical_cast.hpp>
+#include <atomic>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <qi/type/typeinterface.hpp>
@@ -130,11 +133,43 @@ namespace qi {
     return *res;
   }
 
-  QI_API TypeInterface* getType(const std::type_info& type)
+  static boost::mutex& typeFactoryMutex()
   {
     static boost::mutex* mutex = nullptr;
     QI_THREADSAFE_NEW(mutex);
-    boost::mutex::scoped_lock sl(*mutex);
+    return *mutex;
+  }
+
+  /// Incremented each time the type factory is modified by a registration.
+  /// It invalidates the per-thread caches of getType.
+  /// Constant initialization makes it usable at static initialization.
+  static std::atomic<unsigned int> typeFactoryGeneration{0u};
+
+  /// Per-thread cache of the results of getType, valid as long as no type is
+  /// registered. As types are almost only registered at static initialization,
+  /// lookups in the type factory (and its mutex) are almost always avoided.
+  struct TypeCache
+  {
+    unsigned int generation;
+    boost::unordered_map<const std::type_info*, TypeInterface*> types;
+  };
+
+  static TypeCache& typeCache()
+  {
+    static boost::thread_specific_ptr<TypeCache>* cache = nullptr;
+    QI_THREADSAFE_NEW(cache);
+    TypeCache* res = cache->get();
+    if (!res)
+    {
+      res = new TypeCache{typeFactoryGeneration.load(), {}};
+      cache->reset(res);
+    }
+    return *res;
+  }
+
+  static TypeInterface* getTypeFromFactory(const std::type_info& type)
+  {
+    boost::mutex::scoped_lock sl(typeFactoryMutex());
     static bool fallback = !qi::os::getenv("QI_TYPE_RTTI_FALLBACK").empty();
 
     // We create-if-not-exist on purpose: to detect access that occur before
@@ -148,12 +183,35 @@ namespace qi {
     return result;
   }
 
+  QI_API TypeInterface* getType(const std::type_info& type)
+  {
+    TypeCache& cache = typeCache();
+    // The generation is read before the factory, so that a registration
+    // occurring meanwhile invalidates the cached result.
+    const unsigned int generation = typeFactoryGeneration.load(std::memory_order_acquire);
+    if (cache.generation != generation)
+    {
+      cache.types.clear();
+      cache.generation = generation;
+    }
+    else
+    {
+      auto it = cache.types.find(&type);
+      if (it != cache.types.end())
+        return it->second;
+    }
+    TypeInterface* result = getTypeFromFactory(type);
+    cache.types[&type] = result;
+    return result;
+  }
+
   /// Type factory setter
   QI_API bool registerType(const std::type_info& typeId, TypeInterface* type)
   {
     qiLogCategory("qitype.type"); // method can be called at static init
     qiLogDebug() << "registerType "  << typeId.name() << " "
      << type->kind() <<" " << (void*)type << " " << type->signature().toString();
+    boost::mutex::scoped_lock sl(typeFactoryMutex());
     TypeFactory::iterator i = typeFactory().find(TypeInfo(typeId));
     if (i != typeFactory().end())
     {
@@ -166,6 +224,7 @@ namespace qi {
     }
     typeFactory()[TypeInfo(typeId)] = type;
     fallbackTypeFactory()[typeId.name()] = type;
+    typeFactoryGeneration.fetch_add(1u, std::memory_order_release);
     return true;
   }
 
@@ -1374,6 +1433,14 @@ namespace qi {
     }
   }
 
+  namespace detail
+  {
+    bool isDynamicTupleType(TypeInterface* type)
+    {
+      return dynamic_cast<DefaultTupleType*>(type) != nullptr;
+    }
+  }
+
   void* ListTypeInterface::element(void* storage, int index)
   {
     // Default implementation using iteration
@@ -0,0 +1,137 @@
+/*
+ * Streams a big payload (1GiB by default) from a service to a client of
+ * another session with a BufferStreamReader, and checks that the memory used
+ * by the process stays bounded by the fragments in flight instead of growing
+ * with the payload.
+ *
+ * The throughput is measured for each fragment size, and the peak memory
+ * usage is printed. The program fails if the memory grows by more than
+ * `--max-growth` MiB.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/os.hpp>
+#include <qi/session.hpp>
+#include <qi/messaging/bufferstream.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  /// Produces `total` bytes, every byte of the n-th fragment being n % 256.
+  qi::AnyObject makePatternStream(std::size_t total)
+  {
+    std::size_t produced = 0;
+    unsigned int index = 0;
+    return qi::makeBufferStream([total, produced, index](std::size_t maxSize) mutable {
+      qi::Buffer fragment;
+      const auto size = std::min(maxSize, total - produced);
+      if (size)
+      {
+        std::memset(fragment.reserve(size), static_cast<int>(index++ % 256), size);
+        produced += size;
+      }
+      return fragment;
+    });
+  }
+
+  /// Returns false if a fragment does not have the expected content.
+  bool readStream(qi::AnyObject stream, std::size_t fragmentSize, unsigned int prefetch,
+                  std::size_t& peakKb)
+  {
+    const auto pid = qi::os::getpid();
+    qi::BufferStreamReader reader(stream, fragmentSize, prefetch);
+    unsigned int index = 0;
+    for (qi::Buffer fragment = reader.next(); fragment.size(); fragment = reader.next(), ++index)
+    {
+      const auto data = static_cast<const unsigned char*>(fragment.data());
+      const auto expected = static_cast<unsigned char>(index % 256);
+      if (!std::all_of(data, data + fragment.size(), [=](unsigned char c) { return c == expected; }))
+      {
+        std::cerr << "unexpected content in fragment " << index << std::endl;
+        return false;
+      }
+      if (index % 64 == 0)
+        peakKb = std::max(peakKb, qi::os::memoryUsage(pid));
+    }
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("size", po::value<std::size_t>()->default_value(1024), "Size of the streamed payload, in MiB.")
+    ("prefetch", po::value<unsigned int>()->default_value(4), "Number of fragments in flight.")
+    ("max-growth", po::value<std::size_t>()->default_value(128), "Maximum growth of the memory usage, in MiB.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const std::size_t total = vm["size"].as<std::size_t>() * 1024 * 1024;
+  const auto prefetch = std::max(1u, vm["prefetch"].as<unsigned int>());
+  const std::size_t maxGrowthKb = vm["max-growth"].as<std::size_t>() * 1024;
+  qi::DataPerfSuite out("qimessaging", "perf_bufferstream", qi::DataPerfSuite::OutputData_MsgMBPerSecond, vm["output"].as<std::string>());
+
+  qi::Session sd;
+  sd.listenStandalone("tcp://127.0.0.1:0");
+
+  qi::Session serviceHost;
+  serviceHost.connect(sd.url());
+  serviceHost.listen("tcp://127.0.0.1:0");
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("pattern", &makePatternStream);
+  serviceHost.registerService("streams", ob.object());
+
+  qi::Session client;
+  client.connect(sd.url());
+  qi::AnyObject streams = client.service("streams");
+
+  const auto pid = qi::os::getpid();
+  int result = EXIT_SUCCESS;
+  for (std::size_t fragmentSize : {64 * 1024, 1024 * 1024})
+  {
+    const std::size_t initialKb = qi::os::memoryUsage(pid);
+    std::size_t peakKb = initialKb;
+    qi::DataPerf dp;
+    dp.start("stream_" + std::to_string(fragmentSize), (total + fragmentSize - 1) / fragmentSize, fragmentSize);
+    if (!readStream(streams.call<qi::AnyObject>("pattern", total), fragmentSize, prefetch, peakKb))
+      result = EXIT_FAILURE;
+    dp.stop();
+    out << dp;
+
+    // memoryUsage returns 0 where it is not supported.
+    if (!initialKb)
+      continue;
+    std::cout << "fragments of " << fragmentSize << " bytes: memory usage from " << initialKb
+              << "kB up to " << peakKb << "kB" << std::endl;
+    if (peakKb - initialKb > maxGrowthKb)
+    {
+      std::cerr << "memory grew by more than " << maxGrowthKb << "kB" << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+  out.close();
+
+  client.close();
+  serviceHost.close();
+  sd.close();
+  return result;
+}
@@ -0,0 +1,135 @@
+/*
+ * Measures how the calls of many clients to a single service scale with the
+ * number of clients.
+ *
+ * Each client has its own session, and keeps several calls in flight from its
+ * own thread. The arguments are a vector of maps, so that their decoding by
+ * the service takes a significant part of each call. The number of threads
+ * decoding the calls is the one of the network event loop, which can be set
+ * with QI_EVENTLOOP_THREAD_COUNT.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/future.hpp>
+#include <qi/session.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  using Samples = std::vector<std::map<std::string, double>>;
+
+  int count(const Samples& samples)
+  {
+    return static_cast<int>(samples.size());
+  }
+
+  Samples makeSamples(unsigned int size)
+  {
+    Samples samples(size);
+    for (auto& sample : samples)
+    {
+      sample["x"] = 1.0;
+      sample["y"] = 2.0;
+      sample["z"] = 3.0;
+    }
+    return samples;
+  }
+
+  void benchClients(qi::DataPerfSuite& out, const qi::Url& sdUrl, unsigned int clientCount,
+                    const Samples& samples, unsigned int callCount, unsigned int inFlight)
+  {
+    std::vector<std::unique_ptr<qi::Session>> sessions;
+    std::vector<qi::AnyObject> services;
+    for (unsigned int i = 0; i < clientCount; ++i)
+    {
+      sessions.emplace_back(new qi::Session);
+      sessions.back()->connect(sdUrl);
+      services.push_back(sessions.back()->service("counter"));
+    }
+
+    const unsigned int callsPerClient = std::max(1u, callCount / clientCount);
+    qi::DataPerf dp;
+    dp.start("clients_" + std::to_string(clientCount), callsPerClient * clientCount);
+    std::vector<std::thread> clients;
+    for (auto& service : services)
+      clients.emplace_back([&, service] {
+        std::vector<qi::Future<int>> calls(inFlight);
+        for (unsigned int i = 0; i < callsPerClient; ++i)
+        {
+          auto& call = calls[i % inFlight];
+          if (call.isValid())
+            call.value();
+          call = service.async<int>("count", samples);
+        }
+        for (auto& call : calls)
+          if (call.isValid())
+            call.value();
+      });
+    for (auto& client : clients)
+      client.join();
+    dp.stop();
+    out << dp;
+
+    services.clear();
+    for (auto& session : sessions)
+      session->close();
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(20000), "Number of calls per benchmark, shared by the clients.")
+    ("in-flight", po::value<unsigned int>()->default_value(8), "Number of calls in flight per client.")
+    ("samples", po::value<unsigned int>()->default_value(64), "Number of maps in the arguments of each call.")
+    ("max-clients", po::value<unsigned int>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+     "Maximum number of clients.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto callCount = vm["count"].as<unsigned int>();
+  const auto inFlight = std::max(1u, vm["in-flight"].as<unsigned int>());
+  const auto samples = makeSamples(vm["samples"].as<unsigned int>());
+  const auto maxClients = vm["max-clients"].as<unsigned int>();
+  qi::DataPerfSuite out("qimessaging", "perf_concurrentcalls", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::Session sd;
+  sd.listenStandalone("tcp://127.0.0.1:0");
+
+  qi::Session serviceHost;
+  serviceHost.connect(sd.url());
+  serviceHost.listen("tcp://127.0.0.1:0");
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("count", &count);
+  serviceHost.registerService("counter", ob.object());
+
+  for (unsigned int clientCount = 1; clientCount <= maxClients; clientCount *= 2)
+    benchClients(out, sd.url(), clientCount, samples, callCount, inFlight);
+  out.close();
+
+  serviceHost.close();
+  sd.close();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+ * Measures the cost of relaying calls through a gateway, for payloads from
+ * empty to the size of a camera frame.
+ *
+ * A service echoing a buffer is registered on a service directory, and is
+ * called by a client connected either directly to the service directory or to
+ * a gateway attached to it:
+ * - throughput: several calls are kept in flight, and the number of calls per
+ *   second is measured,
+ * - latency: calls are made one at a time, and the latency added by the
+ *   gateway is the difference between the mean call durations of both clients.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/future.hpp>
+#include <qi/session.hpp>
+#include <qi/messaging/gateway.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  qi::Buffer echo(const qi::Buffer& buffer)
+  {
+    return buffer;
+  }
+
+  qi::Buffer makePayload(std::size_t size)
+  {
+    qi::Buffer buffer;
+    const std::vector<unsigned char> data(size, 'x');
+    if (size)
+      buffer.write(data.data(), data.size());
+    return buffer;
+  }
+
+  void benchThroughput(qi::DataPerfSuite& out, const std::string& name, qi::AnyObject service,
+                       const qi::Buffer& payload, unsigned int callCount, unsigned int inFlight)
+  {
+    std::vector<qi::Future<qi::Buffer>> calls(inFlight);
+    qi::DataPerf dp;
+    dp.start(name, callCount, payload.size());
+    for (unsigned int i = 0; i < callCount; ++i)
+    {
+      auto& call = calls[i % inFlight];
+      if (call.isValid())
+        call.value();
+      call = service.async<qi::Buffer>("echo", payload);
+    }
+    for (auto& call : calls)
+      if (call.isValid())
+        call.value();
+    dp.stop();
+    out << dp;
+  }
+
+  /// Returns the mean duration of a call.
+  qi::Duration benchLatency(qi::AnyObject service, const qi::Buffer& payload, unsigned int callCount)
+  {
+    const auto start = qi::SteadyClock::now();
+    for (unsigned int i = 0; i < callCount; ++i)
+      service.call<qi::Buffer>("echo", payload);
+    return (qi::SteadyClock::now() - start) / callCount;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(5000), "Number of calls per benchmark.")
+    ("in-flight", po::value<unsigned int>()->default_value(16), "Number of calls in flight in the throughput benchmarks.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto inFlight = std::max(1u, vm["in-flight"].as<unsigned int>());
+  qi::DataPerfSuite out("qimessaging", "perf_gateway", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::Session sd;
+  sd.listenStandalone("tcp://127.0.0.1:0");
+  qi::Gateway gateway;
+  gateway.attachToServiceDirectory(sd.url()).value();
+  gateway.listen("tcp://127.0.0.1:0");
+
+  qi::Session serviceHost;
+  serviceHost.connect(sd.url());
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("echo", &echo);
+  serviceHost.registerService("echo", ob.object());
+
+  qi::Session directClient;
+  directClient.connect(sd.url());
+  qi::Session gatewayClient;
+  gatewayClient.connect(gateway.endpoints().at(0));
+  qi::AnyObject direct = directClient.service("echo");
+  qi::AnyObject relayed = gatewayClient.service("echo");
+
+  const std::size_t maxBytesPerBench = 256 * 1024 * 1024;
+  // up to a 640x480 RGB camera frame
+  for (std::size_t payloadSize : {0, 1024, 65536, 921600})
+  {
+    // Keep the amount of data sent reasonable for big payloads.
+    const auto n = std::max(1u, std::min(count, static_cast<unsigned int>(maxBytesPerBench / (payloadSize + 1))));
+    const auto payload = makePayload(payloadSize);
+    const auto suffix = "_" + std::to_string(payloadSize);
+    benchThroughput(out, "direct" + suffix, direct, payload, n, inFlight);
+    benchThroughput(out, "gateway" + suffix, relayed, payload, n, inFlight);
+
+    const auto latencyCount = std::max(1u, n / 10);
+    const auto directLatency = benchLatency(direct, payload, latencyCount);
+    const auto gatewayLatency = benchLatency(relayed, payload, latencyCount);
+    const auto us = [](qi::Duration d) {
+      return boost::chrono::duration_cast<qi::MicroSeconds>(d).count();
+    };
+    std::cout << "latency" << suffix << ": direct " << us(directLatency) << "us, gateway "
+              << us(gatewayLatency) << "us, added " << us(gatewayLatency - directLatency) << "us"
+              << std::endl;
+  }
+  out.close();
+
+  gatewayClient.close();
+  directClient.close();
+  serviceHost.close();
+  gateway.close();
+  sd.close();
+  return EXIT_SUCCESS;
+}
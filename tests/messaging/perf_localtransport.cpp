@@ -0,0 +1,146 @@
+/*
+ * Compares calls between two processes of the same machine over tcp on
+ * localhost and over the local transport (a Unix-domain socket, with the
+ * payloads bigger than QI_LOCAL_SHM_THRESHOLD going through shared memory),
+ * for payloads from empty to the size of a camera frame.
+ *
+ * A service echoing a buffer listens on both transports, and is called by a
+ * client connected through each of them:
+ * - throughput: several calls are kept in flight, and the number of calls per
+ *   second is measured,
+ * - latency: calls are made one at a time, and the mean call duration is
+ *   printed.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/future.hpp>
+#include <qi/session.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  qi::Buffer echo(const qi::Buffer& buffer)
+  {
+    return buffer;
+  }
+
+  qi::Buffer makePayload(std::size_t size)
+  {
+    qi::Buffer buffer;
+    const std::vector<unsigned char> data(size, 'x');
+    if (size)
+      buffer.write(data.data(), data.size());
+    return buffer;
+  }
+
+  void benchThroughput(qi::DataPerfSuite& out, const std::string& name, qi::AnyObject service,
+                       const qi::Buffer& payload, unsigned int callCount, unsigned int inFlight)
+  {
+    std::vector<qi::Future<qi::Buffer>> calls(inFlight);
+    qi::DataPerf dp;
+    dp.start(name, callCount, payload.size());
+    for (unsigned int i = 0; i < callCount; ++i)
+    {
+      auto& call = calls[i % inFlight];
+      if (call.isValid())
+        call.value();
+      call = service.async<qi::Buffer>("echo", payload);
+    }
+    for (auto& call : calls)
+      if (call.isValid())
+        call.value();
+    dp.stop();
+    out << dp;
+  }
+
+  /// Returns the mean duration of a call.
+  qi::Duration benchLatency(qi::AnyObject service, const qi::Buffer& payload, unsigned int callCount)
+  {
+    const auto start = qi::SteadyClock::now();
+    for (unsigned int i = 0; i < callCount; ++i)
+      service.call<qi::Buffer>("echo", payload);
+    return (qi::SteadyClock::now() - start) / callCount;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(5000), "Number of calls per benchmark.")
+    ("in-flight", po::value<unsigned int>()->default_value(16), "Number of calls in flight in the throughput benchmarks.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto inFlight = std::max(1u, vm["in-flight"].as<unsigned int>());
+  qi::DataPerfSuite out("qimessaging", "perf_localtransport", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::Session sd;
+  sd.listenStandalone("tcp://127.0.0.1:0");
+
+  qi::Session serviceHost;
+  serviceHost.connect(sd.url());
+  serviceHost.listen("tcp://127.0.0.1:0");
+  if (serviceHost.listen("unix://localhost:0").hasError())
+  {
+    std::cerr << "The local transport is not available" << std::endl;
+    return EXIT_FAILURE;
+  }
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("echo", &echo);
+  serviceHost.registerService("echo", ob.object());
+
+  qi::Session tcpClient;
+  tcpClient.connect(sd.url());
+  qi::Session localClient;
+  localClient.connect(sd.url());
+  qi::AnyObject overTcp = tcpClient.service("echo", "tcp");
+  qi::AnyObject overLocal = localClient.service("echo", "unix");
+
+  const std::size_t maxBytesPerBench = 256 * 1024 * 1024;
+  // up to a 640x480 RGB camera frame
+  for (std::size_t payloadSize : {0, 1024, 65536, 921600})
+  {
+    // Keep the amount of data sent reasonable for big payloads.
+    const auto n = std::max(1u, std::min(count, static_cast<unsigned int>(maxBytesPerBench / (payloadSize + 1))));
+    const auto payload = makePayload(payloadSize);
+    const auto suffix = "_" + std::to_string(payloadSize);
+    benchThroughput(out, "tcp" + suffix, overTcp, payload, n, inFlight);
+    benchThroughput(out, "local" + suffix, overLocal, payload, n, inFlight);
+
+    const auto latencyCount = std::max(1u, n / 10);
+    const auto tcpLatency = benchLatency(overTcp, payload, latencyCount);
+    const auto localLatency = benchLatency(overLocal, payload, latencyCount);
+    const auto us = [](qi::Duration d) {
+      return boost::chrono::duration_cast<qi::MicroSeconds>(d).count();
+    };
+    std::cout << "latency" << suffix << ": tcp " << us(tcpLatency) << "us, local "
+              << us(localLatency) << "us" << std::endl;
+  }
+  out.close();
+
+  localClient.close();
+  tcpClient.close();
+  serviceHost.close();
+  sd.close();
+  return EXIT_SUCCESS;
+}
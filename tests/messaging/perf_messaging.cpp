@@ -0,0 +1,367 @@
+/*
+ * End-to-end benchmarks of the messaging layer. A service directory, a
+ * service host and several clients run in this process and talk over tcp on
+ * localhost, directly or through a gateway (see --gateway).
+ *
+ * The benchmarks sweep:
+ * - the payload size, from empty to 16MiB (see --max-size),
+ * - the shape of the argument: a list of numbers, a list of structs, a map
+ *   and a buffer,
+ * - the way it is sent: calls, posts, signals emitted by the service and
+ *   property updates,
+ * - the number of clients sending concurrently, or receiving the signals.
+ *
+ * Results are named <mode>_<shape>_<size>_<clients>clients, with a _gateway
+ * suffix for the relayed ones. With --baseline, they are compared to the
+ * output of a previous run, and the exit status tells if any regressed.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/binarycodec.hpp>
+#include <qi/buffer.hpp>
+#include <qi/future.hpp>
+#include <qi/session.hpp>
+#include <qi/messaging/gateway.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+struct Sample
+{
+  int id;
+  float x, y, z;
+  double timestamp;
+  std::string frame;
+};
+QI_TYPE_STRUCT(Sample, id, x, y, z, timestamp, frame)
+
+namespace
+{
+  /// Counts the messages received by the service or the clients.
+  class Counter
+  {
+  public:
+    void reset(std::uint64_t target)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _count = 0;
+      _target = target;
+    }
+
+    void increment()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (++_count == _target)
+        _reached.notify_all();
+    }
+
+    /// Returns false if the target is not reached in time.
+    bool wait(std::chrono::seconds timeout)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      return _reached.wait_for(lock, timeout, [&] { return _count >= _target; });
+    }
+
+  private:
+    std::mutex _mutex;
+    std::condition_variable _reached;
+    std::uint64_t _count = 0;
+    std::uint64_t _target = 0;
+  };
+
+  const std::chrono::seconds receiveTimeout{120};
+
+  /// Size of a value once serialized.
+  template<typename T>
+  std::size_t wireSize(const T& value)
+  {
+    qi::Buffer buffer;
+    qi::encodeBinary(&buffer, value);
+    return buffer.size();
+  }
+
+  std::vector<double> makeNumbers(std::size_t size)
+  {
+    return std::vector<double>(size / sizeof(double), 0.5);
+  }
+
+  std::vector<Sample> makeSamples(std::size_t size)
+  {
+    const Sample sample{42, 1.f, 2.f, 3.f, 12.5, "odom"};
+    return std::vector<Sample>(size / wireSize(sample), sample);
+  }
+
+  std::map<std::string, double> makeMap(std::size_t size)
+  {
+    std::map<std::string, double> map;
+    char key[16];
+    std::snprintf(key, sizeof(key), "key%08u", 0u);
+    const std::size_t count = size / wireSize(std::make_pair(std::string(key), 0.5));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::snprintf(key, sizeof(key), "key%08u", static_cast<unsigned int>(i));
+      map.emplace(key, 0.5);
+    }
+    return map;
+  }
+
+  qi::Buffer makeBuffer(std::size_t size)
+  {
+    qi::Buffer buffer;
+    if (size)
+      std::fill_n(static_cast<char*>(buffer.reserve(size)), size, 'x');
+    return buffer;
+  }
+
+  /// Methods, signal and property taking a value of the shape.
+  template<typename T>
+  void advertiseShape(qi::DynamicObjectBuilder& ob, const std::string& shape, Counter& received)
+  {
+    ob.advertiseMethod("take_" + shape,
+                       boost::function<void (const T&)>([&received](const T&) { received.increment(); }));
+    ob.advertiseSignal<const T&>("signal_" + shape);
+    ob.advertiseProperty<T>("property_" + shape);
+  }
+
+  struct Bench
+  {
+    qi::DataPerfSuite& out;
+    /// The service, as registered by its host.
+    qi::AnyObject service;
+    /// Proxies of the service, one per client session.
+    std::vector<qi::AnyObject> clients;
+    Counter& received;
+    unsigned int count;
+    unsigned int inFlight;
+    std::size_t maxBytesPerBench;
+    std::string suffix;
+  };
+
+  /// Runs `send(client, i)` for the messages of each client in its own thread.
+  template<typename F>
+  void sendFromClients(const Bench& bench, unsigned int clientCount, unsigned int perClient, F send)
+  {
+    std::vector<std::thread> threads;
+    for (unsigned int c = 0; c < clientCount; ++c)
+      threads.emplace_back([&, c] {
+        for (unsigned int i = 0; i < perClient; ++i)
+          send(bench.clients[c], i);
+      });
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  /// Keeps at most `inFlight` futures pending per client.
+  template<typename F>
+  void sendWithWindow(const Bench& bench, unsigned int clientCount, unsigned int perClient, F send)
+  {
+    std::vector<std::thread> threads;
+    for (unsigned int c = 0; c < clientCount; ++c)
+      threads.emplace_back([&, c] {
+        std::vector<qi::Future<void>> pending(bench.inFlight);
+        for (unsigned int i = 0; i < perClient; ++i)
+        {
+          auto& future = pending[i % bench.inFlight];
+          if (future.isValid())
+            future.value();
+          future = send(bench.clients[c]);
+        }
+        for (auto& future : pending)
+          if (future.isValid())
+            future.value();
+      });
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  template<typename T>
+  void benchShape(const Bench& bench, const std::string& shape, std::size_t size, const T& value)
+  {
+    const auto method = "take_" + shape;
+    const auto signal = "signal_" + shape;
+    const auto property = "property_" + shape;
+    for (unsigned int clientCount = 1; clientCount <= bench.clients.size(); clientCount *= 2)
+    {
+      // Keep the amount of data sent reasonable for big payloads.
+      const auto perClient = std::max(1u, std::min(bench.count,
+          static_cast<unsigned int>(bench.maxBytesPerBench / (size + 1) / clientCount)));
+      const auto total = perClient * clientCount;
+      const auto name = [&](const std::string& mode) {
+        return mode + "_" + shape + "_" + std::to_string(size) + "_"
+            + std::to_string(clientCount) + "clients" + bench.suffix;
+      };
+      qi::DataPerf dp;
+
+      dp.start(name("call"), total, size);
+      sendWithWindow(bench, clientCount, perClient, [&](const qi::AnyObject& client) {
+        return client.async<void>(method, value);
+      });
+      dp.stop();
+      bench.out << dp;
+
+      bench.received.reset(total);
+      dp.start(name("post"), total, size);
+      sendFromClients(bench, clientCount, perClient, [&](const qi::AnyObject& client, unsigned int) {
+        client.post(method, value);
+      });
+      const bool posted = bench.received.wait(receiveTimeout);
+      dp.stop();
+      if (posted)
+        bench.out << dp;
+      else
+        std::cerr << name("post") << ": posts lost" << std::endl;
+
+      dp.start(name("property"), total, size);
+      sendWithWindow(bench, clientCount, perClient, [&](const qi::AnyObject& client) {
+        return qi::Future<void>(client.setProperty(property, value));
+      });
+      dp.stop();
+      bench.out << dp;
+
+      // Each client receives all the signals.
+      std::vector<qi::SignalLink> links;
+      for (unsigned int c = 0; c < clientCount; ++c)
+        links.push_back(bench.clients[c].connect(signal, boost::function<void (const T&)>(
+                          [&](const T&) { bench.received.increment(); })).value());
+      bench.received.reset(static_cast<std::uint64_t>(perClient) * clientCount);
+      dp.start(name("signal"), total, size);
+      for (unsigned int i = 0; i < perClient; ++i)
+        bench.service.post(signal, value);
+      const bool emitted = bench.received.wait(receiveTimeout);
+      dp.stop();
+      if (emitted)
+        bench.out << dp;
+      else
+        std::cerr << name("signal") << ": signals lost" << std::endl;
+      for (unsigned int c = 0; c < clientCount; ++c)
+        bench.clients[c].disconnect(links[c]).value();
+    }
+  }
+
+  void benchAll(const Bench& bench, const std::vector<std::size_t>& sizes)
+  {
+    for (std::size_t size : sizes)
+    {
+      benchShape(bench, "numbers", size, makeNumbers(size));
+      benchShape(bench, "structs", size, makeSamples(size));
+      benchShape(bench, "map", size, makeMap(size));
+      benchShape(bench, "buffer", size, makeBuffer(size));
+    }
+  }
+
+  std::vector<qi::SessionPtr> connectClients(const qi::Url& url, unsigned int count)
+  {
+    std::vector<qi::SessionPtr> sessions;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      sessions.push_back(qi::makeSession());
+      sessions.back()->connect(url);
+    }
+    return sessions;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(2000), "Number of messages per client and benchmark.")
+    ("clients", po::value<unsigned int>()->default_value(4), "Maximum number of concurrent clients.")
+    ("in-flight", po::value<unsigned int>()->default_value(16), "Number of calls in flight per client.")
+    ("max-size", po::value<std::size_t>()->default_value(16 * 1024 * 1024), "Maximum payload size in bytes.")
+    ("gateway", po::bool_switch(), "Also benchmark clients connected through a gateway.")
+    ("baseline", po::value<std::string>()->default_value(""), "Output of a previous run to compare the results to.")
+    ("tolerance", po::value<double>()->default_value(0.1), "Relative loss above which a result is a regression.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto maxSize = vm["max-size"].as<std::size_t>();
+  std::vector<std::size_t> sizes;
+  for (std::size_t size : {0, 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024})
+    if (size <= maxSize)
+      sizes.push_back(size);
+  const auto clientCount = std::max(1u, vm["clients"].as<unsigned int>());
+
+  qi::DataPerfSuite out("qimessaging", "perf_messaging", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+  const auto baseline = vm["baseline"].as<std::string>();
+  if (!baseline.empty() && !out.setBaseline(baseline, vm["tolerance"].as<double>()))
+    return EXIT_FAILURE;
+
+  qi::Session sd;
+  sd.listenStandalone("tcp://127.0.0.1:0");
+
+  Counter received;
+  qi::DynamicObjectBuilder ob;
+  advertiseShape<std::vector<double>>(ob, "numbers", received);
+  advertiseShape<std::vector<Sample>>(ob, "structs", received);
+  advertiseShape<std::map<std::string, double>>(ob, "map", received);
+  advertiseShape<qi::Buffer>(ob, "buffer", received);
+  const qi::AnyObject service = ob.object();
+  qi::Session serviceHost;
+  serviceHost.connect(sd.url());
+  serviceHost.registerService("perf", service);
+
+  Bench bench{out, service, {}, received,
+              std::max(1u, vm["count"].as<unsigned int>()),
+              std::max(1u, vm["in-flight"].as<unsigned int>()),
+              256 * 1024 * 1024, ""};
+
+  const auto directClients = connectClients(sd.url(), clientCount);
+  for (const auto& session : directClients)
+    bench.clients.push_back(session->service("perf").value());
+  benchAll(bench, sizes);
+
+  qi::Gateway gateway;
+  std::vector<qi::SessionPtr> gatewayClients;
+  if (vm["gateway"].as<bool>())
+  {
+    gateway.attachToServiceDirectory(sd.url()).value();
+    gateway.listen("tcp://127.0.0.1:0");
+    gatewayClients = connectClients(gateway.endpoints().at(0), clientCount);
+    bench.clients.clear();
+    for (const auto& session : gatewayClients)
+      bench.clients.push_back(session->service("perf").value());
+    bench.suffix = "_gateway";
+    benchAll(bench, sizes);
+  }
+  out.close();
+
+  bench.clients.clear();
+  for (const auto& session : gatewayClients)
+    session->close();
+  for (const auto& session : directClients)
+    session->close();
+  serviceHost.close();
+  gateway.close();
+  sd.close();
+
+  if (out.regressionCount())
+  {
+    std::cerr << out.regressionCount() << " results regressed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+ * Measures the local overhead of `RemoteObject::metaCall`: the check of the
+ * expected return signature against the one of the method, including the
+ * construction of the expected signature from its type, as done by
+ * `AnyObject::call`.
+ *
+ * The remote object has no socket, so the calls stop before serializing the
+ * arguments. Each benchmark runs with the signature cache enabled and
+ * disabled.
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+#include "src/messaging/remoteobject_p.hpp"
+#include "src/type/signature_p.hpp"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  struct Sample
+  {
+    int id;
+    std::string name;
+    std::vector<double> values;
+  };
+
+  int getInt()
+  {
+    return 0;
+  }
+
+  std::map<std::string, std::vector<Sample>> getSamples()
+  {
+    return {};
+  }
+}
+
+QI_TYPE_STRUCT(Sample, id, name, values)
+
+namespace
+{
+  /// Returns the number of calls that returned an error for another reason
+  /// than the missing socket.
+  template<typename R>
+  unsigned int bench(qi::DataPerfSuite& out, const std::string& name, qi::DynamicObject& remote,
+                     unsigned int method, unsigned int callCount)
+  {
+    unsigned int unexpected = 0;
+    const qi::GenericFunctionParameters args;
+    qi::DataPerf dp;
+    dp.start(name, callCount);
+    for (unsigned int i = 0; i < callCount; ++i)
+    {
+      auto future = remote.metaCall(qi::AnyObject(), method, args, qi::MetaCallType_Direct,
+                                    qi::typeOf<R>()->signature());
+      if (future.error() != "Socket is not connected")
+        ++unexpected;
+    }
+    dp.stop();
+    out << dp;
+    return unexpected;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of calls per benchmark.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  qi::DataPerfSuite out("qimessaging", "perf_metacall", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("getInt", &getInt);
+  ob.advertiseMethod("getSamples", &getSamples);
+  const qi::MetaObject metaObject = ob.object().metaObject();
+  const auto intMethod = metaObject.findMethod("getInt").at(0).uid();
+  const auto samplesMethod = metaObject.findMethod("getSamples").at(0).uid();
+  qi::RemoteObject remote(1, 1, metaObject);
+
+  unsigned int unexpected = 0;
+  for (bool cached : {true, false})
+  {
+    qi::detail::setSignatureCacheEnabled(cached);
+    const std::string suffix = cached ? "_cached" : "_uncached";
+    unexpected += bench<int>(out, "metacall_int" + suffix, remote, intMethod, count);
+    unexpected += bench<std::map<std::string, std::vector<Sample>>>(
+          out, "metacall_struct_map" + suffix, remote, samplesMethod, count);
+  }
+  qi::detail::setSignatureCacheEnabled(true);
+  out.close();
+
+  if (unexpected)
+  {
+    std::cerr << unexpected << " calls failed unexpectedly" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
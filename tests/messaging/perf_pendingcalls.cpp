@@ -0,0 +1,128 @@
+/*
+ * Measures the cost of matching a reply to its call with 10k calls in
+ * flight, in the lock-free pending-call table and in the synchronized map it
+ * replaced: each reply takes the oldest call, and a new call is inserted.
+ *
+ * The same is measured with several threads handling replies concurrently.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/thread/synchronized_value.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/future.hpp>
+#include "src/messaging/pendingcalltable.hpp"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  using Call = qi::Promise<int>;
+
+  struct TableCalls
+  {
+    qi::PendingCallTable<Call> table;
+
+    void insert(unsigned int id, const Call& call)
+    {
+      table.insert(id, call);
+    }
+
+    bool take(unsigned int id)
+    {
+      return static_cast<bool>(table.take(id));
+    }
+  };
+
+  struct MapCalls
+  {
+    boost::synchronized_value<std::map<int, Call>> map;
+
+    void insert(unsigned int id, const Call& call)
+    {
+      (*map.synchronize())[id] = call;
+    }
+
+    bool take(unsigned int id)
+    {
+      auto sync = map.synchronize();
+      auto it = sync->find(id);
+      if (it == sync->end())
+        return false;
+      Call call = std::move(it->second);
+      sync->erase(it);
+      return true;
+    }
+  };
+
+  template<typename Calls>
+  void bench(qi::DataPerfSuite& out, const std::string& name, unsigned int inFlight,
+             unsigned int replyCount, unsigned int threadCount)
+  {
+    Calls calls;
+    const Call call;
+    for (unsigned int id = 0; id < inFlight; ++id)
+      calls.insert(id, call);
+
+    qi::DataPerf dp;
+    dp.start(name + "_" + std::to_string(threadCount) + "_threads", replyCount);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; ++t)
+      threads.emplace_back([&, t] {
+        // Ids are consecutive, as they come from a global counter: each thread
+        // handles one id out of threadCount.
+        for (unsigned int id = t; id < replyCount; id += threadCount)
+        {
+          if (!calls.take(id))
+            throw std::runtime_error("missing call");
+          calls.insert(id + inFlight, call);
+        }
+      });
+    for (auto& thread : threads)
+      thread.join();
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(2000000), "Number of replies per benchmark.")
+    ("in-flight", po::value<unsigned int>()->default_value(10000), "Number of calls in flight.")
+    ("max-threads", po::value<unsigned int>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+     "Maximum number of threads handling replies.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto inFlight = std::max(1u, vm["in-flight"].as<unsigned int>());
+  const auto maxThreads = std::min(inFlight, vm["max-threads"].as<unsigned int>());
+  qi::DataPerfSuite out("qimessaging", "perf_pendingcalls", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+  {
+    bench<TableCalls>(out, "table", inFlight, count, threadCount);
+    bench<MapCalls>(out, "map", inFlight, count, threadCount);
+  }
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -260,6 +260,15 @@ namespace mock
       _async_read_next_layer(s, b, h);
     }
 
+    /// The mock does not distinguish partial reads from complete reads:
+    /// the transfer handler of the read operation decides how many bytes
+    /// have been read.
+    template<typename NetSslSocket, typename NetTransferHandler>
+    static void async_read_some(NetSslSocket& s, _mutable_buffer_sequence b, NetTransferHandler h)
+    {
+      async_read(s, b, h);
+    }
+
     using _anyAsyncWriterSocket = std::function<void (ssl_socket_type&, const std::vector<_const_buffer_sequence>&, _anyTransferHandler)>;
     static _anyAsyncWriterSocket _async_write_socket;
 
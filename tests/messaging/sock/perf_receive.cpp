@@ -0,0 +1,138 @@
+/*
+ * Compares the two message receiving modes of a socket:
+ * - one read for the header and one read for the payload of each message,
+ * - reads by large chunks, from which all complete messages are extracted.
+ *
+ * A writer thread sends a burst of messages on a loopback connection and the
+ * receiving side measures the number of messages per second, and the number of
+ * heap allocations per message.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/messaging/sock/networkasio.hpp>
+#include <qi/messaging/sock/receive.hpp>
+#include "src/messaging/message.hpp"
+#include "qi/testutils/allocationcounter.hpp"
+
+namespace po = boost::program_options;
+
+using N = qi::sock::NetworkAsio;
+using namespace qi::sock;
+
+namespace
+{
+  std::vector<unsigned char> wireBytes(unsigned int messageCount, std::size_t payloadSize)
+  {
+    std::vector<unsigned char> bytes;
+    const std::vector<unsigned char> payload(payloadSize, 'x');
+    for (unsigned int i = 0; i < messageCount; ++i)
+    {
+      qi::Message msg{qi::Message::Type_Event, qi::MessageAddress{i, 1, 2, 3}};
+      if (payloadSize) msg.buffer().write(payload.data(), payload.size());
+      msg._p->complete();
+      auto header = static_cast<const unsigned char*>(msg._p->getHeader());
+      bytes.insert(bytes.end(), header, header + sizeof(qi::MessagePrivate::MessageHeader));
+      bytes.insert(bytes.end(), payload.begin(), payload.end());
+    }
+    return bytes;
+  }
+
+  /// Procedure<bool (ErrorCode<N>, const Message*)>
+  struct CountMessages
+  {
+    unsigned int* received;
+    unsigned int expected;
+    bool operator()(ErrorCode<N> erc, const qi::Message*)
+    {
+      if (erc)
+      {
+        std::cerr << "Receive error: " << erc.message() << std::endl;
+        return false;
+      }
+      return ++*received < expected;
+    }
+  };
+
+  /// Receive R: ReceiveMessageContinuous<N> or ReceiveMessageChunked<N>
+  template<typename Receive>
+  void bench(qi::DataPerfSuite& out, const std::string& name, Receive receive,
+    unsigned int messageCount, std::size_t payloadSize)
+  {
+    boost::asio::io_service io;
+    SslContext<N> context{Method<SslContext<N>>::sslv23};
+    boost::asio::ip::tcp::acceptor acceptor{io,
+      boost::asio::ip::tcp::endpoint{boost::asio::ip::address_v4::loopback(), 0}};
+    boost::asio::ip::tcp::socket writer{io};
+    writer.connect(acceptor.local_endpoint());
+    auto socket = boost::make_shared<SslSocket<N>>(io, context);
+    acceptor.accept(socket->next_layer());
+    socket->next_layer().set_option(boost::asio::ip::tcp::no_delay{true});
+
+    const auto bytes = wireBytes(messageCount, payloadSize);
+    const std::size_t maxPayload = 50000000;
+    unsigned int received = 0;
+
+    qi::DataPerf dp;
+    qi::test::AllocationCounter allocations;
+    dp.start(name, messageCount, payloadSize);
+    std::thread writeThread{[&] {
+      boost::asio::write(writer, boost::asio::buffer(bytes));
+    }};
+    receive(socket, SslEnabled{false}, maxPayload, CountMessages{&received, messageCount});
+    io.run();
+    dp.stop();
+    const auto allocationCount = allocations.count();
+    writeThread.join();
+    out << dp;
+    std::cout << name << ": " << static_cast<double>(allocationCount) / messageCount
+              << " allocations/msg" << std::endl;
+    if (received != messageCount)
+      std::cerr << name << ": only " << received << " messages received out of "
+                << messageCount << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(100000), "Number of messages per benchmark.")
+    ("chunk-size", po::value<std::size_t>()->default_value(65536), "Size of the receive chunks.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto chunkSize = vm["chunk-size"].as<std::size_t>();
+  qi::DataPerfSuite out("qimessaging", "perf_receive", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  const std::size_t maxBytesPerBench = 256 * 1024 * 1024;
+  for (std::size_t payloadSize : {0, 32, 256, 4096, 65536})
+  {
+    // Keep the amount of data sent reasonable for big payloads.
+    const auto n = std::min(count, static_cast<unsigned int>(maxBytesPerBench /
+      (payloadSize + sizeof(qi::MessagePrivate::MessageHeader))));
+    const auto suffix = "_" + std::to_string(payloadSize);
+    bench(out, "receive_per_message" + suffix, ReceiveMessageContinuous<N>{}, n, payloadSize);
+    bench(out, "receive_chunked" + suffix, ReceiveMessageChunked<N>{chunkSize}, n, payloadSize);
+  }
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -1,6 +1,7 @@
 #include <thread>
 #include <algorithm>
 #include <numeric>
+#include <limits>
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
 #include <gtest/gtest.h>
@@ -413,6 +414,185 @@ TYPED_TEST(NetReceiveMessageContinuous, SeveralMessagesHandled)
     N::_async_read_next_layer.target<AsyncReadNextLayerHeaderThenData>()->_callCount);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// NetReceiveMessageChunked tests:
+////////////////////////////////////////////////////////////////////////////////
+
+namespace mock
+{
+  /// Returns the bytes of the messages as they are sent on the network.
+  std::vector<unsigned char> wireBytes(const std::vector<qi::Message>& msgs)
+  {
+    std::vector<unsigned char> bytes;
+    for (const auto& msg: msgs)
+    {
+      msg._p->complete();
+      auto header = reinterpret_cast<const unsigned char*>(msg._p->getHeader());
+      bytes.insert(bytes.end(), header, header + sizeof(qi::MessagePrivate::MessageHeader));
+      auto data = static_cast<const unsigned char*>(msg.buffer().data());
+      bytes.insert(bytes.end(), data, data + msg.buffer().size());
+    }
+    return bytes;
+  }
+
+  qi::Message makeMessageWithPayload(qi::uint32_t id, std::size_t payloadSize)
+  {
+    qi::Message msg{qi::Message::Type_Event, qi::MessageAddress{id, 1, 2, 3}};
+    std::vector<unsigned char> payload(payloadSize);
+    std::iota(payload.begin(), payload.end(), static_cast<unsigned char>(id));
+    if (payloadSize) msg.buffer().write(payload.data(), payload.size());
+    return msg;
+  }
+
+  /// A read handler that gives the network bytes, at most `_maxPerRead` at a
+  /// time. Once all bytes have been read, the handler is never called.
+  struct AsyncReadNextLayerFromBytes
+  {
+    std::vector<unsigned char> _bytes;
+    std::size_t _maxPerRead = std::numeric_limits<std::size_t>::max();
+    std::size_t _position = 0;
+    int _callCount = 0;
+    void operator()(Socket::next_layer_type&, N::_mutable_buffer_sequence buf, N::_anyTransferHandler h)
+    {
+      ++_callCount;
+      const std::size_t remaining = _bytes.size() - _position;
+      if (remaining == 0u) return;
+      const std::size_t len = std::min({remaining, _maxPerRead,
+        static_cast<std::size_t>(buf.end - buf.begin)});
+      std::copy(_bytes.begin() + _position, _bytes.begin() + _position + len, buf.begin);
+      _position += len;
+      h(Error{}, len);
+    }
+  };
+
+  /// Receives `expectedCount` messages with a chunked receiver and checks they
+  /// are identical to `msgs`.
+  void receiveChunkedAndCheck(const std::vector<qi::Message>& msgs, std::size_t chunkSize)
+  {
+    using namespace qi;
+    using namespace qi::sock;
+    auto socket = boost::make_shared<Socket>(N::defaultIoService(), SslContext<N>{});
+    const size_t maxPayload = 10000;
+    std::vector<Message> received;
+    Promise<Error> promiseError;
+    ReceiveMessageChunked<N> receive{chunkSize};
+    receive(socket, SslEnabled{false}, maxPayload, [&](Error e, const Message* m) mutable {
+      if (e)
+      {
+        promiseError.setValue(e);
+        return false;
+      }
+      // Deep copy: the received message is reused.
+      Message copy{static_cast<Message::Type>(m->type()), m->address()};
+      copy.buffer().write(m->buffer().data(), m->buffer().size());
+      received.push_back(copy);
+      if (received.size() == msgs.size())
+      {
+        promiseError.setValue(success<Error>());
+        return false;
+      }
+      return true;
+    });
+    ASSERT_EQ(success<Error>(), promiseError.future().value());
+    ASSERT_EQ(msgs.size(), received.size());
+    for (std::size_t i = 0; i < msgs.size(); ++i)
+    {
+      ASSERT_EQ(msgs[i].address(), received[i].address());
+      ASSERT_EQ(msgs[i].buffer().size(), received[i].buffer().size());
+      ASSERT_TRUE(std::equal(
+        static_cast<const char*>(msgs[i].buffer().data()),
+        static_cast<const char*>(msgs[i].buffer().data()) + msgs[i].buffer().size(),
+        static_cast<const char*>(received[i].buffer().data())));
+    }
+  }
+} // namespace mock
+
+TEST(NetReceiveMessageChunked, SeveralMessagesInOneRead)
+{
+  using namespace qi;
+  using namespace mock;
+  const std::vector<Message> msgs{
+    makeMessageWithPayload(1, 10), makeMessageWithPayload(2, 0), makeMessageWithPayload(3, 100)};
+  AsyncReadNextLayerFromBytes read;
+  read._bytes = wireBytes(msgs);
+  auto _ = scopedSetAndRestore(N::_async_read_next_layer, read);
+  receiveChunkedAndCheck(msgs, 4096);
+  ASSERT_EQ(1, N::_async_read_next_layer.target<AsyncReadNextLayerFromBytes>()->_callCount);
+}
+
+TEST(NetReceiveMessageChunked, MessagesSplitAcrossReads)
+{
+  using namespace qi;
+  using namespace mock;
+  std::vector<Message> msgs;
+  for (qi::uint32_t i = 0; i < 20; ++i) msgs.push_back(makeMessageWithPayload(i, 3 * i));
+  AsyncReadNextLayerFromBytes read;
+  read._bytes = wireBytes(msgs);
+  read._maxPerRead = 7;
+  auto _ = scopedSetAndRestore(N::_async_read_next_layer, read);
+  receiveChunkedAndCheck(msgs, 128);
+}
+
+TEST(NetReceiveMessageChunked, MessageBiggerThanChunk)
+{
+  using namespace qi;
+  using namespace mock;
+  const std::vector<Message> msgs{
+    makeMessageWithPayload(1, 5), makeMessageWithPayload(2, 1000), makeMessageWithPayload(3, 5)};
+  AsyncReadNextLayerFromBytes read;
+  read._bytes = wireBytes(msgs);
+  auto _ = scopedSetAndRestore(N::_async_read_next_layer, read);
+  receiveChunkedAndCheck(msgs, 64);
+}
+
+TEST(NetReceiveMessageChunked, FailsBecauseOfBadMessageCookie)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  const std::vector<Message> msgs{makeMessageWithPayload(1, 5), makeMessageWithPayload(2, 5)};
+  AsyncReadNextLayerFromBytes read;
+  read._bytes = wireBytes(msgs);
+  // Corrupt the magic of the second message.
+  ++read._bytes[sizeof(MessagePrivate::MessageHeader) + 5];
+  auto _ = scopedSetAndRestore(N::_async_read_next_layer, read);
+  auto socket = boost::make_shared<Socket>(N::defaultIoService(), SslContext<N>{});
+  const size_t maxPayload = 10000;
+  int receivedCount = 0;
+  Promise<Error> promiseError;
+  ReceiveMessageChunked<N> receive{4096};
+  receive(socket, SslEnabled{false}, maxPayload, [&](Error e, const Message*) mutable {
+    if (e)
+    {
+      promiseError.setValue(e);
+      return false;
+    }
+    ++receivedCount;
+    return true;
+  });
+  ASSERT_EQ(fault<Error>(), promiseError.future().value());
+  ASSERT_EQ(1, receivedCount);
+}
+
+TEST(NetReceiveMessageChunked, FailsBecausePayloadIsTooBig)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  const size_t maxPayload = 100;
+  AsyncReadNextLayerFromBytes read;
+  read._bytes = wireBytes({makeMessageWithPayload(1, maxPayload + 1)});
+  auto _ = scopedSetAndRestore(N::_async_read_next_layer, read);
+  auto socket = boost::make_shared<Socket>(N::defaultIoService(), SslContext<N>{});
+  Promise<Error> promiseError;
+  ReceiveMessageChunked<N> receive{4096};
+  receive(socket, SslEnabled{false}, maxPayload, [&](Error e, const Message*) mutable {
+    promiseError.setValue(e);
+    return false;
+  });
+  ASSERT_EQ(messageSize<Error>(), promiseError.future().value());
+}
+
 TEST(NetReceiveMessage, Asio)
 {
   using namespace qi;
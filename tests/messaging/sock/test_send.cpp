@@ -316,3 +316,464 @@ TEST(NetSendMessageEnqueue, MultipleSendsFromMultipleThreadsAsio)
   // Allow detached thread to finish.
   for (auto& t: sendThreads) t.join();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// NetSendMessageBatch tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(NetSendMessageBatch, SingleWriteForAllMessages)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  std::vector<std::size_t> writeBufferCounts;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>& b, N::_anyTransferHandler h) {
+      writeBufferCounts.push_back(b.size());
+      h(success<Error>(), 0u);
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  std::vector<Message> messages(5);
+  using I = decltype(messages.begin());
+  std::vector<std::pair<I, std::size_t>> batches;
+  auto onSent = [&](Error e, I m, std::size_t count) {
+    EXPECT_EQ(success<Error>(), e);
+    batches.push_back({m, count});
+    return boost::optional<std::pair<I, std::size_t>>{};
+  };
+  sendMessageBatch<N>(socket, messages.begin(), messages.size(), onSent, SslEnabled{false});
+  ASSERT_EQ(1u, writeBufferCounts.size());
+  ASSERT_EQ(messages.size() * bufferCount(messages.front()), writeBufferCounts.front());
+  ASSERT_EQ(1u, batches.size());
+  ASSERT_EQ(messages.begin(), batches.front().first);
+  ASSERT_EQ(messages.size(), batches.front().second);
+}
+
+// Messages enqueued while a write is in progress are sent together with the
+// next write, within the batch limits.
+TEST(NetSendMessageEnqueue, BatchesRespectLimits)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  std::vector<std::size_t> writeBufferCounts;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>& b, N::_anyTransferHandler h) {
+      writeBufferCounts.push_back(b.size());
+      pendingWrite = h;
+    }
+  );
+  auto completePendingWrite = [&] {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  };
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  const auto perMessageBufferCount = bufferCount(Message{});
+  // At most 2 messages per write.
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{1024 * 1024, 2 * perMessageBufferCount}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N> e, I m) {
+    EXPECT_EQ(success<Error>(), e);
+    sentIds.push_back(m->id());
+    return true;
+  };
+  const unsigned messageCount = 6u;
+  for (unsigned i = 0; i != messageCount; ++i)
+  {
+    send(Message{Message::Type_Call, MessageAddress{i, 1, 2, 3}}, SslEnabled{false}, onSent);
+  }
+  // The first message is sent alone, as it was the only one in the queue.
+  ASSERT_EQ(1u, writeBufferCounts.size());
+  ASSERT_EQ(perMessageBufferCount, writeBufferCounts.back());
+  while (pendingWrite)
+  {
+    completePendingWrite();
+  }
+  ASSERT_EQ((std::vector<std::size_t>{perMessageBufferCount,
+                                      2 * perMessageBufferCount,
+                                      2 * perMessageBufferCount,
+                                      perMessageBufferCount}),
+            writeBufferCounts);
+  ASSERT_EQ((std::vector<unsigned>{0u, 1u, 2u, 3u, 4u, 5u}), sentIds);
+  const auto counts = send.batchSizeHistogram().counts();
+  ASSERT_EQ(2u, counts[0]);
+  ASSERT_EQ(2u, counts[1]);
+  ASSERT_EQ(4u, send.batchSizeHistogram().writeCount());
+}
+
+TEST(NetSendBatchHistogram, Buckets)
+{
+  using namespace qi::sock;
+  SendBatchHistogram histogram;
+  for (std::size_t n: {1u, 2u, 3u, 4u, 7u, 8u, 100u, 128u, 100000u})
+  {
+    histogram.record(n);
+  }
+  const auto counts = histogram.counts();
+  ASSERT_EQ(1u, counts[0]); // 1
+  ASSERT_EQ(2u, counts[1]); // 2-3
+  ASSERT_EQ(2u, counts[2]); // 4-7
+  ASSERT_EQ(1u, counts[3]); // 8-15
+  ASSERT_EQ(0u, counts[4]); // 16-31
+  ASSERT_EQ(0u, counts[5]); // 32-63
+  ASSERT_EQ(1u, counts[6]); // 64-127
+  ASSERT_EQ(2u, counts[7]); // 128+
+  ASSERT_EQ(9u, histogram.writeCount());
+  std::ostringstream oss;
+  oss << histogram;
+  ASSERT_EQ("1: 1, 2-3: 2, 4-7: 2, 8-15: 1, 16-31: 0, 32-63: 0, 64-127: 1, 128+: 2", oss.str());
+}
+
+namespace
+{
+  qi::Message makeMessage(qi::Message::Type type, unsigned id, unsigned function = 3)
+  {
+    return qi::Message{type, qi::MessageAddress{id, 1, 2, function}};
+  }
+}
+
+// If a handler throws, the send loop stops, as for unbatched messages, and
+// the next enqueued message restarts it.
+TEST(NetSendMessageEnqueue, BatchedSendLoopStopsIfHandlerThrows)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  std::vector<std::size_t> writeBufferCounts;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>& b, N::_anyTransferHandler h) {
+      writeBufferCounts.push_back(b.size());
+      pendingWrite = h;
+    }
+  );
+  auto completePendingWrite = [&] {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  };
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  const auto perMessageBufferCount = bufferCount(Message{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{1024 * 1024}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N>, I m) {
+    sentIds.push_back(m->id());
+    if (m->id() == 0u)
+      throw std::runtime_error("post-send failure");
+    return true;
+  };
+  for (unsigned i = 0; i != 3u; ++i)
+  {
+    send(makeMessage(Message::Type_Call, i), SslEnabled{false}, onSent);
+  }
+  ASSERT_EQ(1u, writeBufferCounts.size());
+  ASSERT_THROW(completePendingWrite(), std::runtime_error);
+  // The loop has stopped: no write is started for the queued messages.
+  ASSERT_FALSE(pendingWrite);
+  ASSERT_EQ(1u, writeBufferCounts.size());
+
+  // The loop is not stuck: the next message restarts it, in a single batch
+  // with the queued ones.
+  send(makeMessage(Message::Type_Call, 3u), SslEnabled{false}, onSent);
+  ASSERT_TRUE(pendingWrite);
+  ASSERT_EQ(3 * perMessageBufferCount, writeBufferCounts.back());
+  while (pendingWrite)
+  {
+    completePendingWrite();
+  }
+  ASSERT_EQ((std::vector<unsigned>{0u, 1u, 2u, 3u}), sentIds);
+}
+
+// Once the queue is full, one-way messages are rejected until a write
+// completes.
+TEST(NetSendMessageEnqueue, QueueLimitsFailPolicy)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      pendingWrite = h;
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{}, SendQueueLimits{0, 2, SendQueuePolicy::Fail}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N>, I m) {
+    sentIds.push_back(m->id());
+    return true;
+  };
+  // The first message is being written and does not count.
+  for (unsigned i = 0; i != 3u; ++i)
+  {
+    ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, i), SslEnabled{false}, onSent));
+  }
+  ASSERT_EQ(EnqueueResult{Status::Rejected}, send(makeMessage(Message::Type_Post, 3u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Rejected}, send(makeMessage(Message::Type_Event, 4u), SslEnabled{false}, onSent));
+  // Someone waits for the other messages: they are queued anyway.
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Reply, 5u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Call, 6u), SslEnabled{false}, onSent));
+
+  auto h = pendingWrite;
+  h(success<Error>(), 0u);
+  ASSERT_EQ(EnqueueResult{Status::Rejected}, send(makeMessage(Message::Type_Post, 7u), SslEnabled{false}, onSent));
+  while (pendingWrite)
+  {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  }
+  // The queue has drained.
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 8u), SslEnabled{false}, onSent));
+  while (pendingWrite)
+  {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  }
+  ASSERT_EQ((std::vector<unsigned>{0u, 1u, 2u, 5u, 6u, 8u}), sentIds);
+}
+
+TEST(NetSendMessageEnqueue, QueueLimitsDropOldestEventsPolicy)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      pendingWrite = h;
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{}, SendQueueLimits{0, 2, SendQueuePolicy::DropOldestEvents}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N>, I m) {
+    sentIds.push_back(m->id());
+    return true;
+  };
+  // Being written.
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Event, 0u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Event, 1u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Call, 2u), SslEnabled{false}, onSent));
+  // The event 1 makes room.
+  ASSERT_EQ(EnqueueResult(Status::Queued, 1u), send(makeMessage(Message::Type_Event, 3u), SslEnabled{false}, onSent));
+  // Calls are queued anyway, without making room.
+  ASSERT_EQ(EnqueueResult(Status::Queued, 0u), send(makeMessage(Message::Type_Call, 4u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult(Status::Queued, 0u), send(makeMessage(Message::Type_Call, 5u), SslEnabled{false}, onSent));
+  // Dropping the event 3 does not make enough room: the new event is dropped
+  // too, and both are reported.
+  ASSERT_EQ(EnqueueResult(Status::Dropped, 1u), send(makeMessage(Message::Type_Event, 6u), SslEnabled{false}, onSent));
+  while (pendingWrite)
+  {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  }
+  ASSERT_EQ((std::vector<unsigned>{0u, 2u, 4u, 5u}), sentIds);
+}
+
+TEST(NetSendMessageEnqueue, QueueLimitsConflateEventsPolicy)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      pendingWrite = h;
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{}, SendQueueLimits{0, 1, SendQueuePolicy::ConflateEvents}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N>, I m) {
+    sentIds.push_back(m->id());
+    return true;
+  };
+  // The event being written is never replaced.
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Event, 0u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Event, 1u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult(Status::Queued, 1u), send(makeMessage(Message::Type_Event, 2u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult(Status::Queued, 1u), send(makeMessage(Message::Type_Event, 3u), SslEnabled{false}, onSent));
+  // Another signal is queued anyway.
+  ASSERT_EQ(EnqueueResult(Status::Queued, 0u), send(makeMessage(Message::Type_Event, 4u, 7u), SslEnabled{false}, onSent));
+  // The latest value is sent after the other signal, which was emitted before.
+  ASSERT_EQ(EnqueueResult(Status::Queued, 1u), send(makeMessage(Message::Type_Event, 5u), SslEnabled{false}, onSent));
+  while (pendingWrite)
+  {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    h(success<Error>(), 0u);
+  }
+  ASSERT_EQ((std::vector<unsigned>{0u, 4u, 5u}), sentIds);
+}
+
+// One-way messages wait for room without blocking the sender.
+TEST(NetSendMessageEnqueue, QueueLimitsBlockPolicy)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      pendingWrite = h;
+    }
+  );
+  auto completePendingWrite = [&] {
+    auto h = pendingWrite;
+    pendingWrite = N::_anyTransferHandler{};
+    if (h)
+      h(success<Error>(), 0u);
+    return static_cast<bool>(h);
+  };
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{},
+    SendQueueLimits{0, 1, SendQueuePolicy::Block, std::chrono::milliseconds{50}}};
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned> sentIds;
+  auto onSent = [&](ErrorCode<N>, I m) {
+    sentIds.push_back(m->id());
+    return true;
+  };
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 0u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 1u), SslEnabled{false}, onSent));
+
+  // Nothing is written: the message is rejected after the timeout.
+  auto result = send(makeMessage(Message::Type_Post, 2u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  ASSERT_TRUE(result.deferred);
+  const Future<void> rejected = *result.deferred;
+  ASSERT_EQ(FutureState_FinishedWithError, rejected.wait(MilliSeconds{5000}));
+  // Other messages are queued anyway.
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Reply, 3u), SslEnabled{false}, onSent));
+
+  // Deferred messages are queued in order, as the writes complete.
+  send.setQueueLimits(SendQueueLimits{0, 1, SendQueuePolicy::Block, std::chrono::seconds{60}});
+  result = send(makeMessage(Message::Type_Post, 4u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  const Future<void> first = *result.deferred;
+  result = send(makeMessage(Message::Type_Event, 5u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  const Future<void> second = *result.deferred;
+
+  ASSERT_TRUE(completePendingWrite()); // 0
+  ASSERT_FALSE(first.isFinished());
+  ASSERT_TRUE(completePendingWrite()); // 1
+  ASSERT_TRUE(first.isFinished());
+  ASSERT_FALSE(first.hasError());
+  ASSERT_FALSE(second.isFinished());
+  ASSERT_TRUE(completePendingWrite()); // 3
+  ASSERT_TRUE(second.isFinished());
+  ASSERT_FALSE(second.hasError());
+  while (completePendingWrite())
+  {
+  }
+  ASSERT_EQ((std::vector<unsigned>{0u, 1u, 3u, 4u, 5u}), sentIds);
+}
+
+// With a reader that never drains the queue, nothing is enqueued and no write
+// completes: the deferred messages are still rejected at their deadline.
+TEST(NetSendMessageEnqueue, QueueLimitsBlockPolicyRejectsWithStalledReader)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  unsigned writeCount = 0u;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      ++writeCount;
+      pendingWrite = h;
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{},
+    SendQueueLimits{0, 1, SendQueuePolicy::Block, std::chrono::milliseconds{500}}};
+  using I = std::list<Message>::const_iterator;
+  auto onSent = [&](ErrorCode<N>, I) {
+    return true;
+  };
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 0u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 1u), SslEnabled{false}, onSent));
+  auto result = send(makeMessage(Message::Type_Post, 2u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  const Future<void> late = *result.deferred;
+
+  // A message deferred later with a shorter timeout is rejected first.
+  send.setQueueLimits(SendQueueLimits{0, 1, SendQueuePolicy::Block, std::chrono::milliseconds{50}});
+  result = send(makeMessage(Message::Type_Event, 3u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  const Future<void> early = *result.deferred;
+
+  ASSERT_EQ(FutureState_FinishedWithError, early.wait(MilliSeconds{5000}));
+  ASSERT_FALSE(late.isFinished());
+  ASSERT_EQ(FutureState_FinishedWithError, late.wait(MilliSeconds{5000}));
+  ASSERT_EQ(1u, writeCount);
+}
+
+// The deferred messages are rejected as soon as a write fails.
+TEST(NetSendMessageEnqueue, QueueLimitsBlockPolicyRejectsWhenWriteFails)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using namespace mock;
+  using Status = EnqueueResult::Status;
+  N::_anyTransferHandler pendingWrite;
+  auto _ = scopedSetAndRestore(
+    N::_async_write_next_layer,
+    [&](Socket::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+      pendingWrite = h;
+    }
+  );
+  IoService<N> io;
+  auto socket = boost::make_shared<Socket>(io, SslContext<N>{});
+  SendMessageEnqueue<N> send{socket, SendBatchLimits{},
+    SendQueueLimits{0, 1, SendQueuePolicy::Block, std::chrono::seconds{60}}};
+  using I = std::list<Message>::const_iterator;
+  auto onSent = [&](ErrorCode<N> e, I) {
+    return !e;
+  };
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 0u), SslEnabled{false}, onSent));
+  ASSERT_EQ(EnqueueResult{Status::Queued}, send(makeMessage(Message::Type_Post, 1u), SslEnabled{false}, onSent));
+  auto result = send(makeMessage(Message::Type_Post, 2u), SslEnabled{false}, onSent);
+  ASSERT_EQ(EnqueueResult{Status::Deferred}, result);
+  const Future<void> deferred = *result.deferred;
+
+  auto h = pendingWrite;
+  pendingWrite = N::_anyTransferHandler{};
+  h(Error{Error::unknown}, 0u);
+  ASSERT_TRUE(deferred.hasError());
+  ASSERT_FALSE(pendingWrite);
+}
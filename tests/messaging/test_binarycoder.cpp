@@ -6,11 +6,16 @@
 */
 
 #include <gtest/gtest.h>
+#include <cstring>
+#include <limits>
+#include <list>
 #include <map>
 #include <qi/buffer.hpp>
 #include <qi/binarycodec.hpp>
 #include <qi/session.hpp>
+#include <qi/scoped.hpp>
 #include <limits.h>
+#include "src/type/binarycodec_p.hpp"
 
 TEST(TestBind, serializeInt)
 {
@@ -649,3 +654,196 @@ TEST(testSerializable, Value) {
   qi::encodeBinary(&buf, gv);
   qi::decodeBinary(&bufr, &gv2);
 }
+
+enum class Mode
+{
+  Idle = 0,
+  Running = 1,
+};
+QI_TYPE_ENUM(Mode);
+
+struct Sample
+{
+  bool operator == (const Sample& b) const {
+    return valid == b.valid && c == b.c && s == b.s && i == b.i && ll == b.ll
+        && f == b.f && d == b.d && name == b.name && mode == b.mode && u == b.u;
+  }
+  bool valid;
+  char c;
+  short s;
+  int i;
+  long long ll;
+  float f;
+  double d;
+  std::string name;
+  Mode mode;
+  unsigned int u;
+};
+QI_TYPE_STRUCT(Sample, valid, c, s, i, ll, f, d, name, mode, u)
+
+namespace
+{
+  Sample sample()
+  {
+    Sample s;
+    s.valid = true;
+    s.c = 'q';
+    s.s = -42;
+    s.i = 123456;
+    s.ll = -1234567890123LL;
+    s.f = 1.5f;
+    s.d = -2.25;
+    s.name = "sample";
+    s.mode = Mode::Running;
+    s.u = 42u;
+    return s;
+  }
+
+  template<typename T>
+  qi::Buffer encodeWithPlans(const T& value, bool plansEnabled)
+  {
+    qi::detail::setStructCodecPlansEnabled(plansEnabled);
+    auto restore = qi::scoped([] { qi::detail::setStructCodecPlansEnabled(true); });
+    qi::Buffer buf;
+    qi::encodeBinary(&buf, value);
+    return buf;
+  }
+
+  std::string bytes(const qi::Buffer& buf)
+  {
+    return std::string(static_cast<const char*>(buf.data()), buf.size());
+  }
+}
+
+TEST(TestBind, SerializeFlatStructSameDataAsVisitor)
+{
+  const Sample s = sample();
+  EXPECT_EQ(bytes(encodeWithPlans(s, false)), bytes(encodeWithPlans(s, true)));
+
+  std::vector<Sample> list{s, s, s};
+  list[1].name.clear();
+  EXPECT_EQ(bytes(encodeWithPlans(list, false)), bytes(encodeWithPlans(list, true)));
+}
+
+TEST(TestBind, SerializeFlatStruct)
+{
+  const Sample s = sample();
+  for (bool plansEnabled: {false, true})
+  {
+    qi::Buffer buf = encodeWithPlans(s, plansEnabled);
+    qi::BufferReader bufr(buf);
+    Sample sout{};
+    qi::decodeBinary(&bufr, &sout);
+    EXPECT_EQ(s, sout);
+    EXPECT_EQ(buf.size(), bufr.position());
+  }
+}
+
+TEST(TestBind, DeserializeFlatStructPastEnd)
+{
+  qi::Buffer buf = encodeWithPlans(sample(), true);
+  qi::Buffer truncated;
+  truncated.write(buf.data(), buf.size() - 3);
+  qi::BufferReader bufr(truncated);
+  Sample sout{};
+  EXPECT_THROW(qi::decodeBinary(&bufr, &sout), std::runtime_error);
+}
+
+TEST(TestBind, DeserializeFlatStructNormalizesBool)
+{
+  // `valid` is the first field: any byte other than 0 means true.
+  std::string data = bytes(encodeWithPlans(sample(), true));
+  data[0] = 2;
+  qi::Buffer buf;
+  buf.write(data.data(), data.size());
+  qi::BufferReader bufr(buf);
+  Sample sout{};
+  qi::decodeBinary(&bufr, &sout);
+  unsigned char stored;
+  std::memcpy(&stored, &sout.valid, sizeof(stored));
+  EXPECT_EQ(1, stored);
+  EXPECT_TRUE(sout.valid);
+}
+
+struct Checked
+{
+  int value;
+  double scale;
+  int sets;
+};
+QI_TYPE_STRUCT_EX(Checked, ++ptr->sets;, value, scale)
+
+TEST(TestBind, DeserializeFlatStructCallsOnSet)
+{
+  Checked c{12, 0.5, 0};
+  qi::Buffer buf = encodeWithPlans(c, true);
+  qi::BufferReader bufr(buf);
+  Checked cout{0, 0., 0};
+  qi::decodeBinary(&bufr, &cout);
+  EXPECT_EQ(12, cout.value);
+  EXPECT_EQ(0.5, cout.scale);
+  EXPECT_EQ(2, cout.sets);
+}
+
+namespace
+{
+  template<typename T>
+  qi::Buffer encodeWithContiguousLists(const T& value, bool enabled)
+  {
+    qi::detail::setContiguousListCodecEnabled(enabled);
+    auto restore = qi::scoped([] { qi::detail::setContiguousListCodecEnabled(true); });
+    qi::Buffer buf;
+    qi::encodeBinary(&buf, value);
+    return buf;
+  }
+
+  template<typename T>
+  void checkNumberList(const std::vector<T>& list)
+  {
+    EXPECT_EQ(bytes(encodeWithContiguousLists(list, false)), bytes(encodeWithContiguousLists(list, true)));
+    for (bool enabled: {false, true})
+    {
+      qi::Buffer buf = encodeWithContiguousLists(list, enabled);
+      qi::BufferReader bufr(buf);
+      std::vector<T> out;
+      qi::decodeBinary(&bufr, &out);
+      EXPECT_EQ(list, out);
+      EXPECT_EQ(buf.size(), bufr.position());
+    }
+  }
+}
+
+TEST(TestBind, SerializeNumberLists)
+{
+  checkNumberList(std::vector<float>{1.5f, -2.f, 3.25f, std::numeric_limits<float>::max()});
+  checkNumberList(std::vector<double>{0.1, -1e300});
+  checkNumberList(std::vector<int>{1, -2, INT_MAX, INT_MIN});
+  checkNumberList(std::vector<unsigned char>{0, 1, 255});
+  checkNumberList(std::vector<short>{-1, 2, 3});
+  checkNumberList(std::vector<long long>{-1234567890123LL, 42});
+  checkNumberList(std::vector<unsigned int>{});
+  std::vector<float> scan(10000);
+  for (std::size_t i = 0; i < scan.size(); ++i)
+    scan[i] = static_cast<float>(i) * 0.01f;
+  checkNumberList(scan);
+}
+
+TEST(TestBind, DeserializeNumberListIntoOtherContainers)
+{
+  const std::vector<int> list{4, 5, 6};
+  qi::Buffer buf = encodeWithContiguousLists(list, true);
+  qi::BufferReader bufr(buf);
+  std::list<int> out;
+  qi::decodeBinary(&bufr, &out);
+  EXPECT_EQ((std::list<int>{4, 5, 6}), out);
+}
+
+TEST(TestBind, DeserializeNumberListPastEnd)
+{
+  qi::Buffer buf = encodeWithContiguousLists(std::vector<double>{1., 2., 3.}, true);
+  qi::Buffer truncated;
+  truncated.write(buf.data(), buf.size() - 3);
+  qi::BufferReader bufr(truncated);
+  std::vector<double> out;
+  EXPECT_THROW(qi::decodeBinary(&bufr, &out), std::runtime_error);
+}
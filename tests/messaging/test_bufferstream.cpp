@@ -0,0 +1,149 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/session.hpp>
+#include <qi/messaging/bufferstream.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+#include <testsession/testsessionpair.hpp>
+
+qiLogCategory("test.bufferstream");
+
+namespace
+{
+  /// Produces `total` bytes, every byte of the n-th fragment being n % 256.
+  qi::AnyObject makePatternStream(std::size_t total)
+  {
+    std::size_t produced = 0;
+    unsigned int index = 0;
+    return qi::makeBufferStream([total, produced, index](std::size_t maxSize) mutable {
+      qi::Buffer fragment;
+      const auto size = std::min(maxSize, total - produced);
+      if (size)
+      {
+        std::memset(fragment.reserve(size), static_cast<int>(index++ % 256), size);
+        produced += size;
+      }
+      return fragment;
+    });
+  }
+
+  qi::AnyObject makeStreamService()
+  {
+    qi::DynamicObjectBuilder ob;
+    ob.advertiseMethod("pattern", &makePatternStream);
+    ob.advertiseMethod("copy", [](const qi::Buffer& buffer) { return qi::makeBufferStream(buffer); });
+    ob.advertiseMethod("failing", []() {
+      unsigned int count = 0;
+      return qi::makeBufferStream([count](std::size_t maxSize) mutable -> qi::Buffer {
+        if (count++ == 2)
+          throw std::runtime_error("no more data");
+        qi::Buffer fragment;
+        std::memset(fragment.reserve(maxSize), 0, maxSize);
+        return fragment;
+      });
+    });
+    return ob.object();
+  }
+
+  qi::Buffer makeBuffer(std::size_t size)
+  {
+    std::vector<unsigned char> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+      data[i] = static_cast<unsigned char>(i * 7);
+    qi::Buffer buffer;
+    buffer.write(data.data(), data.size());
+    return buffer;
+  }
+
+  bool sameContent(const qi::Buffer& a, const qi::Buffer& b)
+  {
+    return a.size() == b.size() && (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+  }
+}
+
+TEST(BufferStream, ReadsLocalBuffer)
+{
+  const qi::Buffer buffer = makeBuffer(10000);
+  qi::BufferStreamReader reader(qi::makeBufferStream(buffer), 3000, 2);
+  std::vector<std::size_t> sizes;
+  qi::Buffer result;
+  for (qi::Buffer fragment = reader.next(); fragment.size(); fragment = reader.next())
+  {
+    sizes.push_back(fragment.size());
+    result.write(fragment.data(), fragment.size());
+  }
+  EXPECT_TRUE(reader.atEnd());
+  EXPECT_EQ((std::vector<std::size_t>{3000, 3000, 3000, 1000}), sizes);
+  EXPECT_TRUE(sameContent(buffer, result));
+  EXPECT_EQ(0u, reader.next().size());
+}
+
+TEST(BufferStream, ReadsEmptyBuffer)
+{
+  qi::BufferStreamReader reader(qi::makeBufferStream(qi::Buffer()));
+  EXPECT_EQ(0u, reader.next().size());
+  EXPECT_TRUE(reader.atEnd());
+}
+
+TEST(BufferStream, ReadsRemoteBuffer)
+{
+  TestSessionPair p;
+  p.server()->registerService("streams", makeStreamService());
+  qi::AnyObject streams = p.client()->service("streams");
+
+  const qi::Buffer buffer = makeBuffer(100000);
+  qi::BufferStreamReader reader(streams.call<qi::AnyObject>("copy", buffer), 4096, 8);
+  qi::Buffer result;
+  for (qi::Buffer fragment = reader.next(); fragment.size(); fragment = reader.next())
+  {
+    ASSERT_LE(fragment.size(), 4096u);
+    result.write(fragment.data(), fragment.size());
+  }
+  EXPECT_TRUE(sameContent(buffer, result));
+}
+
+TEST(BufferStream, ThrowsOnProducerError)
+{
+  TestSessionPair p;
+  p.server()->registerService("streams", makeStreamService());
+  qi::AnyObject streams = p.client()->service("streams");
+
+  qi::BufferStreamReader reader(streams.call<qi::AnyObject>("failing"), 1024, 1);
+  EXPECT_EQ(1024u, reader.next().size());
+  EXPECT_EQ(1024u, reader.next().size());
+  EXPECT_THROW(reader.next(), std::runtime_error);
+}
+
+// The transfer of a payload bigger than the maximum message payload, in
+// bounded memory, is measured by perf_bufferstream.
+TEST(BufferStream, ReadsRemoteProducerInOrder)
+{
+  TestSessionPair p;
+  p.server()->registerService("streams", makeStreamService());
+  qi::AnyObject streams = p.client()->service("streams");
+
+  const std::size_t total = 8 * 1024 * 1024 + 123;
+  const std::size_t fragmentSize = 64 * 1024;
+  qi::BufferStreamReader reader(streams.call<qi::AnyObject>("pattern", total), fragmentSize, 8);
+  std::size_t received = 0;
+  unsigned int index = 0;
+  for (qi::Buffer fragment = reader.next(); fragment.size(); fragment = reader.next(), ++index)
+  {
+    const auto data = static_cast<const unsigned char*>(fragment.data());
+    const auto expected = static_cast<unsigned char>(index % 256);
+    ASSERT_TRUE(std::all_of(data, data + fragment.size(),
+                            [=](unsigned char c) { return c == expected; }))
+        << "fragment " << index;
+    received += fragment.size();
+  }
+  EXPECT_EQ(total, received);
+}
@@ -5,6 +5,7 @@
  *  Copyright (c) 2012 Aldebaran Robotics. All rights reserved.
  */
 
+#include <atomic>
 #include <list>
 
 #include <gtest/gtest.h>
@@ -1145,6 +1146,26 @@ TEST(TestCall, Statistics)
   EXPECT_TRUE(stats.empty());
 }
 
+TEST(TestCall, ClientStatistics)
+{
+  TestSessionPair p;
+  qi::DynamicObjectBuilder gob;
+  int mid = gob.advertiseMethod("sleep", &qi::os::msleep);
+  p.server()->registerService("sleep", gob.object());
+  qi::AnyObject obj = p.client()->service("sleep");
+  // Enabled on the proxy only
+  obj.enableStats(true);
+  obj.call<void>("sleep", 10);
+  obj.call<void>("sleep", 20);
+  EXPECT_LE(0.02f, obj.latencyStats()[mid].p99());
+  qi::ObjectStatistics stats = obj.snapshotStats();
+  qi::MethodStatistics m = stats[mid];
+  EXPECT_EQ(2u, m.count());
+  EXPECT_LE(0.01f, m.wall().minValue());
+  EXPECT_TRUE(obj.stats().empty());
+  EXPECT_TRUE(obj.call<qi::ObjectStatistics>("stats").empty());
+}
+
 class ArgPack
 {
 public:
@@ -1611,6 +1632,125 @@ TEST(TestCall, TestAsyncFutureIsCancelable)
   ASSERT_TRUE(future.isCanceled());
 }
 
+TEST(TestCall, DeadlineCancelsCallOnService)
+{
+  TestSessionPair p;
+
+  // FIXME support cancel in the gateway
+  if (p.mode() == TestMode::Mode_Gateway)
+    return;
+
+  std::atomic<int> serviceCancels{0};
+  qi::Promise<void> pending([&serviceCancels](qi::Promise<void>& promise) {
+    ++serviceCancels;
+    promise.setCanceled();
+  });
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("wait", [=]{ return pending.future(); });
+  ob.setThreadingModel(qi::ObjectThreadingModel_MultiThread);
+  p.server()->registerService("test", ob.object());
+  qi::AnyObject proxy = p.client()->service("test");
+
+  const int method = proxy.findMethod("wait", qi::GenericFunctionParameters());
+  ASSERT_LE(0, method);
+  const auto deadline = qi::SteadyClock::now() + usualTimeout;
+  qi::Future<qi::AnyReference> future = proxy.metaCall(method, qi::GenericFunctionParameters(), deadline);
+  ASSERT_EQ(qi::FutureState_Canceled, future.waitFor(10 * usualTimeout));
+  EXPECT_LE(deadline, qi::SteadyClock::now());
+  // The service gave up on the call too.
+  for (int i = 0; i < 50 && serviceCancels.load() == 0; ++i)
+    qi::os::msleep(20);
+  EXPECT_EQ(1, serviceCancels.load());
+}
+
+TEST(TestCall, DeadlinesBoundQueueOfSlowService)
+{
+  TestSessionPair p;
+
+  // Calls of a single-threaded object run one at a time, the others wait.
+  std::atomic<int> executed{0};
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("work", [&executed]{ qi::os::msleep(20); ++executed; });
+  ob.setThreadingModel(qi::ObjectThreadingModel_SingleThread);
+  p.server()->registerService("slow", ob.object());
+  qi::AnyObject proxy = p.client()->service("slow");
+  const int method = proxy.findMethod("work", qi::GenericFunctionParameters());
+  ASSERT_LE(0, method);
+
+  // Ten times more calls than the service can handle before their deadline.
+  const int callCount = 100;
+  const auto deadline = qi::SteadyClock::now() + qi::MilliSeconds(200);
+  std::vector<qi::Future<qi::AnyReference>> futures;
+  for (int i = 0; i < callCount; ++i)
+    futures.push_back(proxy.metaCall(method, qi::GenericFunctionParameters(), deadline));
+
+  int canceled = 0;
+  for (auto& future : futures)
+  {
+    // Without deadlines, the last call would return after 2 seconds.
+    ASSERT_NE(qi::FutureState_Running, future.waitUntil(deadline + qi::MilliSeconds(500)));
+    if (future.isCanceled())
+      ++canceled;
+  }
+  EXPECT_LT(0, canceled);
+
+  // The expired calls were dropped instead of piling up on the service.
+  qi::os::msleep(200);
+  const int executedAfterDeadline = executed.load();
+  EXPECT_GT(callCount / 2, executedAfterDeadline);
+  qi::os::msleep(200);
+  EXPECT_EQ(executedAfterDeadline, executed.load());
+}
+
+TEST(TestCall, DeadlineIsNotInheritedByNestedCalls)
+{
+  qi::DynamicObjectBuilder otherOb;
+  otherOb.advertiseMethod("f", []{});
+  qi::AnyObject other = otherOb.object();
+
+  qi::GenericObject* target = nullptr;
+  boost::optional<qi::SteadyClockTimePoint> ownDeadline;
+  boost::optional<qi::SteadyClockTimePoint> nestedDeadline;
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("call", [&]{
+    ownDeadline = qi::detail::currentCallDeadline(*target);
+    // What a remote object called from here would forward.
+    nestedDeadline = qi::detail::currentCallDeadline(*other.asGenericObject());
+  });
+  ob.setThreadingModel(qi::ObjectThreadingModel_MultiThread);
+  qi::AnyObject object = ob.object();
+  target = object.asGenericObject();
+
+  const int method = object.findMethod("call", qi::GenericFunctionParameters());
+  ASSERT_LE(0, method);
+  const auto deadline = qi::SteadyClock::now() + usualTimeout;
+  object.metaCall(method, qi::GenericFunctionParameters(), deadline, qi::MetaCallType_Direct).wait();
+  ASSERT_TRUE(ownDeadline);
+  EXPECT_EQ(deadline, *ownDeadline);
+  EXPECT_FALSE(nestedDeadline);
+  EXPECT_FALSE(qi::detail::currentCallDeadline(*target));
+}
+
+TEST(TestCall, CanceledQueuedCallWithoutDeadlineStillRuns)
+{
+  qi::Promise<void> unblock;
+  std::atomic<int> executed{0};
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("block", [=]{ unblock.future().wait(); });
+  ob.advertiseMethod("work", [&executed]{ ++executed; });
+  ob.setThreadingModel(qi::ObjectThreadingModel_SingleThread);
+  qi::AnyObject object = ob.object();
+
+  qi::Future<void> blocking = object.async<void>("block");
+  qi::Future<void> queued = object.async<void>("work");
+  // Only calls whose deadline passed are dropped before they start.
+  queued.cancel();
+  unblock.setValue(nullptr);
+  ASSERT_EQ(qi::FutureState_FinishedWithValue, blocking.waitFor(usualTimeout));
+  ASSERT_NE(qi::FutureState_Running, queued.waitFor(usualTimeout));
+  EXPECT_EQ(1, executed.load());
+}
+
 class SimpleClass
 {
 public:
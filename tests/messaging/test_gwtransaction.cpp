@@ -0,0 +1,65 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "src/messaging/gateway_p.hpp"
+
+namespace
+{
+  std::string bytes(const qi::Buffer& buffer, std::size_t offset, std::size_t size)
+  {
+    std::string result(size, '\0');
+    if (size)
+      buffer.read(&result[0], offset, size);
+    return result;
+  }
+}
+
+TEST(GwTransaction, RelaysToSeveralDestinationsConcurrently)
+{
+  const std::string head(4096, 'h');
+  const std::string tail(8192, 't');
+  const std::string subData(1024, 's');
+
+  qi::Buffer sub;
+  sub.write(subData.data(), subData.size());
+  qi::Message received(qi::Message::Type_Call, qi::MessageAddress(1, 2, 3, 100));
+  received.buffer().write(head.data(), head.size());
+  received.buffer().addSubBuffer(sub);
+  received.buffer().write(tail.data(), tail.size());
+  const std::size_t size = received.buffer().size();
+
+  const qi::GwTransaction transaction(received);
+  std::vector<qi::Message> relayed(2);
+  {
+    std::vector<std::thread> destinations;
+    for (auto& message : relayed)
+      destinations.emplace_back([&] { message = transaction.relay(); });
+    for (auto& destination : destinations)
+      destination.join();
+  }
+
+  // The socket reads the next message in a new one.
+  received = qi::Message();
+  const std::string next(size, 'n');
+  received.buffer().write(next.data(), next.size());
+
+  for (auto& message : relayed)
+  {
+    EXPECT_EQ(qi::Message::Type_Call, message.type());
+    EXPECT_EQ(100u, message.action());
+    const qi::Buffer& payload = message.buffer();
+    ASSERT_EQ(size, payload.size());
+    EXPECT_EQ(head, bytes(payload, 0, head.size()));
+    EXPECT_EQ(tail, bytes(payload, size - tail.size(), tail.size()));
+    ASSERT_EQ(1u, payload.subBuffers().size());
+    EXPECT_EQ(head.size(), payload.subBuffers()[0].first);
+    EXPECT_EQ(subData, bytes(payload.subBuffers()[0].second, 0, subData.size()));
+  }
+}
@@ -0,0 +1,103 @@
+/*
+**  Copyright (C) 2012 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "src/messaging/pendingcalltable.hpp"
+
+TEST(PendingCallTable, TakesInsertedCalls)
+{
+  qi::PendingCallTable<std::string> table;
+  table.insert(1, "one");
+  table.insert(2, "two");
+  EXPECT_FALSE(table.take(3));
+  EXPECT_EQ(std::string("two"), table.take(2).value());
+  EXPECT_FALSE(table.take(2));
+  EXPECT_EQ(std::string("one"), table.take(1).value());
+}
+
+TEST(PendingCallTable, ReleasesTakenValues)
+{
+  qi::PendingCallTable<std::shared_ptr<int>> table;
+  auto value = std::make_shared<int>(42);
+  table.insert(7, value);
+  EXPECT_EQ(2, value.use_count());
+  EXPECT_EQ(42, *table.take(7).value());
+  EXPECT_EQ(1, value.use_count());
+}
+
+TEST(PendingCallTable, GrowsWhenSlotsAreUsed)
+{
+  qi::PendingCallTable<unsigned int> table(4);
+  const unsigned int count = 1000;
+  // Ids mapping to the same slots.
+  for (unsigned int i = 0; i < count; ++i)
+    table.insert(i * 64, i);
+  EXPECT_GE(table.capacity(), count);
+  for (unsigned int i = 0; i < count; ++i)
+    ASSERT_EQ(i, table.take(i * 64).value());
+  // The free slots are reused.
+  const auto capacity = table.capacity();
+  for (unsigned int i = 0; i < count; ++i)
+    table.insert(i, i);
+  EXPECT_EQ(capacity, table.capacity());
+}
+
+TEST(PendingCallTable, TakesAllCalls)
+{
+  qi::PendingCallTable<unsigned int> table(4);
+  for (unsigned int i = 1; i <= 100; ++i)
+    table.insert(i, i * 2);
+  EXPECT_EQ(200u, table.take(100).value());
+  auto calls = table.takeAll();
+  std::sort(calls.begin(), calls.end());
+  ASSERT_EQ(99u, calls.size());
+  for (unsigned int i = 1; i <= 99; ++i)
+  {
+    EXPECT_EQ(i, calls[i - 1].first);
+    EXPECT_EQ(i * 2, calls[i - 1].second);
+  }
+  EXPECT_TRUE(table.takeAll().empty());
+  EXPECT_FALSE(table.take(1));
+}
+
+TEST(PendingCallTable, ConcurrentInsertsAndTakes)
+{
+  qi::PendingCallTable<unsigned int> table(8);
+  const unsigned int threadCount = 8;
+  const unsigned int perThread = 10000;
+  std::atomic<unsigned int> taken{0};
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&, t] {
+      // Each thread takes the calls it inserted, some of them later.
+      for (unsigned int i = 0; i < perThread; ++i)
+      {
+        const unsigned int id = t * perThread + i;
+        table.insert(id, id);
+        if (i >= 100)
+        {
+          auto value = table.take(id - 100);
+          if (value && *value == id - 100)
+            ++taken;
+        }
+      }
+      for (unsigned int i = perThread - 100; i < perThread; ++i)
+      {
+        auto value = table.take(t * perThread + i);
+        if (value && *value == t * perThread + i)
+          ++taken;
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(threadCount * perThread, taken.load());
+  EXPECT_TRUE(table.takeAll().empty());
+}
@@ -3,6 +3,7 @@
 **  See COPYING for the license
 */
 
+#include <cstdint>
 #include <list>
 
 #include <gtest/gtest.h>
@@ -195,7 +196,84 @@ TEST(Proxy, Property)
   PERSIST_ASSERT(, bar3.sum() == 5, 500);
 }
 
+namespace
+{
+  std::uint64_t messagesSent(const qi::SessionPtr& session)
+  {
+    std::uint64_t count = 0;
+    for (const qi::ConnectionMetrics& metrics : session->connectionMetrics())
+      count += metrics.messagesSent;
+    return count;
+  }
+}
+
+TEST(Proxy, MirroredProperty)
+{
+  boost::shared_ptr<Bar> bar(new Bar);
+  qi::AnyObject gbar = qi::AnyReference::from(bar).toObject();
+  // The session must die before bar.
+  TestSessionPair p;
+  p.server()->registerService("bar", gbar);
+  qi::AnyObject client = p.client()->service("bar");
+  bar->set(1);
+
+  qi::ProxyProperty<int> pp(client, "prop");
+  pp.enableMirror();
+  // Nothing received yet: read from the service.
+  ASSERT_EQ(1, pp.get());
+  ASSERT_EQ(1u, pp.mirrorVersion());
+
+  const std::uint64_t sentBefore = messagesSent(p.client());
+  for (int i = 0; i < 100000; ++i)
+    ASSERT_EQ(1, pp.get());
+  // Unmirrored, each read would be a call.
+  EXPECT_LT(messagesSent(p.client()) - sentBefore, 10u);
+
+  // Changes are pushed by the service.
+  bar->set(2);
+  PERSIST_ASSERT(, pp.get() == 2, 1000);
+  EXPECT_EQ(2u, pp.mirrorVersion());
+
+  // Other proxies of the property share the mirror and its subscription.
+  qi::ProxyProperty<int> pp2(p.client()->service("bar"), "prop");
+  pp2.enableMirror();
+  const std::uint64_t sentBeforeSecond = messagesSent(p.client());
+  EXPECT_EQ(2, pp2.get());
+  EXPECT_EQ(pp.mirrorVersion(), pp2.mirrorVersion());
+  EXPECT_LT(messagesSent(p.client()) - sentBeforeSecond, 10u);
+
+  // Values set through a proxy are read back at once.
+  pp2.set(3);
+  EXPECT_EQ(3, pp.get());
+  EXPECT_EQ(3, bar->get());
 
+  // A zero staleness bound reads from the service each time.
+  qi::ProxyProperty<int> pp3(client, "prop");
+  pp3.enableMirror(qi::Duration::zero());
+  const std::uint64_t sentBeforeThird = messagesSent(p.client());
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(3, pp3.get());
+  if (p.client() != p.server())
+  {
+    EXPECT_GE(messagesSent(p.client()) - sentBeforeThird, 10u);
+  }
+
+  pp.disableMirror();
+  EXPECT_EQ(0u, pp.mirrorVersion());
+  EXPECT_EQ(3, pp.get());
+
+  // The mirror is cleared once the service cannot be read anymore.
+  if (p.client() != p.server())
+  {
+    qi::ProxyProperty<int> pp4(client, "prop");
+    pp4.enableMirror(qi::MilliSeconds(10));
+    EXPECT_EQ(3, pp4.get());
+    p.server()->close();
+    qi::os::msleep(20);
+    EXPECT_ANY_THROW(pp4.get());
+    EXPECT_ANY_THROW(pp4.get());
+  }
+}
 
 int main(int argc, char **argv) {
   qi::Application app(argc, argv);
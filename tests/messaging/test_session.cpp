@@ -572,3 +572,43 @@ TEST(QiSession, WaitForServiceCanceled)
   future.cancel();
   EXPECT_TRUE(future.isCanceled());
 }
+
+TEST(QiSession, ConnectionMetricsCountTheTraffic)
+{
+  auto server = qi::makeSession();
+  auto client = qi::makeSession();
+  server->listenStandalone(qi::Url{"tcp://127.0.0.1:0"});
+  client->connect(server->endpoints()[0]);
+
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("reply", &reply);
+  server->registerService("serviceTest", ob.object());
+  qi::AnyObject object = client->service("serviceTest");
+
+  const auto before = client->connectionMetrics();
+  ASSERT_EQ(1u, before.size());
+  const int callCount = 10;
+  for (int i = 0; i < callCount; ++i)
+    EXPECT_EQ("foo", object.call<std::string>("reply", "foo"));
+  const auto after = client->connectionMetrics();
+  ASSERT_EQ(1u, after.size());
+
+  EXPECT_EQ(server->endpoints()[0].port(), after[0].remoteEndpoint.port());
+  EXPECT_LE(before[0].messagesSent + callCount, after[0].messagesSent);
+  EXPECT_LE(before[0].messagesReceived + callCount, after[0].messagesReceived);
+  EXPECT_LT(before[0].bytesSent, after[0].bytesSent);
+  EXPECT_LT(before[0].bytesReceived, after[0].bytesReceived);
+  EXPECT_GE(after[0].sendQueueHighWatermark, 1u);
+  EXPECT_LE(after[0].sendQueueDepth, after[0].sendQueueHighWatermark);
+
+  // The server sees the client connection, with the messages in the other
+  // direction.
+  const auto serverMetrics = server->connectionMetrics();
+  ASSERT_EQ(1u, serverMetrics.size());
+  EXPECT_LE(static_cast<std::uint64_t>(callCount), serverMetrics[0].messagesReceived);
+  EXPECT_LE(static_cast<std::uint64_t>(callCount), serverMetrics[0].messagesSent);
+
+  client->close();
+  EXPECT_TRUE(client->connectionMetrics().empty());
+  server->close();
+}
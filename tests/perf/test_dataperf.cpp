@@ -5,11 +5,17 @@
  *  Copyright (c) 2012-2013 Aldebaran Robotics. All rights reserved.
  */
 
+#include <fstream>
+#include <locale>
 #include <string>
 
+#include <boost/filesystem.hpp>
 #include <gtest/gtest.h>
 
+#include <qi/os.hpp>
+#include <qi/scoped.hpp>
 #include <qi/perf/dataperf.hpp>
+#include <qi/perf/dataperfsuite.hpp>
 
 TEST(TestMsgSize, TestDataPerf)
 {
@@ -25,3 +31,70 @@ TEST(TestMsgSize, TestDataPerf)
   ASSERT_EQ(dp.getMsgSize(), (unsigned int)0);
   dp.stop();
 }
+
+TEST(TestBaseline, TestDataPerfSuite)
+{
+  const boost::filesystem::path dir(qi::os::mktmpdir("test_dataperf"));
+  const std::string baselinePath = (dir / "baseline.xml").string();
+  {
+    std::ofstream baseline(baselinePath.c_str());
+    baseline << "<perf_results project=\"test\" executable=\"test_dataperf\">" << std::endl
+             << "\t<perf_result benchmark=\"fast_MsgPerSecond\" result_value=\"1000000000000.0\" />" << std::endl
+             << "\t<perf_result benchmark=\"slow_MsgPerSecond\" result_value=\"0.001\" />" << std::endl
+             << "</perf_results>" << std::endl;
+  }
+
+  qi::DataPerfSuite suite("test", "test_dataperf", qi::DataPerfSuite::OutputData_MsgPerSecond,
+                          (dir / "results.xml").string());
+  ASSERT_FALSE(suite.setBaseline((dir / "missing.xml").string()));
+  ASSERT_TRUE(suite.setBaseline(baselinePath, 0.1));
+
+  qi::DataPerf dp;
+  for (const char* name : {"fast", "slow", "new"})
+  {
+    dp.start(name, 1000);
+    qi::os::msleep(10);
+    dp.stop();
+    suite << dp;
+  }
+  suite.close();
+  // Only the result far below its baseline is a regression.
+  EXPECT_EQ(1u, suite.regressionCount());
+  boost::filesystem::remove_all(dir);
+}
+
+namespace
+{
+  struct DecimalComma : std::numpunct<char>
+  {
+    char do_decimal_point() const override { return ','; }
+  };
+}
+
+TEST(TestBaseline, IgnoresGlobalLocale)
+{
+  const boost::filesystem::path dir(qi::os::mktmpdir("test_dataperf"));
+  const std::string baselinePath = (dir / "baseline.xml").string();
+  {
+    std::ofstream baseline(baselinePath.c_str());
+    baseline << "<perf_results project=\"test\" executable=\"test_dataperf\">" << std::endl
+             << "\t<perf_result benchmark=\"fast_MsgPerSecond\" result_value=\"1000000000000.5\" />" << std::endl
+             << "</perf_results>" << std::endl;
+  }
+
+  const std::locale previous = std::locale::global(std::locale(std::locale::classic(), new DecimalComma));
+  auto restoreLocale = qi::scoped([&] { std::locale::global(previous); });
+  qi::DataPerfSuite suite("test", "test_dataperf", qi::DataPerfSuite::OutputData_MsgPerSecond,
+                          (dir / "results.xml").string());
+  ASSERT_TRUE(suite.setBaseline(baselinePath, 0.1));
+
+  qi::DataPerf dp;
+  dp.start("fast", 1000);
+  qi::os::msleep(10);
+  dp.stop();
+  suite << dp;
+  suite.close();
+  // With a decimal comma, the baseline would be invalid and ignored.
+  EXPECT_EQ(1u, suite.regressionCount());
+  boost::filesystem::remove_all(dir);
+}
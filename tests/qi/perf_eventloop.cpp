@@ -0,0 +1,139 @@
+/*
+ * Compares the event loop backends on workloads made of many small posted
+ * tasks:
+ * - throughput: several threads post tasks as fast as they can, and tasks
+ *   post other tasks,
+ * - latency: tasks are posted one by one, and the delay between the post and
+ *   the start of each task is measured.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/eventloop.hpp>
+#include <qi/future.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  const char* backendName(qi::EventLoop::Backend backend)
+  {
+    return backend == qi::EventLoop::Backend::WorkStealing ? "workstealing" : "asio";
+  }
+
+  /// Each task posts `fanout` tasks from the loop, the producers post from
+  /// outside of the loop.
+  void benchThroughput(qi::DataPerfSuite& out, qi::EventLoop::Backend backend,
+                       unsigned int threadCount, unsigned int producerCount,
+                       unsigned int taskCount, unsigned int fanout)
+  {
+    qi::EventLoop loop("perf", backend);
+    loop.start(threadCount);
+    const unsigned int rootCount = taskCount / (fanout + 1) / producerCount;
+    const unsigned int total = rootCount * producerCount * (fanout + 1);
+    std::atomic<unsigned int> done{0};
+    qi::Promise<void> allDone;
+    auto leaf = [&] {
+      if (++done == total)
+        allDone.setValue(0);
+    };
+    auto root = [&] {
+      for (unsigned int i = 0; i < fanout; ++i)
+        loop.post(leaf);
+      leaf();
+    };
+
+    qi::DataPerf dp;
+    dp.start(std::string("throughput_") + backendName(backend) + "_" + std::to_string(threadCount)
+             + "_threads_" + std::to_string(producerCount) + "_producers", total);
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < producerCount; ++p)
+      producers.emplace_back([&] {
+        for (unsigned int i = 0; i < rootCount; ++i)
+          loop.post(root);
+      });
+    for (auto& producer: producers)
+      producer.join();
+    allDone.future().wait();
+    dp.stop();
+    out << dp;
+    loop.stop();
+    loop.join();
+  }
+
+  void benchLatency(qi::DataPerfSuite& out, qi::EventLoop::Backend backend,
+                    unsigned int threadCount, unsigned int taskCount)
+  {
+    qi::EventLoop loop("perf", backend);
+    loop.start(threadCount);
+    std::vector<qi::Duration> latencies(taskCount);
+
+    qi::DataPerf dp;
+    dp.start(std::string("latency_") + backendName(backend) + "_" + std::to_string(threadCount)
+             + "_threads", taskCount);
+    for (unsigned int i = 0; i < taskCount; ++i)
+    {
+      const auto posted = qi::SteadyClock::now();
+      loop.async([&, i, posted] { latencies[i] = qi::SteadyClock::now() - posted; }).wait();
+    }
+    dp.stop();
+    out << dp;
+    loop.stop();
+    loop.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto us = [](qi::Duration d) {
+      return boost::chrono::duration_cast<qi::MicroSeconds>(d).count();
+    };
+    std::cout << dp.getBenchmarkName() << ": median " << us(latencies[taskCount / 2])
+              << "us, p99 " << us(latencies[taskCount * 99 / 100])
+              << "us, max " << us(latencies.back()) << "us" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of tasks per throughput benchmark.")
+    ("latency-count", po::value<unsigned int>()->default_value(20000), "Number of tasks per latency benchmark.")
+    ("fanout", po::value<unsigned int>()->default_value(4), "Number of tasks posted by each task posted by a producer.")
+    ("max-threads", po::value<unsigned int>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+     "Maximum number of threads of the event loops.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto latencyCount = vm["latency-count"].as<unsigned int>();
+  const auto fanout = vm["fanout"].as<unsigned int>();
+  const auto maxThreads = vm["max-threads"].as<unsigned int>();
+  qi::DataPerfSuite out("qi", "perf_eventloop", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  for (auto backend: {qi::EventLoop::Backend::Asio, qi::EventLoop::Backend::WorkStealing})
+  {
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+      benchThroughput(out, backend, threadCount, 1, count, fanout);
+      benchThroughput(out, backend, threadCount, threadCount, count, fanout);
+    }
+    benchLatency(out, backend, maxThreads, latencyCount);
+  }
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*
+ * Measures the cost of the future machinery on its own, without any event
+ * loop involved:
+ * - promise: a promise is created, its future gets a value, which is read,
+ * - then: a synchronous continuation is connected before the value is set,
+ * - chain: a chain of synchronous continuations is built with `then` and
+ *   resolved by the value of its first promise,
+ * - wait: another thread sets the value while the future is waited for.
+ */
+
+#include <iostream>
+#include <thread>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/future.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  void benchPromise(qi::DataPerfSuite& out, unsigned int count)
+  {
+    int sum = 0;
+    qi::DataPerf dp;
+    dp.start("promise", count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::Promise<int> promise;
+      promise.setValue(1);
+      sum += promise.future().value();
+    }
+    dp.stop();
+    out << dp;
+    if (sum != static_cast<int>(count))
+      std::cerr << "promise: unexpected sum " << sum << std::endl;
+  }
+
+  void benchThen(qi::DataPerfSuite& out, unsigned int count)
+  {
+    int sum = 0;
+    qi::DataPerf dp;
+    dp.start("then", count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::Promise<int> promise(qi::FutureCallbackType_Sync);
+      promise.future().connect([&sum](const qi::Future<int>& f) { sum += f.value(); });
+      promise.setValue(1);
+    }
+    dp.stop();
+    out << dp;
+    if (sum != static_cast<int>(count))
+      std::cerr << "then: unexpected sum " << sum << std::endl;
+  }
+
+  void benchChain(qi::DataPerfSuite& out, unsigned int count, unsigned int length)
+  {
+    const unsigned int chainCount = std::max(1u, count / length);
+    qi::DataPerf dp;
+    dp.start("chain_" + std::to_string(length), chainCount * length);
+    for (unsigned int i = 0; i < chainCount; ++i)
+    {
+      qi::Promise<int> promise(qi::FutureCallbackType_Sync);
+      qi::Future<int> future = promise.future();
+      for (unsigned int j = 0; j < length; ++j)
+        future = future.then(qi::FutureCallbackType_Sync,
+                             [](const qi::Future<int>& f) { return f.value() + 1; });
+      promise.setValue(0);
+      if (future.value() != static_cast<int>(length))
+        std::cerr << "chain: unexpected value " << future.value() << std::endl;
+    }
+    dp.stop();
+    out << dp;
+  }
+
+  void benchWait(qi::DataPerfSuite& out, unsigned int count)
+  {
+    qi::DataPerf dp;
+    dp.start("wait", count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::Promise<void> promise;
+      std::thread setter([&promise] { promise.setValue(0); });
+      promise.future().wait();
+      setter.join();
+    }
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of futures per benchmark.")
+    ("chain-length", po::value<unsigned int>()->default_value(10), "Number of continuations of a chain.")
+    ("wait-count", po::value<unsigned int>()->default_value(10000), "Number of futures waited for.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto chainLength = std::max(1u, vm["chain-length"].as<unsigned int>());
+  qi::DataPerfSuite out("qi", "perf_future", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  benchPromise(out, count);
+  benchThen(out, count);
+  benchChain(out, count, chainLength);
+  benchWait(out, vm["wait-count"].as<unsigned int>());
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*
+ * Measures the cost of logging from several threads at once, in asynchronous
+ * and synchronous modes.
+ *
+ * For each number of producer threads, every thread logs the same number of
+ * messages to a handler that only counts them. The benchmark reports the total
+ * throughput, the mean duration of a log call as seen by the producers, and
+ * the number of messages dropped by the asynchronous log buffer, if any.
+ *
+ * Only the public logging API is used, so that the benchmark can be built
+ * against other versions of the library for comparison.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/log.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+
+qiLogCategory("qi.perf.log");
+
+namespace po = boost::program_options;
+
+namespace
+{
+  std::atomic<unsigned long> handledCount{0u};
+
+  void countingHandler(const qi::LogLevel, const qi::Clock::time_point,
+                       const qi::SystemClock::time_point, const char*, const char*,
+                       const char*, const char*, int)
+  {
+    ++handledCount;
+  }
+
+  void bench(qi::DataPerfSuite& out, bool synchronous, unsigned int threadCount,
+             unsigned int perThreadCount)
+  {
+    const auto name = std::string{synchronous ? "log_sync_" : "log_async_"}
+                      + std::to_string(threadCount) + "_threads";
+    qi::log::setSynchronousLog(synchronous);
+    qi::log::flush();
+    handledCount = 0u;
+
+    std::vector<std::thread> threads;
+    std::atomic<long long> callDurationNs{0};
+    qi::DataPerf dp;
+    dp.start(name, threadCount * perThreadCount);
+    for (unsigned int t = 0; t < threadCount; ++t)
+    {
+      threads.emplace_back([&, t] {
+        const auto begin = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < perThreadCount; ++i)
+          qiLogInfo() << "message " << i << " from thread " << t;
+        const auto end = std::chrono::steady_clock::now();
+        callDurationNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+      });
+    }
+    for (auto& t: threads) t.join();
+    qi::log::flush();
+    dp.stop();
+    out << dp;
+
+    const unsigned long total = threadCount * perThreadCount;
+    std::cout << name << ": " << static_cast<double>(callDurationNs) / total << " ns/call, "
+              << (total - handledCount.load()) << " dropped" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(100000), "Number of messages per thread.")
+    ("max-threads", po::value<unsigned int>()->default_value(32), "Maximum number of producer threads.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto maxThreads = vm["max-threads"].as<unsigned int>();
+  qi::DataPerfSuite out("qi", "perf_log", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::log::init(qi::LogLevel_Info, 0, true);
+  qi::log::removeHandler("consoleloghandler");
+  qi::log::addHandler("countinghandler", &countingHandler);
+
+  for (bool synchronous: {false, true})
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+      bench(out, synchronous, threadCount, count);
+  out.close();
+
+  qi::log::removeHandler("countinghandler");
+  return EXIT_SUCCESS;
+}
@@ -1,5 +1,9 @@
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <qi/eventloop.hpp>
 #include "test_future.hpp"
@@ -114,3 +118,85 @@ TEST(EventLoop, asyncFast)
     f.wait();
   }
 }
+
+class EventLoopBackend: public ::testing::TestWithParam<qi::EventLoop::Backend>
+{
+};
+
+INSTANTIATE_TEST_CASE_P(AllBackends, EventLoopBackend,
+                        ::testing::Values(qi::EventLoop::Backend::Asio,
+                                          qi::EventLoop::Backend::WorkStealing));
+
+TEST_P(EventLoopBackend, RunsAllPostedTasks)
+{
+  static const int taskCount = 10000;
+  std::atomic<int> done{0};
+  qi::Promise<void> allDone;
+
+  qi::EventLoop loop("test", GetParam());
+  loop.start(4);
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; ++i)
+    producers.emplace_back([&] {
+      for (int j = 0; j < taskCount / 4; ++j)
+        loop.post([&] {
+          if (++done == taskCount)
+            allDone.setValue(0);
+        });
+    });
+  for (auto& producer: producers)
+    producer.join();
+  ASSERT_EQ(qi::FutureState_FinishedWithValue, allDone.future().wait(qi::Seconds{10}));
+  loop.stop();
+  loop.join();
+}
+
+TEST_P(EventLoopBackend, RunsTasksPostedFromTasks)
+{
+  qi::EventLoop loop("test", GetParam());
+  loop.start(2);
+  qi::Promise<int> result;
+  std::function<void (int)> chain = [&](int i) {
+    if (i == 100)
+      result.setValue(i);
+    else
+      loop.post([&, i] { chain(i + 1); });
+  };
+  loop.post([&] { chain(0); });
+  EXPECT_EQ(100, result.future().value(10000));
+  loop.stop();
+  loop.join();
+}
+
+TEST_P(EventLoopBackend, AsyncDelayCanBeCanceled)
+{
+  qi::EventLoop loop("test", GetParam());
+  loop.start(2);
+  auto value = loop.asyncDelay([] { return 42; }, qi::MilliSeconds{1});
+  EXPECT_EQ(42, value.value(1000));
+
+  auto canceled = loop.asyncDelay([] { return 42; }, qi::Seconds{10});
+  canceled.cancel();
+  EXPECT_EQ(qi::FutureState_Canceled, canceled.wait(1000));
+
+  auto error = loop.async([] { throw std::runtime_error("fail"); });
+  EXPECT_TRUE(error.hasError(1000));
+  loop.stop();
+  loop.join();
+}
+
+TEST_P(EventLoopBackend, TaskWaitingForAnotherTaskOnTheSameThread)
+{
+  qi::EventLoop loop("test", GetParam());
+  loop.start(2);
+  qi::Promise<void> inner;
+  auto outer = loop.async([&] {
+    // On a work-stealing loop, the inner task is queued on the current
+    // thread: the other thread must take it.
+    loop.post([&] { inner.setValue(0); });
+    inner.future().wait();
+  });
+  EXPECT_EQ(qi::FutureState_FinishedWithValue, outer.wait(10000));
+  loop.stop();
+  loop.join();
+}
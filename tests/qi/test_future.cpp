@@ -7,6 +7,7 @@
 #include <future>
 #include <list>
 #include <string>
+#include <vector>
 #include <functional>
 #include <boost/thread.hpp>
 #include <qi/application.hpp>
@@ -534,6 +535,37 @@ TEST(TestFutureError, ValueOnError)
   EXPECT_ANY_THROW({ f.value();});
 }
 
+TEST(TestFutureCallbacks, RunInConnectionOrder)
+{
+  qi::Promise<int> p(qi::FutureCallbackType_Sync);
+  qi::Future<int> f = p.future();
+  std::vector<int> order;
+  for (int i = 0; i < 5; ++i)
+    f.connect([&order, i](qi::Future<int>) { order.push_back(i); });
+  p.setValue(42);
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), order);
+
+  // connected after the result, called right away
+  f.connect([&order](qi::Future<int>) { order.push_back(5); });
+  EXPECT_EQ(6u, order.size());
+}
+
+TEST(TestFutureCallbacks, ConnectWhileSettingValue)
+{
+  for (int round = 0; round < 100; ++round)
+  {
+    qi::Promise<int> p(qi::FutureCallbackType_Sync);
+    qi::Future<int> f = p.future();
+    std::atomic<int> called{0};
+    std::thread setter([&] { p.setValue(round); });
+    for (int i = 0; i < 10; ++i)
+      f.connect([&called](qi::Future<int>) { ++called; });
+    setter.join();
+    EXPECT_EQ(10, called.load());
+    EXPECT_EQ(round, f.value());
+  }
+}
+
 
 TEST(TestFutureCancel, AsyncCallCanceleable)
 {
@@ -10,6 +10,10 @@
 #include <qi/atomic.hpp>
 #include <qi/future.hpp>
 #include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "src/logring_p.hpp"
 
 static const int MAX = 1000;
 
@@ -61,3 +65,158 @@ TEST(log, cats)
   qiLogWarningF("canard %s", 12);
   qi::os::msleep(100);
 }
+
+namespace
+{
+  using qi::log::detail::LogRing;
+  using qi::log::detail::LogRecord;
+  using qi::log::detail::OverflowPolicy;
+
+  LogRecord makeRecord(const char* message, int line = 42)
+  {
+    return LogRecord{qi::LogLevel_Info, qi::Clock::now(), qi::SystemClock::now(),
+                     "cat", "file.cpp", "function", message, line};
+  }
+
+  // Fills the ring with records until one is refused.
+  int fill(LogRing& ring, const std::string& message)
+  {
+    int pushed = 0;
+    while (ring.push(makeRecord(message.c_str()), []{ return false; }))
+      ++pushed;
+    return pushed;
+  }
+}
+
+TEST(LogRing, PushThenConsume)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::CountDrops};
+  ASSERT_TRUE(ring.empty());
+  ASSERT_TRUE(ring.push(makeRecord("hello", 1)));
+  ASSERT_TRUE(ring.push(makeRecord(nullptr, 2)));
+  ASSERT_FALSE(ring.empty());
+  std::vector<std::string> messages;
+  std::vector<int> lines;
+  const auto count = ring.consume([&](const LogRecord& r) {
+    EXPECT_STREQ("cat", r.category);
+    EXPECT_STREQ("file.cpp", r.file);
+    EXPECT_STREQ("function", r.function);
+    EXPECT_EQ(qi::LogLevel_Info, r.level);
+    messages.push_back(r.message);
+    lines.push_back(r.line);
+  });
+  ASSERT_EQ(2u, count);
+  ASSERT_EQ((std::vector<std::string>{"hello", "(null)"}), messages);
+  ASSERT_EQ((std::vector<int>{1, 2}), lines);
+  ASSERT_TRUE(ring.empty());
+  ASSERT_EQ(0u, ring.consume([](const LogRecord&) {}));
+}
+
+TEST(LogRing, TruncatesLongStrings)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::CountDrops};
+  const std::string longMessage(LogRing::maxMessageSize * 2, 'x');
+  ASSERT_TRUE(ring.push(makeRecord(longMessage.c_str())));
+  std::string message;
+  ring.consume([&](const LogRecord& r) { message = r.message; });
+  ASSERT_EQ(std::string(LogRing::maxMessageSize - 1, 'x'), message);
+}
+
+TEST(LogRing, WrapsAround)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::CountDrops};
+  // Records of various sizes, so that some of them need padding at the end of
+  // the ring.
+  int expected = 0;
+  int received = 0;
+  for (int round = 0; round < 100; ++round)
+  {
+    for (int i = 0; i < 7; ++i)
+    {
+      const auto message = std::to_string(expected) + std::string((round * 37 + i * 101) % 500, '.');
+      ASSERT_TRUE(ring.push(makeRecord(message.c_str(), expected)));
+      ++expected;
+    }
+    ring.consume([&](const LogRecord& r) {
+      EXPECT_EQ(received, r.line);
+      EXPECT_EQ(std::to_string(received), std::string(r.message).substr(0, std::to_string(received).size()));
+      ++received;
+    });
+  }
+  ASSERT_EQ(expected, received);
+  ASSERT_EQ(0u, ring.dropCount());
+}
+
+TEST(LogRing, CountsDropsWhenFull)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::CountDrops};
+  const std::string message(200, 'm');
+  const int pushed = fill(ring, message);
+  ASSERT_GT(pushed, 0);
+  ASSERT_FALSE(ring.push(makeRecord(message.c_str())));
+  ASSERT_EQ(2u, ring.dropCount());
+  ASSERT_EQ(static_cast<std::size_t>(pushed), ring.consume([](const LogRecord&) {}));
+  ASSERT_TRUE(ring.push(makeRecord(message.c_str())));
+}
+
+TEST(LogRing, DropsSilentlyWhenFull)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::Drop};
+  fill(ring, std::string(200, 'm'));
+  ASSERT_FALSE(ring.push(makeRecord("dropped")));
+  ASSERT_EQ(0u, ring.dropCount());
+}
+
+TEST(LogRing, BlocksWhenFull)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::Block};
+  const std::string message(200, 'm');
+  // With the block policy, the fill helper refuses to wait.
+  const int pushed = fill(ring, message);
+  std::atomic<bool> waited{false};
+  std::thread producer{[&] {
+    ring.push(makeRecord("last"), [&] { waited = true; return true; });
+  }};
+  while (!waited)
+    std::this_thread::yield();
+  std::vector<std::string> messages;
+  while (messages.size() != static_cast<std::size_t>(pushed) + 1)
+    ring.consume([&](const LogRecord& r) { messages.push_back(r.message); });
+  producer.join();
+  ASSERT_EQ("last", messages.back());
+}
+
+TEST(LogRing, MultipleProducers)
+{
+  LogRing ring{LogRing::minCapacity, OverflowPolicy::Block};
+  const int producerCount = 4;
+  const int perProducerCount = 10000;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producerCount; ++p)
+  {
+    producers.emplace_back([&ring, p, perProducerCount] {
+      const auto category = std::to_string(p);
+      for (int i = 0; i < perProducerCount; ++i)
+      {
+        LogRecord r = makeRecord("message", i);
+        r.category = category.c_str();
+        ring.push(r, []{ return true; });
+      }
+    });
+  }
+  // Records of each producer must be received in order.
+  std::vector<int> nextLines(producerCount, 0);
+  int received = 0;
+  while (received != producerCount * perProducerCount)
+  {
+    ring.consume([&](const LogRecord& r) {
+      int& next = nextLines.at(std::stoi(r.category));
+      EXPECT_EQ(next, r.line);
+      next = r.line + 1;
+      ++received;
+    });
+  }
+  for (auto& t: producers) t.join();
+  ASSERT_TRUE(ring.empty());
+  ASSERT_EQ(0u, ring.dropCount());
+}
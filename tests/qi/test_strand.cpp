@@ -1,6 +1,8 @@
 /*
 ** Copyright (C) 2014 Aldebaran
 */
+#include <thread>
+#include <vector>
 #include <qi/application.hpp>
 #include <qi/future.hpp>
 #include <boost/thread/mutex.hpp>
@@ -431,3 +433,60 @@ TEST(TestStrand, CallWrappedInStrandWhileJoiningDoesNotDeadlock)
   callLongCallbackWithDestructionHook(strand, strand.schedulerFor([]{}));
   strand.join();
 }
+
+namespace
+{
+  // Runs `jobCount` jobs scheduled with `schedule` from each of `producerCount`
+  // threads, and prints the number of jobs executed per second.
+  //
+  // Procedure<void (qi::Strand&, boost::function<void()>)> Schedule
+  template <typename Schedule>
+  void measureThroughput(const std::string& name, unsigned int producerCount,
+                         unsigned int jobCount, Schedule schedule)
+  {
+    struct State
+    {
+      unsigned int total;
+      unsigned int done; // only accessed from the strand
+      qi::Promise<void> allDone;
+    } state;
+    state.total = producerCount * jobCount;
+    state.done = 0;
+    // small enough to be stored without allocation in a boost::function
+    boost::function<void()> job = [&state] {
+      if (++state.done == state.total)
+        state.allDone.setValue(0);
+    };
+    qi::Strand strand;
+
+    const qi::SteadyClockTimePoint start = qi::SteadyClock::now();
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < producerCount; ++p)
+      producers.emplace_back([&] {
+        for (unsigned int i = 0; i < jobCount; ++i)
+          schedule(strand, job);
+      });
+    for (auto& producer: producers)
+      producer.join();
+    ASSERT_EQ(qi::FutureState_FinishedWithValue, state.allDone.future().wait(qi::Seconds(60)));
+    const auto elapsed = boost::chrono::duration_cast<qi::MicroSeconds>(qi::SteadyClock::now() - start);
+    EXPECT_EQ(state.total, state.done);
+    std::cout << name << " with " << producerCount << " producer(s): "
+              << static_cast<double>(state.total) * 1000000 / std::max<qi::MicroSeconds::rep>(1, elapsed.count())
+              << " jobs/sec" << std::endl;
+  }
+}
+
+TEST(TestStrand, PostThroughput)
+{
+  auto post = [](qi::Strand& strand, const boost::function<void()>& job) { strand.post(job); };
+  measureThroughput("post", 1, 200000, post);
+  measureThroughput("post", 4, 50000, post);
+}
+
+TEST(TestStrand, AsyncThroughput)
+{
+  auto async = [](qi::Strand& strand, const boost::function<void()>& job) { strand.async(job); };
+  measureThroughput("async", 1, 50000, async);
+  measureThroughput("async", 4, 12500, async);
+}
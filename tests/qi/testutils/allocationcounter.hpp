@@ -0,0 +1,62 @@
+#pragma once
+#ifndef _QI_TESTUTILS_ALLOCATIONCOUNTER_HPP
+#define _QI_TESTUTILS_ALLOCATIONCOUNTER_HPP
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/// @file
+/// Replaces the global allocation functions to count heap allocations.
+///
+/// Warning: This header defines the replacement functions, so it must be
+/// included in exactly one translation unit of a program.
+
+namespace qi { namespace test {
+  /// Number of calls to the global allocation functions since the program start.
+  inline std::atomic<unsigned long long>& allocationCount()
+  {
+    static std::atomic<unsigned long long> count{0u};
+    return count;
+  }
+
+  /// Counts the allocations performed, by any thread, between its construction
+  /// and the call to `count()`.
+  class AllocationCounter
+  {
+    unsigned long long _start;
+  public:
+    AllocationCounter()
+      : _start(allocationCount().load())
+    {
+    }
+    unsigned long long count() const
+    {
+      return allocationCount().load() - _start;
+    }
+  };
+}} // namespace qi::test
+
+void* operator new(std::size_t size)
+{
+  ++qi::test::allocationCount();
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+#endif // _QI_TESTUTILS_ALLOCATIONCOUNTER_HPP
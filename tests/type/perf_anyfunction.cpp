@@ -0,0 +1,138 @@
+/*
+ * Measures the speed and the number of heap allocations of calls to an
+ * AnyFunction taking an int, a double and a string, with arguments:
+ * - typed: of the parameter types, passed through,
+ * - converted: of other types (int64, float, C string), converted,
+ * - dynamic: wrapped in AnyValues, unwrapped,
+ * and of the same calls through an object with a direct metaCall().
+ *
+ * The allocations are counted by replacing the global operator new, and the
+ * number of allocations per call is printed for each benchmark.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyfunction.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/anyvalue.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  std::atomic<std::size_t> allocationCount{0};
+}
+
+void* operator new(std::size_t size)
+{
+  ++allocationCount;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+  int compute(int i, double d, const std::string& s)
+  {
+    return i + static_cast<int>(d) + static_cast<int>(s.size());
+  }
+
+  void bench(qi::DataPerfSuite& out, const std::string& name, unsigned int count,
+             qi::AnyFunction function, const qi::AnyReferenceVector& args)
+  {
+    qi::DataPerf dp;
+    const std::size_t allocationsBefore = allocationCount;
+    dp.start(name, count);
+    for (unsigned int i = 0; i < count; ++i)
+      function.call(args).destroy();
+    dp.stop();
+    const std::size_t allocations = allocationCount - allocationsBefore;
+    out << dp;
+    std::cout << name << ": " << static_cast<double>(allocations) / count << " allocations per call"
+              << std::endl;
+  }
+
+  void benchMetaCall(qi::DataPerfSuite& out, const std::string& name, unsigned int count,
+                     qi::AnyObject obj, unsigned int method, const qi::AnyReferenceVector& args)
+  {
+    const qi::GenericFunctionParameters params(args);
+    qi::DataPerf dp;
+    const std::size_t allocationsBefore = allocationCount;
+    dp.start(name, count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::AnyReference result = obj.metaCall(method, params, qi::MetaCallType_Direct).value();
+      result.destroy();
+    }
+    dp.stop();
+    const std::size_t allocations = allocationCount - allocationsBefore;
+    out << dp;
+    std::cout << name << ": " << static_cast<double>(allocations) / count << " allocations per call"
+              << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of calls per benchmark.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_anyfunction", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  int i = 1;
+  double d = 2.0;
+  std::string s = "three";
+  const qi::AnyReferenceVector typed{
+    qi::AnyReference::from(i), qi::AnyReference::from(d), qi::AnyReference::from(s)};
+
+  qi::int64_t i64 = 1;
+  float f = 2.0f;
+  char cstring[] = "three";
+  char* cs = cstring;
+  const qi::AnyReferenceVector converted{
+    qi::AnyReference::from(i64), qi::AnyReference::from(f), qi::AnyReference::from(cs)};
+
+  qi::AnyValue di(i), dd(d), ds(s);
+  const qi::AnyReferenceVector dynamic{
+    qi::AnyReference::from(di), qi::AnyReference::from(dd), qi::AnyReference::from(ds)};
+
+  qi::AnyFunction function = qi::AnyFunction::from(&compute);
+  bench(out, "anyfunction_typed", count, function, typed);
+  bench(out, "anyfunction_converted", count, function, converted);
+  bench(out, "anyfunction_dynamic", count, function, dynamic);
+
+  qi::DynamicObjectBuilder ob;
+  const unsigned int method = ob.advertiseMethod("compute", &compute);
+  qi::AnyObject obj = ob.object();
+  benchMetaCall(out, "metacall_typed", count, obj, method, typed);
+  benchMetaCall(out, "metacall_dynamic", count, obj, method, dynamic);
+  out.close();
+
+  return EXIT_SUCCESS;
+}
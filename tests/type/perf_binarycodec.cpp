@@ -0,0 +1,119 @@
+/*
+ * Compares the binary serialization of structs made of numbers and strings
+ * through their compiled serialization plan and through the type visitors,
+ * and of lists of numbers copied at once and element by element.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/binarycodec.hpp>
+#include <qi/anyvalue.hpp>
+#include "src/type/binarycodec_p.hpp"
+
+namespace po = boost::program_options;
+
+struct Pose
+{
+  float x, y, z;
+  float qx, qy, qz, qw;
+  double timestamp;
+  int frame;
+};
+QI_TYPE_STRUCT(Pose, x, y, z, qx, qy, qz, qw, timestamp, frame)
+
+struct Reading
+{
+  std::string sensor;
+  double value;
+  unsigned int sequence;
+  bool valid;
+};
+QI_TYPE_STRUCT(Reading, sensor, value, sequence, valid)
+
+namespace
+{
+  template<typename T>
+  void bench(qi::DataPerfSuite& out, const std::string& name, const T& value, unsigned int count)
+  {
+    qi::Buffer encoded;
+    qi::encodeBinary(&encoded, value);
+
+    qi::DataPerf dp;
+    dp.start(name + "_encode", count, encoded.size());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::Buffer buf;
+      qi::encodeBinary(&buf, value);
+    }
+    dp.stop();
+    out << dp;
+
+    dp.start(name + "_decode", count, encoded.size());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      // Lists are appended to: decode into a new value each time.
+      T decoded{};
+      qi::BufferReader reader(encoded);
+      qi::decodeBinary(&reader, &decoded);
+    }
+    dp.stop();
+    out << dp;
+  }
+
+  void benchAll(qi::DataPerfSuite& out, const std::string& suffix, unsigned int count)
+  {
+    const Pose pose{1.f, 2.f, 3.f, 0.f, 0.f, 0.f, 1.f, 12.5, 42};
+    bench(out, "pose" + suffix, pose, count);
+    bench(out, "pose_list" + suffix, std::vector<Pose>(100, pose), count / 100);
+    bench(out, "reading" + suffix, Reading{"sonar/left", 0.42, 7u, true}, count);
+  }
+
+  void benchLists(qi::DataPerfSuite& out, const std::string& suffix, unsigned int count)
+  {
+    for (unsigned int size = 1000; size <= 1000000; size *= 10)
+    {
+      // At least a few loops for the biggest lists.
+      const unsigned int loops = std::max(10u, count / size);
+      bench(out, "float_list_" + std::to_string(size) + suffix, std::vector<float>(size, 0.5f), loops);
+      bench(out, "int_list_" + std::to_string(size) + suffix, std::vector<int>(size, 42), loops);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of structs per benchmark.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_binarycodec", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  qi::detail::setStructCodecPlansEnabled(false);
+  benchAll(out, "_visitor", count);
+  qi::detail::setStructCodecPlansEnabled(true);
+  benchAll(out, "_plan", count);
+  qi::detail::setContiguousListCodecEnabled(false);
+  benchLists(out, "_elementwise", count);
+  qi::detail::setContiguousListCodecEnabled(true);
+  benchLists(out, "_contiguous", count);
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*
+ * Measures the throughput of the JSON codec on a small document and on large
+ * configuration and diagnostic blobs:
+ * - encode: encodeJSON() of the value,
+ * - decode: decodeJSON() into a generic AnyValue,
+ * - decode_typed: decodeJSON() directly into a value of the original type.
+ *
+ * The message size of each benchmark is the size of the document, to compare
+ * the results with the ones of previous versions of the codec.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyvalue.hpp>
+#include <qi/jsoncodec.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  struct Entry
+  {
+    std::string name;
+    int id;
+    std::vector<double> values;
+  };
+
+  bool operator==(const Entry& lhs, const Entry& rhs)
+  {
+    return lhs.name == rhs.name && lhs.id == rhs.id && lhs.values == rhs.values;
+  }
+
+  using Config = std::map<std::string, Entry>;
+}
+
+QI_TYPE_STRUCT(Entry, name, id, values)
+
+namespace
+{
+  Config makeConfig(unsigned int entryCount, unsigned int valueCount)
+  {
+    Config config;
+    for (unsigned int i = 0; i < entryCount; ++i)
+    {
+      Entry& entry = config["entry" + std::to_string(i)];
+      entry.name = "a configuration entry, number " + std::to_string(i);
+      entry.id = static_cast<int>(i) * 37 - 1000;
+      for (unsigned int j = 0; j < valueCount; ++j)
+        entry.values.push_back(i * 0.25 + j / 8.0);
+    }
+    return config;
+  }
+
+  std::vector<std::string> makeDiagnostics(unsigned int lineCount)
+  {
+    std::vector<std::string> lines;
+    for (unsigned int i = 0; i < lineCount; ++i)
+      lines.push_back("[" + std::to_string(i) + "] motor \"HeadYaw\" temperature is nominal, "
+                      "no stiffness loss detected during the last sampling period\t(ok)");
+    return lines;
+  }
+
+  template <typename T>
+  void bench(qi::DataPerfSuite& out, const std::string& name, const T& value, unsigned int count)
+  {
+    const std::string json = qi::encodeJSON(value);
+    std::size_t size = 0;
+    qi::DataPerf dp;
+
+    dp.start("encode_" + name, count, json.size());
+    for (unsigned int i = 0; i < count; ++i)
+      size += qi::encodeJSON(value).size();
+    dp.stop();
+    out << dp;
+
+    dp.start("decode_" + name, count, json.size());
+    for (unsigned int i = 0; i < count; ++i)
+      size += qi::decodeJSON(json).isValid();
+    dp.stop();
+    out << dp;
+
+    dp.start("decode_typed_" + name, count, json.size());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      T decoded;
+      qi::decodeJSON(json, qi::AnyReference::from(decoded));
+      size += decoded == value;
+    }
+    dp.stop();
+    out << dp;
+
+    if (size == 0)
+      std::cerr << name << ": nothing was encoded" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(20000), "Number of small documents per benchmark.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_json", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  bench(out, "small", makeConfig(1, 4), count);
+  bench(out, "config", makeConfig(1000, 16), std::max(1u, count / 1000));
+  bench(out, "diagnostics", makeDiagnostics(10000), std::max(1u, count / 1000));
+  out.close();
+
+  return EXIT_SUCCESS;
+}
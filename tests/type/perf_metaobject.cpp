@@ -0,0 +1,132 @@
+/*
+ * Measures the cost of dispatching calls through the metaobject of objects
+ * with few and many methods:
+ * - the lookups of a method by uid and by signature,
+ * - direct metaCall()s, from one thread and from several threads at once.
+ *
+ * With an index-addressed and lock-free metaobject, the costs should not
+ * depend on the number of methods, and the throughput of concurrent calls
+ * should grow with the number of threads.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  qi::AnyObject makeObject(unsigned int methodCount)
+  {
+    qi::DynamicObjectBuilder ob;
+    for (unsigned int i = 0; i < methodCount; ++i)
+      ob.advertiseMethod("method" + std::to_string(i), [](int value) { return value; });
+    return ob.object();
+  }
+
+  void benchLookups(qi::DataPerfSuite& out, qi::AnyObject obj, unsigned int methodCount,
+                    unsigned int count)
+  {
+    const qi::MetaObject& metaObject = obj.metaObject();
+    std::vector<unsigned int> uids;
+    std::vector<std::string> signatures;
+    for (unsigned int i = 0; i < methodCount; ++i)
+    {
+      const qi::MetaMethod method = metaObject.findMethod("method" + std::to_string(i)).at(0);
+      uids.push_back(method.uid());
+      signatures.push_back(method.toString());
+    }
+
+    const auto suffix = "_" + std::to_string(methodCount);
+    std::size_t found = 0;
+    qi::DataPerf dp;
+    dp.start("method_by_uid" + suffix, count);
+    for (unsigned int i = 0; i < count; ++i)
+      found += metaObject.method(uids[i % methodCount]) != nullptr;
+    dp.stop();
+    out << dp;
+
+    dp.start("method_by_signature" + suffix, count);
+    for (unsigned int i = 0; i < count; ++i)
+      found += metaObject.methodId(signatures[i % methodCount]) != -1;
+    dp.stop();
+    out << dp;
+
+    if (found != 2 * static_cast<std::size_t>(count))
+      std::cerr << "some lookups failed" << std::endl;
+  }
+
+  void metaCalls(qi::AnyObject obj, const std::vector<unsigned int>& uids, unsigned int count)
+  {
+    int value = 42;
+    qi::GenericFunctionParameters args;
+    args.push_back(qi::AnyReference::from(value));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      qi::AnyReference result = obj.metaCall(uids[i % uids.size()], args, qi::MetaCallType_Direct).value();
+      result.destroy();
+    }
+  }
+
+  void benchMetaCalls(qi::DataPerfSuite& out, qi::AnyObject obj, unsigned int methodCount,
+                      unsigned int threadCount, unsigned int perThreadCount)
+  {
+    std::vector<unsigned int> uids;
+    for (unsigned int i = 0; i < methodCount; ++i)
+      uids.push_back(obj.metaObject().findMethod("method" + std::to_string(i)).at(0).uid());
+
+    std::vector<std::thread> threads;
+    qi::DataPerf dp;
+    dp.start("metacall_" + std::to_string(methodCount) + "_methods_"
+             + std::to_string(threadCount) + "_threads", threadCount * perThreadCount);
+    for (unsigned int i = 0; i < threadCount; ++i)
+      threads.emplace_back([&] { metaCalls(obj, uids, perThreadCount); });
+    for (auto& t: threads)
+      t.join();
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of lookups or calls per thread.")
+    ("max-threads", po::value<unsigned int>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+     "Maximum number of concurrent threads.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto maxThreads = vm["max-threads"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_metaobject", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  for (unsigned int methodCount : {5u, 500u})
+  {
+    qi::AnyObject obj = makeObject(methodCount);
+    benchLookups(out, obj, methodCount, count);
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+      benchMetaCalls(out, obj, methodCount, threadCount, count / 10);
+  }
+  out.close();
+
+  return EXIT_SUCCESS;
+}
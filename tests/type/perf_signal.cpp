@@ -0,0 +1,94 @@
+/*
+ * Measures the cost of emitting a signal with 1, 10 and 100 subscribers:
+ * - direct: the subscribers are called synchronously,
+ * - queued: the subscribers are posted to the event loop, which share a
+ *   single copy of the arguments.
+ *
+ * Each emission is compared to the "copy" baseline, which takes the
+ * subscribers of the signal under its lock, as emission did before it read
+ * an immutable snapshot, and calls them one by one, copying the arguments
+ * for each queued subscriber.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/os.hpp>
+#include <qi/signal.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  void waitFor(const std::atomic<unsigned int>& calls, unsigned int expected)
+  {
+    while (calls.load() < expected)
+      qi::os::msleep(1);
+  }
+
+  void bench(qi::DataPerfSuite& out, qi::MetaCallType callType, unsigned int subscriberCount,
+             unsigned int count)
+  {
+    qi::Signal<std::string> signal;
+    std::atomic<unsigned int> calls{0};
+    for (unsigned int i = 0; i < subscriberCount; ++i)
+      signal.connect([&calls](const std::string&) { ++calls; }).setCallType(callType);
+
+    const std::string arg(64, 'x');
+    const auto suffix = std::string(callType == qi::MetaCallType_Direct ? "_direct_" : "_queued_")
+        + std::to_string(subscriberCount);
+    const unsigned int emitCount = std::max(1u, count / subscriberCount);
+
+    qi::DataPerf dp;
+    dp.start("emit" + suffix, emitCount);
+    for (unsigned int i = 0; i < emitCount; ++i)
+      signal(arg);
+    waitFor(calls, emitCount * subscriberCount);
+    dp.stop();
+    out << dp;
+
+    calls = 0;
+    std::vector<qi::AnyReference> argRefs{qi::AnyReference::from(arg)};
+    const qi::GenericFunctionParameters params(argRefs);
+    dp.start("copy" + suffix, emitCount);
+    for (unsigned int i = 0; i < emitCount; ++i)
+      for (auto& subscriber: signal.subscribers())
+        subscriber.call(params, callType);
+    waitFor(calls, emitCount * subscriberCount);
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of subscriber calls per benchmark.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_signal", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  for (auto callType: {qi::MetaCallType_Direct, qi::MetaCallType_Queued})
+    for (unsigned int subscriberCount: {1, 10, 100})
+      bench(out, callType, subscriberCount, count);
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/*
+ * Measures the throughput of type lookups (typeOf<T>()) when several threads
+ * perform them concurrently. With a lock-free lookup, the total throughput
+ * should grow linearly with the number of threads.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/anyvalue.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  std::size_t lookups(unsigned int count)
+  {
+    std::size_t n = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      // Use a few types to avoid measuring a single cache line.
+      n += qi::typeOf<int>() != nullptr;
+      n += qi::typeOf<std::string>() != nullptr;
+      n += qi::typeOf<std::vector<double>>() != nullptr;
+      n += qi::typeOf<std::map<std::string, qi::AnyValue>>() != nullptr;
+    }
+    return n;
+  }
+
+  void bench(qi::DataPerfSuite& out, unsigned int threadCount, unsigned int perThreadCount)
+  {
+    const unsigned int lookupsPerLoop = 4;
+    std::vector<std::thread> threads;
+    qi::DataPerf dp;
+    dp.start("typeof_" + std::to_string(threadCount) + "_threads",
+             threadCount * perThreadCount * lookupsPerLoop);
+    for (unsigned int i = 0; i < threadCount; ++i)
+      threads.emplace_back([=]{ lookups(perThreadCount); });
+    for (auto& t: threads) t.join();
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("count,n", po::value<unsigned int>()->default_value(1000000), "Number of loops per thread.")
+    ("max-threads", po::value<unsigned int>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+     "Maximum number of concurrent threads.");
+
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto count = vm["count"].as<unsigned int>();
+  const auto maxThreads = vm["max-threads"].as<unsigned int>();
+  qi::DataPerfSuite out("qitype", "perf_typeof", qi::DataPerfSuite::OutputData_MsgPerSecond, vm["output"].as<std::string>());
+
+  // Warm up: the first lookups of a type go through the type factory.
+  lookups(1);
+  for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    bench(out, threadCount, count);
+  out.close();
+
+  return EXIT_SUCCESS;
+}
@@ -7,6 +7,8 @@
 #include <cmath>
 #include <gtest/gtest.h>
 #include <map>
+#include <string>
+#include <vector>
 #include <qi/anyvalue.hpp>
 #include <qi/application.hpp>
 #include <qi/type/typeinterface.hpp>
@@ -448,3 +450,68 @@ TEST(DecodeJSON, StructWithDifferentSizedFields)
   EXPECT_EQ(val,
             res) << qi::encodeJSON(val) << "\n" << qi::encodeJSON(res);
 }
+
+TEST(DecodeJSON, IntoTypedValue)
+{
+  std::vector<int> ints;
+  qi::decodeJSON("[1, 2,\t3]", qi::AnyReference::from(ints));
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), ints);
+
+  std::map<std::string, std::vector<double>> doubles;
+  qi::decodeJSON("{\"a\": [1.5, 2], \"b\": []}", qi::AnyReference::from(doubles));
+  ASSERT_EQ(2u, doubles.size());
+  EXPECT_EQ((std::vector<double>{1.5, 2.0}), doubles["a"]);
+  EXPECT_TRUE(doubles["b"].empty());
+
+  std::string str;
+  qi::decodeJSON("\"a \\\"quoted\\\" string\"", qi::AnyReference::from(str));
+  EXPECT_EQ("a \"quoted\" string", str);
+
+  bool boolean = false;
+  qi::decodeJSON("true", qi::AnyReference::from(boolean));
+  EXPECT_TRUE(boolean);
+}
+
+TEST(DecodeJSON, IntoTypedStruct)
+{
+  Qiqi byName;
+  byName.fint = 0;
+  qi::decodeJSON("{\"fint\": 12, \"ignored\": [1], \"fdouble\": 2.5, \"ffloat\": 0.5}",
+                 qi::AnyReference::from(byName));
+  EXPECT_EQ(12, byName.fint);
+  EXPECT_EQ(2.5, byName.fdouble);
+  EXPECT_EQ(0.5f, byName.ffloat);
+
+  Qiqi val;
+  val.ffloat = 3.14f;
+  val.fdouble = 5.5555;
+  val.fint = 44;
+  Qiqi res;
+  qi::decodeJSON(qi::encodeJSON(val), qi::AnyReference::from(res));
+  EXPECT_EQ(val, res);
+
+  MPoint point;
+  qi::decodeJSON("[3, 4]", qi::AnyReference::from(point));
+  EXPECT_EQ(3, point.x);
+  EXPECT_EQ(4, point.y);
+}
+
+TEST(DecodeJSON, IntoTypedValueErrors)
+{
+  int i = 0;
+  EXPECT_ANY_THROW(qi::decodeJSON("\"not a number\"", qi::AnyReference::from(i)));
+  unsigned char small = 0;
+  EXPECT_ANY_THROW(qi::decodeJSON("1000", qi::AnyReference::from(small)));
+  std::vector<int> ints;
+  EXPECT_ANY_THROW(qi::decodeJSON("[1, 2", qi::AnyReference::from(ints)));
+}
+
+TEST(EncodeJSON, LongStrings)
+{
+  // long enough to go through the vectorized scanner
+  const std::string plain(100, 'a');
+  EXPECT_EQ("\"" + plain + "\"", qi::encodeJSON(plain));
+  const std::string special = plain + "\"\n\t\x01" + plain + "\\";
+  EXPECT_EQ("\"" + plain + "\\\"\\n\\t\\u0001" + plain + "\\\\\"", qi::encodeJSON(special));
+  EXPECT_EQ(special, qi::decodeJSON(qi::encodeJSON(special)).toString());
+}
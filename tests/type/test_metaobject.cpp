@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <qi/anyobject.hpp>
 #include <qi/jsoncodec.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
 
 bool compareMetaMethodParameter(
     const qi::MetaMethodParameter& lhs,
@@ -104,5 +105,39 @@ TEST(MetaObject, constructSimpleMetaObject)
   EXPECT_EQ(returnDescription, mm.returnDescription());
 }
 
+TEST(MetaObject, lookupsSeeMembersAddedToABuiltObject)
+{
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("first", [] { return 1; });
+  qi::AnyObject obj = ob.object();
+  const auto firstId = obj.metaObject().findMethod("first").at(0).uid();
+  ASSERT_NE(nullptr, obj.metaObject().method(firstId));
+
+  ob.advertiseMethod("second", [](int i) { return i; });
+  ob.advertiseMethod("second", [](int i, int j) { return i + j; });
+  ob.advertiseSignal<int>("fired");
+  EXPECT_EQ(2u, obj.metaObject().findMethod("second").size());
+  EXPECT_NE(-1, obj.metaObject().methodId("second::(i)"));
+  EXPECT_NE(-1, obj.metaObject().signalId("fired"));
+  EXPECT_EQ(3, obj.call<int>("second", 1, 2));
+  EXPECT_EQ(nullptr, obj.metaObject().method(firstId + 1000));
+}
+
+TEST(MetaObject, sparseUids)
+{
+  qi::MetaObjectBuilder mob;
+  auto mmb = makeMetaMethodBuilder();
+  mob.addMethod(mmb, 42);
+  mmb.setName("far");
+  mob.addMethod(mmb, 1000000);
+
+  auto mo = mob.metaObject();
+  ASSERT_NE(nullptr, mo.method(42));
+  ASSERT_NE(nullptr, mo.method(1000000));
+  EXPECT_EQ("far", mo.method(1000000)->name());
+  EXPECT_EQ(nullptr, mo.method(43));
+  EXPECT_EQ(1000000, mo.methodId("far::()"));
+}
+
 // MetaObject carry a map<int, MetaMethod>, therefore it cannot be serialized
 // to JSON, because JSON does not support non-string keys in maps!
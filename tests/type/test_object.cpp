@@ -6,6 +6,7 @@
 */
 
 #include <map>
+#include <thread>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/assign/list_of.hpp>
@@ -222,6 +223,28 @@ TEST(TestObject, Typing)
   ASSERT_TRUE(checkValue(res, 42));
 }
 
+static std::string concat(const std::string& a, std::string b, int c)
+{
+  return a + b + std::to_string(c);
+}
+
+TEST(TestObject, CallConvertsArguments)
+{
+  qi::AnyFunction f = qi::AnyFunction::from(&concat);
+  char a[] = "a long enough string not to fit in the small string buffer";
+  char* pa = a;
+  std::string b = "b";
+  qi::int64_t c = 3;
+  std::vector<qi::AnyReference> args{
+    qi::AnyReference::from(pa), qi::AnyReference::from(b), qi::AnyReference::from(c)};
+  for (int i = 0; i < 2; ++i) // the second time with the cached conversions
+  {
+    qi::AnyReference res = f.call(args);
+    EXPECT_EQ(std::string(a) + "b3", res.to<std::string>());
+    res.destroy();
+  }
+}
+
 TEST(TestObject, ABI)
 {
   using namespace qi;
@@ -864,6 +887,42 @@ TEST(TestObject, statisticsGeneric)
   EXPECT_EQ(1u, m.count());
 }
 
+TEST(TestObject, statisticsSnapshot)
+{
+  qi::DynamicObjectBuilder gob;
+  int mid = gob.advertiseMethod("sleep", &qi::os::msleep);
+  qi::AnyObject obj = gob.object();
+  obj.enableStats(true);
+  obj.call<void>("sleep", 10);
+  std::thread([&]{ obj.call<void>("sleep", 10); }).join();
+  qi::ObjectLatencyStatistics latencies = obj.call<qi::ObjectLatencyStatistics>("latencyStats");
+  EXPECT_LE(0.01f, latencies[mid].p50());
+  EXPECT_LE(latencies[mid].p50(), latencies[mid].p999());
+  qi::ObjectStatistics stats = obj.call<qi::ObjectStatistics>("snapshotStats");
+  EXPECT_EQ(2u, stats[mid].count());
+  EXPECT_TRUE(obj.stats().empty());
+  EXPECT_TRUE(obj.latencyStats().empty());
+  obj.call<void>("sleep", 0);
+  EXPECT_EQ(1u, obj.snapshotStats()[mid].count());
+}
+
+TEST(TestObject, latencyHistogramPercentiles)
+{
+  qi::LatencyHistogram histogram;
+  EXPECT_EQ(0.f, histogram.percentile(0.5f));
+  for (int ms = 1; ms <= 1000; ++ms)
+    histogram.push(ms / 1000.f);
+  EXPECT_EQ(1000u, histogram.count());
+  const qi::LatencyPercentiles p = histogram.percentiles();
+  // Buckets are at most 6.25% wide
+  EXPECT_NEAR(0.5f, p.p50(), 0.5f * 0.0625f);
+  EXPECT_NEAR(0.9f, p.p90(), 0.9f * 0.0625f);
+  EXPECT_NEAR(0.99f, p.p99(), 0.99f * 0.0625f);
+  EXPECT_NEAR(0.999f, p.p999(), 0.999f * 0.0625f);
+  histogram.reset();
+  EXPECT_EQ(0u, histogram.count());
+}
+
 TEST(TestObject, statisticsType)
 {
   qi::ObjectTypeBuilder<Adder> builder;
@@ -6,6 +6,8 @@
 */
 
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 #include <qi/signal.hpp>
 #include <qi/future.hpp>
 #include <qi/signalspy.hpp>
@@ -449,6 +451,56 @@ TEST(TestSignal, SignalSubscriberDoesNotUnsubscribeAtDestruction)
   ASSERT_EQ(2, count);
 }
 
+TEST(TestSignal, ConnectFromCallbackAppliesToNextEmission)
+{
+  int count = 0;
+  qi::Signal<void> signal;
+  signal.connect([&]{
+    ++count;
+    signal.connect([&]{ ++count; }).setCallType(qi::MetaCallType_Direct);
+  }).setCallType(qi::MetaCallType_Direct);
+
+  signal();
+  EXPECT_EQ(1, count);
+  signal();
+  EXPECT_EQ(3, count);
+}
+
+TEST(TestSignal, QueuedSubscribersReceiveTheArguments)
+{
+  qi::Signal<std::string> signal;
+  std::vector<qi::Promise<std::string>> received(3);
+  for (auto& promise: received)
+    signal.connect([promise](const std::string& s) mutable { promise.setValue(s); })
+        .setCallType(qi::MetaCallType_Queued);
+  {
+    std::string arg = "value";
+    QI_EMIT signal(arg);
+  }
+  for (auto& promise: received)
+    EXPECT_EQ("value", promise.future().value());
+}
+
+TEST(TestSignal, QueuedSubscribersModifyingArgumentsGetTheirOwnCopy)
+{
+  qi::Signal<int> signal;
+  std::vector<qi::Promise<int>> received(3);
+  for (auto& promise: received)
+  {
+    // Dynamic functions can modify the values of their arguments.
+    signal.connect(qi::AnyFunction::fromDynamicFunction(
+        [promise](const qi::AnyReferenceVector& args) mutable {
+          qi::AnyReference arg = args[0];
+          promise.setValue(static_cast<int>(arg.toInt()));
+          arg.setInt(arg.toInt() + 1);
+          return qi::AnyReference(qi::typeOf<void>());
+        })).setCallType(qi::MetaCallType_Queued);
+  }
+  QI_EMIT signal(42);
+  for (auto& promise: received)
+    EXPECT_EQ(42, promise.future().value());
+}
+
 // ===========================================================
 // Signal Spy
 // -----------------------------------------------------------
@@ -18,6 +18,8 @@
 #include <qi/signature.hpp>
 #include <qi/anyvalue.hpp>
 #include <qi/jsoncodec.hpp>
+#include <qi/scoped.hpp>
+#include "src/type/signature_p.hpp"
 
 #include <vector>
 #include <map>
@@ -309,6 +311,40 @@ TEST(TestSignature, IsCompatible) {
   EXPECT_GT(s3.isConvertibleTo("([m])"), s3.isConvertibleTo("(m)"));
 }
 
+TEST(TestSignature, IsCompatibleSameScoreWithoutCache) {
+  const char* sigs[] = { "i", "f", "b", "s", "m", "[i]", "[m]", "{is}", "{im}", "(is)", "(sm)",
+                         "(i[f]{if})", "(i[d]{im})", "(is)<Foo,a,b>", "(isi)<Foo,a,b,c>", "#i", "v", "X" };
+  std::vector<float> cached;
+  for (const char* from : sigs)
+    for (const char* to : sigs)
+      cached.push_back(qi::Signature(from).isConvertibleTo(qi::Signature(to)));
+  // asking again hits the cache
+  auto it = cached.begin();
+  for (const char* from : sigs)
+    for (const char* to : sigs)
+      EXPECT_EQ(*it++, qi::Signature(from).isConvertibleTo(qi::Signature(to))) << from << " -> " << to;
+
+  qi::detail::setSignatureCacheEnabled(false);
+  auto restore = qi::scoped([]{ qi::detail::setSignatureCacheEnabled(true); });
+  // scores are computed again
+  it = cached.begin();
+  for (const char* from : sigs)
+    for (const char* to : sigs)
+      EXPECT_EQ(*it++, qi::Signature(from).isConvertibleTo(qi::Signature(to))) << from << " -> " << to;
+}
+
+TEST(TestSignature, SameStringEqualSignatures) {
+  const qi::Signature a("(i[f]{if})");
+  const qi::Signature b(std::string("(i[f]{if})"));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.toString(), b.toString());
+  ASSERT_EQ(3u, b.children().size());
+  EXPECT_EQ("{if}", b.children()[2].toString());
+  // invalid signatures are not interned
+  EXPECT_ANY_THROW(qi::Signature("(i[f]{if}"));
+  EXPECT_ANY_THROW(qi::Signature("(i[f]{if}"));
+}
+
 TEST(TestSignature, SignatureSplit) {
   std::vector<std::string> sigInfo;
 
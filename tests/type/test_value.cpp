@@ -5,6 +5,7 @@
 
 
 #include <map>
+#include <thread>
 #include <gtest/gtest.h>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
@@ -921,3 +922,42 @@ TYPED_TEST(ConvertWithTypes, convertReferenceFromInvalidToOtherTypeInterfaceIsSa
   qi::AnyReference::from(qi::AnyValue{}).convert(qi::typeOf<typename TestFixture::Type>());
   // depending on the type, the result may be invalid or not, let's not test the result
 }
+
+namespace
+{
+  struct RegisteredLate
+  {
+    int i;
+  };
+}
+
+TEST(TypeRegistry, RegistrationAfterLookupIsVisible)
+{
+  // Looked up before registration: nothing is found.
+  ASSERT_EQ(nullptr, qi::getType(typeid(RegisteredLate)));
+  qi::TypeInterface* type = new qi::TypeImpl<RegisteredLate>();
+  qi::registerType(typeid(RegisteredLate), type);
+  ASSERT_EQ(type, qi::getType(typeid(RegisteredLate)));
+  // Other threads see the registration too.
+  qi::TypeInterface* typeFromOtherThread = nullptr;
+  std::thread t{[&]{ typeFromOtherThread = qi::getType(typeid(RegisteredLate)); }};
+  t.join();
+  ASSERT_EQ(type, typeFromOtherThread);
+}
+
+TEST(TypeRegistry, ConcurrentLookupsGiveTheSameType)
+{
+  const auto expected = qi::typeOf<std::vector<std::string>>();
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int i = 0; i < 8; ++i)
+  {
+    threads.emplace_back([&]{
+      for (int j = 0; j < 10000; ++j)
+        if (qi::typeOf<std::vector<std::string>>() != expected)
+          ++mismatches;
+    });
+  }
+  for (auto& t: threads) t.join();
+  ASSERT_EQ(0, mismatches.load());
+}